@@ -363,5 +363,24 @@ class EngineTestCase(BrokerTestCase):
 class MtBrokerTest(EngineTestCase):
     broker_exe = "mt_broker"
 
+    def test_heavy_and_light(self):
+        # With a large credit window the heavy sender fills its turns and is
+        # queued again while light clients are served, by a broker whose
+        # workers can steal the work.
+        addr = pick_addr()
+        self.proc(["mt_broker", "-a", addr, "-t", "4", "-c", "5000"], "listening")
+        heavy, count = addr + "/heavy", 20000
+        heavy_recv = self.proc(["simple_recv", "-a", heavy, "-m", str(count)])
+        heavy_send = self.proc(["simple_send", "-a", heavy, "-m", str(count)])
+        # Light clients run together so they share workers with the heavy ones.
+        lights = ["%s/light%s" % (addr, i) for i in range(4)]
+        recvs = [self.proc(["simple_recv", "-a", light]) for light in lights]
+        sends = [self.proc(["simple_send", "-a", light]) for light in lights]
+        for light, recv, send in zip(lights, recvs, sends):
+            self.assertEqual("all messages confirmed\n", send.wait_exit())
+            self.assertEqual(recv_expect("simple_recv", light), recv.wait_exit())
+        self.assertEqual("all messages confirmed\n", heavy_send.wait_exit())
+        self.assertTrue(heavy_recv.wait_exit().endswith('{"sequence"=%s}\n' % count))
+
 if __name__ == "__main__":
     unittest.main()
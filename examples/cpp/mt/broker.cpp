@@ -23,6 +23,7 @@
 #include <proton/controller.hpp>
 #include <proton/delivery.hpp>
 #include <proton/handler.hpp>
+#include <proton/receiver_options.hpp>
 #include <proton/work_queue.hpp>
 
 #include <atomic>
@@ -120,7 +121,7 @@ class queues {
 ///
 class broker_connection_handler : public proton::handler {
   public:
-    broker_connection_handler(queues& qs) : queues_(qs) {}
+    broker_connection_handler(queues& qs, int credit) : queues_(qs), credit_(credit) {}
 
     void on_connection_open(proton::connection& c) override {
         // Create the has_messages callback for use with queue subscriptions.
@@ -162,6 +163,7 @@ class broker_connection_handler : public proton::handler {
                 proton::error_condition("shutdown", "stop broker"));
         } else {
             std::cout << "receiving to " << qname << std::endl;
+            receiver.open(proton::receiver_options().credit_window(credit_));
         }
     }
 
@@ -232,6 +234,7 @@ class broker_connection_handler : public proton::handler {
     }
 
     queues& queues_;
+    int credit_;
     blocked_map blocked_;
     std::function<void(queue*)> has_messages_callback_;
     proton::connection connection_;
@@ -240,35 +243,46 @@ class broker_connection_handler : public proton::handler {
 
 class broker {
   public:
-    broker(const std::string addr) : controller_(proton::controller::create()) {
+    broker(const std::string addr, size_t threads, bool pin, int credit) :
+        controller_(proton::controller::create()), threads_(threads), credit_(credit)
+    {
         controller_->options(proton::connection_options().container_id("mt_broker"));
+        controller_->workers(threads_, pin);
         std::cout << "broker listening on " << addr << std::endl;
         controller_->listen(addr, std::bind(&broker::new_handler, this));
     }
 
     void run() {
-        for(size_t i = 0; i < std::thread::hardware_concurrency(); ++i)
+        for(size_t i = 0; i < threads_; ++i)
             std::thread(&proton::controller::run, controller_.get()).detach();
         controller_->wait();
     }
 
   private:
     proton::handler* new_handler() {
-        return new broker_connection_handler(queues_);
+        return new broker_connection_handler(queues_, credit_);
     }
 
     queues queues_;
     std::unique_ptr<proton::controller> controller_;
+    size_t threads_;
+    int credit_;
 };
 
 int main(int argc, char **argv) {
     // Command line options
     std::string address("0.0.0.0");
+    size_t threads = std::thread::hardware_concurrency();
+    bool pin = false;
+    int credit = 10;
     example::options opts(argc, argv);
     opts.add_value(address, 'a', "address", "listen on URL", "URL");
+    opts.add_value(threads, 't', "threads", "run N worker threads", "N");
+    opts.add_flag(pin, 'p', "pin", "pin each worker thread to its own CPU");
+    opts.add_value(credit, 'c', "credit", "credit window for each incoming link", "N");
     try {
         opts.parse();
-        broker(address).run();
+        broker(address, threads ? threads : 1, pin, credit).run();
         return 0;
     } catch (const example::bad_option& e) {
         std::cout << opts << std::endl << e.what() << std::endl;
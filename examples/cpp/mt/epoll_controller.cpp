@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include <proton/admission_limiter.hpp>
 #include <proton/controller.hpp>
 #include <proton/work_queue.hpp>
 #include <proton/url.hpp>
@@ -24,7 +25,12 @@
 #include <proton/io/connection_engine.hpp>
 #include <proton/io/default_controller.hpp>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <condition_variable>
@@ -32,12 +38,18 @@
 #include <set>
 #include <sstream>
 #include <system_error>
+#include <vector>
 
 // Linux native IO
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/socket.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
@@ -75,6 +87,7 @@ class unique_addrinfo {
     ~unique_addrinfo() { if (addrinfo_) ::freeaddrinfo(addrinfo_); }
 
     ::addrinfo* operator->() const { return addrinfo_; }
+    ::addrinfo* get() const { return addrinfo_; }
 
   private:
     static const char* char_p(const std::string& s) { return s.empty() ? 0 : s.c_str(); }
@@ -93,9 +106,269 @@ class unique_fd {
     int fd_;
 };
 
+// A resolved socket address.
+struct address {
+    ::sockaddr_storage addr;
+    ::socklen_t len;
+};
+
+// Resolves and connects outgoing connections on a few background threads
+// so that a slow name server or an unreachable host does not block the
+// caller of connect(). Resolved addresses are cached for a short time so
+// reconnecting to the same host skips the name lookup.
+//
+// A connect gives up after connect_timeout, and stop() cuts short the
+// ones in progress.
+class connector {
+  public:
+    // Called with a connected socket, or -1 and an error message.
+    typedef std::function<void(int, const std::string&)> callback;
+
+    connector() :
+        stop_fd_(check(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), "eventfd")),
+        idle_(0), stopping_(false) {}
+    ~connector() { stop(); }
+
+    // Resolve and connect addr in the background, then call done.
+    void connect(const std::string& addr, callback done) {
+        lock_guard g(lock_);
+        if (stopping_)
+            throw proton::error("controller is stopping");
+        requests_.push_back(request{addr, done});
+        if (idle_ == 0 && threads_.size() < max_threads)
+            threads_.push_back(std::thread(&connector::run, this));
+        ready_.notify_one();
+    }
+
+    // Wait for the threads to finish, fail requests that have not started.
+    void stop() {
+        std::deque<request> abandoned;
+        {
+            lock_guard g(lock_);
+            stopping_ = true;
+            abandoned.swap(requests_);
+            ready_.notify_all();
+        }
+        uint64_t n = 1;
+        if (::write(stop_fd_, &n, sizeof(n)) < 0) {} // Stays readable, wakes every race().
+        for (auto& r : abandoned)
+            r.done(-1, "controller is stopping");
+        for (auto& t : threads_)
+            t.join();
+        threads_.clear();
+    }
+
+  private:
+    static const size_t max_threads = 2;
+    static const int connect_delay_ms = 250;
+    static std::chrono::seconds cache_ttl() { return std::chrono::seconds(30); }
+    static std::chrono::seconds connect_timeout() { return std::chrono::seconds(30); }
+
+    struct request {
+        std::string addr;
+        callback done;
+    };
+
+    struct cached {
+        std::vector<address> addresses;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> l(lock_);
+        while (true) {
+            ++idle_;
+            ready_.wait(l, [this]() { return stopping_ || !requests_.empty(); });
+            --idle_;
+            if (stopping_)
+                return;
+            request r = requests_.front();
+            requests_.pop_front();
+            l.unlock();
+            std::string err;
+            int fd = connect_to(r.addr, err);
+            r.done(fd, err);
+            l.lock();
+        }
+    }
+
+    int connect_to(const std::string& addr, std::string& err) {
+        try {
+            int fd = race(addr, resolve(addr));
+            if (fd < 0) {
+                err = errno_str("connect to "+addr);
+                lock_guard g(lock_);
+                cache_.erase(addr); // Maybe the host moved, look it up again next time.
+            }
+            return fd;
+        } catch (const std::exception& e) {
+            err = e.what();
+            return -1;
+        }
+    }
+
+    // Look up addr, alternating address families as RFC 8305 recommends.
+    std::vector<address> resolve(const std::string& addr) {
+        auto now = std::chrono::steady_clock::now();
+        {
+            lock_guard g(lock_);
+            auto i = cache_.find(addr);
+            if (i != cache_.end() && i->second.expires > now)
+                return i->second.addresses;
+        }
+        unique_addrinfo ainfo(addr);
+        std::vector<address> same, other, addresses;
+        for (::addrinfo* ai = ainfo.get(); ai; ai = ai->ai_next) {
+            if (ai->ai_socktype != SOCK_STREAM || ai->ai_addrlen > sizeof(::sockaddr_storage))
+                continue;
+            address a;
+            memcpy(&a.addr, ai->ai_addr, ai->ai_addrlen);
+            a.len = ai->ai_addrlen;
+            bool first = same.empty() || same[0].addr.ss_family == ai->ai_family;
+            (first ? same : other).push_back(a);
+        }
+        for (size_t i = 0; i < same.size() || i < other.size(); ++i) {
+            if (i < same.size()) addresses.push_back(same[i]);
+            if (i < other.size()) addresses.push_back(other[i]);
+        }
+        lock_guard g(lock_);
+        cache_[addr] = cached{addresses, now + cache_ttl()};
+        return addresses;
+    }
+
+    // Return a socket connected to the first address that answers, or -1
+    // with errno set. Each attempt gets connect_delay_ms to finish before
+    // the next address is tried alongside it ("happy eyeballs"), all of
+    // them together get connect_timeout.
+    int race(const std::string& addr, const std::vector<address>& addresses) {
+        using namespace std::chrono;
+        auto deadline = steady_clock::now() + connect_timeout();
+        pollfd stop = { stop_fd_, POLLIN, 0 };
+        std::vector<pollfd> attempts(1, stop); // Connecting sockets follow stop_fd_
+        int error = EHOSTUNREACH, winner = -1;
+        size_t next = 0;
+        while (winner < 0 && (next < addresses.size() || attempts.size() > 1)) {
+            if (next < addresses.size()) {
+                const address& a = addresses[next++];
+                int fd = ::socket(a.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+                if (fd < 0) {
+                    error = errno;
+                    continue;
+                }
+                if (::connect(fd, reinterpret_cast<const ::sockaddr*>(&a.addr), a.len) < 0 &&
+                    errno != EINPROGRESS) {
+                    error = errno;
+                    ::close(fd);
+                    continue;
+                }
+                pollfd p = { fd, POLLOUT, 0 };
+                attempts.push_back(p);
+            }
+            auto left = duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+            if (left <= 0) {
+                error = ETIMEDOUT;
+                break;
+            }
+            int timeout = int(left);
+            if (next < addresses.size() && connect_delay_ms < timeout)
+                timeout = connect_delay_ms;
+            if (::poll(attempts.data(), attempts.size(), timeout) < 0 && errno != EINTR) {
+                error = errno;
+                break;
+            }
+            if (attempts[0].revents) {
+                error = ECANCELED;
+                break;
+            }
+            for (auto i = attempts.begin() + 1; i != attempts.end();) {
+                if (!i->revents) {
+                    ++i;
+                    continue;
+                }
+                int e = 0;
+                ::socklen_t len = sizeof(e);
+                if (::getsockopt(i->fd, SOL_SOCKET, SO_ERROR, &e, &len) < 0)
+                    e = errno;
+                if (!e && winner < 0)
+                    winner = i->fd;
+                else {
+                    if (e) error = e;
+                    ::close(i->fd);
+                }
+                i = attempts.erase(i);
+            }
+        }
+        for (size_t i = 1; i < attempts.size(); ++i)
+            ::close(attempts[i].fd);
+        errno = error;
+        return winner;
+    }
+
+    const unique_fd stop_fd_;
+    std::mutex lock_;
+    std::condition_variable ready_;
+    std::deque<request> requests_;
+    std::vector<std::thread> threads_;
+    std::map<std::string, cached> cache_;
+    size_t idle_;
+    bool stopping_;
+};
+
 class pollable;
 class pollable_engine;
 class pollable_listener;
+struct worker;
+
+// Admission limits for a listener, shared with the connections it accepts
+// since they finish their handshakes on other threads.
+class admission {
+  public:
+    explicit admission(const proton::admission_limiter& l) : limiter_(l) {}
+
+    bool admit() {
+        lock_guard g(lock_);
+        return limiter_.admit(proton::timestamp::now());
+    }
+
+    void handshake_done() {
+        lock_guard g(lock_);
+        limiter_.handshake_done();
+    }
+
+  private:
+    std::mutex lock_;
+    proton::admission_limiter limiter_;
+};
+
+// A connection handed to a worker, to be built by one of its threads.
+// An outgoing connection that failed has fd -1 and the error to report.
+struct pending {
+    proton::handler* handler;
+    proton::connection_options opts;
+    int fd;
+    std::shared_ptr<admission> adm;
+    std::string err;
+    worker* home;               // Set by epoll_controller::place()
+};
+
+// CPUs this process may run on.
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0)
+        for (int i = 0; i < CPU_SETSIZE; ++i)
+            if (CPU_ISSET(i, &set))
+                cpus.push_back(i);
+    return cpus;
+}
+
+// Bind the calling thread to cpu, best effort.
+void pin_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+}
 
 class epoll_controller : public proton::controller {
   public:
@@ -117,6 +390,7 @@ class epoll_controller : public proton::controller {
     proton::connection_options options() override;
 
     void run() override;
+    void workers(size_t n, bool pin) override;
 
     void stop_on_idle() override;
     void stop(const proton::error_condition& err) override;
@@ -124,14 +398,29 @@ class epoll_controller : public proton::controller {
 
     // Functions used internally.
 
-    void add_engine(proton::handler* h, proton::connection_options opts, int fd);
+    void add_engine(proton::handler* h, proton::connection_options opts, int fd,
+                    std::shared_ptr<admission> adm, int cpu = -1);
+    void build(worker&, pending&);
+    void backlog(worker&);
     void erase(pollable*);
+    void connected(proton::handler* h, const proton::connection_options& opts,
+                   int fd, const std::string& err);
 
   private:
+    static const size_t poll_turns = 16; // Poll epoll after this many turns of queued work
+    static const int max_events = 64;
+
     void idle_check(const lock_guard&);
     void interrupt();
-
-    const unique_fd epoll_fd_;
+    void fail(proton::handler* h, const proton::connection_options& opts, const std::string& err);
+    void place(pending, int cpu);
+    worker& choose(int cpu);
+    worker& host(worker& home);
+    pollable* steal(worker&);
+    bool dispatch(worker&, const epoll_event*, int n);
+
+    std::vector<std::unique_ptr<worker> > workers_;
+    std::atomic<size_t> next_worker_;
     const unique_fd interrupt_fd_;
 
     mutable std::mutex lock_;
@@ -142,42 +431,179 @@ class epoll_controller : public proton::controller {
 
     std::condition_variable stopped_;
     bool stopping_;
+    bool interrupted_;
     proton::error_condition stop_err_;
     std::atomic<size_t> threads_;
+    size_t connecting_;
+
+    // Last, so it is stopped before the members its callbacks use are destroyed.
+    connector connector_;
+};
+
+// A share of the connections with its own epoll set, see controller::workers().
+//
+// Connections that epoll reports ready are queued on the worker's run
+// queue and served in turn from the front. Threads of an idle worker may
+// take from the back of a busy worker's queue, see epoll_controller::steal().
+struct worker {
+    static const uint64_t wake_mark = 1; // epoll data for wake_fd, pollables are pointers
+
+    worker(size_t i, int c, epoll_controller& ec) :
+        controller(ec), index(i), epoll_fd(check(epoll_create(1), "epoll_create")),
+        wake_fd(check(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), "eventfd")),
+        cpu(c), connections(0), threads(0), sleeping(0)
+    {
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLET; // Each write wakes one thread.
+        ev.data.u64 = wake_mark;
+        check(::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev), "wake fd");
+    }
+
+    // Queue p to be served, wake a thread if they are all asleep. If they
+    // are all busy and a backlog starts, wake another worker to steal.
+    void schedule(pollable* p) {
+        bool wake_one, behind;
+        {
+            lock_guard g(lock);
+            ready.push_back(p);
+            wake_one = sleeping;
+            behind = !sleeping && ready.size() == 2;
+        }
+        if (wake_one)
+            wake();
+        else if (behind)
+            controller.backlog(*this);
+    }
+
+    // Next ready pollable, or null after counting the caller as sleeping so
+    // that a schedule() before it reaches epoll_wait() still wakes it.
+    pollable* pop_or_sleep() {
+        lock_guard g(lock);
+        if (ready.empty()) {
+            ++sleeping;
+            return nullptr;
+        }
+        pollable* p = ready.front();
+        ready.pop_front();
+        return p;
+    }
+
+    pollable* pop() {
+        lock_guard g(lock);
+        if (ready.empty())
+            return nullptr;
+        pollable* p = ready.front();
+        ready.pop_front();
+        return p;
+    }
+
+    // Take the most recently queued pollable, only if every thread is busy.
+    pollable* steal() {
+        lock_guard g(lock);
+        if (sleeping || ready.empty())
+            return nullptr;
+        pollable* p = ready.back();
+        ready.pop_back();
+        return p;
+    }
+
+    // Hand a new connection to the worker, to be built by one of its threads.
+    void push(pending p) {
+        {
+            lock_guard g(lock);
+            inbox.push_back(std::move(p));
+        }
+        wake();
+    }
+
+    std::deque<pending> pop_inbox() {
+        uint64_t n;
+        if (::read(wake_fd, &n, sizeof(n)) < 0) {} // Reset the count, ignore errors.
+        lock_guard g(lock);
+        return std::move(inbox);
+    }
+
+    void wake() {
+        uint64_t n = 1;
+        if (::write(wake_fd, &n, sizeof(n)) < 0) {} // Only fails if the count overflows.
+    }
+
+    epoll_controller& controller;
+    const size_t index;
+    const unique_fd epoll_fd;
+    const unique_fd wake_fd;
+    const int cpu;                      // Threads are pinned to this CPU, or -1
+    std::atomic<size_t> connections;    // Including those not built yet
+    std::atomic<size_t> threads;        // Threads running this worker
+    std::atomic<size_t> sleeping;       // Threads in a blocking epoll_wait()
+
+    std::mutex lock;
+    std::deque<pollable*> ready;        // Run queue
+    std::deque<pending> inbox;          // Connections to build
 };
 
 // Base class for pollable file-descriptors. Manages epoll interaction,
 // subclasses implement virtual work() to do their serialized work.
+//
+// The fd is registered EPOLLONESHOT. Once epoll reports it the pollable is
+// queued on its worker and epoll is not re-armed until work() has nothing
+// left to do, so a busy connection costs no epoll_ctl() between turns.
+//
+// A pollable whose home worker had no thread yet is served by another
+// worker, and moves home after its first turn once home has a thread.
 class pollable {
   public:
-    pollable(int fd, int epoll_fd) : fd_(fd), epoll_fd_(epoll_fd), notified_(false), working_(false)
+    pollable(int fd, worker& w, worker* home = nullptr) :
+        fd_(fd), worker_(&w), home_(home ? home : &w),
+        events_(0), scheduled_(false), notified_(false)
     {
         int flags = check(::fcntl(fd, F_GETFL, 0), "non-blocking");
         check(::fcntl(fd, F_SETFL,  flags | O_NONBLOCK), "non-blocking");
         ::epoll_event ev = {};
         ev.data.ptr = this;
-        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &ev);
+        ::epoll_ctl(worker_->epoll_fd, EPOLL_CTL_ADD, fd_, &ev);
     }
 
     virtual ~pollable() {
         ::epoll_event ev = {};
-        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd_, &ev); // Ignore errors.
+        ::epoll_ctl(worker_->epoll_fd, EPOLL_CTL_DEL, fd_, &ev); // Ignore errors.
     }
 
-    bool do_work(uint32_t events) {
+    // Called when epoll reports events, queue for a turn of work.
+    void ready(uint32_t events) {
+        lock_guard g(lock_);
+        events_ |= events;
+        if (!scheduled_) {
+            scheduled_ = true;
+            worker_->schedule(this);
+        }
+    }
+
+    // Do one turn of work. Returns false if finished.
+    bool do_work() {
+        uint32_t events;
         {
             lock_guard g(lock_);
-            if (working_)
-                return true;         // Another thread is already working.
-            working_ = true;
+            events = events_;
+            events_ = 0;
             notified_ = false;
         }
-        uint32_t new_events = work(events);  // Serialized, outside the lock.
-        if (new_events) {
-            lock_guard g(lock_);
-            rearm(notified_ ?  EPOLLIN|EPOLLOUT : new_events);
+        uint32_t next = work(events);  // Serialized, outside the lock.
+        if (!next)
+            return false;
+        lock_guard g(lock_);
+        if (worker_ != home_ && home_->threads)
+            move_home();
+        if (next == again)
+            events_ |= events;          // Used up its turn, go to the back of the queue.
+        else if (notified_)
+            events_ |= EPOLLIN|EPOLLOUT;
+        else {
+            rearm(next);                // Idle, wait for epoll.
+            return true;
         }
-        return new_events;
+        worker_->schedule(this);
+        return true;
     }
 
     // Called by work_queue to notify that there are jobs.
@@ -185,19 +611,22 @@ class pollable {
         lock_guard g(lock_);
         if (!notified_) {
             notified_ = true;
-            if (!working_) // No worker thread, rearm now.
+            if (!scheduled_) // Idle, rearm now.
                 rearm(EPOLLIN|EPOLLOUT);
         }
     }
 
   protected:
+    // Returned by work() when it stopped for fairness with more to do.
+    static const uint32_t again = ~uint32_t(0);
 
     // Subclass implements  work.
-    // Returns epoll events to re-enable or 0 if finished.
+    // Returns epoll events to re-enable, again or 0 if finished.
     virtual uint32_t work(uint32_t events) = 0;
 
     const unique_fd fd_;
-    const int epoll_fd_;
+    worker* worker_;            // Serving the pollable, changed under lock_
+    worker* const home_;        // Counts the pollable in its connections
 
   private:
 
@@ -205,13 +634,24 @@ class pollable {
         epoll_event ev;
         ev.data.ptr = this;
         ev.events = EPOLLONESHOT | events;
-        check(::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd_, &ev), "re-arm epoll");
-        working_ = false;
+        check(::epoll_ctl(worker_->epoll_fd, EPOLL_CTL_MOD, fd_, &ev), "re-arm epoll");
+        scheduled_ = false;
+    }
+
+    // Called at the end of a turn, when epoll is disarmed and only the
+    // calling thread can schedule the pollable.
+    void move_home() {
+        ::epoll_event ev = {};
+        ::epoll_ctl(worker_->epoll_fd, EPOLL_CTL_DEL, fd_, &ev);
+        worker_ = home_;
+        ev.data.ptr = this;
+        check(::epoll_ctl(worker_->epoll_fd, EPOLL_CTL_ADD, fd_, &ev), "move epoll");
     }
 
     std::mutex lock_;
+    uint32_t events_;           // Reported since the last turn
+    bool scheduled_;            // Queued or working, epoll is disarmed
     bool notified_;
-    bool working_;
 };
 
 class work_queue : public proton::work_queue {
@@ -253,38 +693,37 @@ class work_queue : public proton::work_queue {
 };
 
 // Handle epoll wakeups for a connection_engine.
+//
+// A turn reads and writes at most turn_bytes, then returns again so the
+// other ready connections of the worker get their turn.
 class pollable_engine : public pollable {
   public:
 
+    // Takes fd from the caller once it is sure to be closed on failure.
     pollable_engine(
         proton::handler* h, proton::connection_options opts, epoll_controller& c,
-        int fd, int epoll_fd
-    ) : pollable(fd, epoll_fd),
-        engine_(*h, opts),
-        queue_(new work_queue(*this, c))
-    {
-        engine_.work_queue(queue_.get());
-    }
+        unique_fd& fd, worker& w, worker& home, std::shared_ptr<admission> adm = nullptr
+    );
 
-    ~pollable_engine() {
-        queue_->close();               // No calls to notify() after this.
-        engine_.dispatch();            // Run any final events.
-        try { write(); } catch(...) {} // Write connection close if we can.
-        for (auto f : queue_->pop_all()) {// Run final queued work for side-effects.
-            try { f(); } catch(...) {}
-        }
-    }
+    ~pollable_engine();
 
     uint32_t work(uint32_t events) {
         try {
-            bool can_read = events & EPOLLIN, can_write = events && EPOLLOUT;
+            bool can_read = events & EPOLLIN, can_write = events & EPOLLOUT;
+            size_t budget = turn_bytes;
             do {
-                can_write = can_write && write();
-                can_read = can_read && read();
+                can_write = can_write && write(budget);
+                can_read = can_read && read(budget);
                 for (auto f : queue_->pop_all()) // Run queued work
                     f();
                 engine_.dispatch();
-            } while (can_read || can_write);
+            } while ((can_read || can_write) && budget);
+            if (admission_ && engine_.connection().active()) {
+                admission_->handshake_done(); // Opened by the handler
+                admission_.reset();
+            }
+            if (can_read || can_write)
+                return again;
             return (engine_.read_buffer().size ? EPOLLIN:0) |
                 (engine_.write_buffer().size ? EPOLLOUT:0);
         } catch (const std::exception& e) {
@@ -298,14 +737,16 @@ class pollable_engine : public pollable {
     }
 
   private:
+    static const size_t turn_bytes = 64*1024;
 
-    bool write() {
+    bool write(size_t& budget) {
         if (engine_.write_buffer().size) {
             ssize_t n = ::write(fd_, engine_.write_buffer().data, engine_.write_buffer().size);
             while (n == EINTR)
                 n = ::write(fd_, engine_.write_buffer().data, engine_.write_buffer().size);
             if (n > 0) {
                 engine_.write_done(n);
+                budget -= std::min(budget, size_t(n));
                 return true;
             } else if (errno != EAGAIN && errno != EWOULDBLOCK)
                 check(n, "write");
@@ -313,13 +754,15 @@ class pollable_engine : public pollable {
         return false;
     }
 
-    bool read() {
-        if (engine_.read_buffer().size) {
-            ssize_t n = ::read(fd_, engine_.read_buffer().data, engine_.read_buffer().size);
+    bool read(size_t& budget) {
+        size_t size = std::min(engine_.read_buffer().size, budget);
+        if (size) {
+            ssize_t n = ::read(fd_, engine_.read_buffer().data, size);
             while (n == EINTR)
-                n = ::read(fd_, engine_.read_buffer().data, engine_.read_buffer().size);
+                n = ::read(fd_, engine_.read_buffer().data, size);
             if (n > 0) {
                 engine_.read_done(n);
+                budget -= n;
                 return true;
             }
             else if (n == 0)
@@ -332,36 +775,89 @@ class pollable_engine : public pollable {
 
     proton::io::connection_engine engine_;
     std::shared_ptr<work_queue> queue_;
+    std::shared_ptr<admission> admission_; // Until the handshake is done
 };
 
+pollable_engine::pollable_engine(
+    proton::handler* h, proton::connection_options opts, epoll_controller& c,
+    unique_fd& fd, worker& w, worker& home, std::shared_ptr<admission> adm
+) : pollable(fd.release(), w, &home),
+    engine_(*h, opts),
+    queue_(new work_queue(*this, c)),
+    admission_(adm)
+{
+    engine_.work_queue(queue_.get());
+}
+
+pollable_engine::~pollable_engine() {
+    --home_->connections;
+    if (admission_)
+        admission_->handshake_done();
+    queue_->close();               // No calls to notify() after this.
+    engine_.dispatch();            // Run any final events.
+    size_t budget = turn_bytes;
+    try { write(budget); } catch(...) {} // Write connection close if we can.
+    for (auto f : queue_->pop_all()) {// Run final queued work for side-effects.
+        try { f(); } catch(...) {}
+    }
+}
+
 // A pollable listener fd that creates pollable_engine for incoming connections.
+//
+// Each turn accepts until the listen queue is empty, up to max_accepts so
+// one busy listener cannot hold a thread indefinitely. Connections over the
+// connection_options::admission() limits are closed as soon as they are accepted.
 class pollable_listener : public pollable {
   public:
     pollable_listener(
         const std::string& addr,
         std::function<proton::handler*(const std::string&)> factory,
-        int epoll_fd,
+        worker& w,
         epoll_controller& c,
         const proton::connection_options& opts
     ) :
-        pollable(listen(addr), epoll_fd),
+        pollable(listen(addr), w),
         addr_(addr),
         factory_(factory),
         controller_(c),
         opts_(opts)
-    {}
+    {
+        if (opts.admission().limited())
+            admission_.reset(new admission(opts.admission()));
+    }
 
     uint32_t work(uint32_t events) {
         if (events & EPOLLRDHUP)
             return 0;
-        int accepted = check(::accept(fd_, NULL, 0), "accept");
-        controller_.add_engine(factory_(addr_), opts_, accepted);
-        return EPOLLIN;
+        for (int i = 0; i < max_accepts; ++i) {
+            int accepted = ::accept4(fd_, NULL, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (accepted < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return EPOLLIN; // Queue is empty, wait for more.
+                // The connection went away before we got to it, try the next.
+                if (errno == ECONNABORTED || errno == EINTR)
+                    continue;
+                check(accepted, "accept");
+            }
+            if (admission_ && !admission_->admit()) {
+                ::close(accepted); // Over the limit, the client will retry.
+                continue;
+            }
+            int cpu = -1;
+#ifdef SO_INCOMING_CPU
+            ::socklen_t len = sizeof(cpu);
+            if (::getsockopt(accepted, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0)
+                cpu = -1;
+#endif
+            controller_.add_engine(factory_(addr_), opts_, accepted, admission_, cpu);
+        }
+        return again;           // Hit max_accepts, there may be more.
     }
 
     std::string addr() { return addr_; }
 
   private:
+    static const int max_accepts = 64;
 
     int listen(const std::string& addr) {
         std::string msg = "listen on "+addr;
@@ -370,7 +866,7 @@ class pollable_listener : public pollable {
         int yes = 1;
         check(::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)), msg);
         check(::bind(fd, ainfo->ai_addr, ainfo->ai_addrlen), msg);
-        check(::listen(fd, 32), msg);
+        check(::listen(fd, SOMAXCONN), msg);
         return fd.release();
     }
 
@@ -378,14 +874,17 @@ class pollable_listener : public pollable {
     std::function<proton::handler*(const std::string&)> factory_;
     epoll_controller& controller_;
     proton::connection_options opts_;
+    std::shared_ptr<admission> admission_;
 };
 
 
 epoll_controller::epoll_controller()
-    : epoll_fd_(check(epoll_create(1), "epoll_create")),
+    : next_worker_(0),
       interrupt_fd_(check(eventfd(1, 0), "eventfd")),
-      stopping_(false), threads_(0)
-{}
+      stopping_(false), interrupted_(false), threads_(0), connecting_(0)
+{
+    workers_.emplace_back(new worker(0, -1, *this));
+}
 
 epoll_controller::~epoll_controller() {
     try {
@@ -394,13 +893,74 @@ epoll_controller::~epoll_controller() {
     } catch (...) {}
 }
 
-void epoll_controller::add_engine(proton::handler* h, proton::connection_options opts, int fd) {
+void epoll_controller::add_engine(proton::handler* h, proton::connection_options opts, int fd,
+                                  std::shared_ptr<admission> adm, int cpu) {
+    {
+        lock_guard g(lock_);
+        if (stopping_) {
+            ::close(fd);
+            throw proton::error("controller is stopping");
+        }
+        ++connecting_;
+    }
+    place(pending{h, opts, fd, adm}, cpu);
+}
+
+// Give p a home worker, and hand it to a worker that can build it now.
+void epoll_controller::place(pending p, int cpu) {
+    worker& home = choose(cpu);
+    p.home = &home;
+    host(home).push(std::move(p));
+}
+
+// The worker pinned to cpu, otherwise the one with the fewest connections,
+// whether or not it has a thread yet.
+worker& epoll_controller::choose(int cpu) {
+    worker* best = workers_[0].get();
+    for (auto& w : workers_) {
+        if (cpu >= 0 && w->cpu == cpu) {
+            best = w.get();
+            break;
+        }
+        if (w->connections < best->connections)
+            best = w.get();
+    }
+    ++best->connections;
+    return *best;
+}
+
+// Home if it has a thread, otherwise a worker that does. Threads are dealt
+// out in order, so the first worker has one if any does.
+worker& epoll_controller::host(worker& home) {
+    if (home.threads)
+        return home;
+    for (auto& w : workers_)
+        if (w->threads)
+            return *w;
+    return *workers_[0];
+}
+
+// Called on a thread of w to build a connection from add_engine() or
+// connected(), or to report a failed connect.
+void epoll_controller::build(worker& w, pending& p) {
+    if (p.fd < 0)
+        fail(p.handler, p.opts, p.err);
+    else try {
+        unique_fd fd(p.fd);     // Closed here until the engine owns it.
+        std::unique_ptr<pollable_engine> e(
+            new pollable_engine(p.handler, p.opts, *this, fd, w, *p.home, p.adm));
+        lock_guard g(lock_);
+        e->notify();
+        engines_[e.get()] = std::move(e);
+        --connecting_;
+        return;
+    } catch (const std::exception& e) {
+        fail(p.handler, p.opts, e.what());
+    }
+    --p.home->connections;
     lock_guard g(lock_);
-    if (stopping_)
-        throw proton::error("controller is stopping");
-    std::unique_ptr<pollable_engine> e(new pollable_engine(h, opts, *this, fd, epoll_fd_));
-    e->notify();
-    engines_[e.get()] = std::move(e);
+    --connecting_;
+    idle_check(g);
 }
 
 void epoll_controller::erase(pollable* e) {
@@ -414,7 +974,7 @@ void epoll_controller::erase(pollable* e) {
 }
 
 void epoll_controller::idle_check(const lock_guard&) {
-    if (stopping_  && engines_.empty() && listeners_.empty())
+    if (stopping_  && engines_.empty() && listeners_.empty() && !connecting_)
         interrupt();
 }
 
@@ -422,11 +982,47 @@ void epoll_controller::connect(const std::string& addr,
                                proton::handler& h,
                                const proton::connection_options& opts)
 {
-    std::string msg = "connect to "+addr;
-    unique_addrinfo ainfo(addr);
-    unique_fd fd(check(::socket(ainfo->ai_family, SOCK_STREAM, 0), msg));
-    check(::connect(fd, ainfo->ai_addr, ainfo->ai_addrlen), msg);
-    add_engine(&h, options().update(opts), fd.release());
+    proton::connection_options o = options().update(opts);
+    proton::handler* hp = &h;
+    {
+        lock_guard g(lock_);
+        if (stopping_)
+            throw proton::error("controller is stopping");
+        ++connecting_;
+    }
+    try {
+        connector_.connect(addr, [this, hp, o](int fd, const std::string& err) {
+                connected(hp, o, fd, err);
+            });
+    } catch (...) {
+        lock_guard g(lock_);
+        --connecting_;
+        idle_check(g);
+        throw;
+    }
+}
+
+// Called on a connector thread when an outgoing connection completes or
+// fails. Either way a worker thread takes it from here, so the handler is
+// never called on the connector thread. Still counted in connecting_.
+void epoll_controller::connected(proton::handler* h, const proton::connection_options& opts,
+                                 int fd, const std::string& err)
+{
+    place(pending{h, opts, fd, nullptr, err}, -1);
+}
+
+// Report the failure to the handler like any other transport error,
+// which is only delivered for a locally open connection. Called where
+// nothing else can be calling the handler: on a worker thread, or in
+// wait() once they have all returned.
+void epoll_controller::fail(proton::handler* h, const proton::connection_options& opts,
+                            const std::string& err)
+{
+    proton::io::connection_engine engine(*h, opts);
+    engine.connection().open();
+    engine.close(proton::error_condition("proton:io", err));
+    while (engine.dispatch())
+        ;
 }
 
 void epoll_controller::listen(const std::string& addr,
@@ -439,7 +1035,8 @@ void epoll_controller::listen(const std::string& addr,
     if (stopping_)
         throw proton::error("controller is stopping");
     auto& l = listeners_[addr];
-    l.reset(new pollable_listener(addr, factory, epoll_fd_, *this, options_.update(opts)));
+    // Accepted connections are handed to the other workers from here.
+    l.reset(new pollable_listener(addr, factory, *workers_[0], *this, options_.update(opts)));
     l->notify();
 }
 
@@ -460,24 +1057,94 @@ proton::connection_options epoll_controller::options() {
 }
 
 void epoll_controller::run() {
+    worker& w = *workers_[next_worker_++ % workers_.size()];
+    if (w.cpu >= 0)
+        pin_thread(w.cpu);
     ++threads_;
+    ++w.threads;
     try {
-        epoll_event e;
+        epoll_event events[max_events];
+        size_t turns = 0;
         while(true) {
-            check(::epoll_wait(epoll_fd_, &e, 1, -1), "epoll_wait");
-            pollable* p = reinterpret_cast<pollable*>(e.data.ptr);
+            pollable* p = w.pop();
             if (!p)
-                break;          // Interrupted
-            if (!p->do_work(e.events))
+                p = steal(w);
+            bool sleep = !p && !(p = w.pop_or_sleep());
+            // Block when there is nothing to do, otherwise look for newly
+            // ready fds every poll_turns so queued work cannot starve them.
+            if (sleep || ++turns % poll_turns == 0) {
+                int n = ::epoll_wait(w.epoll_fd, events, max_events, sleep ? -1 : 0);
+                if (sleep)
+                    --w.sleeping;
+                if (!dispatch(w, events, check(n, "epoll_wait")))
+                    break;      // Interrupted
+            }
+            if (p && !p->do_work())
                 erase(p);
         }
     } catch (const std::exception& e) {
         stop(proton::error_condition("exception", e.what()));
     }
+    --w.threads;
+    lock_guard g(lock_);
     if (--threads_ == 0)
         stopped_.notify_all();
 }
 
+// Queue the pollables epoll reported, build new connections.
+// Returns false if the controller was interrupted.
+bool epoll_controller::dispatch(worker& w, const epoll_event* events, int n) {
+    for (int i = 0; i < n; ++i) {
+        if (events[i].data.u64 == worker::wake_mark) {
+            for (auto& p : w.pop_inbox())
+                build(w, p);
+        } else if (!events[i].data.ptr) {
+            return false;
+        } else {
+            reinterpret_cast<pollable*>(events[i].data.ptr)->ready(events[i].events);
+        }
+    }
+    return true;
+}
+
+// Called when w has a backlog with all its threads busy. Wake a sleeping
+// thread of another worker, which will look for work to steal.
+void epoll_controller::backlog(worker& w) {
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        worker& other = *workers_[(w.index + i) % workers_.size()];
+        if (other.sleeping) {
+            other.wake();
+            return;
+        }
+    }
+}
+
+// Called when thief has run out of work. Take the last ready connection
+// from a worker whose threads are all busy. The connection stays with its
+// worker: when the turn is over it is queued or re-armed there.
+pollable* epoll_controller::steal(worker& thief) {
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        pollable* p = workers_[(thief.index + i) % workers_.size()]->steal();
+        if (p)
+            return p;
+    }
+    return nullptr;
+}
+
+void epoll_controller::workers(size_t n, bool pin) {
+    lock_guard g(lock_);
+    if (threads_ || !engines_.empty() || !listeners_.empty() || connecting_ || interrupted_)
+        throw proton::error("workers() must be called before run(), connect() or listen()");
+    if (!n)
+        n = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> cpus;
+    if (pin)
+        cpus = allowed_cpus();
+    workers_.clear();
+    for (size_t i = 0; i < n; ++i)
+        workers_.emplace_back(new worker(i, cpus.empty() ? -1 : cpus[i % cpus.size()], *this));
+}
+
 void epoll_controller::stop_on_idle() {
     lock_guard g(lock_);
     stopping_ = true;
@@ -492,7 +1159,18 @@ void epoll_controller::stop(const proton::error_condition& err) {
 
 void epoll_controller::wait() {
     std::unique_lock<std::mutex> l(lock_);
-    stopped_.wait(l, [this]() { return this->threads_ == 0; } );
+    // Threads may not have started yet, so wait for the interrupt as well.
+    stopped_.wait(l, [this]() { return this->interrupted_ && this->threads_ == 0; } );
+    l.unlock();
+    connector_.stop();          // Outstanding connects fail, may need the lock.
+    l.lock();
+    for (auto& w : workers_)
+        for (auto& p : w->pop_inbox()) { // Never built
+            if (p.fd >= 0)
+                ::close(p.fd);
+            else
+                fail(p.handler, p.opts, p.err);
+        }
     for (auto& eng : engines_)
         eng.second->close(stop_err_);
     listeners_.clear();
@@ -500,10 +1178,14 @@ void epoll_controller::wait() {
 }
 
 void epoll_controller::interrupt() {
+    if (interrupted_)
+        return;
+    interrupted_ = true;
     // Add an always-readable fd with 0 data and no ONESHOT to interrupt all threads.
     epoll_event ev = {};
     ev.events = EPOLLIN;
-    check(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, interrupt_fd_, &ev), "interrupt");
+    for (auto& w : workers_)
+        check(epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, interrupt_fd_, &ev), "interrupt");
 }
 
 // Register make_epoll_controller() as proton::controller::create().
@@ -0,0 +1,75 @@
+#ifndef PROTON_ADMISSION_LIMITER_HPP
+#define PROTON_ADMISSION_LIMITER_HPP
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <proton/export.hpp>
+#include <proton/timestamp.hpp>
+#include <proton/type_compat.h>
+
+namespace proton {
+
+/// Limits the rate at which a listener accepts new connections, and
+/// the number of accepted connections that are still handshaking
+/// (SASL, SSL/TLS and the AMQP open). Connections over the limit are
+/// refused, so when many clients reconnect at once the server works
+/// through them at a pace it can sustain.
+///
+/// The rate is a token bucket: each accepted connection takes a token,
+/// tokens are added at rate per second up to burst.
+///
+/// Set the limits for a listener with connection_options::admission().
+/// Each listener keeps its own count, starting with a full bucket.
+/// Not thread safe.
+class admission_limiter {
+  public:
+    /// No limits.
+    PN_CPP_EXTERN admission_limiter();
+
+    /// @param rate new connections per second, 0 for no limit.
+    /// @param burst connections that can be accepted together after a
+    /// quiet spell, at least 1.
+    /// @param max_handshakes connections handshaking at once, 0 for no limit.
+    PN_CPP_EXTERN admission_limiter(uint32_t rate, uint32_t burst, uint32_t max_handshakes = 0);
+
+    /// Ask to accept a connection at time now. If true it counts as
+    /// handshaking until handshake_done() is called for it.
+    PN_CPP_EXTERN bool admit(timestamp now);
+
+    /// An admitted connection finished its handshake or closed.
+    PN_CPP_EXTERN void handshake_done();
+
+    /// Connections admitted and not yet done.
+    uint32_t handshakes() const { return handshakes_; }
+
+    /// True if there is any limit.
+    bool limited() const { return rate_ || max_handshakes_; }
+
+  private:
+    uint32_t rate_;
+    uint32_t burst_;
+    uint32_t max_handshakes_;
+    uint32_t handshakes_;
+    uint64_t tokens_;           // In thousandths of a connection
+    timestamp last_;
+};
+
+}
+
+#endif // PROTON_ADMISSION_LIMITER_HPP
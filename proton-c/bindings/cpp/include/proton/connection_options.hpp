@@ -22,6 +22,7 @@
  *
  */
 
+#include <proton/admission_limiter.hpp>
 #include <proton/config.hpp>
 #include <proton/export.hpp>
 #include <proton/duration.hpp>
@@ -133,6 +134,15 @@ class connection_options {
     PN_CPP_EXTERN connection_options& sasl_config_path(const std::string &);
     /// @endcond
 
+    /// Limit the connections accepted by a listener, see
+    /// admission_limiter. Only used by listeners, each one keeps its
+    /// own count.
+    PN_CPP_EXTERN connection_options& admission(const admission_limiter &);
+
+    /// The admission limits, no limits if not set. For use by
+    /// implementations of proton::controller.
+    PN_CPP_EXTERN admission_limiter admission() const;
+
     /// Update option values from values set in other.
     PN_CPP_EXTERN connection_options& update(const connection_options& other);
 
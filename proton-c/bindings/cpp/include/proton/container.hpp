@@ -89,8 +89,63 @@ class container {
 
     /// Start processing events. It returns when all connections and
     /// acceptors are closed.
+    ///
+    /// With more than one thread, see threads(), the calling thread
+    /// runs the first shard and the others are started and joined by
+    /// run(). It returns when every shard has no connections,
+    /// acceptors, timers or queued work left. An exception thrown by a
+    /// handler on any thread stops all of them and is rethrown here.
     PN_CPP_EXTERN void run();
 
+    /// How connections opened outside a handler are spread over the
+    /// threads of the container, see threads().
+    enum placement {
+        LEAST_LOADED,           ///< The thread with the fewest connections.
+        BY_HASH                 ///< A hash of the URL host and port.
+    };
+
+    /// Run the container on `n` threads, each with its own event loop
+    /// and its own share (shard) of the connections. A connection
+    /// stays on its shard for its whole life, so all of its events,
+    /// and the handlers called for them, run on one thread.
+    ///
+    /// handler::on_container_start() is called once, on the first
+    /// thread, before the other threads start. What it does counts as
+    /// done before run():
+    ///
+    /// - connect(), open_sender() and open_receiver() called before
+    ///   run() place the connection by `p`. Called from any other
+    ///   handler they open it on the handler's own thread.
+    ///
+    /// - listen() called before run() listens on every thread, sharing
+    ///   the port with SO_REUSEPORT so the kernel spreads incoming
+    ///   connections between them, each with its own admission_limiter.
+    ///   Where that is not supported, or for port 0, only the first
+    ///   thread listens. Called from any other handler it listens on
+    ///   the handler's thread. Closing the returned acceptor, from
+    ///   any handler, closes them all.
+    ///
+    /// - schedule() runs the timer on the first thread when called
+    ///   before run(), otherwise on the calling handler's thread.
+    ///
+    /// Handlers are called concurrently on different threads, so a
+    /// handler shared by connections on different threads must be
+    /// thread safe. To act on a connection from another thread, push
+    /// the work to it with work_queue::get(connection). While the
+    /// container runs, only its own threads may call connect(),
+    /// listen() and schedule(); with C++11 any other thread gets
+    /// proton::error.
+    ///
+    /// Must be called before anything is connected, listened to or
+    /// scheduled.
+    ///
+    /// @throw proton::error if it is too late, if `n` is 0, or if
+    /// `n` is more than 1 and the library was built without C++11.
+    PN_CPP_EXTERN void threads(size_t n, placement p = LEAST_LOADED);
+
+    /// The number of threads the container runs on.
+    PN_CPP_EXTERN size_t threads() const;
+
     /// Open a connection to `url` and open a sender for `url.path()`.
     /// Any supplied sender or connection options will override the
     /// container's template options.
@@ -149,6 +204,7 @@ class container {
   private:
     internal::pn_unique_ptr<container_impl> impl_;
 
+    friend class acceptor;
     friend class connector;
     friend class messaging_adapter;
     friend class receiver_options;
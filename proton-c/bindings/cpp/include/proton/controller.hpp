@@ -44,7 +44,7 @@ class connection;
 /// the last is handler::on_transport_close(). Handlers can be deleted after
 /// handler::on_transport_close().
 ///
-class controller {
+class PN_CPP_CLASS_EXTERN controller {
   public:
     /// Create an instance of the default controller implementation.
     /// @param container_id set on connections for this controller.
@@ -71,6 +71,10 @@ class controller {
     /// Calls to the factory for this address are serialized. Calls for separate
     /// addresses in separate calls to listen() may be concurrent.
     ///
+    /// Set connection_options::admission() to limit the rate of new
+    /// connections and the number handshaking at once, connections over
+    /// the limits are closed without calling make_handler.
+    ///
     virtual void listen(
         const std::string& address,
         std::function<proton::handler*(const std::string&)> make_handler,
@@ -97,6 +101,31 @@ class controller {
     /// stopped.  Multiple threads can call run()
     virtual void run() = 0;
 
+    /// Split the connections between `n` workers, 0 for one per CPU.
+    /// The threads that call run() are dealt out to the workers in
+    /// turn. A connection belongs to one worker, which creates it and
+    /// serves it from then on, so its state stays in the caches (and
+    /// the memory node) of that worker's CPU. A worker with nothing to
+    /// do serves connections of another only while all of that
+    /// worker's threads are busy.
+    ///
+    /// A connection whose worker has no thread in run() yet is served
+    /// by one that has, and moves to its own worker at the end of a turn
+    /// once that worker's thread starts. If fewer threads than workers
+    /// call run(), the others serve the connections of the extra workers.
+    ///
+    /// With `pin` each worker's threads are bound to one CPU, in
+    /// order. Incoming connections then go to the worker pinned to the
+    /// CPU that received them (SO_INCOMING_CPU) where the platform
+    /// supports it, others to the worker with the fewest connections.
+    ///
+    /// Without a call to workers(), every thread serves every connection.
+    /// The default implementation ignores the call, for controllers
+    /// that do not split their connections.
+    ///
+    /// @throw proton::error if called after run(), connect() or listen().
+    PN_CPP_EXTERN virtual void workers(size_t n, bool pin = false);
+
     /// Stop the controller: abort open connections, run() will return in all threads.
     /// Handlers will receive on_transport_error() with the error_condition.
     virtual void stop(const error_condition& = error_condition()) = 0;
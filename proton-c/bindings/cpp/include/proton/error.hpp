@@ -24,7 +24,6 @@
 
 #include <proton/config.hpp>
 #include <proton/export.hpp>
-#include <proton/value.hpp>
 
 #include <stdexcept>
 #include <string>
@@ -26,6 +26,8 @@
 
 #include "proton/pn_unique_ptr.hpp"
 
+#include <vector>
+
 namespace proton {
 
 class error_condition;
@@ -133,6 +135,10 @@ PN_CPP_CLASS_EXTERN handler
     PN_CPP_EXTERN virtual void on_tracker_release(tracker &d);
     /// The receiving peer settled a transfer.
     PN_CPP_EXTERN virtual void on_tracker_settle(tracker &d);
+    /// The receiving peer settled a range of transfers with a single
+    /// disposition, on a sender with sender_options::bulk_settle set.
+    /// The default calls on_tracker_settle() for each.
+    PN_CPP_EXTERN virtual void on_delivery_settle_range(sender &s, const std::vector<tracker> &settled);
     /// The sending peer settled a transfer.
     PN_CPP_EXTERN virtual void on_delivery_settle(delivery &d);
 
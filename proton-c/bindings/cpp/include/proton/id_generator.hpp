@@ -0,0 +1,64 @@
+#ifndef PROTON_ID_GENERATOR_HPP
+#define PROTON_ID_GENERATOR_HPP
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <proton/export.hpp>
+#include <proton/type_compat.h>
+
+#include <string>
+
+namespace proton {
+
+/// Generates identifiers made of a fixed prefix and a count in hex,
+/// unique for the life of the generator. Used by the library to name
+/// links and connections.
+///
+/// next() is lock-free and can be called from any thread. Set the
+/// prefix before sharing the generator between threads.
+class id_generator {
+  public:
+    /// Ids start at prefix + "1".
+    PN_CPP_EXTERN id_generator(const std::string &prefix=std::string());
+
+    /// Return the next id.
+    PN_CPP_EXTERN std::string next();
+
+    /// Write the next id to buf, null terminated, without allocating.
+    ///
+    /// @return the length of the id, or 0 if a buffer of size bytes
+    /// might be too small, see max_size(). No id is used up in that case.
+    PN_CPP_EXTERN size_t next(char* buf, size_t size);
+
+    /// The size of buffer next(char*, size_t) always succeeds with,
+    /// including the null.
+    size_t max_size() const { return prefix_.size() + 2 * sizeof(uint64_t) + 1; }
+
+    /// Set the prefix, not thread safe.
+    void prefix(const std::string &p) { prefix_ = p; }
+    const std::string& prefix() const { return prefix_; } ///< The prefix
+
+  private:
+    std::string prefix_;
+    uint64_t count_;
+};
+
+}
+
+#endif // PROTON_ID_GENERATOR_HPP
@@ -0,0 +1,93 @@
+#ifndef PROTON_IO_CONNECTION_ENGINE_PAIR_HPP
+#define PROTON_IO_CONNECTION_ENGINE_PAIR_HPP
+
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "proton/duration.hpp"
+#include "proton/export.hpp"
+#include "proton/timestamp.hpp"
+
+#include <cstddef>
+
+struct pn_transport_pair_t;
+
+namespace proton {
+namespace io {
+
+class connection_engine;
+
+/// Two connection_engines connected to each other in memory.
+///
+/// Bytes written by either engine are handed to the other with no IO,
+/// for testing and benchmarking an application's handlers and the
+/// protocol engine on their own. The link between the engines can be
+/// given a latency, a bandwidth and a largest segment size.
+///
+/// The pair keeps its own clock, which only moves when advance() is
+/// called, so a run does the same thing every time whatever the speed
+/// of the machine. See pn_transport_pair_t for details.
+///
+/// The engines must outlive the pair.
+class
+PN_CPP_CLASS_EXTERN connection_engine_pair {
+  public:
+    /// Connect engines a and b.
+    PN_CPP_EXTERN connection_engine_pair(connection_engine& a, connection_engine& b);
+    PN_CPP_EXTERN ~connection_engine_pair();
+
+    /// Set the time bytes take to cross the link, in each direction.
+    PN_CPP_EXTERN void latency(duration);
+
+    /// Limit the rate bytes cross the link in each direction, 0 for no limit.
+    PN_CPP_EXTERN void bandwidth(size_t bytes_per_second);
+
+    /// Limit the bytes handed over at a time, 0 for no limit.
+    PN_CPP_EXTERN void segment_size(size_t);
+
+    /// The pair's clock.
+    PN_CPP_EXTERN timestamp now() const;
+
+    /// When bytes in flight next arrive or a timer fires, 0 if never.
+    PN_CPP_EXTERN timestamp deadline() const;
+
+    /// Bytes sent by either engine not yet handed to the other.
+    PN_CPP_EXTERN size_t in_flight() const;
+
+    /// Dispatch events on both engines and move bytes between them
+    /// until neither has anything more to do at the current time.
+    ///
+    /// Returns true if either engine is still active.
+    PN_CPP_EXTERN bool process();
+
+    /// Move the clock forward, run the engines' timers and process().
+    PN_CPP_EXTERN bool advance(duration);
+
+  private:
+    connection_engine_pair(const connection_engine_pair&);
+    connection_engine_pair& operator=(const connection_engine_pair&);
+
+    connection_engine& a_;
+    connection_engine& b_;
+    pn_transport_pair_t* pair_;
+};
+
+}}
+
+#endif // PROTON_IO_CONNECTION_ENGINE_PAIR_HPP
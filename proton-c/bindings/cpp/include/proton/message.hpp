@@ -28,6 +28,7 @@
 #include <proton/export.hpp>
 #include <proton/message_id.hpp>
 #include <proton/pn_unique_ptr.hpp>
+#include <proton/string_view.hpp>
 #include <proton/value.hpp>
 
 #include <string>
@@ -238,13 +239,52 @@ class message {
 
     /// @}
 
+    /// @name Views
+    ///
+    /// Look at a string field without copying it. The view refers to
+    /// the message's own storage and is valid until the field is set,
+    /// the message is cleared, assigned or decoded into, or the message
+    /// is destroyed. An unset field gives an empty view.
+    ///
+    /// @{
+
+    PN_CPP_EXTERN string_view user_view() const;
+    PN_CPP_EXTERN string_view to_view() const;
+    PN_CPP_EXTERN string_view reply_to_view() const;
+    PN_CPP_EXTERN string_view subject_view() const;
+    PN_CPP_EXTERN string_view content_type_view() const;
+    PN_CPP_EXTERN string_view content_encoding_view() const;
+    PN_CPP_EXTERN string_view group_id_view() const;
+    PN_CPP_EXTERN string_view reply_to_group_id_view() const;
+
+    /// @}
+
     /// @name Extended attributes
     /// @{
 
     /// Application properties map, can be modified in place.
+    ///
+    /// The first call decodes every property, prefer property() to
+    /// look at or change just a few of them.
     PN_CPP_EXTERN property_map& properties();
     PN_CPP_EXTERN const property_map& properties() const;
 
+    /// Get one application property without decoding the others.
+    ///
+    /// @return the value, or an empty scalar if there is no such property
+    PN_CPP_EXTERN scalar property(const string_view& key) const;
+
+    /// True if there is an application property called key.
+    PN_CPP_EXTERN bool has_property(const string_view& key) const;
+
+    /// Set one application property without decoding the others.
+    /// The change is merged into the encoded properties when the
+    /// message is encoded.
+    PN_CPP_EXTERN void property(const std::string& key, const scalar& value);
+
+    /// Remove one application property, false if there was none.
+    PN_CPP_EXTERN bool remove_property(const string_view& key);
+
     /// Message annotations map, can be modified in place.
     PN_CPP_EXTERN annotation_map& message_annotations();
     PN_CPP_EXTERN const annotation_map& message_annotations() const;
@@ -265,6 +305,20 @@ class message {
     mutable annotation_map message_annotations_;
     mutable annotation_map delivery_annotations_;
 
+    // Properties set or removed by key while the encoded map is the
+    // authority, see MAP CACHING in message.cpp.
+    struct property_edit {
+        std::string key;
+        scalar value;
+        bool removed;
+    };
+    typedef std::vector<property_edit> property_edits;
+    mutable property_edits property_edits_;
+
+    const property_edit* find_edit(const string_view& key) const;
+    void apply_property_edits() const;
+    void encode_property_edits() const;
+
     /// Decode the message corresponding to a delivery from a link.
     void decode(proton::delivery);
 
@@ -37,10 +37,24 @@ namespace proton {
 class reconnect_timer
 {
   public:
-    /** TODO:
+    /** Create a timer.
+     *
+     * @param first delay before the first attempt, in milliseconds
+     * @param max longest delay, -1 for no limit
+     * @param increment added to the first delay for the second attempt,
+     * and to each delay after that unless doubling
+     * @param doubling double each delay after the second instead of adding increment
+     * @param max_retries most attempts, -1 for no limit
+     * @param timeout milliseconds from the first attempt after which to give up, -1 for never
+     * @param jitter randomize the delays so that clients that lost their
+     * connections at the same moment do not all retry at the same moments
+     * ("decorrelated jitter"). The first delay is picked between 0 and
+     * first, each later one between increment and three times the one
+     * before, and doubling is ignored.
      */
     PN_CPP_EXTERN reconnect_timer(uint32_t first = 0, int32_t max = -1, uint32_t increment = 100,
-                                  bool doubling = true, int32_t max_retries = -1, int32_t timeout = -1);
+                                  bool doubling = true, int32_t max_retries = -1, int32_t timeout = -1,
+                                  bool jitter = false);
 
     /** Indicate a successful connection, resetting the internal timer values */
     PN_CPP_EXTERN void reset();
@@ -53,6 +67,7 @@ class reconnect_timer
     duration max_delay_;
     duration increment_;
     bool doubling_;
+    bool jitter_;
     int32_t max_retries_;
     duration timeout_;
     int32_t retries_;
@@ -25,6 +25,7 @@
 #include <proton/decimal.hpp>
 #include <proton/error.hpp>
 #include <proton/export.hpp>
+#include <proton/string_view.hpp>
 #include <proton/symbol.hpp>
 #include <proton/timestamp.hpp>
 #include <proton/type_id.hpp>
@@ -45,6 +46,8 @@ class encoder;
 
 namespace internal {
 
+class value_base;
+
 /// Base class for scalar types.
 class scalar_base : private comparable<scalar_base> {
   public:
@@ -69,6 +72,7 @@ class scalar_base : private comparable<scalar_base> {
     PN_CPP_EXTERN scalar_base();
     PN_CPP_EXTERN scalar_base(const scalar_base&);
     PN_CPP_EXTERN scalar_base& operator=(const scalar_base&);
+    PN_CPP_EXTERN ~scalar_base();
 
     PN_CPP_EXTERN void put_(bool);
     PN_CPP_EXTERN void put_(uint8_t);
@@ -91,6 +95,7 @@ class scalar_base : private comparable<scalar_base> {
     PN_CPP_EXTERN void put_(const symbol&);
     PN_CPP_EXTERN void put_(const binary&);
     PN_CPP_EXTERN void put_(const char* s); ///< Treated as an AMQP string
+    PN_CPP_EXTERN void put_(const string_view&); ///< Treated as an AMQP string
     PN_CPP_EXTERN void put_(const null&);
 
     PN_CPP_EXTERN void get_(bool&) const;
@@ -113,19 +118,26 @@ class scalar_base : private comparable<scalar_base> {
     PN_CPP_EXTERN void get_(std::string&) const;
     PN_CPP_EXTERN void get_(symbol&) const;
     PN_CPP_EXTERN void get_(binary&) const;
+    PN_CPP_EXTERN void get_(string_view&) const; ///< Any string-like type, valid until the scalar changes
     PN_CPP_EXTERN void get_(null&) const;
 
   private:
     void ok(pn_type_t) const;
     void set(const pn_atom_t&);
-    void set(const binary& x, pn_type_t t);
+    void set(const char* start, size_t size, pn_type_t t);
 
+    // String-like data is held in small_ if it fits, saving an
+    // allocation for the short strings and symbols that make up most
+    // keys and properties, otherwise in heap_, which is kept for reuse.
     pn_atom_t atom_;
-    binary bytes_;              // Hold binary data.
+    char* heap_;
+    size_t heap_size_;
+    char small_[24];
 
   friend class proton::message;
   friend class codec::encoder;
   friend class codec::decoder;
+  friend class value_base;
 };
 
 template<class T> T get(const scalar_base& s) { T x; s.get(x); return x; }
@@ -86,6 +86,11 @@ class sender_options {
     /// Automatically settle messages (default value: true).
     PN_CPP_EXTERN sender_options& auto_settle(bool);
 
+    /// Report messages the receiver settles with one disposition
+    /// together, through handler::on_delivery_settle_range (default
+    /// value: false).
+    PN_CPP_EXTERN sender_options& bulk_settle(bool);
+
     /// Options for the source node of the sender.
     PN_CPP_EXTERN sender_options& source(source_options &);
 
@@ -128,6 +128,12 @@ class ssl_domain {
     PN_CPP_EXTERN ssl_domain& operator=(const ssl_domain&);
     PN_CPP_EXTERN ~ssl_domain();
 
+    /// Number of handshakes that resumed a previous session.
+    PN_CPP_EXTERN uint64_t session_hits() const;
+
+    /// Number of full handshakes that could have resumed a session.
+    PN_CPP_EXTERN uint64_t session_misses() const;
+
   protected:
     ssl_domain(bool is_server);
     pn_ssl_domain_t *pn_domain();
@@ -156,6 +162,9 @@ class ssl_server_options : private internal::ssl_domain {
     /// suites on the platform.
     PN_CPP_EXTERN ssl_server_options();
 
+    using internal::ssl_domain::session_hits;
+    using internal::ssl_domain::session_misses;
+
   private:
     // Bring pn_domain into scope and allow connection_options to use
     // it.
@@ -181,6 +190,9 @@ class ssl_client_options : private internal::ssl_domain {
     /// suites on the platform.
     PN_CPP_EXTERN ssl_client_options();
 
+    using internal::ssl_domain::session_hits;
+    using internal::ssl_domain::session_misses;
+
   private:
     // Bring pn_domain into scope and allow connection_options to use
     // it.
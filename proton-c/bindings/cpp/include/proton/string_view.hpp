@@ -0,0 +1,84 @@
+#ifndef PROTON_STRING_VIEW_HPP
+#define PROTON_STRING_VIEW_HPP
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <proton/comparable.hpp>
+#include <proton/export.hpp>
+#include <proton/types_fwd.hpp>
+
+#include <iosfwd>
+#include <string>
+
+#include <string.h>
+
+namespace proton {
+
+/// A read-only reference to a sequence of characters held elsewhere,
+/// for looking at a string without copying it.
+///
+/// A string_view does not own its characters. It is only valid as long
+/// as whatever it refers to is unchanged, see the functions that return
+/// one for how long that is.
+class string_view : private internal::comparable<string_view> {
+  public:
+    typedef const char* const_iterator; ///< Iterator over the characters
+    typedef const char* iterator;       ///< Iterator over the characters
+
+    ///@name Constructors @{
+    string_view() : data_(0), size_(0) {}
+    string_view(const char* s) : data_(s), size_(s ? ::strlen(s) : 0) {}
+    string_view(const char* s, size_t n) : data_(s), size_(n) {}
+    string_view(const std::string& s) : data_(s.data()), size_(s.size()) {}
+    ///@}
+
+    const char* data() const { return data_; } ///< Characters, not null terminated
+    size_t size() const { return size_; }      ///< Number of characters
+    size_t length() const { return size_; }    ///< Number of characters
+    bool empty() const { return size_ == 0; }  ///< True if size() == 0
+
+    const_iterator begin() const { return data_; } ///< First character
+    const_iterator end() const { return data_ + size_; } ///< One past the last character
+    char operator[](size_t i) const { return data_[i]; } ///< Character at i
+
+    /// Copy the characters to a std::string
+    std::string str() const { return std::string(data_, size_); }
+
+    /// Compare characters
+  friend bool operator==(const string_view& x, const string_view& y) {
+      return x.size_ == y.size_ && (x.size_ == 0 || ::memcmp(x.data_, y.data_, x.size_) == 0);
+  }
+    /// Compare characters, shorter first if one is a prefix of the other
+  friend bool operator<(const string_view& x, const string_view& y) {
+      size_t n = x.size_ < y.size_ ? x.size_ : y.size_;
+      int c = n ? ::memcmp(x.data_, y.data_, n) : 0;
+      return c < 0 || (c == 0 && x.size_ < y.size_);
+  }
+
+  private:
+    const char* data_;
+    size_t size_;
+};
+
+/// Print the characters
+PN_CPP_EXTERN std::ostream& operator<<(std::ostream&, const string_view&);
+
+}
+
+#endif // PROTON_STRING_VIEW_HPP
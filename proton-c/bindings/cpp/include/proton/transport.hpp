@@ -23,6 +23,7 @@
  */
 
 #include "proton/object.hpp"
+#include "proton/transport_metrics.hpp"
 #include "proton/types.hpp"
 #include "proton/export.hpp"
 
@@ -58,6 +59,10 @@ class transport : public internal::object<pn_transport_t> {
     /// Get the error condition.
     PN_CPP_EXTERN class error_condition error() const;
 
+    /// Get a copy of the transport's counters. Unlike the other
+    /// accessors this may be called from any thread.
+    PN_CPP_EXTERN transport_metrics metrics() const;
+
     /// @cond INTERNAL
     friend class internal::factory<transport>;
     /// @endcond
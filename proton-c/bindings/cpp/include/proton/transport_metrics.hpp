@@ -0,0 +1,89 @@
+#ifndef PROTON_CPP_TRANSPORT_METRICS_H
+#define PROTON_CPP_TRANSPORT_METRICS_H
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "proton/export.hpp"
+#include "proton/types_fwd.hpp"
+
+namespace proton {
+
+class transport;
+
+/// A copy of the counters kept by a transport.
+///
+/// Taking the copy does not lock anything, so it may be done from any
+/// thread while the connection is working. Counters copied while the
+/// connection is busy may come from slightly different moments.
+class transport_metrics {
+  public:
+    /// The kinds of frame counted separately.
+    enum performative {
+        OPEN, BEGIN, ATTACH, FLOW, TRANSFER, DISPOSITION, DETACH, END, CLOSE,
+        OTHER ///< SASL, empty (heartbeat) and unrecognised frames
+    };
+
+    /// All counters zero.
+    PN_CPP_EXTERN transport_metrics();
+
+    /// @name Frames and bytes by performative, headers included
+    /// @{
+    uint64_t frames_input(performative p) const { return input_[p].frames; }
+    uint64_t frames_output(performative p) const { return output_[p].frames; }
+    uint64_t bytes_input(performative p) const { return input_[p].bytes; }
+    uint64_t bytes_output(performative p) const { return output_[p].bytes; }
+    /// @}
+
+    uint64_t frames_input() const { return frames_input_; }    ///< All frames read
+    uint64_t frames_output() const { return frames_output_; }  ///< All frames written
+    uint64_t bytes_input() const { return bytes_input_; }      ///< Bytes read, before TLS or SASL
+    uint64_t bytes_output() const { return bytes_output_; }    ///< Bytes written, after TLS or SASL
+    uint64_t bytes_copied() const { return bytes_copied_; }    ///< Bytes moved between the transport's buffers
+    uint64_t output_high_water() const { return output_high_water_; } ///< Most encoded output held at once
+    uint64_t deliveries_sent() const { return deliveries_sent_; }
+    uint64_t deliveries_received() const { return deliveries_received_; }
+    uint64_t deliveries_settled() const { return deliveries_settled_; }
+    uint64_t credit_stalls() const { return credit_stalls_; }  ///< Times a sender ran out of credit
+    uint64_t window_stalls() const { return window_stalls_; }  ///< Times a session window closed
+
+  private:
+    struct frame_counts { uint64_t frames, bytes; };
+    frame_counts input_[OTHER + 1];
+    frame_counts output_[OTHER + 1];
+    uint64_t frames_input_;
+    uint64_t frames_output_;
+    uint64_t bytes_input_;
+    uint64_t bytes_output_;
+    uint64_t bytes_copied_;
+    uint64_t output_high_water_;
+    uint64_t deliveries_sent_;
+    uint64_t deliveries_received_;
+    uint64_t deliveries_settled_;
+    uint64_t credit_stalls_;
+    uint64_t window_stalls_;
+
+    friend class transport;
+};
+
+}
+
+#endif // PROTON_CPP_TRANSPORT_METRICS_H
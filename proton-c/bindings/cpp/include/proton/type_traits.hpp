@@ -114,7 +114,8 @@ template<> struct type_id_of<binary> : public type_id_constant<BINARY, binary> {
 
 /// Metafunction to test if a class has a type_id.
 template <class T, class Enable=void> struct has_type_id : public false_type {};
-template <class T> struct has_type_id<T, typename type_id_of<T>::type>  : public true_type {};
+template <class T> struct has_type_id<T, typename enable_if<is_same<T, typename type_id_of<T>::type>::value>::type>
+    : public true_type {};
 
 // Map arbitrary integral types to known AMQP integral types.
 template<size_t SIZE, bool IS_SIGNED> struct integer_type;
@@ -38,6 +38,7 @@ class decimal128;
 class decimal32;
 class decimal64;
 class scalar;
+class string_view;
 class symbol;
 class timestamp;
 class duration;
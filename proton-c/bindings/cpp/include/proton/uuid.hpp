@@ -35,10 +35,12 @@ class uuid : public byte_array<16> {
     PN_CPP_EXTERN static uuid copy();
     PN_CPP_EXTERN static uuid copy(const char* bytes);
 
-    /// Return a simple randomly-generated UUID. Used by the proton library to
-    /// generate default UUIDs.  For specific security, performance or
-    /// uniqueness requirements you may want to use a better UUID generator or
-    /// some other form of identifier entirely.
+    /// Return a randomly-generated (version 4) UUID. Used by the proton
+    /// library to generate default UUIDs.
+    ///
+    /// Each thread has its own fast pseudo-random generator, seeded from
+    /// the system where possible, so this can be called from any thread
+    /// without locking. It is not suitable for cryptographic use.
     PN_CPP_EXTERN static uuid random();
 
     /// UUID standard string format: 8-4-4-4-12 (36 chars, 32 alphanumeric and 4 hypens)
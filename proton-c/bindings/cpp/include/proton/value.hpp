@@ -22,6 +22,7 @@
 
 #include <proton/encoder.hpp>
 #include <proton/decoder.hpp>
+#include <proton/scalar.hpp>
 #include <proton/type_traits.hpp>
 #include <proton/types_fwd.hpp>
 
@@ -36,6 +37,11 @@ class value_base;
 PN_CPP_EXTERN std::ostream& operator<<(std::ostream& o, const value_base& x);
 
 ///@internal - separate value data from implicit conversion constructors to avoid recursions.
+///
+/// A scalar is held inline in scalar_ and only compound values are
+/// encoded in data_, so most values never allocate a pn_data_t. Once a
+/// value has data_ it keeps using it, since message bodies are values
+/// whose data_ belongs to the message.
 class value_base {
   public:
 
@@ -45,9 +51,19 @@ class value_base {
     /// True if the value is null
     PN_CPP_EXTERN bool empty() const;
 
+    ///@cond INTERNAL
+    /// The value if it is a scalar held inline, else 0.
+    const scalar* held_scalar() const { return scalar_.empty() ? 0 : &scalar_; }
+    ///@endcond
+
   protected:
-    codec::data& data() const;
+    codec::data& data() const;      // Encodes a held scalar into data_
+    codec::data& new_data();        // Clears the value, returns data_ ready to encode
+    codec::data encoded() const;    // data_, or a new data holding the held scalar
+    PN_CPP_EXTERN void put_scalar(const scalar_base&);
+
     mutable class codec::data data_;
+    mutable scalar scalar_;
 
   friend class proton::message;
   friend class codec::encoder;
@@ -55,6 +71,23 @@ class value_base {
   friend PN_CPP_EXTERN std::ostream& operator<<(std::ostream&, const value_base&);
 };
 
+// Get a scalar held inline without decoding, false if it must be decoded.
+template <class T> typename enable_if<has_type_id<T>::value, bool>::type
+get_held(const value_base& v, T& x) {
+    const scalar* s = v.held_scalar();
+    if (s) s->get(x);
+    return s != 0;
+}
+
+inline bool get_held(const value_base& v, scalar& x) {
+    const scalar* s = v.held_scalar();
+    if (s) x = *s;
+    return s != 0;
+}
+
+template <class T> typename enable_if<!has_type_id<T>::value, bool>::type
+get_held(const value_base&, T&) { return false; }
+
 }
 
 
@@ -85,8 +118,7 @@ class value : public internal::value_base, private internal::comparable<value> {
 
     /// Assign from any allowed type T, see @ref types.
     template <class T> typename assignable<T, value&>::type operator=(const T& x) {
-        codec::encoder e(*this);
-        e << x;
+        put_(x);
         return *this;
     }
 
@@ -113,6 +145,21 @@ class value : public internal::value_base, private internal::comparable<value> {
     ///@cond INTERNAL
     PN_CPP_EXTERN explicit value(const codec::data&);
     ///@endcond
+
+  private:
+    template <class T> typename internal::enable_if<internal::has_type_id<T>::value>::type
+    put_(const T& x) { if (!data_) scalar_ = x; else encode_(x); }
+
+    template <class T> typename internal::enable_if<
+        !internal::has_type_id<T>::value && !internal::is_convertible<T, internal::scalar_base>::value>::type
+    put_(const T& x) { encode_(x); }
+
+    template <class T> typename internal::enable_if<internal::is_convertible<T, internal::scalar_base>::value>::type
+    put_(const T& x) { put_scalar(x); }
+
+    void put_(const char* x) { if (!data_) scalar_ = x; else encode_(x); }
+
+    template <class T> void encode_(const T& x) { codec::encoder e(*this); e << x; }
 };
 
 ///@copydoc scalar::get
@@ -122,7 +169,9 @@ template<class T> T get(const value& v) { T x; get(v, x); return x; }
 /// Like get(const value&) but assigns the value to a reference instead of returning it.
 /// May be more efficient for complex values (arrays, maps etc.)
 ///@related proton::value
-template<class T> void get(const value& v, T& x) { codec::decoder d(v, true); d >> x; }
+template<class T> void get(const value& v, T& x) {
+    if (!internal::get_held(v, x)) { codec::decoder d(v, true); d >> x; }
+}
 
 ///@copydoc scalar::coerce
 ///@related proton::value
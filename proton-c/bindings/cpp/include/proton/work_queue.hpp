@@ -41,8 +41,10 @@ class work_queue : public std::enable_shared_from_this<work_queue> {
     work_queue(const work_queue&) = delete;
     virtual ~work_queue() {}
 
-    /// Get the work_queue associated with a connection.
-    /// @throw proton::error if this is not a controller-managed connection.
+    /// Get the work_queue associated with a connection. Connections
+    /// of a proton::container share the work_queue of the thread
+    /// they run on, see container::threads().
+    /// @throw proton::error if the connection has no work_queue.
     PN_CPP_EXTERN static std::shared_ptr<work_queue> get(const proton::connection&);
 
     /// push a function object on the queue to be invoked in a safely serialized
@@ -63,6 +65,7 @@ class work_queue : public std::enable_shared_from_this<work_queue> {
     virtual bool push(std::function<void()>) = 0;
 
     /// Get the controller associated with this work_queue.
+    /// @throw proton::error for a container's work_queue.
     virtual class controller& controller() const = 0;
 
   protected:
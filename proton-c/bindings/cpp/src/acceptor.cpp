@@ -22,12 +22,16 @@
 #include "proton/acceptor.hpp"
 #include "proton/error.hpp"
 #include "proton/connection_options.hpp"
+#include "proton/container.hpp"
+#include "container_impl.hpp"
 #include "msg.hpp"
 #include "contexts.hpp"
 
 namespace proton {
 
-void acceptor::close() { pn_acceptor_close(pn_object()); }
+void acceptor::close() {
+    container_context::get(pn_object_reactor(pn_object())).impl_->close(pn_object());
+}
 
 class connection_options& acceptor::connection_options() {
     listener_context& lc(listener_context::get(pn_object()));
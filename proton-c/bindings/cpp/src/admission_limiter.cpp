@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "proton/admission_limiter.hpp"
+
+namespace proton {
+
+namespace {
+const uint64_t ONE = 1000;      // A token, tokens_ is kept in thousandths
+}
+
+admission_limiter::admission_limiter() :
+    rate_(0), burst_(1), max_handshakes_(0), handshakes_(0), tokens_(ONE), last_(0) {}
+
+admission_limiter::admission_limiter(uint32_t rate, uint32_t burst, uint32_t max_handshakes) :
+    rate_(rate), burst_(burst ? burst : 1), max_handshakes_(max_handshakes), handshakes_(0),
+    tokens_(uint64_t(burst_) * ONE), last_(0) {}
+
+bool admission_limiter::admit(timestamp now) {
+    if (max_handshakes_ && handshakes_ >= max_handshakes_)
+        return false;
+    if (rate_) {
+        // One token per 1000/rate milliseconds, so rate thousandths per millisecond.
+        if (last_ != timestamp(0) && now > last_) {
+            uint64_t cap = uint64_t(burst_) * ONE;
+            uint64_t added = uint64_t((now - last_).milliseconds()) * rate_;
+            tokens_ = added < cap - tokens_ ? tokens_ + added : cap;
+        }
+        last_ = now;
+        if (tokens_ < ONE)
+            return false;
+        tokens_ -= ONE;
+    }
+    ++handshakes_;
+    return true;
+}
+
+void admission_limiter::handshake_done() {
+    if (handshakes_) --handshakes_;
+}
+
+}
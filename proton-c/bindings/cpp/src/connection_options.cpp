@@ -61,6 +61,7 @@ class connection_options::impl {
     option<bool> sasl_allow_insecure_mechs;
     option<std::string> sasl_config_name;
     option<std::string> sasl_config_path;
+    option<admission_limiter> admission;
 
     void apply(connection& c) {
         pn_connection_t *pnc = unwrap(c);
@@ -111,6 +112,10 @@ class connection_options::impl {
                 pn_transport_set_channel_max(pnt, max_sessions.value);
             if (idle_timeout.set)
                 pn_transport_set_idle_timeout(pnt, idle_timeout.value.milliseconds());
+
+            // The messaging adapter acts on the current state of each
+            // delivery and link, so one event per object will do.
+            pn_transport_set_coalesce_events(pnt, true);
         }
         // Only apply connection options if uninit.
         if (uninit) {
@@ -138,6 +143,7 @@ class connection_options::impl {
         sasl_allowed_mechs.update(x.sasl_allowed_mechs);
         sasl_config_name.update(x.sasl_config_name);
         sasl_config_path.update(x.sasl_config_path);
+        admission.update(x.admission);
     }
 
 };
@@ -180,6 +186,8 @@ connection_options& connection_options::sasl_allow_insecure_mechs(bool b) { impl
 connection_options& connection_options::sasl_allowed_mechs(const std::string &s) { impl_->sasl_allowed_mechs = s; return *this; }
 connection_options& connection_options::sasl_config_name(const std::string &n) { impl_->sasl_config_name = n; return *this; }
 connection_options& connection_options::sasl_config_path(const std::string &p) { impl_->sasl_config_path = p; return *this; }
+connection_options& connection_options::admission(const admission_limiter &a) { impl_->admission = a; return *this; }
+admission_limiter connection_options::admission() const { return impl_->admission.value; }
 
 void connection_options::apply(connection& c) const { impl_->apply(c); }
 proton_handler* connection_options::handler() const { return impl_->handler.value; }
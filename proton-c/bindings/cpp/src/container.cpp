@@ -73,7 +73,11 @@ connection container::connect(const std::string &url, const connection_options &
 
 std::string container::id() const { return impl_->id_; }
 
-void container::run() { impl_->reactor_.run(); }
+void container::run() { impl_->run(); }
+
+void container::threads(size_t n, placement p) { impl_->threads(n, p); }
+
+size_t container::threads() const { return impl_->threads(); }
 
 sender container::open_sender(const std::string &url) {
     return impl_->open_sender(url, proton::sender_options(), connection_options());
@@ -41,15 +41,28 @@
 #include "proton_bits.hpp"
 #include "proton_event.hpp"
 
+#include "proton/condition.h"
 #include "proton/connection.h"
+#include "proton/io.h"
 #include "proton/session.h"
 #include "proton/handlers.h"
 #include "proton/reactor.h"
+#include "proton/transport.h"
+
+#if PN_CPP_HAS_CPP11
+#include <thread>
+#endif
 
 namespace proton {
 
 namespace {
 
+#if PN_CPP_HAS_CPP11
+// The shard run by this thread, null outside run() and until
+// on_container_start() has returned.
+thread_local container_shard *current_shard = 0;
+#endif
+
 struct handler_context {
     static handler_context& get(pn_handler_t* h) {
         return *reinterpret_cast<handler_context*>(pn_handler_mem(h));
@@ -67,6 +80,8 @@ struct handler_context {
     static void dispatch(pn_handler_t *c_handler, pn_event_t *c_event, pn_event_type_t)
     {
         handler_context& hc(handler_context::get(c_handler));
+        if (!hc.container_start_ && pn_event_type(c_event) == PN_REACTOR_INIT)
+            return;
         proton_event pevent(c_event, hc.container_);
         pevent.dispatch(*hc.handler_);
         return;
@@ -74,6 +89,7 @@ struct handler_context {
 
     container *container_;
     proton_handler *handler_;
+    bool container_start_;      // False for the shards after the first
 };
 
 } // namespace
@@ -84,17 +100,31 @@ class override_handler : public proton_handler
   public:
     internal::pn_ptr<pn_handler_t> base_handler;
     container_impl &container_impl_;
+    container_shard &shard_;
 
-    override_handler(pn_handler_t *h, container_impl &c) : base_handler(h), container_impl_(c) {}
+    override_handler(pn_handler_t *h, container_impl &c, container_shard &s) :
+        base_handler(h), container_impl_(c), shard_(s) {}
 
     virtual void on_unhandled(proton_event &pe) {
         proton_event::event_type type = pe.type();
         if (type==proton_event::EVENT_NONE) return;  // Also not from the reactor
 
+        if (type == proton_event::REACTOR_INIT && !shard_.index_)
+            container_impl_.started(shard_);
+        // Don't block in the selector if the container is stopping.
+        if (type == proton_event::REACTOR_QUIESCED && !container_impl_.quiesced(shard_))
+            return;
+
         pn_event_t *cevent = pe.pn_event();
         pn_connection_t *conn = pn_event_connection(cevent);
         if (conn) {
-            proton_handler *override = connection_context::get(conn).handler.get();
+            connection_context& cc = connection_context::get(conn);
+            if (cc.handshaking &&
+                (type == proton_event::CONNECTION_REMOTE_OPEN || type == proton_event::TRANSPORT_CLOSED)) {
+                cc.handshaking = false;
+                listener_context::get(pn_connection_acceptor(conn)).admission.handshake_done();
+            }
+            proton_handler *override = cc.handler.get();
             if (override && type != proton_event::CONNECTION_INIT) {
                 // Send event to connector
                 pe.dispatch(*override);
@@ -102,8 +132,10 @@ class override_handler : public proton_handler
             else if (!override && type == proton_event::CONNECTION_INIT) {
                 // Newly accepted connection from lister socket
                 connection c(make_wrapper(conn));
-                container_impl_.configure_server_connection(c);
+                container_impl_.configure_server_connection(c, shard_);
             }
+            if (type == proton_event::CONNECTION_FINAL && shard_.connections_)
+                --shard_.connections_;
         }
         pn_handler_dispatch(base_handler.get(), cevent, pn_event_type_t(type));
     }
@@ -117,31 +149,137 @@ internal::pn_ptr<pn_handler_t> container_impl::cpp_handler(proton_handler *h) {
         handler_context &hc = handler_context::get(handler);
         hc.container_ = &container_;
         hc.handler_ = h;
+        hc.container_start_ = true;
     }
     return internal::take_ownership(handler);
 }
 
-container_impl::container_impl(container& c, messaging_adapter *h, const std::string& id) :
-    container_(c), reactor_(reactor::create()), handler_(h),
-    id_(id.empty() ? uuid::random().str() : id), id_gen_()
+container_shard::container_shard(container_impl& c, size_t index) :
+    index_(index), reactor_(reactor::create()), connections_(0)
 {
-    container_context::set(reactor_, container_);
+    container_context::set(reactor_, c.container_);
 
     // Set our own global handler that "subclasses" the existing one
     pn_handler_t *global_handler = reactor_.pn_global_handler();
-    override_handler_.reset(new override_handler(global_handler, *this));
-    internal::pn_ptr<pn_handler_t> cpp_global_handler(cpp_handler(override_handler_.get()));
+    override_handler_.reset(new override_handler(global_handler, c, *this));
+    internal::pn_ptr<pn_handler_t> cpp_global_handler(c.cpp_handler(override_handler_.get()));
     reactor_.pn_global_handler(cpp_global_handler.get());
-    if (handler_) {
-        reactor_.pn_handler(cpp_handler(handler_).get());
+    if (c.handler_) {
+        internal::pn_ptr<pn_handler_t> chandler(c.cpp_handler(c.handler_));
+        // on_container_start() is called once, by the first shard.
+        handler_context::get(chandler.get()).container_start_ = !index_;
+        reactor_.pn_handler(chandler.get());
     }
+#if PN_CPP_HAS_CPP11
+    queue_ = std::make_shared<shard_queue>(c.group_, reactor_.pn_object());
+#endif
 
     // Note: we have just set up the following handlers that see
     // events in this order: messaging_adapter, connector override,
     // the reactor's default globalhandler (pn_iohandler)
 }
 
-container_impl::~container_impl() {}
+container_impl::container_impl(container& c, messaging_adapter *h, const std::string& id) :
+    container_(c), handler_(h), placement_(container::LEAST_LOADED), used_(false),
+#if PN_CPP_HAS_CPP11
+    group_(std::make_shared<shard_group>()),
+#endif
+    id_(id.empty() ? uuid::random().str() : id), id_gen_()
+{
+    shards_.push_back(new container_shard(*this, 0));
+}
+
+container_impl::~container_impl() {
+#if PN_CPP_HAS_CPP11
+    {
+        // Work queues held by the application refuse work from now on.
+        std::lock_guard<std::mutex> l(group_->lock);
+        group_->done = true;
+    }
+#endif
+    for (size_t i = 0; i < shards_.size(); ++i)
+        delete shards_[i];
+}
+
+void container_impl::threads(size_t n, container::placement p) {
+    if (used_)
+        throw error(MSG("container::threads() must be called before connect, listen or schedule"));
+    if (!n)
+        throw error(MSG("container::threads() needs at least one thread"));
+#if !PN_CPP_HAS_CPP11
+    if (n > 1)
+        throw error(MSG("container::threads() needs C++11 for more than one thread"));
+#endif
+    while (shards_.size() > n) {
+        delete shards_.back();
+        shards_.pop_back();
+    }
+    while (shards_.size() < n)
+        shards_.push_back(new container_shard(*this, shards_.size()));
+    placement_ = p;
+}
+
+container_shard* container_impl::running_shard() {
+#if PN_CPP_HAS_CPP11
+    container_shard *s = current_shard;
+    if (s && s->index_ < shards_.size() && shards_[s->index_] == s)
+        return s;
+#endif
+    return 0;
+}
+
+// The shard of the calling handler. A shard's reactor may only be used by
+// its own thread while the container runs, so other threads are refused.
+container_shard* container_impl::calling_shard(const char *what) {
+    container_shard *s = running_shard();
+    if (!s && running())
+        throw error(MSG("container::" << what << "() called from outside the container"
+                        " while it is running, use a work_queue"));
+    return s;
+}
+
+// True once on_container_start() has returned until the shards stop.
+bool container_impl::running() {
+#if PN_CPP_HAS_CPP11
+    std::lock_guard<std::mutex> l(group_->lock);
+    if (group_->started)
+        for (size_t i = 0; i < shards_.size(); ++i)
+            if (shards_[i]->queue_->running_)
+                return true;
+#endif
+    return false;
+}
+
+container_shard& container_impl::place(const proton::url &url) {
+    container_shard *s = calling_shard("connect");
+    if (s)
+        return *s;
+    if (placement_ == container::BY_HASH) {
+        std::string key = url.host() + ":" + url.port();
+        uint32_t hash = 2166136261u;   // FNV-1a
+        for (std::string::const_iterator i = key.begin(); i != key.end(); ++i)
+            hash = (hash ^ uint8_t(*i)) * 16777619u;
+        return *shards_[hash % shards_.size()];
+    }
+    s = shards_[0];
+    for (size_t i = 1; i < shards_.size(); ++i)
+        if (shards_[i]->connections_ < s->connections_)
+            s = shards_[i];
+    return *s;
+}
+
+container_shard& container_impl::shard(pn_reactor_t *r) {
+    for (size_t i = 0; i < shards_.size(); ++i)
+        if (shards_[i]->reactor_.pn_object() == r)
+            return *shards_[i];
+    throw error(MSG("reactor is not part of this container"));
+}
+
+void container_impl::set_work_queue(connection &c, container_shard &s) {
+#if PN_CPP_HAS_CPP11
+    connection_context::get(c).work_queue = s.queue_.get();
+#endif
+}
 
 connection container_impl::connect(const proton::url &url, const connection_options &user_opts) {
     connection_options opts = client_connection_options(); // Defaults
@@ -149,12 +287,16 @@ connection container_impl::connect(const proton::url &url, const connection_opti
     proton_handler *h = opts.handler();
 
     internal::pn_ptr<pn_handler_t> chandler = h ? cpp_handler(h) : internal::pn_ptr<pn_handler_t>();
-    connection conn(reactor_.connection_to_host(url.host(), url.port(), chandler.get()));
+    container_shard &s = place(url);
+    used_ = true;
+    connection conn(s.reactor_.connection_to_host(url.host(), url.port(), chandler.get()));
     internal::pn_unique_ptr<connector> ctor(new connector(conn, url, opts));
     connection_context& cc(connection_context::get(conn));
     cc.handler.reset(ctor.release());
     cc.link_gen.prefix(id_gen_.next() + "/");
     pn_connection_set_container(unwrap(conn), id_.c_str());
+    set_work_queue(conn, s);
+    ++s.connections_;
 
     conn.open(opts);
     return conn;
@@ -184,25 +326,70 @@ acceptor container_impl::listen(const proton::url& url, const connection_options
     connection_options opts = server_connection_options(); // Defaults
     opts.update(user_opts);
     proton_handler *h = opts.handler();
-    internal::pn_ptr<pn_handler_t> chandler = h ? cpp_handler(h) : internal::pn_ptr<pn_handler_t>();
-    pn_acceptor_t *acptr = pn_reactor_acceptor(reactor_.pn_object(), url.host().c_str(), url.port().c_str(), chandler.get());
-    if (!acptr)
-        throw error(MSG("accept fail: " <<
-                        pn_error_text(pn_io_error(reactor_.pn_io())))
-                        << "(" << url << ")");
-    // Do not use pn_acceptor_set_ssl_domain().  Manage the incoming connections ourselves for
-    // more flexibility (i.e. ability to change the server cert for a long running listener).
-    listener_context& lc(listener_context::get(acptr));
-    lc.connection_options = opts;
-    lc.ssl = url.scheme() == url::AMQPS;
-    return make_wrapper(acptr);
+    container_shard *running = calling_shard("listen");
+    used_ = true;
+
+    // Listen on every shard if they can share the port, otherwise on the
+    // handler's shard or the first one.
+    std::vector<container_shard*> shards;
+    if (!running && shards_.size() > 1 && url.port() != "0" &&
+        !pn_io_set_reuse_port(shards_[0]->reactor_.pn_io(), true))
+        shards = shards_;
+    else
+        shards.push_back(running ? running : shards_[0]);
+
+    std::vector<pn_acceptor_t*> acceptors;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        reactor &r = shards[i]->reactor_;
+        // Each shard's connections reference the handler on its own thread.
+        internal::pn_ptr<pn_handler_t> chandler = h ? cpp_handler(h) : internal::pn_ptr<pn_handler_t>();
+        if (shards.size() > 1) pn_io_set_reuse_port(r.pn_io(), true);
+        pn_acceptor_t *acptr = pn_reactor_acceptor(r.pn_object(), url.host().c_str(), url.port().c_str(), chandler.get());
+        if (shards.size() > 1) pn_io_set_reuse_port(r.pn_io(), false);
+        if (!acptr) {
+            for (size_t j = 0; j < acceptors.size(); ++j)
+                pn_acceptor_close(acceptors[j]);
+            throw error(MSG("accept fail: " <<
+                            pn_error_text(pn_io_error(r.pn_io())))
+                            << "(" << url << ")");
+        }
+        // Do not use pn_acceptor_set_ssl_domain().  Manage the incoming connections ourselves for
+        // more flexibility (i.e. ability to change the server cert for a long running listener).
+        listener_context& lc(listener_context::get(acptr));
+        lc.connection_options = opts;
+        lc.admission = opts.admission();
+        lc.ssl = url.scheme() == url::AMQPS;
+        acceptors.push_back(acptr);
+    }
+    listener_context::get(acceptors[0]).siblings.assign(acceptors.begin() + 1, acceptors.end());
+    return make_wrapper(acceptors[0]);
+}
+
+void container_impl::close(pn_acceptor_t *a) {
+#if PN_CPP_HAS_CPP11
+    container_shard *s = running_shard();
+    container_shard &owner = shard(pn_object_reactor(a));
+    if (s && s != &owner) {
+        // Close it on its own thread.
+        owner.queue_->push([this, a]() { close(a); });
+        return;
+    }
+#endif
+    listener_context &lc(listener_context::get(a));
+    std::vector<pn_acceptor_t*> siblings;
+    siblings.swap(lc.siblings);
+    for (size_t i = 0; i < siblings.size(); ++i)
+        close(siblings[i]);
+    pn_acceptor_close(a);
 }
 
 task container_impl::schedule(int delay, proton_handler *h) {
     internal::pn_ptr<pn_handler_t> task_handler;
     if (h)
         task_handler = cpp_handler(h);
-    return reactor_.schedule(delay, task_handler.get());
+    container_shard *s = calling_shard("schedule");
+    used_ = true;
+    return (s ? s : shards_[0])->reactor_.schedule(delay, task_handler.get());
 }
 
 void container_impl::client_connection_options(const connection_options &opts) {
@@ -221,12 +408,163 @@ void container_impl::receiver_options(const proton::receiver_options &opts) {
     receiver_options_ = opts;
 }
 
-void container_impl::configure_server_connection(connection &c) {
+void container_impl::configure_server_connection(connection &c, container_shard &s) {
     pn_acceptor_t *pnp = pn_connection_acceptor(unwrap(c));
     listener_context &lc(listener_context::get(pnp));
+    ++s.connections_;
+    if (lc.admission.limited()) {
+        if (!lc.admission.admit(s.reactor_.now())) {
+            // Refuse before any handshake work is done.
+            pn_transport_t *pnt = pn_connection_transport(unwrap(c));
+            pn_condition_t *cond = pn_transport_condition(pnt);
+            pn_condition_set_name(cond, "amqp:resource-limit-exceeded");
+            pn_condition_set_description(cond, "too many new connections");
+            pn_transport_close_tail(pnt);
+            pn_transport_close_head(pnt);
+            return;
+        }
+        connection_context::get(c).handshaking = true;
+    }
     connection_context::get(c).link_gen.prefix(id_gen_.next() + "/");
     pn_connection_set_container(unwrap(c), id_.c_str());
+    set_work_queue(c, s);
     lc.connection_options.apply(c);
 }
 
+#if PN_CPP_HAS_CPP11
+
+void container_impl::run() {
+    {
+        std::lock_guard<std::mutex> l(group_->lock);
+        group_->shards = shards_.size();
+        group_->idle = 0;
+        group_->started = group_->done = group_->stopping = false;
+        group_->error = std::exception_ptr();
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            shards_[i]->queue_->idle_ = false;
+            shards_[i]->queue_->running_ = true;
+        }
+    }
+    std::vector<std::thread> threads;
+    try {
+        for (size_t i = 1; i < shards_.size(); ++i)
+            threads.push_back(std::thread(&container_impl::run_shard, this, std::ref(*shards_[i])));
+    } catch (...) {
+        stop(std::current_exception());
+    }
+    run_shard(*shards_[0]);
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    if (group_->error)
+        std::rethrow_exception(group_->error);
+}
+
+void container_impl::run_shard(container_shard &s) {
+    try {
+        if (s.index_) {
+            // Connections, listeners and timers made by on_container_start()
+            // are placed as if made before run().
+            std::unique_lock<std::mutex> l(group_->lock);
+            while (!group_->started && !group_->stopping)
+                group_->idle_cv.wait(l);
+            current_shard = &s;
+        }
+        s.reactor_.timeout(duration(3141)); // As pn_reactor_run()
+        s.reactor_.start();
+        while (true) {
+            while (!group_->stopping && s.reactor_.process()) {}
+            if (!s.queue_->wait())
+                break;
+            s.queue_->run();
+        }
+        s.reactor_.stop();
+    } catch (...) {
+        stop(std::current_exception());
+    }
+    std::lock_guard<std::mutex> l(group_->lock);
+    s.queue_->running_ = false;
+    current_shard = 0;
+}
+
+void container_impl::started(container_shard &s) {
+    current_shard = &s;
+    std::lock_guard<std::mutex> l(group_->lock);
+    group_->started = true;
+    group_->idle_cv.notify_all();
+}
+
+bool container_impl::quiesced(container_shard &s) {
+    if (group_->stopping)
+        return false;
+    s.queue_->run();
+    return true;
+}
+
+void container_impl::stop(std::exception_ptr e) {
+    std::lock_guard<std::mutex> l(group_->lock);
+    if (!group_->error)
+        group_->error = e;
+    group_->stopping = true;
+    group_->done = true;
+    group_->idle_cv.notify_all();
+    for (size_t i = 0; i < shards_.size(); ++i)
+        if (shards_[i]->queue_->running_)
+            shards_[i]->reactor_.wakeup();
+}
+
+shard_queue::shard_queue(std::shared_ptr<shard_group> g, pn_reactor_t *r) :
+    group_(g), reactor_(r), idle_(false), running_(false) {}
+
+bool shard_queue::push(std::function<void()> f) {
+    std::lock_guard<std::mutex> l(group_->lock);
+    if (group_->done)
+        return false;
+    work_.push_back(std::move(f));
+    if (idle_) {
+        idle_ = false;
+        --group_->idle;
+        group_->idle_cv.notify_all();
+    } else if (running_) {
+        pn_reactor_wakeup(reactor_);
+    }
+    return true;
+}
+
+class controller& shard_queue::controller() const {
+    throw error(MSG("container connection has no controller"));
+}
+
+void shard_queue::run() {
+    std::deque<std::function<void()> > work;
+    {
+        std::lock_guard<std::mutex> l(group_->lock);
+        work.swap(work_);
+    }
+    for (size_t i = 0; i < work.size(); ++i)
+        work[i]();
+}
+
+bool shard_queue::wait() {
+    std::unique_lock<std::mutex> l(group_->lock);
+    if (work_.empty() && !group_->done) {
+        idle_ = true;
+        if (++group_->idle == group_->shards) {
+            // Every shard is out of work, so no more can arrive.
+            group_->done = true;
+            group_->idle_cv.notify_all();
+        }
+        while (idle_ && !group_->done)
+            group_->idle_cv.wait(l);
+    }
+    return !group_->done;
+}
+
+#else
+
+void container_impl::run() { shards_[0]->reactor_.run(); }
+void container_impl::started(container_shard&) {}
+bool container_impl::quiesced(container_shard&) { return true; }
+
+#endif
+
 }
@@ -22,10 +22,12 @@
  *
  */
 
-#include "id_generator.hpp"
+#include "proton/id_generator.hpp"
 
+#include "proton/config.hpp"
 #include "proton/connection.hpp"
 #include "proton/connection_options.hpp"
+#include "proton/container.hpp"
 #include "proton/duration.hpp"
 #include "proton/export.hpp"
 #include "proton/handler.hpp"
@@ -36,6 +38,17 @@
 #include "proton_handler.hpp"
 
 #include <string>
+#include <vector>
+
+#if PN_CPP_HAS_CPP11
+#include "proton/work_queue.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#endif
 
 namespace proton {
 
@@ -46,6 +59,65 @@ class acceptor;
 class container;
 class url;
 class task;
+class container_impl;
+
+#if PN_CPP_HAS_CPP11
+
+// State shared by the shards of a container and their work queues,
+// which the application may hold on to after the container is gone.
+struct shard_group {
+    shard_group() : shards(0), idle(0), started(false), done(false), stopping(false) {}
+
+    std::mutex lock;
+    std::condition_variable idle_cv;
+    size_t shards;
+    size_t idle;                // Shards waiting for work
+    bool started;               // on_container_start() returned, other shards may start
+    bool done;                  // run() is over, work can no longer be pushed
+    std::atomic<bool> stopping; // A handler threw, stop every shard
+    std::exception_ptr error;
+};
+
+// Work for the connections of one shard, run on the shard's thread.
+class shard_queue : public work_queue {
+  public:
+    shard_queue(std::shared_ptr<shard_group>, pn_reactor_t*);
+
+    bool push(std::function<void()>) override;
+    class controller& controller() const override;
+
+    // Run the queued work, called on the shard's thread.
+    void run();
+    // Called when the reactor has nothing more to do, wait for more
+    // work. Return false when run() is over.
+    bool wait();
+
+  private:
+    std::shared_ptr<shard_group> group_;
+    pn_reactor_t *reactor_;
+    std::deque<std::function<void()> > work_;
+    bool idle_;
+    bool running_;              // The reactor can be woken
+
+  friend class container_impl;
+};
+
+#endif
+
+// One reactor of a container, see container::threads().
+class container_shard
+{
+  public:
+    container_shard(container_impl&, size_t index);
+
+    size_t index_;
+    reactor reactor_;
+    internal::pn_unique_ptr<proton_handler> override_handler_;
+    size_t connections_;        // Placed here and not yet final, for LEAST_LOADED
+#if PN_CPP_HAS_CPP11
+    std::shared_ptr<shard_queue> queue_;
+#endif
+};
 
 class container_impl
 {
@@ -56,6 +128,9 @@ class container_impl
     sender open_sender(const url&, const proton::sender_options &, const connection_options &);
     receiver open_receiver(const url&, const proton::receiver_options &, const connection_options &);
     class acceptor listen(const url&, const connection_options &);
+    void run();
+    void threads(size_t n, container::placement);
+    size_t threads() const { return shards_.size(); }
     duration timeout();
     void timeout(duration timeout);
     void client_connection_options(const connection_options &);
@@ -67,18 +142,40 @@ class container_impl
     void receiver_options(const proton::receiver_options&);
     const proton::receiver_options& receiver_options() { return receiver_options_; }
 
-    void configure_server_connection(connection &c);
+    void configure_server_connection(connection &c, container_shard&);
     task schedule(int delay, proton_handler *h);
     internal::pn_ptr<pn_handler_t> cpp_handler(proton_handler *h);
+    // Close an acceptor and its siblings, each on its own thread.
+    void close(pn_acceptor_t*);
+    // The first shard has called on_container_start().
+    void started(container_shard&);
+    // Run queued work before the reactor blocks, false to stop the shard.
+    bool quiesced(container_shard&);
 
     std::string next_link_name();
 
   private:
+    container_shard* running_shard();
+    container_shard* calling_shard(const char *what);
+    bool running();
+    container_shard& place(const url&);
+    container_shard& shard(pn_reactor_t*);
+    void set_work_queue(connection&, container_shard&);
+#if PN_CPP_HAS_CPP11
+    void run_shard(container_shard&);
+    void stop(std::exception_ptr);
+#endif
 
     container& container_;
-    reactor reactor_;
     proton_handler *handler_;
-    internal::pn_unique_ptr<proton_handler> override_handler_;
+    std::vector<container_shard*> shards_;
+    container::placement placement_;
+#if PN_CPP_HAS_CPP11
+    std::atomic<bool> used_;    // Something was connected, listened to or scheduled
+    std::shared_ptr<shard_group> group_;
+#else
+    bool used_;
+#endif
     internal::pn_unique_ptr<proton_handler> flow_controller_;
     std::string id_;
     id_generator id_gen_;
@@ -88,6 +185,7 @@ class container_impl
     proton::receiver_options receiver_options_;
 
   friend class container;
+  friend class container_shard;
   friend class messaging_adapter;
 };
 
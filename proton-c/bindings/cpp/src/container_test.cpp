@@ -24,13 +24,28 @@
 #include "proton/container.hpp"
 #include "proton/handler.hpp"
 #include "proton/acceptor.hpp"
+#include "proton/admission_limiter.hpp"
+#include "proton/reconnect_timer.hpp"
+#include "proton/task.hpp"
+#include "proton/transport.hpp"
+#include "proton/error.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
 #include <string>
 #include <cstdio>
 #include <sstream>
 
+#if PN_CPP_HAS_CPP11
+#include "proton/work_queue.hpp"
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#endif
+
 #if __cplusplus < 201103L
 #define override
 #endif
@@ -117,11 +132,324 @@ int test_container_no_vhost() {
     return 0;
 }
 
+int test_reconnect_jitter() {
+    proton::timestamp now(1000);
+    proton::reconnect_timer fixed(10, 1000, 100, true);
+    ASSERT_EQUAL(10, fixed.next_delay(now));
+    ASSERT_EQUAL(110, fixed.next_delay(now));
+    ASSERT_EQUAL(220, fixed.next_delay(now));
+
+    bool varied = false;
+    int first = -1;
+    for (int i = 0; i < 20; ++i) {
+        proton::reconnect_timer rt(10, 1000, 100, true, -1, -1, true);
+        int d = rt.next_delay(now);
+        ASSERT(d >= 0 && d <= 10);
+        int prev = d;
+        for (int j = 0; j < 10; ++j) {
+            d = rt.next_delay(now);
+            ASSERT(d >= 100 && d <= 1000);
+            ASSERT(d <= 3 * std::max(prev, 100));
+            prev = d;
+        }
+        if (first < 0) first = d;
+        varied = varied || d != first;
+    }
+    ASSERT(varied);
+    return 0;
+}
+
+int test_admission_limiter() {
+    proton::admission_limiter unlimited;
+    ASSERT(!unlimited.limited());
+    for (int i = 0; i < 100; ++i) ASSERT(unlimited.admit(proton::timestamp(1)));
+
+    proton::admission_limiter rate(10, 2); // A token every 100ms
+    ASSERT(rate.admit(proton::timestamp(1000)));
+    ASSERT(rate.admit(proton::timestamp(1000)));
+    ASSERT(!rate.admit(proton::timestamp(1050)));
+    ASSERT(rate.admit(proton::timestamp(1100)));
+    ASSERT(!rate.admit(proton::timestamp(1100)));
+    ASSERT(rate.admit(proton::timestamp(9000)));
+    ASSERT(rate.admit(proton::timestamp(9000))); // Refilled to burst only
+    ASSERT(!rate.admit(proton::timestamp(9000)));
+
+    proton::admission_limiter handshakes(0, 0, 2);
+    ASSERT(handshakes.admit(proton::timestamp(1)));
+    ASSERT(handshakes.admit(proton::timestamp(1)));
+    ASSERT(!handshakes.admit(proton::timestamp(1)));
+    ASSERT_EQUAL(2u, handshakes.handshakes());
+    handshakes.handshake_done();
+    ASSERT(handshakes.admit(proton::timestamp(1)));
+    return 0;
+}
+
+// Connect twice to a listener that takes one new connection a second.
+class admission_handler : public proton::handler {
+  public:
+    int opened, closed, refused;
+    proton::acceptor acptr;
+
+    admission_handler() : opened(0), closed(0), refused(0) {}
+
+    void on_container_start(proton::container &c) override {
+        proton::connection_options opts;
+        opts.admission(proton::admission_limiter(1, 1));
+        int port;
+        srand((unsigned int)time(0));
+        while (true) {
+            port = 20000 + (rand() % 30000);
+            try {
+                acptr = c.listen("0.0.0.0:" + int2string(port), opts);
+                break;
+            } catch (...) {
+                // keep trying
+            }
+        }
+        c.connect("127.0.0.1:" + int2string(port));
+        c.connect("127.0.0.1:" + int2string(port));
+    }
+
+    void on_connection_open(proton::connection &c) override {
+        ++opened;
+        c.close();
+    }
+
+    void on_connection_close(proton::connection &) override {
+        ++closed;
+        check_done();
+    }
+
+    void on_transport_error(proton::transport &) override {
+        ++refused;
+        check_done();
+    }
+
+    void check_done() {
+        if (closed == 2 && refused == 1) acptr.close();
+    }
+};
+
+int test_container_admission() {
+    admission_handler h;
+    proton::container(h).run();
+    ASSERT_EQUAL(2, h.opened);  // Both ends of the first connection
+    ASSERT_EQUAL(1, h.refused);
+    return 0;
+}
+
+#if PN_CPP_HAS_CPP11
+
+// Connections spread over the threads of a container, each handled on
+// its own thread, with work pushed between the threads.
+class threads_handler : public proton::handler {
+  public:
+    static const int COUNT = 8;
+
+    std::mutex lock;
+    int opened, closed, misplaced;
+    std::set<std::thread::id> threads;
+    std::map<proton::work_queue*, std::thread::id> queues;
+    std::vector<std::shared_ptr<proton::work_queue> > targets;
+    proton::acceptor acptr;
+
+    threads_handler() : opened(0), closed(0), misplaced(0) {}
+
+    void on_container_start(proton::container &c) override {
+        int port;
+        srand((unsigned int)time(0));
+        while (true) {
+            port = 20000 + (rand() % 30000);
+            try {
+                acptr = c.listen("0.0.0.0:" + int2string(port));
+                break;
+            } catch (...) {
+                // keep trying
+            }
+        }
+        for (int i = 0; i < COUNT; ++i)
+            c.connect("127.0.0.1:" + int2string(port));
+    }
+
+    void check(proton::work_queue *q) {
+        std::lock_guard<std::mutex> l(lock);
+        if (queues[q] != std::this_thread::get_id()) ++misplaced;
+    }
+
+    void on_connection_open(proton::connection &c) override {
+        std::shared_ptr<proton::work_queue> q = proton::work_queue::get(c);
+        std::vector<std::shared_ptr<proton::work_queue> > others;
+        {
+            std::lock_guard<std::mutex> l(lock);
+            ++opened;
+            threads.insert(std::this_thread::get_id());
+            queues[q.get()] = std::this_thread::get_id();
+            others = targets;
+            targets.push_back(q);
+        }
+        // Work for connections that may be on other threads.
+        for (size_t i = 0; i < others.size(); ++i) {
+            proton::work_queue *p = others[i].get();
+            ASSERT(p->push([this, p]() { check(p); }));
+        }
+        ASSERT(q->push([this, q, c]() mutable { check(q.get()); c.close(); }));
+    }
+
+    void on_connection_close(proton::connection &) override {
+        std::lock_guard<std::mutex> l(lock);
+        if (++closed == 2 * COUNT) acptr.close();
+    }
+};
+
+int test_container_threads() {
+    threads_handler h;
+    proton::container c(h);
+    ASSERT_EQUAL(1u, c.threads());
+    try { c.threads(0); FAIL("threads(0) did not throw"); } catch (const proton::error&) {}
+    c.threads(4);
+    ASSERT_EQUAL(4u, c.threads());
+    c.run();
+    ASSERT_EQUAL(2 * threads_handler::COUNT, h.opened); // Both ends of each connection
+    ASSERT_EQUAL(2 * threads_handler::COUNT, h.closed);
+    ASSERT_EQUAL(0, h.misplaced);
+    ASSERT(h.threads.size() > 1);
+    // Work can't be pushed once the container has stopped.
+    ASSERT(!h.targets[0]->push([]() {}));
+    try { c.threads(2); FAIL("threads() after run did not throw"); } catch (const proton::error&) {}
+    return 0;
+}
+
+// A listener with its own handler accepts on every thread.
+class listen_threads_handler : public proton::handler {
+  public:
+    std::mutex lock;
+    int opened;
+    std::set<std::thread::id> threads;
+
+    listen_threads_handler() : opened(0) {}
+
+    void on_connection_open(proton::connection &c) override {
+        {
+            std::lock_guard<std::mutex> l(lock);
+            ++opened;
+            threads.insert(std::this_thread::get_id());
+        }
+        c.close();
+    }
+};
+
+class connect_threads_handler : public proton::handler {
+  public:
+    static const int COUNT = 16;
+
+    listen_threads_handler server;
+    std::mutex lock;
+    int closed;
+    proton::acceptor acptr;
+
+    connect_threads_handler() : closed(0) {}
+
+    void on_container_start(proton::container &c) override {
+        int port;
+        srand((unsigned int)time(0));
+        while (true) {
+            port = 20000 + (rand() % 30000);
+            try {
+                acptr = c.listen("0.0.0.0:" + int2string(port), proton::connection_options().handler(&server));
+                break;
+            } catch (...) {
+                // keep trying
+            }
+        }
+        for (int i = 0; i < COUNT; ++i)
+            c.connect("127.0.0.1:" + int2string(port));
+    }
+
+    void on_connection_close(proton::connection &) override {
+        std::lock_guard<std::mutex> l(lock);
+        if (++closed == COUNT) acptr.close();
+    }
+};
+
+int test_container_listen_threads() {
+    connect_threads_handler h;
+    proton::container c(h);
+    c.threads(4);
+    c.run();
+    const int count = connect_threads_handler::COUNT;
+    ASSERT_EQUAL(count, h.server.opened);
+    ASSERT_EQUAL(count, h.closed);
+    ASSERT(h.server.threads.size() > 1);
+    return 0;
+}
+
+// Other threads may not connect, listen or schedule while the container runs.
+class foreign_thread_handler : public proton::handler {
+  public:
+    proton::container *container;
+    proton::acceptor acptr;
+    std::string url;
+    int refused;
+    bool tried;
+
+    foreign_thread_handler() : container(0), refused(0), tried(false) {}
+
+    void on_container_start(proton::container &c) override {
+        container = &c;
+        int port;
+        srand((unsigned int)time(0));
+        while (true) {
+            port = 20000 + (rand() % 30000);
+            try {
+                acptr = c.listen("0.0.0.0:" + int2string(port));
+                break;
+            } catch (...) {
+                // keep trying
+            }
+        }
+        url = "127.0.0.1:" + int2string(port);
+        c.connect(url);
+    }
+
+    void on_connection_open(proton::connection &c) override {
+        if (!tried) {
+            tried = true;
+            std::thread t([this]() {
+                    try { container->connect(url); } catch (const proton::error&) { ++refused; }
+                    try { container->listen("0.0.0.0:0"); } catch (const proton::error&) { ++refused; }
+                    try { container->schedule(0); } catch (const proton::error&) { ++refused; }
+                });
+            t.join();
+            acptr.close();
+        }
+        c.close();
+    }
+};
+
+int test_container_foreign_thread() {
+    foreign_thread_handler h;
+    proton::container c(h);
+    c.threads(2);
+    c.run();
+    ASSERT_EQUAL(3, h.refused);
+    return 0;
+}
+
+#endif
+
 int main(int, char**) {
     int failed = 0;
     RUN_TEST(failed, test_container_vhost());
     RUN_TEST(failed, test_container_default_vhost());
     RUN_TEST(failed, test_container_no_vhost());
+    RUN_TEST(failed, test_reconnect_jitter());
+    RUN_TEST(failed, test_admission_limiter());
+    RUN_TEST(failed, test_container_admission());
+#if PN_CPP_HAS_CPP11
+    RUN_TEST(failed, test_container_threads());
+    RUN_TEST(failed, test_container_listen_threads());
+    RUN_TEST(failed, test_container_foreign_thread());
+#endif
     return failed;
 }
 
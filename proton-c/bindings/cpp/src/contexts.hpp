@@ -25,12 +25,15 @@
 #include "proton/pn_unique_ptr.hpp"
 #include "proton/message.hpp"
 #include "proton/connection.hpp"
+#include "proton/admission_limiter.hpp"
 #include "proton/container.hpp"
 #include "proton/io/connection_engine.hpp"
 
-#include "id_generator.hpp"
+#include "proton/id_generator.hpp"
 #include "proton_handler.hpp"
 
+#include <vector>
+
 struct pn_session_t;
 struct pn_event_t;
 struct pn_reactor_t;
@@ -83,14 +86,15 @@ class context {
 // Connection context used by all connections.
 class connection_context : public context {
   public:
-    connection_context() : default_session(0), work_queue(0), collector(0) {}
+    connection_context() : default_session(0), work_queue(0), collector(0), handshaking(false) {}
 
     // Used by all connections
     pn_session_t *default_session; // Owned by connection.
     message event_message;      // re-used by messaging_adapter for performance.
     id_generator link_gen;      // Link name generator.
-    class work_queue* work_queue; // Work queue if this is proton::controller connection.
+    class work_queue* work_queue; // Work queue of the controller or container shard.
     pn_collector_t* collector;
+    bool handshaking;           // Counted by the listener's admission_limiter.
 
     internal::pn_unique_ptr<proton_handler> handler;
 
@@ -115,7 +119,9 @@ class listener_context : public context {
     static listener_context& get(pn_acceptor_t* c);
     listener_context() : ssl(false) {}
     class connection_options connection_options;
+    admission_limiter admission;
     bool ssl;
+    std::vector<pn_acceptor_t*> siblings; // The same listen() on other threads, see container::threads()
 };
 
 class link_context : public context {
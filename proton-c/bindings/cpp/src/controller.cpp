@@ -42,6 +42,8 @@ controller& controller::get(const proton::connection& c) {
     return work_queue::get(c)->controller();
 }
 
+void controller::workers(size_t, bool) {}
+
 std::shared_ptr<work_queue> work_queue::get(const proton::connection& c) {
     work_queue* wq = connection_context::get(c).work_queue;
     if (!wq)
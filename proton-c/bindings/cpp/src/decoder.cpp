@@ -43,7 +43,7 @@ namespace codec {
  * to be returned by the decoder.
  */
 
-decoder::decoder(const internal::value_base& v, bool exact) : data(v.data()), exact_(exact) { rewind(); }
+decoder::decoder(const internal::value_base& v, bool exact) : data(v.encoded()), exact_(exact) { rewind(); }
 
 namespace {
 template <class T> T check(T result) {
@@ -141,7 +141,15 @@ decoder& decoder::operator>>(null&) {
 decoder& decoder::operator>>(internal::value_base& x) {
     if (*this == x.data_)
         throw conversion_error("extract into self");
-    data d = x.data();
+    if (!x.data_) {             // Hold a scalar inline
+        state_guard sg(*this);
+        if (next() && type_id_is_scalar(type_id(pn_data_type(pn_object())))) {
+            x.scalar_.set(pn_data_get_atom(pn_object()));
+            sg.cancel();
+            return *this;
+        }
+    }
+    data d = x.new_data();
     d.clear();
     narrow();
     try {
@@ -45,7 +45,7 @@ void encoder::check(long result) {
 }
 
 
-encoder::encoder(internal::value_base& v) : data(v.data()) {
+encoder::encoder(internal::value_base& v) : data(v.new_data()) {
     clear();
 }
 
@@ -147,6 +147,9 @@ encoder& encoder::operator<<(const internal::scalar_base& x) { return insert(x.a
 encoder& encoder::operator<<(const internal::value_base& x) {
     if (*this == x.data_)
         throw conversion_error("cannot insert into self");
+    if (const scalar* s = x.held_scalar()) {
+        return *this << *s;
+    }
     if (x.empty()) {
         return *this << null();
     }
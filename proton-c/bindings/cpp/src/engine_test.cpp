@@ -20,10 +20,17 @@
 
 #include "test_bits.hpp"
 #include <proton/uuid.hpp>
+#include <proton/id_generator.hpp>
 #include <proton/io/connection_engine.hpp>
+#include <proton/io/connection_engine_pair.hpp>
 #include <proton/handler.hpp>
 #include <proton/types_fwd.hpp>
 #include <proton/link.hpp>
+#include <proton/message.hpp>
+#include <proton/sender.hpp>
+#include <proton/sender_options.hpp>
+#include <proton/tracker.hpp>
+#include <proton/transport.hpp>
 #include <deque>
 #include <algorithm>
 
@@ -186,6 +193,120 @@ void test_transport_close() {
     ASSERT_EQUAL(0u, ha.connection_errors.size());
 }
 
+/// Counts trackers settled one at a time and in ranges.
+struct settle_handler : public record_handler {
+    int settled, ranges;
+
+    settle_handler() : settled(0), ranges(0) {}
+
+    void on_tracker_settle(tracker &) override { ++settled; }
+
+    void on_delivery_settle_range(sender &s, const std::vector<tracker> &t) override {
+        ++ranges;
+        handler::on_delivery_settle_range(s, t);
+    }
+};
+
+void test_settle_range() {
+    // Dispositions for consecutive messages arrive as one range, if asked.
+    for (int bulk = 0; bulk < 2; ++bulk) {
+        settle_handler ha;
+        record_handler hb;
+        engine_pair e(ha, hb);
+        e.a.connection().open();
+        sender s = e.a.connection().open_sender("x", sender_options().bulk_settle(bulk));
+        while (s.credit() < 10) e.process();
+        for (int i = 0; i < 10; ++i)
+            s.send(message("hello"));
+        while (ha.settled < 10) e.process();
+        ASSERT_EQUAL(10, ha.settled);
+        ASSERT_EQUAL(bool(bulk), ha.ranges > 0);
+    }
+}
+
+void test_transport_metrics() {
+    // What one end writes the other reads.
+    settle_handler ha;
+    record_handler hb;
+    engine_pair e(ha, hb);
+    e.a.connection().open();
+    sender s = e.a.connection().open_sender("x");
+    while (s.credit() < 10) e.process();
+    for (int i = 0; i < 10; ++i)
+        s.send(message("hello"));
+    while (ha.settled < 10) e.process();
+    transport_metrics ma = e.a.transport().metrics();
+    transport_metrics mb = e.b.transport().metrics();
+    ASSERT_EQUAL(10u, ma.deliveries_sent());
+    ASSERT_EQUAL(10u, mb.deliveries_received());
+    ASSERT_EQUAL(1u, ma.frames_output(transport_metrics::OPEN));
+    ASSERT_EQUAL(10u, ma.frames_output(transport_metrics::TRANSFER));
+    ASSERT_EQUAL(ma.bytes_output(transport_metrics::TRANSFER), mb.bytes_input(transport_metrics::TRANSFER));
+    ASSERT(ma.frames_input(transport_metrics::DISPOSITION) > 0);
+    ASSERT(ma.output_high_water() > 0);
+}
+
+void test_engine_pair() {
+    // Engines connected in memory over a 10ms link, on the pair's clock.
+    settle_handler ha;
+    record_handler hb;
+    connection_engine a(ha), b(hb);
+    connection_engine_pair link(a, b);
+    link.latency(duration(10));
+    timestamp start = link.now();
+    a.connection().open();
+    link.process();
+    ASSERT(link.in_flight() > 0);
+    ASSERT_EQUAL(start + duration(10), link.deadline());
+    ASSERT(!b.connection().active());
+    link.advance(duration(10));
+    ASSERT(b.connection().active());
+    ASSERT(link.in_flight() > 0); // b's open on its way back
+    link.advance(duration(10));
+    ASSERT_EQUAL(0u, link.in_flight());
+
+    // Credit comes back a round trip after the attach goes out, and
+    // settlement a round trip after the sends.
+    sender s = a.connection().open_sender("x");
+    link.process();
+    while (s.credit() < 10) link.advance(duration(1));
+    ASSERT_EQUAL(start + duration(40), link.now());
+    for (int i = 0; i < 10; ++i)
+        s.send(message("hello"));
+    link.process();
+    while (ha.settled < 10) link.advance(duration(1));
+    ASSERT_EQUAL(start + duration(60), link.now());
+    ASSERT_EQUAL(0u, link.in_flight());
+    ASSERT_EQUAL(a.transport().metrics().bytes_output(), b.transport().metrics().bytes_input());
+}
+
+}
+
+void test_id_generator() {
+    id_generator g("x/");
+    ASSERT_EQUAL("x/1", g.next());
+    char buf[32];
+    ASSERT_EQUAL(3u, g.next(buf, sizeof(buf)));
+    ASSERT_EQUAL("x/2", std::string(buf));
+    ASSERT_EQUAL(0u, g.next(buf, g.max_size() - 1)); // Too small, no id used
+    for (int i = 3; i < 0x1f; ++i) g.next();
+    ASSERT_EQUAL("x/1f", g.next());
+    ASSERT_EQUAL(4u, g.next(buf, g.max_size()));
+    ASSERT_EQUAL("x/20", std::string(buf));
+}
+
+void test_uuid_random() {
+    uuid a = uuid::random(), b = uuid::random();
+    ASSERT(a != b);
+    ASSERT_EQUAL(0x40, a[6] & 0xF0); // Version 4
+    ASSERT_EQUAL(0x80, a[8] & 0xC0); // RFC4122 variant
+    std::string s = a.str();
+    ASSERT_EQUAL(36u, s.size());
+    ASSERT_EQUAL('-', s[8]);
+    ASSERT_EQUAL('-', s[23]);
+    std::ostringstream o;
+    o << uuid::copy("\x00\x11\x22\x33\x44\x55\x66\x77\x88\x99\xaa\xbb\xcc\xdd\xee\xff");
+    ASSERT_EQUAL("00112233-4455-6677-8899-aabbccddeeff", o.str());
 }
 
 int main(int, char**) {
@@ -193,5 +314,10 @@ int main(int, char**) {
     RUN_TEST(failed, test_engine_container_id());
     RUN_TEST(failed, test_endpoint_close());
     RUN_TEST(failed, test_transport_close());
+    RUN_TEST(failed, test_settle_range());
+    RUN_TEST(failed, test_transport_metrics());
+    RUN_TEST(failed, test_engine_pair());
+    RUN_TEST(failed, test_id_generator());
+    RUN_TEST(failed, test_uuid_random());
     return failed;
 }
@@ -24,6 +24,7 @@
 #include "proton/receiver.hpp"
 #include "proton/sender.hpp"
 #include "proton/session.hpp"
+#include "proton/tracker.hpp"
 #include "proton/transport.hpp"
 
 #include "proton_event.hpp"
@@ -61,6 +62,12 @@ void handler::on_tracker_accept(tracker &) {}
 void handler::on_tracker_reject(tracker &) {}
 void handler::on_tracker_release(tracker &) {}
 void handler::on_tracker_settle(tracker &) {}
+void handler::on_delivery_settle_range(sender &, const std::vector<tracker> &settled) {
+    for (std::vector<tracker>::const_iterator i = settled.begin(); i != settled.end(); ++i) {
+        tracker t(*i);
+        on_tracker_settle(t);
+    }
+}
 void handler::on_delivery_settle(delivery &) {}
 void handler::on_sender_drain_start(sender &) {}
 void handler::on_receiver_drain_finish(receiver &) {}
@@ -17,18 +17,60 @@
  * under the License.
  */
 
-#include "id_generator.hpp"
-#include <sstream>
+#include "proton/id_generator.hpp"
+
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__GNUC__)
+#include <windows.h>
+#endif
 
 namespace proton {
 
+namespace {
+
+uint64_t increment(uint64_t* count) {
+#if defined(__GNUC__)
+    return __atomic_add_fetch(count, 1, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+    return InterlockedIncrement64(reinterpret_cast<volatile LONG64*>(count));
+#else
+    return ++*count;            // No atomics, not thread safe.
+#endif
+}
+
+// Write n in lower case hex with no leading zeros, return the length.
+size_t put_hex(char* buf, uint64_t n) {
+    static const char digits[] = "0123456789abcdef";
+    char tmp[2 * sizeof(uint64_t)];
+    size_t len = 0;
+    do {
+        tmp[len++] = digits[n & 0xF];
+        n >>= 4;
+    } while (n);
+    for (size_t i = 0; i < len; ++i) buf[i] = tmp[len - 1 - i];
+    return len;
+}
+
+}
+
 id_generator::id_generator(const std::string& s) : prefix_(s), count_(0) {}
 
 std::string id_generator::next() {
-    // TODO aconway 2016-01-19: more efficient conversion, fixed buffer.
-    std::ostringstream o;
-    o << prefix_ << std::hex << ++count_;
-    return o.str();
+    char hex[2 * sizeof(uint64_t)];
+    size_t len = put_hex(hex, increment(&count_));
+    std::string id;
+    id.reserve(prefix_.size() + len);
+    id.append(prefix_).append(hex, len);
+    return id;
+}
+
+size_t id_generator::next(char* buf, size_t size) {
+    if (size < max_size()) return 0;
+    memcpy(buf, prefix_.data(), prefix_.size());
+    size_t len = prefix_.size() + put_hex(buf + prefix_.size(), increment(&count_));
+    buf[len] = '\0';
+    return len;
 }
 
 }
@@ -23,7 +23,7 @@
 #include "proton/uuid.hpp"
 
 #include "contexts.hpp"
-#include "id_generator.hpp"
+#include "proton/id_generator.hpp"
 #include "messaging_adapter.hpp"
 #include "msg.hpp"
 #include "proton_bits.hpp"
@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "proton/io/connection_engine_pair.hpp"
+#include "proton/io/connection_engine.hpp"
+#include "proton/error.hpp"
+
+#include "proton_bits.hpp"
+
+#include <proton/transport_pair.h>
+
+namespace proton {
+namespace io {
+
+connection_engine_pair::connection_engine_pair(connection_engine& a, connection_engine& b) :
+    a_(a), b_(b),
+    pair_(pn_transport_pair(unwrap(a.transport()), unwrap(b.transport())))
+{
+    if (!pair_)
+        throw proton::error("engine pair create");
+}
+
+connection_engine_pair::~connection_engine_pair() {
+    pn_transport_pair_free(pair_);
+}
+
+void connection_engine_pair::latency(duration d) {
+    pn_transport_pair_set_latency(pair_, pn_millis_t(d.milliseconds()));
+}
+
+void connection_engine_pair::bandwidth(size_t bytes_per_second) {
+    pn_transport_pair_set_bandwidth(pair_, bytes_per_second);
+}
+
+void connection_engine_pair::segment_size(size_t size) {
+    pn_transport_pair_set_segment_size(pair_, size);
+}
+
+timestamp connection_engine_pair::now() const {
+    return timestamp(pn_transport_pair_now(pair_));
+}
+
+timestamp connection_engine_pair::deadline() const {
+    return timestamp(pn_transport_pair_deadline(pair_));
+}
+
+size_t connection_engine_pair::in_flight() const {
+    return pn_transport_pair_in_flight(pair_);
+}
+
+bool connection_engine_pair::process() {
+    bool active;
+    do {
+        active = a_.dispatch();
+        active = b_.dispatch() || active;
+    } while (pn_transport_pair_pump(pair_));
+    return active;
+}
+
+bool connection_engine_pair::advance(duration d) {
+    pn_transport_pair_advance(pair_, pn_millis_t(d.milliseconds()));
+    return process();
+}
+
+}}
@@ -63,6 +63,7 @@ void swap(message& x, message& y) {
     swap(x.pn_msg_, y.pn_msg_);
     swap(x.body_, y.body_);
     swap(x.application_properties_, y.application_properties_);
+    swap(x.property_edits_, y.property_edits_);
     swap(x.message_annotations_, y.message_annotations_);
     swap(x.delivery_annotations_, y.delivery_annotations_);
 }
@@ -73,23 +74,33 @@ pn_message_t *message::pn_msg() const {
     return pn_msg_;
 }
 
+namespace {
+void check(int err) {
+    if (err) throw error(error_str(err));
+}
+} // namespace
+
+// Each map is held either encoded in the pn_message_t or decoded in the
+// map member (see MAP CACHING below), so copying both copies whichever
+// is the authority without disturbing the source.
 message& message::operator=(const message& m) {
     if (&m != this) {
-        // TODO aconway 2015-08-10: more efficient pn_message_copy function
-        std::vector<char> data;
-        m.encode(data);
-        decode(data);
+        if (m.pn_msg_)
+            check(pn_message_copy(pn_msg(), m.pn_msg_));
+        else
+            clear();
+        application_properties_ = m.application_properties_;
+        property_edits_ = m.property_edits_;
+        message_annotations_ = m.message_annotations_;
+        delivery_annotations_ = m.delivery_annotations_;
     }
     return *this;
 }
 
-void message::clear() { if (pn_msg_) pn_message_clear(pn_msg_); }
-
-namespace {
-void check(int err) {
-    if (err) throw error(error_str(err));
+void message::clear() {
+    if (pn_msg_) pn_message_clear(pn_msg_);
+    property_edits_.clear();
 }
-} // namespace
 
 void message::id(const message_id& id) { pn_message_set_id(pn_msg(), id.atom_); }
 
@@ -200,6 +211,42 @@ std::string message::reply_to_group_id() const {
     return s ? std::string(s) : std::string();
 }
 
+// Views read pn_msg_ directly so that looking at an empty message does
+// not allocate one.
+string_view message::user_view() const {
+    if (!pn_msg_) return string_view();
+    pn_bytes_t b = pn_message_get_user_id(pn_msg_);
+    return string_view(b.start, b.size);
+}
+
+string_view message::to_view() const {
+    return pn_msg_ ? string_view(pn_message_get_address(pn_msg_)) : string_view();
+}
+
+string_view message::reply_to_view() const {
+    return pn_msg_ ? string_view(pn_message_get_reply_to(pn_msg_)) : string_view();
+}
+
+string_view message::subject_view() const {
+    return pn_msg_ ? string_view(pn_message_get_subject(pn_msg_)) : string_view();
+}
+
+string_view message::content_type_view() const {
+    return pn_msg_ ? string_view(pn_message_get_content_type(pn_msg_)) : string_view();
+}
+
+string_view message::content_encoding_view() const {
+    return pn_msg_ ? string_view(pn_message_get_content_encoding(pn_msg_)) : string_view();
+}
+
+string_view message::group_id_view() const {
+    return pn_msg_ ? string_view(pn_message_get_group_id(pn_msg_)) : string_view();
+}
+
+string_view message::reply_to_group_id_view() const {
+    return pn_msg_ ? string_view(pn_message_get_reply_to_group_id(pn_msg_)) : string_view();
+}
+
 bool message::inferred() const { return pn_message_is_inferred(pn_msg()); }
 
 void message::inferred(bool b) { pn_message_set_inferred(pn_msg(), b); }
@@ -236,11 +283,177 @@ template<class M> M& put_map(pn_message_t* msg, pn_data_t* (*get)(pn_message_t*)
 }
 
 message::property_map& message::properties() {
-    return get_map(pn_msg(), pn_message_properties, application_properties_);
+    get_map(pn_msg(), pn_message_properties, application_properties_);
+    apply_property_edits();
+    return application_properties_;
 }
 
 const message::property_map& message::properties() const {
-    return get_map(pn_msg(), pn_message_properties, application_properties_);
+    get_map(pn_msg(), pn_message_properties, application_properties_);
+    apply_property_edits();
+    return application_properties_;
+}
+
+// PROPERTY EDITS: property() looks up a single key in the encoded properties
+// without decoding the rest. Changes made by key while the encoded map is the
+// authority are kept in property_edits_, and merged into the map member by
+// properties() or into the encoded map by encode(). When the map member is the
+// authority it is used directly and there are no edits.
+
+namespace {
+// Leave d at the value for key in an encoded map, false if there is none.
+bool find_property(pn_data_t* d, const string_view& key) {
+    pn_data_rewind(d);
+    if (!pn_data_next(d) || pn_data_type(d) != PN_MAP) return false;
+    pn_data_enter(d);
+    while (pn_data_next(d)) {
+        pn_type_t t = pn_data_type(d);
+        bool match = false;
+        if (t == PN_STRING || t == PN_SYMBOL) {
+            pn_bytes_t b = pn_data_get_bytes(d);
+            match = string_view(b.start, b.size) == key;
+        }
+        if (!pn_data_next(d)) return false;
+        if (match) return true;
+    }
+    return false;
+}
+} // namespace
+
+const message::property_edit* message::find_edit(const string_view& key) const {
+    for (property_edits::const_iterator i = property_edits_.begin(); i != property_edits_.end(); ++i)
+        if (string_view(i->key) == key) return &*i;
+    return 0;
+}
+
+scalar message::property(const string_view& key) const {
+    if (const property_edit* e = find_edit(key))
+        return e->removed ? scalar() : e->value;
+    if (!application_properties_.empty()) {
+        property_map::const_iterator i = application_properties_.find(key.str());
+        return i == application_properties_.end() ? scalar() : i->second;
+    }
+    scalar x;
+    if (!pn_msg_) return x;
+    pn_data_t* d = pn_message_properties(pn_msg_);
+    if (find_property(d, key)) {
+        type_id t = type_id(pn_data_type(d));
+        if (t != NULL_TYPE) {
+            if (!type_id_is_scalar(t)) {
+                pn_data_rewind(d);
+                throw conversion_error("expected scalar, found "+type_name(t));
+            }
+            x.set(pn_data_get_atom(d));
+        }
+    }
+    pn_data_rewind(d);
+    return x;
+}
+
+bool message::has_property(const string_view& key) const {
+    if (const property_edit* e = find_edit(key))
+        return !e->removed;
+    if (!application_properties_.empty())
+        return application_properties_.count(key.str());
+    if (!pn_msg_) return false;
+    pn_data_t* d = pn_message_properties(pn_msg_);
+    bool found = find_property(d, key);
+    pn_data_rewind(d);
+    return found;
+}
+
+void message::property(const std::string& key, const scalar& value) {
+    if (!application_properties_.empty()) {
+        application_properties_[key] = value;
+        return;
+    }
+    property_edit* e = const_cast<property_edit*>(find_edit(key));
+    if (!e) {
+        property_edits_.push_back(property_edit());
+        e = &property_edits_.back();
+        e->key = key;
+    }
+    e->value = value;
+    e->removed = false;
+}
+
+bool message::remove_property(const string_view& key) {
+    if (!application_properties_.empty())
+        return application_properties_.erase(key.str());
+    if (!has_property(key)) return false;
+    property_edit* e = const_cast<property_edit*>(find_edit(key));
+    if (!e) {
+        property_edits_.push_back(property_edit());
+        e = &property_edits_.back();
+        e->key = key.str();
+    }
+    e->value = scalar();
+    e->removed = true;
+    return true;
+}
+
+// Merge edits into the map member, which must be the authority.
+void message::apply_property_edits() const {
+    for (property_edits::const_iterator i = property_edits_.begin(); i != property_edits_.end(); ++i) {
+        if (i->removed)
+            application_properties_.erase(i->key);
+        else
+            application_properties_[i->key] = i->value;
+    }
+    property_edits_.clear();
+}
+
+// Merge edits into the encoded map, which must be the authority. Edited
+// properties keep their place, new ones are added at the end.
+void message::encode_property_edits() const {
+    if (property_edits_.empty()) return;
+    pn_data_t* props = pn_message_properties(pn_msg());
+    pn_data_t* merged = pn_data(0);
+    std::vector<bool> done(property_edits_.size());
+    pn_data_put_map(merged);
+    pn_data_enter(merged);
+    pn_data_rewind(props);
+    if (pn_data_next(props) && pn_data_type(props) == PN_MAP) {
+        pn_data_enter(props);
+        while (true) {
+            pn_data_narrow(props); // So pn_data_appendn starts at the next key
+            if (!pn_data_next(props)) break;
+            const property_edit* e = 0;
+            pn_type_t t = pn_data_type(props);
+            if (t == PN_STRING || t == PN_SYMBOL) {
+                pn_bytes_t b = pn_data_get_bytes(props);
+                e = find_edit(string_view(b.start, b.size));
+            }
+            if (!e) {
+                pn_data_appendn(merged, props, 2); // Key and value unchanged
+            } else {
+                done[e - &property_edits_[0]] = true;
+                if (!e->removed) {
+                    pn_data_appendn(merged, props, 1);
+                    pn_data_put_atom(merged, e->value.atom_);
+                }
+            }
+            pn_data_next(props);
+            pn_data_widen(props);
+        }
+        pn_data_widen(props);
+    }
+    for (size_t i = 0; i < property_edits_.size(); ++i) {
+        const property_edit& e = property_edits_[i];
+        if (!done[i] && !e.removed) {
+            pn_data_put_string(merged, pn_bytes(e.key));
+            pn_data_put_atom(merged, e.value.atom_);
+        }
+    }
+    pn_data_exit(merged);
+    pn_data_rewind(merged);
+    pn_data_next(merged);
+    if (pn_data_get_map(merged))
+        pn_data_copy(props, merged);
+    else
+        pn_data_clear(props);   // Don't send an empty section
+    pn_data_free(merged);
+    property_edits_.clear();
 }
 
 
@@ -262,6 +475,7 @@ const message::annotation_map& message::delivery_annotations() const {
 }
 
 void message::encode(std::vector<char> &s) const {
+    encode_property_edits();
     put_map(pn_msg(), pn_message_properties, application_properties_);
     put_map(pn_msg(), pn_message_annotations, message_annotations_);
     put_map(pn_msg(), pn_message_instructions, delivery_annotations_);
@@ -288,6 +502,7 @@ std::vector<char> message::encode() const {
 
 void message::decode(const std::vector<char> &s) {
     application_properties_.clear();
+    property_edits_.clear();
     message_annotations_.clear();
     delivery_annotations_.clear();
     check(pn_message_decode(pn_msg(), &s[0], s.size()));
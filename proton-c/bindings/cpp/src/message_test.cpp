@@ -137,6 +137,114 @@ void test_message_maps() {
     ASSERT(m2.message_annotations().empty());
 }
 
+void test_message_copy() {
+    message m("hello");
+    m.id("id");
+    m.durable(true);
+    m.properties()["foo"] = 12;
+    m.message_annotations()[23] = "23";
+    std::vector<char> encoded = m.encode();
+
+    // Copies are independent of each other and of the original.
+    message m2(m), m3;
+    m3 = m;
+    m2.properties()["foo"] = 13;
+    m2.body("changed");
+    ASSERT_EQUAL(scalar(12), m.properties()["foo"]);
+    ASSERT_EQUAL(scalar(12), m3.properties()["foo"]);
+    ASSERT_EQUAL("hello", get<std::string>(m3.body()));
+    ASSERT_EQUAL(message_id("id"), m3.id());
+    ASSERT(m3.durable());
+    ASSERT_EQUAL(scalar("23"), m3.message_annotations()[23]);
+    ASSERT(m3.encode() == encoded);
+    ASSERT(m.encode() == encoded);
+
+    // Copying an empty message empties the target.
+    m3 = message();
+    ASSERT(m3.properties().empty());
+    ASSERT(m3.body().empty());
+    ASSERT(!m3.durable());
+}
+
+#define CHECK_VIEW(ATTR) \
+    ASSERT(m.ATTR##_view().empty()); \
+    m.ATTR(#ATTR); \
+    ASSERT_EQUAL(proton::string_view(#ATTR), m.ATTR##_view())
+
+void test_message_views() {
+    message m;
+    CHECK_VIEW(user);
+    CHECK_VIEW(to);
+    CHECK_VIEW(reply_to);
+    CHECK_VIEW(subject);
+    CHECK_VIEW(content_type);
+    CHECK_VIEW(content_encoding);
+    CHECK_VIEW(group_id);
+    CHECK_VIEW(reply_to_group_id);
+
+    // A view looks at the message's own copy.
+    message m2(m);
+    ASSERT(m2.to_view().data() != m.to_view().data());
+    ASSERT_EQUAL(m.to_view(), m2.to_view());
+    ASSERT(message().to_view().empty());
+}
+
+}
+
+void test_message_property() {
+    message m;
+    ASSERT(!m.has_property("a"));
+    ASSERT(m.property("a").empty());
+    ASSERT(!m.remove_property("a"));
+
+    m.properties()["a"] = 1;
+    m.properties()["b"] = "bee";
+    m.properties()["c"] = 3.0;
+    message m2;
+    m2.decode(m.encode());
+
+    // Looked up in the encoded map
+    ASSERT(m2.has_property("a"));
+    ASSERT(!m2.has_property("x"));
+    ASSERT_EQUAL(scalar(1), m2.property("a"));
+    ASSERT_EQUAL(scalar("bee"), m2.property(std::string("b")));
+    ASSERT(m2.property("x").empty());
+
+    // Edits are seen straight away and spliced in on encode
+    m2.property("b", scalar("buzz"));
+    m2.property("d", scalar(4));
+    ASSERT(m2.remove_property("c"));
+    ASSERT(!m2.remove_property("c"));
+    ASSERT_EQUAL(scalar("buzz"), m2.property("b"));
+    ASSERT_EQUAL(scalar(4), m2.property("d"));
+    ASSERT(!m2.has_property("c"));
+
+    message m3(m2);
+    ASSERT_EQUAL(scalar("buzz"), m3.property("b"));
+    message m4;
+    m4.decode(m2.encode());
+    ASSERT_EQUAL(3u, m4.properties().size());
+    ASSERT_EQUAL(scalar(1), m4.properties()["a"]);
+    ASSERT_EQUAL(scalar("buzz"), m4.properties()["b"]);
+    ASSERT_EQUAL(scalar(4), m4.properties()["d"]);
+    ASSERT_EQUAL(3u, m3.properties().size());
+    ASSERT(!m3.has_property("c"));
+
+    // Once properties() is called the map is used directly
+    m4.property("e", scalar(true));
+    ASSERT(m4.remove_property("a"));
+    ASSERT_EQUAL(3u, m4.properties().size());
+    ASSERT_EQUAL(scalar(true), m4.property("e"));
+
+    // Removing everything leaves no properties
+    message m5;
+    m5.decode(m.encode());
+    m5.remove_property("a");
+    m5.remove_property("b");
+    m5.remove_property("c");
+    message m6;
+    m6.decode(m5.encode());
+    ASSERT(m6.properties().empty());
 }
 
 int main(int, char**) {
@@ -144,5 +252,8 @@ int main(int, char**) {
     RUN_TEST(failed, test_message_properties());
     RUN_TEST(failed, test_message_body());
     RUN_TEST(failed, test_message_maps());
+    RUN_TEST(failed, test_message_copy());
+    RUN_TEST(failed, test_message_views());
+    RUN_TEST(failed, test_message_property());
     return failed;
 }
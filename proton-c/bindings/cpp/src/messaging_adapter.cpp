@@ -41,6 +41,8 @@
 #include "proton/session.h"
 #include "proton/transport.h"
 
+#include <vector>
+
 namespace proton {
 
 namespace {
@@ -53,6 +55,18 @@ void credit_topup(pn_link_t *link) {
         }
     }
 }
+
+void tracker_outcome(handler &h, tracker &t, uint64_t rstate) {
+    if (rstate == PN_ACCEPTED) {
+        h.on_tracker_accept(t);
+    }
+    else if (rstate == PN_REJECTED) {
+        h.on_tracker_reject(t);
+    }
+    else if (rstate == PN_RELEASED || rstate == PN_MODIFIED) {
+        h.on_tracker_release(t);
+    }
+}
 }
 
 messaging_adapter::messaging_adapter(handler &delegate) : delegate_(delegate) {}
@@ -150,17 +164,8 @@ void messaging_adapter::on_delivery(proton_event &pe) {
         tracker t(make_wrapper<tracker>(dlv));
         // sender
         if (pn_delivery_updated(dlv)) {
-            uint64_t rstate = pn_delivery_remote_state(dlv);
-            if (rstate == PN_ACCEPTED) {
-                delegate_.on_tracker_accept(t);
-            }
-            else if (rstate == PN_REJECTED) {
-                delegate_.on_tracker_reject(t);
-            }
-            else if (rstate == PN_RELEASED || rstate == PN_MODIFIED) {
-                delegate_.on_tracker_release(t);
-            }
-
+            pn_delivery_clear(dlv);
+            tracker_outcome(delegate_, t, pn_delivery_remote_state(dlv));
             if (t.settled()) {
                 delegate_.on_tracker_settle(t);
             }
@@ -170,6 +175,44 @@ void messaging_adapter::on_delivery(proton_event &pe) {
     }
 }
 
+// A disposition settled a range of deliveries on a link in bulk settle
+// mode. Hand them to the handler together.
+void messaging_adapter::on_delivery_settle_range(proton_event &pe) {
+    pn_link_t *lnk = pn_event_link(pe.pn_event());
+    link_context& lctx = link_context::get(lnk);
+
+    std::vector<pn_delivery_t*> updated;
+    while (pn_delivery_t *dlv = pn_link_take_settled(lnk)) {
+        pn_delivery_clear(dlv);
+        updated.push_back(dlv);
+    }
+
+    if (pn_link_is_receiver(lnk)) {
+        for (size_t i = 0; i < updated.size(); ++i) {
+            delivery d(make_wrapper<delivery>(updated[i]));
+            if (d.settled())
+                delegate_.on_delivery_settle(d);
+        }
+        return;
+    }
+
+    std::vector<tracker> settled;
+    for (size_t i = 0; i < updated.size(); ++i) {
+        tracker t(make_wrapper<tracker>(updated[i]));
+        tracker_outcome(delegate_, t, pn_delivery_remote_state(updated[i]));
+        if (t.settled())
+            settled.push_back(t);
+    }
+    if (!settled.empty()) {
+        sender s(make_wrapper<sender>(lnk));
+        delegate_.on_delivery_settle_range(s, settled);
+    }
+    if (lctx.auto_settle) {
+        for (size_t i = 0; i < updated.size(); ++i)
+            pn_delivery_settle(updated[i]);
+    }
+}
+
 namespace {
 
 bool is_local_open(pn_state_t state) {
@@ -244,7 +287,8 @@ void messaging_adapter::on_session_remote_open(proton_event &pe) {
 }
 
 void messaging_adapter::on_link_local_open(proton_event &pe) {
-    credit_topup(pn_event_link(pe.pn_event()));
+    pn_link_t *lnk = pn_event_link(pe.pn_event());
+    credit_topup(lnk);
 }
 
 void messaging_adapter::on_link_remote_open(proton_event &pe) {
@@ -43,6 +43,7 @@ class messaging_adapter : public proton_handler
     void on_reactor_init(proton_event &e);
     void on_link_flow(proton_event &e);
     void on_delivery(proton_event &e);
+    void on_delivery_settle_range(proton_event &e);
     void on_connection_remote_open(proton_event &e);
     void on_connection_remote_close(proton_event &e);
     void on_session_remote_open(proton_event &e);
@@ -66,6 +66,7 @@ void proton_event::dispatch(proton_handler &handler) {
       case PN_LINK_FINAL: handler.on_link_final(*this); break;
 
       case PN_DELIVERY: handler.on_delivery(*this); break;
+      case PN_DELIVERY_SETTLE_RANGE: handler.on_delivery_settle_range(*this); break;
 
       case PN_TRANSPORT: handler.on_transport(*this); break;
       case PN_TRANSPORT_ERROR: handler.on_transport_error(*this); break;
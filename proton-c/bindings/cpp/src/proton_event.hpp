@@ -213,6 +213,12 @@ class proton_event
       */
       DELIVERY=PN_DELIVERY,
 
+      /**
+      * The remote peer settled a range of deliveries on a link in bulk
+      * settle mode. Events of this type point to the relevant link.
+      */
+      DELIVERY_SETTLE_RANGE=PN_DELIVERY_SETTLE_RANGE,
+
       /**
       * The transport has new data to read and/or write. Events of this
       * type point to the relevant transport.
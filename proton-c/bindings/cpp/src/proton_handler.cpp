@@ -56,6 +56,7 @@ void proton_handler::on_link_remote_detach(proton_event &e) { on_unhandled(e); }
 void proton_handler::on_link_flow(proton_event &e) { on_unhandled(e); }
 void proton_handler::on_link_final(proton_event &e) { on_unhandled(e); }
 void proton_handler::on_delivery(proton_event &e) { on_unhandled(e); }
+void proton_handler::on_delivery_settle_range(proton_event &e) { on_unhandled(e); }
 void proton_handler::on_transport(proton_event &e) { on_unhandled(e); }
 void proton_handler::on_transport_error(proton_event &e) { on_unhandled(e); }
 void proton_handler::on_transport_head_closed(proton_event &e) { on_unhandled(e); }
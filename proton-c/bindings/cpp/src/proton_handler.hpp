@@ -72,6 +72,7 @@ class proton_handler
     virtual void on_link_flow(proton_event &e);
     virtual void on_link_final(proton_event &e);
     virtual void on_delivery(proton_event &e);
+    virtual void on_delivery_settle_range(proton_event &e);
     virtual void on_transport(proton_event &e);
     virtual void on_transport_error(proton_event &e);
     virtual void on_transport_head_closed(proton_event &e);
@@ -95,6 +95,7 @@ class reactor : public internal::object<pn_reactor_t> {
     void yield();
 
   friend class container_impl;
+  friend class container_shard;
   friend class container_context;
   friend class internal::factory<reactor>;
 };
@@ -22,14 +22,26 @@
 #include "proton/reconnect_timer.hpp"
 #include "proton/error.hpp"
 #include "msg.hpp"
+#include "types_internal.hpp"
 #include "proton/types.h"
 #include "proton/reactor.h"
 
+#include <algorithm>
+
 namespace proton {
 
+namespace {
+// Pick a number of milliseconds from lo to hi inclusive.
+duration random_between(duration lo, duration hi) {
+    if (hi <= lo) return lo;
+    uint64_t range = hi.milliseconds() - lo.milliseconds() + 1;
+    return duration(lo.milliseconds() + duration::numeric_type(random_uint64() % range));
+}
+}
+
 reconnect_timer::reconnect_timer(uint32_t first, int32_t max, uint32_t increment,
-                                 bool doubling, int32_t max_retries, int32_t timeout) :
-    first_delay_(first), max_delay_(max), increment_(increment), doubling_(doubling),
+                                 bool doubling, int32_t max_retries, int32_t timeout, bool jitter) :
+    first_delay_(first), max_delay_(max), increment_(increment), doubling_(doubling), jitter_(jitter),
     max_retries_(max_retries), timeout_(timeout), retries_(0), next_delay_(-1), timeout_deadline_(0)
     {}
 
@@ -47,7 +59,10 @@ int reconnect_timer::next_delay(timestamp now) {
     if (retries_ == 1) {
         if (timeout_ >= duration(0))
             timeout_deadline_ = now + timeout_;
-        next_delay_ = first_delay_;
+        next_delay_ = jitter_ ? random_between(duration(0), first_delay_) : first_delay_;
+    } else if (jitter_) {
+        duration prev = std::max(next_delay_, increment_);
+        next_delay_ = random_between(increment_, prev + prev + prev);
     } else if (retries_ == 2) {
         next_delay_ = next_delay_ + increment_;
     } else {
@@ -23,6 +23,7 @@
 #include "proton/binary.hpp"
 #include "proton/decimal.hpp"
 #include "proton/scalar_base.hpp"
+#include "proton/string_view.hpp"
 #include "proton/symbol.hpp"
 #include "proton/timestamp.hpp"
 #include "proton/type_traits.hpp"
@@ -30,12 +31,15 @@
 
 #include <ostream>
 
+#include <string.h>
+
 namespace proton {
 namespace internal {
 
-scalar_base::scalar_base() { atom_.type = PN_NULL; }
-scalar_base::scalar_base(const pn_atom_t& a) { set(a); }
-scalar_base::scalar_base(const scalar_base& x) { set(x.atom_); }
+scalar_base::scalar_base() : heap_(0), heap_size_(0) { atom_.type = PN_NULL; }
+scalar_base::scalar_base(const pn_atom_t& a) : heap_(0), heap_size_(0) { set(a); }
+scalar_base::scalar_base(const scalar_base& x) : heap_(0), heap_size_(0) { set(x.atom_); }
+scalar_base::~scalar_base() { delete[] heap_; }
 
 scalar_base& scalar_base::operator=(const scalar_base& x) {
     if (this != &x)
@@ -45,18 +49,28 @@ scalar_base& scalar_base::operator=(const scalar_base& x) {
 
 type_id scalar_base::type() const { return type_id(atom_.type); }
 
-void scalar_base::set(const binary& x, pn_type_t t) {
+void scalar_base::set(const char* start, size_t size, pn_type_t t) {
+    char* p = small_;
+    if (size > sizeof(small_)) {
+        if (size > heap_size_) {
+            char* h = new char[size];
+            delete[] heap_;
+            heap_ = h;
+            heap_size_ = size;
+        }
+        p = heap_;
+    }
+    if (size) ::memmove(p, start, size);
     atom_.type = t;
-    bytes_ = x;
-    atom_.u.as_bytes = pn_bytes(bytes_);
+    atom_.u.as_bytes.start = p;
+    atom_.u.as_bytes.size = size;
 }
 
 void scalar_base::set(const pn_atom_t& atom) {
     if (type_id_is_string_like(type_id(atom.type))) {
-        set(bin(atom.u.as_bytes), atom.type);
+        set(atom.u.as_bytes.start, atom.u.as_bytes.size, atom.type);
     } else {
         atom_ = atom;
-        bytes_.clear();
     }
 }
 
@@ -77,10 +91,11 @@ void scalar_base::put_(const decimal32& x) { byte_copy(atom_.u.as_decimal32, x);
 void scalar_base::put_(const decimal64& x) { byte_copy(atom_.u.as_decimal64, x); atom_.type = PN_DECIMAL64; }
 void scalar_base::put_(const decimal128& x) { byte_copy(atom_.u.as_decimal128, x); atom_.type = PN_DECIMAL128; }
 void scalar_base::put_(const uuid& x) { byte_copy(atom_.u.as_uuid, x); atom_.type = PN_UUID; }
-void scalar_base::put_(const std::string& x) { set(binary(x), PN_STRING); }
-void scalar_base::put_(const symbol& x) { set(binary(x), PN_SYMBOL); }
-void scalar_base::put_(const binary& x) { set(x, PN_BINARY); }
-void scalar_base::put_(const char* x) { set(binary(std::string(x)), PN_STRING); }
+void scalar_base::put_(const std::string& x) { set(x.data(), x.size(), PN_STRING); }
+void scalar_base::put_(const symbol& x) { set(x.data(), x.size(), PN_SYMBOL); }
+void scalar_base::put_(const binary& x) { set(x.empty() ? 0 : reinterpret_cast<const char*>(&x[0]), x.size(), PN_BINARY); }
+void scalar_base::put_(const char* x) { set(x, ::strlen(x), PN_STRING); }
+void scalar_base::put_(const string_view& x) { set(x.data(), x.size(), PN_STRING); }
 void scalar_base::put_(const null&) { atom_.type = PN_NULL; }
 
 void scalar_base::ok(pn_type_t t) const {
@@ -104,9 +119,13 @@ void scalar_base::get_(decimal32& x) const { ok(PN_DECIMAL32); byte_copy(x, atom
 void scalar_base::get_(decimal64& x) const { ok(PN_DECIMAL64); byte_copy(x, atom_.u.as_decimal64); }
 void scalar_base::get_(decimal128& x) const { ok(PN_DECIMAL128); byte_copy(x, atom_.u.as_decimal128); }
 void scalar_base::get_(uuid& x) const { ok(PN_UUID); byte_copy(x, atom_.u.as_uuid); }
-void scalar_base::get_(std::string& x) const { ok(PN_STRING); x = std::string(bytes_.begin(), bytes_.end()); }
-void scalar_base::get_(symbol& x) const { ok(PN_SYMBOL); x = symbol(bytes_.begin(), bytes_.end()); }
-void scalar_base::get_(binary& x) const { ok(PN_BINARY); x = bytes_; }
+void scalar_base::get_(std::string& x) const { ok(PN_STRING); x.assign(atom_.u.as_bytes.start, atom_.u.as_bytes.size); }
+void scalar_base::get_(symbol& x) const { ok(PN_SYMBOL); x.assign(atom_.u.as_bytes.start, atom_.u.as_bytes.size); }
+void scalar_base::get_(binary& x) const { ok(PN_BINARY); x = bin(atom_.u.as_bytes); }
+void scalar_base::get_(string_view& x) const {
+    if (!type_id_is_string_like(type())) throw make_conversion_error(STRING, type());
+    x = string_view(atom_.u.as_bytes.start, atom_.u.as_bytes.size);
+}
 void scalar_base::get_(null&) const { ok(PN_NULL); }
 
 namespace {
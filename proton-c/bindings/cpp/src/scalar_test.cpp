@@ -119,6 +119,52 @@ void annotation_key_test() {
     ASSERT_EQUAL(scalar(symbol("foo")), annotation_key("foo"));
 }
 
+// Short and long strings are held differently, check both behave the same.
+void string_storage_test() {
+    std::string small("short"), big(100, 'x');
+    scalar a(small), b(big), c = binary(big);
+    ASSERT_EQUAL(small, a.get<std::string>());
+    ASSERT_EQUAL(big, b.get<std::string>());
+    ASSERT_EQUAL(binary(big), c.get<binary>());
+
+    scalar a2(a), b2(b);
+    a = big;                    // Small to big and back, copies unaffected
+    b = small;
+    ASSERT_EQUAL(small, a2.get<std::string>());
+    ASSERT_EQUAL(big, b2.get<std::string>());
+    ASSERT_EQUAL(big, a.get<std::string>());
+    ASSERT_EQUAL(small, b.get<std::string>());
+    a = 42;
+    a = symbol(big);
+    ASSERT_EQUAL(symbol(big), a.get<symbol>());
+
+    value v(b2);                // Round trip through the codec
+    ASSERT_EQUAL(b2, get<scalar>(v));
+}
+
+void string_view_test() {
+    scalar a("foo");
+    ASSERT_EQUAL(proton::string_view("foo"), a.get<proton::string_view>());
+    a = symbol("sym");
+    ASSERT_EQUAL(proton::string_view("sym"), a.get<proton::string_view>());
+    a = binary("bin");
+    ASSERT_EQUAL(proton::string_view("bin"), get<proton::string_view>(a));
+    a = 42;
+    ASSERT_MISMATCH(a.get<proton::string_view>(), STRING, INT);
+
+    std::string s("abc");
+    scalar b(proton::string_view(s.data(), 2));
+    ASSERT_EQUAL(STRING, b.type());
+    ASSERT_EQUAL("ab", b.get<std::string>());
+
+    ASSERT(proton::string_view() == proton::string_view(""));
+    ASSERT(proton::string_view("ab") < proton::string_view("abc"));
+    ASSERT(proton::string_view("abc") < proton::string_view("b"));
+    ASSERT(proton::string_view("abc") == s);
+    ASSERT("abd" != proton::string_view(s));
+    ASSERT_EQUAL("abc", proton::string_view(s).str());
+}
+
 template <class T> T make(const char c) { T x; std::fill(x.begin(), x.end(), c); return x; }
 
 }
@@ -150,5 +196,7 @@ int main(int, char**) {
     RUN_TEST(failed, message_id_test());
     RUN_TEST(failed, annotation_key_test());
     RUN_TEST(failed, coerce_test());
+    RUN_TEST(failed, string_storage_test());
+    RUN_TEST(failed, string_view_test());
     return failed;
 }
@@ -69,6 +69,7 @@ class sender_options::impl {
     option<proton_handler*> handler;
     option<proton::delivery_mode> delivery_mode;
     option<bool> auto_settle;
+    option<bool> bulk_settle;
     option<source_options> source;
     option<target_options> target;
 
@@ -77,6 +78,7 @@ class sender_options::impl {
             if (delivery_mode.set) set_delivery_mode(s, delivery_mode.value);
             if (handler.set && handler.value) set_handler(s, *handler.value);
             if (auto_settle.set) get_context(s).auto_settle = auto_settle.value;
+            if (bulk_settle.set) pn_link_set_bulk_settle(unwrap(s), bulk_settle.value);
             if (source.set) {
                 proton::source local_s(make_wrapper<proton::source>(pn_link_source(unwrap(s))));
                 source.value.apply(local_s);
@@ -92,6 +94,7 @@ class sender_options::impl {
         handler.update(x.handler);
         delivery_mode.update(x.delivery_mode);
         auto_settle.update(x.auto_settle);
+        bulk_settle.update(x.bulk_settle);
         source.update(x.source);
         target.update(x.target);
     }
@@ -114,6 +117,7 @@ void sender_options::update(const sender_options& x) { impl_->update(*x.impl_);
 sender_options& sender_options::handler(class handler *h) { impl_->handler = h->messaging_adapter_.get(); return *this; }
 sender_options& sender_options::delivery_mode(proton::delivery_mode m) {impl_->delivery_mode = m; return *this; }
 sender_options& sender_options::auto_settle(bool b) {impl_->auto_settle = b; return *this; }
+sender_options& sender_options::bulk_settle(bool b) {impl_->bulk_settle = b; return *this; }
 sender_options& sender_options::source(source_options &s) {impl_->source = s; return *this; }
 sender_options& sender_options::target(target_options &s) {impl_->target = s; return *this; }
 
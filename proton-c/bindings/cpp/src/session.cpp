@@ -57,8 +57,14 @@ connection session::connection() const {
 }
 
 namespace {
-std::string next_link_name(const connection& c) {
-    return connection_context::get(c).link_gen.next();
+// Make a link with the next generated name, formatted on the stack since
+// pn_sender and pn_receiver copy it.
+pn_link_t* new_link(pn_session_t* s, const connection& c, pn_link_t* (*make)(pn_session_t*, const char*)) {
+    id_generator& gen = connection_context::get(c).link_gen;
+    char name[128];
+    if (gen.next(name, sizeof(name)))
+        return make(s, name);
+    return make(s, gen.next().c_str());
 }
 }
 
@@ -67,7 +73,7 @@ sender session::open_sender(const std::string &addr) {
 }
 
 sender session::open_sender(const std::string &addr, const sender_options &so) {
-    pn_link_t *lnk = pn_sender(pn_object(), next_link_name(connection()).c_str());
+    pn_link_t *lnk = new_link(pn_object(), connection(), pn_sender);
     pn_terminus_set_address(pn_link_target(lnk), addr.c_str());
     sender snd(make_wrapper<sender>(lnk));
     snd.open(so);
@@ -80,7 +86,7 @@ receiver session::open_receiver(const std::string &addr) {
 
 receiver session::open_receiver(const std::string &addr, const receiver_options &ro)
 {
-    pn_link_t *lnk = pn_receiver(pn_object(), next_link_name(connection()).c_str());
+    pn_link_t *lnk = new_link(pn_object(), connection(), pn_receiver);
     pn_terminus_set_address(pn_link_source(lnk), addr.c_str());
     receiver rcv(make_wrapper<receiver>(lnk));
     rcv.open(ro);
@@ -64,6 +64,14 @@ ssl_domain& internal::ssl_domain::operator=(const ssl_domain&x) {
 
 ssl_domain::~ssl_domain() { if (impl_) impl_->decref(); }
 
+uint64_t ssl_domain::session_hits() const {
+    return impl_ ? pn_ssl_domain_get_session_hits(impl_->pn_domain()) : 0;
+}
+
+uint64_t ssl_domain::session_misses() const {
+    return impl_ ? pn_ssl_domain_get_session_misses(impl_->pn_domain()) : 0;
+}
+
 pn_ssl_domain_t *ssl_domain::pn_domain() {
     if (!impl_)
         // Lazily create in case never actually used or configured.
@@ -17,29 +17,15 @@
  * under the License.
  */
 
-///@internal
-#include "proton/types_fwd.hpp"
 
-#ifndef ID_GENERATOR_HPP
-#define ID_GENERATOR_HPP
+#include <proton/string_view.hpp>
 
-namespace proton {
-
-/// @cond INTERNAL
-class id_generator {
-  public:
-    id_generator(const std::string &prefix="");
-    std::string next();
-    void prefix(const std::string &p) { prefix_ = p; }
-    const std::string& prefix() const { return prefix_; }
+#include <ostream>
 
-  private:
-    std::string prefix_;
-    uint64_t count_;
-};
+namespace proton {
 
+std::ostream& operator<<(std::ostream& o, const string_view& x) {
+    return o.write(x.data(), std::streamsize(x.size()));
 }
 
-/// @endcond
-
-#endif
+}
@@ -26,8 +26,11 @@
 #include "proton/ssl.hpp"
 #include "proton/sasl.hpp"
 #include "proton/transport.h"
+#include "proton/metrics.h"
 #include "proton/error.h"
 
+#include <cstring>
+
 #include "msg.hpp"
 #include "proton_bits.hpp"
 
@@ -50,4 +53,32 @@ error_condition transport::error() const {
     return make_wrapper(pn_transport_condition(pn_object()));
 }
 
+transport_metrics::transport_metrics() {
+    std::memset(this, 0, sizeof(*this));
+}
+
+transport_metrics transport::metrics() const {
+    pn_transport_metrics_t m;
+    pn_transport_metrics_copy(pn_object(), &m);
+    transport_metrics r;
+    for (int i = 0; i < PN_PERFORMATIVE_CT; ++i) {
+        r.input_[i].frames = m.input[i].frames;
+        r.input_[i].bytes = m.input[i].bytes;
+        r.output_[i].frames = m.output[i].frames;
+        r.output_[i].bytes = m.output[i].bytes;
+    }
+    r.frames_input_ = m.frames_input;
+    r.frames_output_ = m.frames_output;
+    r.bytes_input_ = m.bytes_input;
+    r.bytes_output_ = m.bytes_output;
+    r.bytes_copied_ = m.bytes_copied;
+    r.output_high_water_ = m.output_high_water;
+    r.deliveries_sent_ = m.deliveries_sent;
+    r.deliveries_received_ = m.deliveries_received;
+    r.deliveries_settled_ = m.deliveries_settled;
+    r.credit_stalls_ = m.credit_stalls;
+    r.window_stalls_ = m.window_stalls;
+    return r;
+}
+
 }
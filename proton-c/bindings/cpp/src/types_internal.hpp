@@ -70,5 +70,8 @@ struct ios_guard {
 // as a numeric byte value, not a character and will not get sign-extended.
 inline unsigned int printable_byte(uint8_t byte) { return byte; }
 
+// Next value from the calling thread's pseudo-random generator, see uuid.cpp.
+uint64_t random_uint64();
+
 }
 #endif // TYPES_INTERNAL_HPP
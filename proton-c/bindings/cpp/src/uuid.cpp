@@ -22,10 +22,11 @@
 #include <proton/uuid.hpp>
 #include <proton/types_fwd.hpp>
 
-#include <cstdlib>
+#include <algorithm>
 #include <ctime>
-#include <sstream>
-#include <iomanip>
+#include <ostream>
+
+#include <stdio.h>
 
 #ifdef WIN32
 #include <process.h>
@@ -35,22 +36,55 @@
 #define GETPID getpid
 #endif
 
+#if defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL            // Shared by all threads, not thread safe.
+#endif
+
 namespace proton {
 
 namespace {
 
+// Each thread has its own splitmix64 generator, so uuid::random() needs no
+// lock. Threads are seeded separately on first use.
+THREAD_LOCAL uint64_t rand_state;
+THREAD_LOCAL bool rand_seeded;
 
-// Seed the random number generated once at startup.
-struct seed {
-    seed() {
-        // A hash of time and PID, time alone is a bad seed as programs started
-        // within the same second will get the same seed.
-        long secs = time(0);
-        long pid = GETPID();
-        std::srand(((secs*181)*((pid-83)*359))%104729);
-    }
-} seed_;
+// 64 bit constants built from 32 bit halves, C++03 has no long long literals.
+const uint64_t GOLDEN = (uint64_t(0x9e3779b9) << 32) | 0x7f4a7c15;
+const uint64_t MIX1 = (uint64_t(0xbf58476d) << 32) | 0x1ce4e5b9;
+const uint64_t MIX2 = (uint64_t(0x94d049bb) << 32) | 0x133111eb;
 
+uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * MIX1;
+    z = (z ^ (z >> 27)) * MIX2;
+    return z ^ (z >> 31);
+}
+
+}
+
+uint64_t random_uint64() {
+    if (!rand_seeded) {
+        uint64_t seed = 0;
+#ifndef WIN32
+        FILE* f = fopen("/dev/urandom", "rb");
+        if (f) {
+            if (fread(&seed, sizeof(seed), 1, f) != 1) seed = 0;
+            fclose(f);
+        }
+#endif
+        // Mix in the time, the process and the thread, in case there is
+        // no system source or it failed.
+        seed ^= mix(uint64_t(time(0)) ^ (uint64_t(clock()) << 32));
+        seed ^= mix(uint64_t(GETPID()) + GOLDEN);
+        seed ^= mix(uint64_t(reinterpret_cast<uintptr_t>(&rand_state)));
+        rand_state = seed;
+        rand_seeded = true;
+    }
+    return mix(rand_state += GOLDEN);
 }
 
 uuid uuid::copy() {
@@ -70,11 +104,10 @@ uuid uuid::copy(const char* bytes) {
 
 uuid uuid::random() {
     uuid bytes;
-    int r = std::rand();
-    for (size_t i = 0; i < bytes.size(); ++i ) {
-        bytes[i] = r & 0xFF;
-        r >>= 8;
-        if (!r) r = std::rand();
+    for (size_t i = 0; i < bytes.size(); i += sizeof(uint64_t)) {
+        uint64_t r = random_uint64();
+        for (size_t j = 0; j < sizeof(uint64_t); ++j, r >>= 8)
+            bytes[i + j] = char(r & 0xFF);
     }
 
     // From RFC4122, the version bits are set to 0100
@@ -85,26 +118,33 @@ uuid uuid::random() {
     return bytes;
 }
 
-/// UUID standard format: 8-4-4-4-12 (36 chars, 32 alphanumeric and 4 hypens)
-std::ostream& operator<<(std::ostream& o, const uuid& u) {
-    ios_guard restore_flags(o);
-    o << std::hex << std::setfill('0');
-    static const int segments[] = {4,2,2,2,6}; // 1 byte is 2 hex chars.
+namespace {
+// Standard format: 8-4-4-4-12 (36 chars, 32 alphanumeric and 4 hypens)
+const size_t STR_SIZE = 36;
+
+void format(const uuid& u, char* buf) {
+    static const char digits[] = "0123456789abcdef";
     const uint8_t *p = reinterpret_cast<const uint8_t*>(u.begin());
-    for (size_t i = 0; i < sizeof(segments)/sizeof(segments[0]); ++i) {
-        if (i > 0)
-            o << '-';
-        for (int j = 0; j < segments[i]; ++j) {
-            o << std::setw(2) << printable_byte(*(p++));
-        }
+    for (size_t i = 0; i < u.size(); ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10)
+            *buf++ = '-';
+        *buf++ = digits[p[i] >> 4];
+        *buf++ = digits[p[i] & 0xF];
     }
-    return o;
+}
+}
+
+/// UUID standard format: 8-4-4-4-12 (36 chars, 32 alphanumeric and 4 hypens)
+std::ostream& operator<<(std::ostream& o, const uuid& u) {
+    char buf[STR_SIZE];
+    format(u, buf);
+    return o.write(buf, STR_SIZE);
 }
 
 std::string uuid::str() const {
-    std::ostringstream s;
-    s << *this;
-    return s.str();
+    char buf[STR_SIZE];
+    format(*this, buf);
+    return std::string(buf, STR_SIZE);
 }
 
 }
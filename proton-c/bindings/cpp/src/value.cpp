@@ -40,21 +40,34 @@ value& value::operator=(value&& x) { swap(*this, x); return *this; }
 
 value& value::operator=(const value& x) {
     if (this != &x) {
-        if (x.empty())
+        if (const scalar* s = x.held_scalar()) {
+            put_scalar(*s);
+        } else if (x.empty()) {
             clear();
-        else
-            data().copy(x.data());
+        } else if (!data_ && type_id_is_scalar(x.type())) {
+            decoder d(x);       // Hold a copy of an encoded scalar inline
+            d >> *this;
+        } else {
+            new_data().copy(x.data());
+        }
     }
     return *this;
 }
 
-void swap(value& x, value& y) { std::swap(x.data_, y.data_); }
+void swap(value& x, value& y) {
+    std::swap(x.data_, y.data_);
+    std::swap(x.scalar_, y.scalar_);
+}
 
-void value::clear() { if (!!data_) data_.clear(); }
+void value::clear() {
+    scalar_.clear();
+    if (!!data_) data_.clear();
+}
 
 namespace internal {
 
 type_id value_base::type() const {
+    if (const scalar* s = held_scalar()) return s->type();
     return (!data_ || data_.empty()) ? NULL_TYPE : codec::decoder(*this).next_type();
 }
 
@@ -62,11 +75,43 @@ bool value_base::empty() const { return type() == NULL_TYPE; }
 
 // On demand
 codec::data& value_base::data() const {
+    if (!data_)
+        data_ = codec::data::create();
+    if (const scalar* s = held_scalar()) {
+        codec::encoder e(data_);
+        e.clear();
+        e << *s;
+        scalar_.clear();
+    }
+    return data_;
+}
+
+codec::data& value_base::new_data() {
+    scalar_.clear();
     if (!data_)
         data_ = codec::data::create();
     return data_;
 }
 
+// Reading a held scalar through a decoder must not stop it being held.
+codec::data value_base::encoded() const {
+    if (const scalar* s = held_scalar()) {
+        codec::encoder e(codec::data::create());
+        e << *s;
+        return e;
+    }
+    return data();
+}
+
+void value_base::put_scalar(const scalar_base& x) {
+    if (!data_) {
+        scalar_.set(x.atom_);
+    } else {
+        codec::encoder e(*this);
+        e << x;
+    }
+}
+
 }
 
 namespace {
@@ -160,12 +205,16 @@ int compare(const value& x, const value& y) {
 } // namespace
 
 bool operator==(const value& x, const value& y) {
+    const scalar *sx = x.held_scalar(), *sy = y.held_scalar();
+    if (sx && sy) return *sx == *sy;
     if (x.empty() && y.empty()) return true;
     if (x.empty() || y.empty()) return false;
     return compare(x, y) == 0;
 }
 
 bool operator<(const value& x, const value& y) {
+    const scalar *sx = x.held_scalar(), *sy = y.held_scalar();
+    if (sx && sy) return *sx < *sy;
     if (x.empty() && y.empty()) return false;
     if (x.empty()) return true; // empty is < !empty
     return compare(x, y) < 0;
@@ -147,6 +147,51 @@ void get_coerce_test() {
     try { get<symbol>(value(std::string())); FAIL("string as symbol"); } catch (conversion_error) {}
 }
 
+// Scalars are held inline, compound values are encoded.
+void held_scalar_test() {
+    value v(42), s("foo"), l(std::vector<int>(2, 1));
+    ASSERT(v.held_scalar());
+    ASSERT(s.held_scalar());
+    ASSERT(!l.held_scalar());
+    ASSERT(!value().held_scalar());
+    ASSERT_EQUAL(scalar(42), *v.held_scalar());
+
+    // Reading through a decoder leaves the scalar held.
+    ASSERT_EQUAL(42, coerce<int64_t>(v));
+    ASSERT_EQUAL("42", str(v));
+    ASSERT(v.held_scalar());
+
+    // Held and encoded scalars compare and copy alike.
+    value e(codec::data::create());
+    codec::encoder(e) << 42;
+    ASSERT(!e.held_scalar());
+    ASSERT_EQUAL(v, e);
+    ASSERT(value(41) < e && e < value(43));
+    value c(e);
+    ASSERT(c.held_scalar());
+    ASSERT_EQUAL(v, c);
+
+    // Compound to scalar and back.
+    l = 1;
+    ASSERT_EQUAL(1, get<int>(l));
+    l = std::vector<int>(2, 1);
+    ASSERT_EQUAL(LIST == l.type() || ARRAY == l.type(), true);
+    swap(l, v);
+    ASSERT_EQUAL(42, get<int>(l));
+    ASSERT_EQUAL(2u, get<std::vector<int> >(v).size());
+
+    // Decoded map values are held.
+    std::map<std::string, value> m;
+    m["a"] = 1;
+    m["b"] = "two";
+    value vm(m);
+    std::map<std::string, value> m2;
+    get(vm, m2);
+    ASSERT(m2["a"].held_scalar());
+    ASSERT(m2["b"].held_scalar());
+    ASSERT_EQUAL(value("two"), m2["b"]);
+}
+
 }
 
 int main(int, char**) {
@@ -224,5 +269,6 @@ int main(int, char**) {
 
     RUN_TEST(failed, get_coerce_test());
     RUN_TEST(failed, null_test());
+    RUN_TEST(failed, held_scalar_test());
     return failed;
 }
@@ -77,6 +77,7 @@ const (
 	ETransportHeadClosed    EventType = C.PN_TRANSPORT_HEAD_CLOSED
 	ETransportTailClosed    EventType = C.PN_TRANSPORT_TAIL_CLOSED
 	ETransportClosed        EventType = C.PN_TRANSPORT_CLOSED
+	EDeliverySettleRange    EventType = C.PN_DELIVERY_SETTLE_RANGE
 )
 
 func (e EventType) String() string {
@@ -142,6 +143,8 @@ func (e EventType) String() string {
 		return "TransportTailClosed"
 	case C.PN_TRANSPORT_CLOSED:
 		return "TransportClosed"
+	case C.PN_DELIVERY_SETTLE_RANGE:
+		return "DeliverySettleRange"
 	}
 	return "Unknown"
 }
@@ -336,6 +339,15 @@ func (l Link) RemoteSndSettleMode() SndSettleMode {
 func (l Link) RemoteRcvSettleMode() RcvSettleMode {
 	return RcvSettleMode(C.pn_link_remote_rcv_settle_mode(l.pn))
 }
+func (l Link) SetBulkSettle(bulk bool) {
+	C.pn_link_set_bulk_settle(l.pn, C.bool(bulk))
+}
+func (l Link) BulkSettle() bool {
+	return bool(C.pn_link_get_bulk_settle(l.pn))
+}
+func (l Link) TakeSettled() Delivery {
+	return Delivery{C.pn_link_take_settled(l.pn)}
+}
 func (l Link) Unsettled() int {
 	return int(C.pn_link_unsettled(l.pn))
 }
@@ -777,6 +789,12 @@ func (t Transport) RequireEncryption(required bool) {
 func (t Transport) IsEncrypted() bool {
 	return bool(C.pn_transport_is_encrypted(t.pn))
 }
+func (t Transport) SetCoalesceEvents(coalesce bool) {
+	C.pn_transport_set_coalesce_events(t.pn, C.bool(coalesce))
+}
+func (t Transport) CoalesceEvents() bool {
+	return bool(C.pn_transport_get_coalesce_events(t.pn))
+}
 func (t Transport) Condition() Condition {
 	return Condition{C.pn_transport_condition(t.pn)}
 }
@@ -3865,6 +3865,7 @@ class Event(Wrapper, EventBase):
   LINK_FINAL = _core(PN_LINK_FINAL, "on_link_final")
 
   DELIVERY = _core(PN_DELIVERY, "on_delivery")
+  DELIVERY_SETTLE_RANGE = _core(PN_DELIVERY_SETTLE_RANGE, "on_delivery_settle_range")
 
   TRANSPORT = _core(PN_TRANSPORT, "on_transport")
   TRANSPORT_ERROR = _core(PN_TRANSPORT_ERROR, "on_transport_error")
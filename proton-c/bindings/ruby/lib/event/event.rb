@@ -106,6 +106,8 @@ module Qpid::Proton
 
     # A delivery has been created or updated.
     DELIVERY = event_type(:PN_DELIVERY)
+    # A range of deliveries on a link in bulk settle mode has been settled.
+    DELIVERY_SETTLE_RANGE = event_type(:PN_DELIVERY_SETTLE_RANGE)
 
     # A transport has new data to read and/or write.
     TRANSPORT = event_type(:PN_TRANSPORT)
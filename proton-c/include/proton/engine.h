@@ -38,5 +38,7 @@
 #include <proton/delivery.h>
 #include <proton/event.h>
 #include <proton/transport.h>
+#include <proton/metrics.h>
+#include <proton/transport_pair.h>
 
 #endif /* engine.h */
@@ -302,7 +302,16 @@ typedef enum {
   PN_SELECTABLE_WRITABLE,
   PN_SELECTABLE_ERROR,
   PN_SELECTABLE_EXPIRED,
-  PN_SELECTABLE_FINAL
+  PN_SELECTABLE_FINAL,
+
+  /**
+   * The remote peer settled a range of deliveries on a link in bulk
+   * settle mode (see ::pn_link_set_bulk_settle). This is issued in
+   * place of a ::PN_DELIVERY event for each delivery in the range.
+   * Events of this type point to the relevant link, and the deliveries
+   * are taken with ::pn_link_take_settled.
+   */
+  PN_DELIVERY_SETTLE_RANGE
 
 } pn_event_type_t;
 
@@ -96,7 +96,36 @@ PN_EXTERN pn_io_t *pn_io(void);
 PN_EXTERN void pn_io_free(pn_io_t *io);
 PN_EXTERN pn_error_t *pn_io_error(pn_io_t *io);
 PN_EXTERN pn_socket_t pn_connect(pn_io_t *io, const char *host, const char *port);
+/**
+ * Create a socket listening on host and port.
+ *
+ * The socket is non-blocking, like every ::pn_socket_t: ::pn_accept()
+ * does not wait for a connection. When none is queued it returns
+ * PN_INVALID_SOCKET with ::pn_wouldblock() true, so wait for the socket
+ * to be readable, for example with a ::pn_selector_t, before accepting.
+ */
 PN_EXTERN pn_socket_t pn_listen(pn_io_t *io, const char *host, const char *port);
+/**
+ * Set the length of the pending connection queue of sockets created by
+ * later calls to ::pn_listen(). The default, or a backlog <= 0, is the
+ * system maximum (SOMAXCONN).
+ */
+PN_EXTERN void pn_io_set_listen_backlog(pn_io_t *io, int backlog);
+/**
+ * Set SO_REUSEPORT on sockets created by later calls to ::pn_listen(), so
+ * several listeners can share a port and the kernel spreads incoming
+ * connections between them.
+ *
+ * @return 0 on success, PN_ERR if the platform does not support it.
+ */
+PN_EXTERN int pn_io_set_reuse_port(pn_io_t *io, bool reuse);
+/**
+ * Accept a connection queued on a socket from ::pn_listen().
+ *
+ * @return the new non-blocking socket, or PN_INVALID_SOCKET if there is
+ * none. ::pn_wouldblock() is then true if the queue was empty, otherwise
+ * ::pn_io_error() holds the error.
+ */
 PN_EXTERN pn_socket_t pn_accept(pn_io_t *io, pn_socket_t socket, char *name, size_t size);
 PN_EXTERN void pn_close(pn_io_t *io, pn_socket_t socket);
 PN_EXTERN ssize_t pn_send(pn_io_t *io, pn_socket_t socket, const void *buf, size_t size);
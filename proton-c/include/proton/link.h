@@ -540,6 +540,42 @@ PN_EXTERN pn_snd_settle_mode_t pn_link_remote_snd_settle_mode(pn_link_t *link);
  */
 PN_EXTERN pn_rcv_settle_mode_t pn_link_remote_rcv_settle_mode(pn_link_t *link);
 
+/**
+ * Set the bulk settle mode on a link.
+ *
+ * By default a ::PN_DELIVERY event is issued for every delivery whose
+ * remote disposition changes. In bulk settle mode a disposition that
+ * settles a range of deliveries on the link issues a single
+ * ::PN_DELIVERY_SETTLE_RANGE event for the link instead. A range that
+ * is updated but not settled still issues ::PN_DELIVERY events. The affected
+ * deliveries are still updated (see ::pn_delivery_updated) and are taken
+ * one by one with ::pn_link_take_settled.
+ *
+ * @param[in] link a link object
+ * @param[in] bulk true to enable bulk settle mode
+ */
+PN_EXTERN void pn_link_set_bulk_settle(pn_link_t *link, bool bulk);
+
+/**
+ * Get the bulk settle mode of a link.
+ *
+ * @param[in] link a link object
+ * @return true if and only if the link is in bulk settle mode
+ */
+PN_EXTERN bool pn_link_get_bulk_settle(pn_link_t *link);
+
+/**
+ * Take the next delivery settled by the peer in bulk settle mode.
+ *
+ * Deliveries are taken in the order the peer settled them, and each is
+ * taken once. A delivery settled locally before it is taken is dropped.
+ *
+ * @param[in] link a link object
+ * @return the next delivery reported by a ::PN_DELIVERY_SETTLE_RANGE
+ * event, or NULL if there are none left
+ */
+PN_EXTERN pn_delivery_t *pn_link_take_settled(pn_link_t *link);
+
 /**
  * Get the number of unsettled deliveries for a link.
  *
@@ -81,6 +81,19 @@ PN_EXTERN void           pn_message_free(pn_message_t *msg);
  */
 PN_EXTERN void           pn_message_clear(pn_message_t *msg);
 
+/**
+ * Copy the content of one ::pn_message_t into another.
+ *
+ * The properties and sections of src are copied field by field into
+ * dst, replacing whatever dst held, without encoding src or decoding
+ * the result. The two messages share nothing afterwards.
+ *
+ * @param[in] dst the message to copy into
+ * @param[in] src the message to copy from
+ * @return zero on success or an error code on failure
+ */
+PN_EXTERN int            pn_message_copy(pn_message_t *dst, pn_message_t *src);
+
 /**
  * Access the error code of a message.
  *
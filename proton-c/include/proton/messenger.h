@@ -450,8 +450,53 @@ PN_EXTERN int pn_messenger_set_incoming_window(pn_messenger_t *messenger,
                                                int window);
 
 /**
- * Currently a no-op placeholder. For future compatibility, do not
- * send or receive messages before starting the messenger.
+ * Keep a messenger's outgoing messages in a journal so they survive a
+ * crash or restart.
+ *
+ * Each message is written once to a memory mapped segment file in the
+ * directory at path, which is created if needed. Writes are flushed
+ * to disk in batches: whenever the messenger does I/O, and at least
+ * every 64 messages. Segments are rotated when full and deleted once
+ * none of their messages are outstanding.
+ *
+ * Durability is deferred to the next flush, so a message may not be
+ * on disk yet when ::pn_messenger_put returns, and a crash can lose
+ * messages put since the last flush. A message is always flushed
+ * before any of it is sent.
+ *
+ * A message stays in the journal until it has an outcome, or until it
+ * leaves the outgoing window without one (see
+ * ::pn_messenger_set_outgoing_window). With a window of zero a message
+ * counts as done when it is handed to a link, so use an outgoing
+ * window for at least once delivery.
+ *
+ * Messages left in the journal by a previous messenger are put again
+ * by ::pn_messenger_start. Only one messenger may use a journal
+ * directory at a time.
+ *
+ * Must be called before any messages are put. Journals are not
+ * supported on Windows.
+ *
+ * @param[in] messenger a messenger object
+ * @param[in] path the journal directory
+ * @return an error code or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_set_journal(pn_messenger_t *messenger, const char *path);
+
+/**
+ * Get the journal directory of a messenger.
+ *
+ * @param[in] messenger a messenger object
+ * @return the path set with ::pn_messenger_set_journal or NULL
+ */
+PN_EXTERN const char *pn_messenger_get_journal(pn_messenger_t *messenger);
+
+/**
+ * Puts any messages left in the journal (see
+ * ::pn_messenger_set_journal), otherwise a no-op placeholder. For
+ * future compatibility, do not send or receive messages before
+ * starting the messenger.
  *
  * @param[in] messenger the messenger to start
  * @return an error code or zero on success
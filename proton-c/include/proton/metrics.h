@@ -0,0 +1,276 @@
+#ifndef PROTON_METRICS_H
+#define PROTON_METRICS_H 1
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/import_export.h>
+#include <proton/type_compat.h>
+#include <proton/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file
+ * Counters kept by the engine while it works.
+ *
+ * Every transport, session and link keeps a set of counters that the
+ * engine updates as frames and deliveries pass through it. The
+ * counters are always on and cost an increment or two per frame.
+ *
+ * The structures returned by ::pn_transport_metrics,
+ * ::pn_session_metrics and ::pn_link_metrics are updated in place by
+ * whichever thread is driving the transport, and should only be read
+ * through by that thread. Other threads can take a copy without
+ * locking with ::pn_transport_metrics_copy, ::pn_session_metrics_copy
+ * and ::pn_link_metrics_copy, for as long as the owner exists. Each
+ * counter is copied whole and only ever grows, but counters copied
+ * while the transport is busy may come from slightly different moments.
+ *
+ * @defgroup metrics Metrics
+ * @ingroup transport
+ * @{
+ */
+
+/**
+ * The kinds of frame counted separately by ::pn_transport_metrics_t.
+ */
+typedef enum {
+  PN_PERFORMATIVE_OPEN,
+  PN_PERFORMATIVE_BEGIN,
+  PN_PERFORMATIVE_ATTACH,
+  PN_PERFORMATIVE_FLOW,
+  PN_PERFORMATIVE_TRANSFER,
+  PN_PERFORMATIVE_DISPOSITION,
+  PN_PERFORMATIVE_DETACH,
+  PN_PERFORMATIVE_END,
+  PN_PERFORMATIVE_CLOSE,
+  PN_PERFORMATIVE_OTHER  /**< SASL, empty (heartbeat) and unrecognised frames */
+} pn_performative_t;
+
+#define PN_PERFORMATIVE_CT (PN_PERFORMATIVE_OTHER + 1)
+
+/**
+ * Number and total size, headers included, of one kind of frame.
+ */
+typedef struct {
+  uint64_t frames;
+  uint64_t bytes;
+} pn_frame_metrics_t;
+
+/**
+ * Counters for a whole transport.
+ *
+ * The delivery and stall counts are the totals over all the sessions
+ * and links the transport has carried.
+ */
+typedef struct {
+  pn_frame_metrics_t input[PN_PERFORMATIVE_CT];   /**< frames read, by performative */
+  pn_frame_metrics_t output[PN_PERFORMATIVE_CT];  /**< frames written, by performative */
+  uint64_t frames_input;        /**< all frames read */
+  uint64_t frames_output;       /**< all frames written */
+  uint64_t bytes_input;         /**< bytes handed to the transport, before any TLS or SASL layer */
+  uint64_t bytes_output;        /**< bytes taken from the transport, after any TLS or SASL layer */
+  uint64_t bytes_copied;        /**< bytes moved between the transport's own buffers */
+  uint64_t output_high_water;   /**< most encoded output ever held waiting to be written */
+  uint64_t deliveries_sent;     /**< outgoing deliveries whose last frame has been written */
+  uint64_t deliveries_received; /**< incoming deliveries whose first frame has been read */
+  uint64_t deliveries_settled;  /**< deliveries the transport forgot after both ends settled */
+  uint64_t credit_stalls;       /**< times a link had a delivery to send but no credit */
+  uint64_t window_stalls;       /**< times a session window closed with transfers pending */
+} pn_transport_metrics_t;
+
+/**
+ * Counters for one session.
+ */
+typedef struct {
+  uint64_t bytes_sent;              /**< transfer payload written */
+  uint64_t bytes_received;          /**< transfer payload read */
+  uint64_t deliveries_sent;
+  uint64_t deliveries_received;
+  uint64_t deliveries_settled;
+  uint64_t outgoing_window_stalls;  /**< times the peer's incoming window held up a transfer */
+  uint64_t incoming_window_stalls;  /**< times our incoming window ran out */
+} pn_session_metrics_t;
+
+/**
+ * Counters for one link.
+ */
+typedef struct {
+  uint64_t bytes_sent;
+  uint64_t bytes_received;
+  uint64_t deliveries_sent;
+  uint64_t deliveries_received;
+  uint64_t deliveries_settled;
+  uint64_t credit_stalls;       /**< times the link had a delivery to send but no credit */
+} pn_link_metrics_t;
+
+/**
+ * A log-linear histogram of values, in the manner of an HDR histogram.
+ *
+ * Values are grouped in buckets eight to each power of two, so a value
+ * reported for a percentile is within 12.5% of the recorded one.
+ */
+typedef struct pn_histogram_t pn_histogram_t;
+
+/**
+ * Get the counters of a transport.
+ *
+ * @param[in] transport a transport object
+ * @return the live counters, valid for the life of the transport
+ */
+PN_EXTERN const pn_transport_metrics_t *pn_transport_metrics(pn_transport_t *transport);
+
+/**
+ * Copy the counters of a transport. This may be called from any
+ * thread, including while another thread drives the transport.
+ *
+ * @param[in] transport a transport object
+ * @param[out] metrics where to copy the counters
+ */
+PN_EXTERN void pn_transport_metrics_copy(pn_transport_t *transport, pn_transport_metrics_t *metrics);
+
+/**
+ * Get the counters of a session.
+ *
+ * @param[in] session a session object
+ * @return the live counters, valid for the life of the session
+ */
+PN_EXTERN const pn_session_metrics_t *pn_session_metrics(pn_session_t *session);
+
+/**
+ * Copy the counters of a session. This may be called from any thread,
+ * including while another thread drives its transport.
+ *
+ * @param[in] session a session object
+ * @param[out] metrics where to copy the counters
+ */
+PN_EXTERN void pn_session_metrics_copy(pn_session_t *session, pn_session_metrics_t *metrics);
+
+/**
+ * Get the counters of a link.
+ *
+ * @param[in] link a link object
+ * @return the live counters, valid for the life of the link
+ */
+PN_EXTERN const pn_link_metrics_t *pn_link_metrics(pn_link_t *link);
+
+/**
+ * Copy the counters of a link. This may be called from any thread,
+ * including while another thread drives its transport.
+ *
+ * @param[in] link a link object
+ * @param[out] metrics where to copy the counters
+ */
+PN_EXTERN void pn_link_metrics_copy(pn_link_t *link, pn_link_metrics_t *metrics);
+
+/**
+ * Record how long each delivery sent on a link takes to be settled by
+ * the peer.
+ *
+ * The time is measured in microseconds from when the first frame of
+ * the delivery is written to when the disposition settling it is
+ * read. Deliveries sent pre-settled, or before recording started, are
+ * not recorded. Turning this off discards the values recorded so far.
+ *
+ * Call this on the thread driving the transport, not while another
+ * thread may be in ::pn_link_settle_latency_copy.
+ *
+ * @param[in] link a sending link
+ * @param[in] record true to start recording, false to stop
+ */
+PN_EXTERN void pn_link_record_settle_latency(pn_link_t *link, bool record);
+
+/**
+ * Get the send-to-settle latencies recorded for a link.
+ *
+ * Like ::pn_link_metrics, the histogram is updated in place and should
+ * only be read by the thread driving the transport.
+ *
+ * @param[in] link a link object
+ * @return the histogram, or NULL if the link is not recording
+ */
+PN_EXTERN const pn_histogram_t *pn_link_settle_latency(pn_link_t *link);
+
+/**
+ * Copy the send-to-settle latencies recorded for a link. This may be
+ * called from any thread, including while another thread drives its
+ * transport, but not while recording is turned on or off.
+ *
+ * @param[in] link a link object
+ * @param[out] histogram where to copy the values, from ::pn_histogram
+ * @return false, leaving histogram alone, if the link is not recording
+ */
+PN_EXTERN bool pn_link_settle_latency_copy(pn_link_t *link, pn_histogram_t *histogram);
+
+/**
+ * Create an empty histogram, to copy into with
+ * ::pn_link_settle_latency_copy.
+ *
+ * @return a new histogram, freed with ::pn_histogram_free
+ */
+PN_EXTERN pn_histogram_t *pn_histogram(void);
+
+/**
+ * Free a histogram created by ::pn_histogram.
+ */
+PN_EXTERN void pn_histogram_free(pn_histogram_t *histogram);
+
+/**
+ * The number of values recorded in a histogram.
+ */
+PN_EXTERN uint64_t pn_histogram_count(const pn_histogram_t *histogram);
+
+/**
+ * The smallest value recorded in a histogram, 0 if it is empty.
+ */
+PN_EXTERN uint64_t pn_histogram_min(const pn_histogram_t *histogram);
+
+/**
+ * The largest value recorded in a histogram, 0 if it is empty.
+ */
+PN_EXTERN uint64_t pn_histogram_max(const pn_histogram_t *histogram);
+
+/**
+ * The mean of the values recorded in a histogram, 0 if it is empty.
+ */
+PN_EXTERN double pn_histogram_mean(const pn_histogram_t *histogram);
+
+/**
+ * The value that the given percentage of recorded values do not
+ * exceed.
+ *
+ * @param[in] histogram a histogram
+ * @param[in] percentile a percentage between 0 and 100
+ * @return the highest value of the bucket the percentile falls in,
+ * capped at the largest value recorded, or 0 if the histogram is empty
+ */
+PN_EXTERN uint64_t pn_histogram_percentile(const pn_histogram_t *histogram, double percentile);
+
+/** @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* metrics.h */
@@ -148,6 +148,52 @@ PN_EXTERN void pn_reactor_set_connection_host(pn_reactor_t *reactor,
 PN_EXTERN const char *pn_reactor_get_connection_address(pn_reactor_t *reactor,
                                                         pn_connection_t *connection);
 
+/**
+ * Look up the addresses of a host for an outgoing reactor connection.
+ *
+ * Called on a resolver thread, not the reactor thread. On success
+ * append the numeric addresses of @p host to @p addresses separated by
+ * spaces and return zero. On failure return non-zero, @p addresses may
+ * be set to a description of the error.
+ *
+ * @see ::pn_reactor_set_resolver_lookup()
+ */
+typedef int (*pn_reactor_lookup_t)(void *context, const char *host, pn_string_t *addresses);
+
+/**
+ * Set the number of background threads used to look up host names for
+ * outgoing connections.
+ *
+ * Threads are started on demand, up to this number. Zero means look up
+ * host names on the reactor thread, which blocks all other connections
+ * while a lookup is in progress. Default is 2.
+ *
+ * @param[in] reactor the reactor
+ * @param[in] threads the maximum number of resolver threads
+ */
+PN_EXTERN void pn_reactor_set_resolver_threads(pn_reactor_t *reactor, int threads);
+
+/**
+ * Set how long the addresses found for a host and port are reused by
+ * later connections, including reconnects. Zero disables caching.
+ * An entry is also dropped if none of its addresses can be connected.
+ * Default is 30 seconds.
+ *
+ * @param[in] reactor the reactor
+ * @param[in] ttl time to keep resolved addresses in milliseconds
+ */
+PN_EXTERN void pn_reactor_set_resolver_ttl(pn_reactor_t *reactor, pn_millis_t ttl);
+
+/**
+ * Replace the system name lookup used for outgoing connections, for
+ * example with a stub for testing. NULL restores the default.
+ *
+ * @param[in] reactor the reactor
+ * @param[in] lookup the lookup function
+ * @param[in] context passed to each call of @p lookup
+ */
+PN_EXTERN void pn_reactor_set_resolver_lookup(pn_reactor_t *reactor, pn_reactor_lookup_t lookup, void *context);
+
 PN_EXTERN int pn_reactor_wakeup(pn_reactor_t *reactor);
 PN_EXTERN void pn_reactor_start(pn_reactor_t *reactor);
 PN_EXTERN bool pn_reactor_quiesced(pn_reactor_t *reactor);
@@ -159,6 +205,9 @@ PN_EXTERN pn_task_t *pn_reactor_schedule(pn_reactor_t *reactor, int delay, pn_ha
 
 PN_EXTERN void pn_acceptor_set_ssl_domain(pn_acceptor_t *acceptor, pn_ssl_domain_t *domain);
 PN_EXTERN void pn_acceptor_close(pn_acceptor_t *acceptor);
+PN_EXTERN void pn_acceptor_set_max_accepts(pn_acceptor_t *acceptor, int max);
+PN_EXTERN uint64_t pn_acceptor_get_accepted(pn_acceptor_t *acceptor);
+PN_EXTERN double pn_acceptor_get_accept_rate(pn_acceptor_t *acceptor);
 PN_EXTERN pn_acceptor_t *pn_connection_acceptor(pn_connection_t *connection);
 
 PN_EXTERN pn_timer_t *pn_timer(pn_collector_t *collector);
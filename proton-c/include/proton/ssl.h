@@ -216,6 +216,64 @@ PN_EXTERN int pn_ssl_domain_set_peer_authentication(pn_ssl_domain_t *domain,
  */
 PN_EXTERN int pn_ssl_domain_allow_unsecured_client(pn_ssl_domain_t *domain);
 
+/** Bound the domain's SSL session cache.
+ *
+ * A client domain keeps the sessions saved under the session_id given to
+ * ::pn_ssl_init, a server domain keeps the sessions of its clients.  When
+ * the cache is full the least recently saved session is evicted.  Sessions
+ * also expire after ttl seconds or at the end of the lifetime negotiated
+ * with the peer, whichever comes first.  The default is 1024 sessions with
+ * no ttl of its own.
+ *
+ * Windows SChannel resumes sessions from a cache of its own that is shared
+ * by the whole process and cannot be bounded per domain, so with SChannel
+ * this fails with PN_ERR and leaves that cache as it is.
+ *
+ * @param[in] domain the ssl domain to configure.
+ * @param[in] max_sessions the most sessions to keep, 0 disables the cache.
+ * @param[in] ttl the most seconds to keep a session, 0 for no limit.
+ * @return 0 on success, PN_ERR if the SSL implementation has no cache to
+ * configure
+ */
+PN_EXTERN int pn_ssl_domain_set_session_cache(pn_ssl_domain_t *domain, size_t max_sessions,
+                                              unsigned int ttl);
+
+/** Enable or disable TLS session tickets (RFC 5077).
+ *
+ * With tickets a server hands the encrypted session state to the client
+ * instead of keeping it, so resumption does not depend on the server's own
+ * cache.  Tickets are enabled by default.  Windows SChannel decides for
+ * itself whether to use tickets, so with SChannel this fails with PN_ERR.
+ *
+ * @param[in] domain the ssl domain to configure.
+ * @param[in] enable true to issue (server) or accept (client) tickets.
+ * @return 0 on success, PN_ERR if the SSL implementation does not support
+ * turning tickets on and off
+ */
+PN_EXTERN int pn_ssl_domain_set_session_tickets(pn_ssl_domain_t *domain, bool enable);
+
+/** Number of handshakes on the domain's connections that resumed a
+ * previous session.
+ *
+ * The session counters may be read from any thread.  They are always 0
+ * with Windows SChannel, which does not report resumption.
+ *
+ * @param[in] domain the ssl domain to query.
+ * @return the number of resumed handshakes.
+ */
+PN_EXTERN uint64_t pn_ssl_domain_get_session_hits(pn_ssl_domain_t *domain);
+
+/** Number of full handshakes on the domain's connections that could have
+ * resumed a session.
+ *
+ * For a client domain these are the handshakes of connections initialized
+ * with a session_id, for a server domain all full handshakes.
+ *
+ * @param[in] domain the ssl domain to query.
+ * @return the number of full handshakes.
+ */
+PN_EXTERN uint64_t pn_ssl_domain_get_session_misses(pn_ssl_domain_t *domain);
+
 /** Create a new SSL session object associated with a transport.
  *
  * A transport must have an SSL object in order to "speak" SSL over its connection. This
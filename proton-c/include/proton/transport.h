@@ -52,6 +52,7 @@ extern "C" {
  * - ::PN_TRACE_RAW
  * - ::PN_TRACE_FRM
  * - ::PN_TRACE_DRV
+ * - ::PN_TRACE_BIN
  *
  */
 typedef int pn_trace_t;
@@ -81,6 +82,56 @@ typedef void (*pn_tracer_t)(pn_transport_t *transport, const char *message);
  */
 #define PN_TRACE_DRV (4)
 
+/**
+ * Record frames into/out of the transport in its binary trace ring,
+ * see ::pn_transport_set_trace_ring.
+ */
+#define PN_TRACE_BIN (8)
+
+/**
+ * The header of a binary trace written by ::pn_transport_trace_dump.
+ *
+ * The header is followed by count records, oldest first. Both are in
+ * the byte order of the machine that wrote them, which a reader can
+ * tell from byte_order.
+ */
+typedef struct {
+  char magic[8];        /**< "PNTRACE1" */
+  uint32_t byte_order;  /**< 0x01020304 as written */
+  uint32_t record_size; /**< sizeof(pn_trace_record_t) */
+  uint64_t count;       /**< records that follow */
+  uint64_t dropped;     /**< older records overwritten or torn before the dump */
+} pn_trace_header_t;
+
+#define PN_TRACE_OUT      (0x01)  /**< frame written rather than read */
+#define PN_TRACE_SASL     (0x02)  /**< SASL frame rather than AMQP */
+#define PN_TRACE_SETTLED  (0x04)  /**< transfer or disposition: settled */
+#define PN_TRACE_MORE     (0x08)  /**< transfer: more frames follow */
+#define PN_TRACE_FLAG     (0x10)  /**< attach, disposition: role is receiver; flow: drain; detach: closed */
+
+/**
+ * One frame in a binary trace.
+ *
+ * The meaning of the fields depends on the performative:
+ *
+ * - open: max-frame-size, channel-max, idle-time-out
+ * - begin: remote-channel (0xFFFF if absent), next-outgoing-id, incoming-window
+ * - attach: handle
+ * - flow: handle (0xFFFFFFFF if absent), delivery-count, link-credit
+ * - transfer: handle, delivery-id
+ * - disposition: first, last, descriptor code of the delivery state
+ * - detach: handle
+ */
+typedef struct {
+  uint64_t time;      /**< microseconds since the epoch */
+  uint32_t seq;       /**< for internal use */
+  uint32_t size;      /**< bytes of payload after the performative */
+  uint32_t fields[3];
+  uint16_t channel;
+  uint8_t code;       /**< descriptor code of the performative, 0 for an empty frame */
+  uint8_t flags;      /**< PN_TRACE_OUT, PN_TRACE_SASL and so on */
+} pn_trace_record_t;
+
 /**
  * Factory for creating a transport.
  * A transport is used by a connection to interface with the network.
@@ -187,6 +238,38 @@ PN_EXTERN void pn_transport_require_encryption(pn_transport_t *transport, bool r
  */
 PN_EXTERN bool pn_transport_is_encrypted(pn_transport_t *transport);
 
+/**
+ * Set whether input events are coalesced.
+ *
+ * Each call to ::pn_transport_process decodes every complete frame in
+ * the input before the application sees any events. When coalescing,
+ * the ::PN_DELIVERY, ::PN_LINK_FLOW and ::PN_TRANSPORT events raised
+ * while decoding are collapsed so that each delivery, link or
+ * transport gets at most one of each, at the position of the first.
+ * Handlers see the final state of each object either way. A
+ * receiver's flow frame, sent when the incoming session window is
+ * used up, is held back to the next output rather than encoded in
+ * the middle of the input.
+ *
+ * This cuts the per message event cost when many small frames
+ * arrive together, for example on a connection with many busy
+ * links. The default is not to coalesce.
+ *
+ * @param[in] transport the transport
+ * @param[in] coalesce true to coalesce input events
+ */
+PN_EXTERN void pn_transport_set_coalesce_events(pn_transport_t *transport, bool coalesce);
+
+/**
+ * Tell whether input events are coalesced.
+ *
+ * @see ::pn_transport_set_coalesce_events
+ *
+ * @param[in] transport the transport
+ * @return true if input events are coalesced
+ */
+PN_EXTERN bool pn_transport_get_coalesce_events(pn_transport_t *transport);
+
 /**
  * Get additional information about the condition of the transport.
  *
@@ -231,6 +314,42 @@ PN_EXTERN int pn_transport_unbind(pn_transport_t *transport);
  */
 PN_EXTERN void pn_transport_trace(pn_transport_t *transport, pn_trace_t trace);
 
+/**
+ * Set the size of the ring a transport records frames in when
+ * ::PN_TRACE_BIN is on.
+ *
+ * Recording a frame costs a few field lookups and a copy of a small
+ * fixed size record, so unlike ::PN_TRACE_FRM it can be left on in
+ * production as a flight recorder. Once the ring is full the oldest
+ * records are overwritten. A ring of 4096 records is made the first
+ * time ::PN_TRACE_BIN is set if none has been sized. Setting a new size
+ * discards what has been recorded.
+ *
+ * @param[in] transport a transport object
+ * @param[in] records the number of records to keep, rounded up to a
+ * power of two; 0 frees the ring
+ * @return 0 on success, PN_OUT_OF_MEMORY if the ring cannot be made
+ */
+PN_EXTERN int pn_transport_set_trace_ring(pn_transport_t *transport, size_t records);
+
+/**
+ * Copy the records in a transport's trace ring, oldest first, after a
+ * ::pn_trace_header_t.
+ *
+ * The result can be saved to a file and printed with the trace-print
+ * tool. This may be called from any thread while the transport is in
+ * use: records being overwritten as they are copied are left out and
+ * counted as dropped.
+ *
+ * @param[in] transport a transport object
+ * @param[out] bytes where to write the trace, or NULL to find the size
+ * needed
+ * @param[in] size the space available at bytes
+ * @return the number of bytes written, or needed if bytes is NULL;
+ * PN_OVERFLOW if size is too small
+ */
+PN_EXTERN ssize_t pn_transport_trace_dump(pn_transport_t *transport, char *bytes, size_t size);
+
 /**
  * Set the tracing function used by a transport.
  *
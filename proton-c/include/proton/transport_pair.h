@@ -0,0 +1,150 @@
+#ifndef PROTON_TRANSPORT_PAIR_H
+#define PROTON_TRANSPORT_PAIR_H 1
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/import_export.h>
+#include <proton/type_compat.h>
+#include <proton/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file
+ * Two transports connected to each other in memory.
+ *
+ * A transport pair moves the output of each transport to the input of
+ * the other without any IO, for testing and benchmarking the protocol
+ * engine on its own. The link between them can be given a latency, a
+ * bandwidth and a largest segment size, so that slow or fragmented
+ * networks can be reproduced exactly.
+ *
+ * The pair keeps its own clock, which only moves when
+ * ::pn_transport_pair_advance is called. Bytes in flight arrive and the
+ * transports' timers (heartbeats and idle timeouts) fire according to
+ * that clock, so a run does the same thing every time whatever the
+ * speed of the machine.
+ *
+ * A pair is not thread safe. It does not own its transports, which
+ * must outlive it.
+ *
+ * @defgroup transport_pair Transport Pair
+ * @ingroup transport
+ * @{
+ */
+
+/**
+ * Two transports connected in memory.
+ */
+typedef struct pn_transport_pair_t pn_transport_pair_t;
+
+/**
+ * Connect two transports to each other.
+ *
+ * The link starts with no latency, unlimited bandwidth and no limit on
+ * segment size, so bytes are copied straight from one transport's
+ * output to the other's input.
+ *
+ * @param[in] a a transport
+ * @param[in] b another transport
+ * @return the pair, or NULL if there is no memory for it
+ */
+PN_EXTERN pn_transport_pair_t *pn_transport_pair(pn_transport_t *a, pn_transport_t *b);
+
+/**
+ * Free a transport pair, discarding any bytes in flight. The
+ * transports themselves are not freed.
+ */
+PN_EXTERN void pn_transport_pair_free(pn_transport_pair_t *pair);
+
+/**
+ * Set the time bytes take to cross the link, in each direction.
+ */
+PN_EXTERN void pn_transport_pair_set_latency(pn_transport_pair_t *pair, pn_millis_t latency);
+
+/**
+ * Limit the rate at which bytes cross the link, in each direction.
+ *
+ * @param[in] pair a transport pair
+ * @param[in] bytes_per_second the bandwidth, or 0 for no limit
+ */
+PN_EXTERN void pn_transport_pair_set_bandwidth(pn_transport_pair_t *pair, size_t bytes_per_second);
+
+/**
+ * Limit the number of bytes taken from a transport's output, and
+ * handed to the other's input, at a time, like the segments of a TCP
+ * stream. Frames larger than this are split across several reads.
+ *
+ * @param[in] pair a transport pair
+ * @param[in] size the largest segment, or 0 for no limit
+ */
+PN_EXTERN void pn_transport_pair_set_segment_size(pn_transport_pair_t *pair, size_t size);
+
+/**
+ * Get the pair's clock. It starts at 1 and moves only with
+ * ::pn_transport_pair_advance.
+ */
+PN_EXTERN pn_timestamp_t pn_transport_pair_now(pn_transport_pair_t *pair);
+
+/**
+ * Move output to input in both directions until neither transport
+ * has anything more to say at the current time.
+ *
+ * @param[in] pair a transport pair
+ * @return the number of bytes handed to either transport's input
+ */
+PN_EXTERN size_t pn_transport_pair_pump(pn_transport_pair_t *pair);
+
+/**
+ * Move the pair's clock forward, run both transports' timers and pump.
+ *
+ * @param[in] pair a transport pair
+ * @param[in] time how far to move the clock
+ * @return the number of bytes handed to either transport's input
+ */
+PN_EXTERN size_t pn_transport_pair_advance(pn_transport_pair_t *pair, pn_millis_t time);
+
+/**
+ * Get the time at which something next happens on its own: bytes in
+ * flight arrive or a transport timer fires.
+ *
+ * @param[in] pair a transport pair
+ * @return the time, or 0 if nothing will happen until the transports
+ * are given more work
+ */
+PN_EXTERN pn_timestamp_t pn_transport_pair_deadline(pn_transport_pair_t *pair);
+
+/**
+ * Get the number of bytes sent by either transport that have not yet
+ * been handed to the other.
+ */
+PN_EXTERN size_t pn_transport_pair_in_flight(pn_transport_pair_t *pair);
+
+/** @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* transport_pair.h */
@@ -24,6 +24,7 @@
 #include "framing/framing.h"
 #include "protocol.h"
 #include "engine/engine-internal.h"
+#include "platform.h"
 
 #include "dispatch_actions.h"
 
@@ -74,9 +75,23 @@ static inline int pni_dispatch_action(pn_transport_t* transport, uint64_t lcode,
   return action(transport, frame_type, channel, args, payload);
 }
 
-static int pni_dispatch_frame(pn_transport_t * transport, pn_data_t *args, pn_frame_t frame)
+// Count a frame of size bytes, headers included, under its performative.
+void pni_count_frame(pn_frame_metrics_t *metrics, uint8_t frame_type, uint64_t lcode, size_t size)
+{
+  pn_performative_t performative = PN_PERFORMATIVE_OTHER;
+  if (frame_type == AMQP_FRAME_TYPE && lcode >= OPEN && lcode <= CLOSE) {
+    performative = (pn_performative_t) (PN_PERFORMATIVE_OPEN + (lcode - OPEN));
+  }
+  PNI_COUNT(metrics[performative].frames, 1);
+  PNI_COUNT(metrics[performative].bytes, size);
+}
+
+static int pni_dispatch_frame(pn_transport_t * transport, pn_data_t *args, pn_frame_t frame, size_t size)
 {
   if (frame.size == 0) { // ignore null frames
+    pni_count_frame(transport->metrics.input, frame.type, 0, size);
+    if (transport->trace & PN_TRACE_BIN)
+      pni_trace_frame(transport, IN, frame.type, frame.channel, 0, NULL, 0);
     if (transport->trace & PN_TRACE_FRM)
       pn_transport_logf(transport, "%u <- (EMPTY FRAME)", frame.channel);
     return 0;
@@ -111,6 +126,9 @@ static int pni_dispatch_frame(pn_transport_t * transport, pn_data_t *args, pn_fr
   const char *payload_mem = payload_size ? frame.payload + dsize : NULL;
   pn_bytes_t payload = {payload_size, payload_mem};
 
+  pni_count_frame(transport->metrics.input, frame_type, lcode, size);
+  if (transport->trace & PN_TRACE_BIN)
+    pni_trace_frame(transport, IN, frame_type, channel, lcode, args, payload_size);
   pn_do_trace(transport, channel, IN, args, payload_mem, payload_size);
 
   int err = pni_dispatch_action(transport, lcode, frame_type, channel, args, &payload);
@@ -131,8 +149,8 @@ ssize_t pn_dispatcher_input(pn_transport_t *transport, const char *bytes, size_t
     if (n > 0) {
       read += n;
       available -= n;
-      transport->input_frames_ct += 1;
-      int e = pni_dispatch_frame(transport, transport->args, frame);
+      PNI_COUNT(transport->metrics.frames_input, 1);
+      int e = pni_dispatch_frame(transport, transport->args, frame, n);
       if (e) return e;
     } else if (n < 0) {
       pn_do_error(transport, "amqp:connection:framing-error", "malformed frame");
@@ -152,6 +170,7 @@ ssize_t pn_dispatcher_output(pn_transport_t *transport, char *bytes, size_t size
     int n = transport->available < size ? transport->available : size;
     memmove(bytes, transport->output, n);
     memmove(transport->output, transport->output + n, transport->available - n);
+    PNI_COUNT(transport->metrics.bytes_copied, transport->available);
     transport->available -= n;
     // XXX: need to check for errors
     return n;
@@ -27,11 +27,13 @@
 #endif
 
 #include "proton/codec.h"
+#include "proton/metrics.h"
 #include "proton/types.h"
 
 typedef int (pn_action_t)(pn_transport_t *transport, uint8_t frame_type, uint16_t channel, pn_data_t *args, const pn_bytes_t *payload);
 
 ssize_t pn_dispatcher_input(pn_transport_t* transport, const char* bytes, size_t available, bool batch, bool* halt);
 ssize_t pn_dispatcher_output(pn_transport_t *transport, char *bytes, size_t size);
+void pni_count_frame(pn_frame_metrics_t *metrics, uint8_t frame_type, uint64_t lcode, size_t size);
 
 #endif /* dispatcher.h */
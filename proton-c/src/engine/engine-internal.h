@@ -27,6 +27,8 @@
 #include <proton/types.h>
 #include "buffer.h"
 #include "dispatcher/dispatcher.h"
+#include "histogram.h"
+#include "transport/trace_ring.h"
 #include "util.h"
 
 typedef enum pn_endpoint_type_t {CONNECTION, SESSION, SENDER, RECEIVER} pn_endpoint_type_t;
@@ -49,6 +51,10 @@ struct pn_endpoint_t {
   pn_endpoint_t *endpoint_prev;
   pn_endpoint_t *transport_next;
   pn_endpoint_t *transport_prev;
+  pn_endpoint_t *child_next;     // siblings under the same parent
+  pn_endpoint_t *child_prev;
+  pn_endpoint_t *freed_next;     // freed siblings not yet finalized
+  pn_endpoint_t *freed_prev;
   int refcount; // when this hits zero we generate a final event
   bool modified;
   bool freed;
@@ -61,11 +67,30 @@ typedef struct {
   bool init;
 } pn_delivery_state_t;
 
+// Deliveries in flight on a session, by delivery-id.  Ids are assigned in
+// sequence so the map is a ring holding ids [base, next), indexed by
+// id - base.  Deliveries that stay unsettled long after those around them
+// are moved to the overflow hash rather than holding the window open.
 typedef struct {
+  pn_delivery_t **ring;
+  pn_hash_t *overflow;
+  size_t capacity;
+  size_t head;          // ring index of base
+  size_t live;          // deliveries held in the ring
+  pn_sequence_t base;
   pn_sequence_t next;
-  pn_hash_t *deliveries;
 } pn_delivery_map_t;
 
+// Local channel or handle numbers in use.  Numbers are handed out lowest
+// first; a bit in used marks a number in use and a bit in full marks a
+// word of used with no clear bits, so finding a free number skips the
+// full words 64 at a time.
+typedef struct {
+  uint64_t *used;
+  uint64_t *full;
+  size_t words;
+} pn_alias_set_t;
+
 typedef struct {
   // XXX: stop using negative numbers
   uint32_t local_handle;
@@ -88,6 +113,7 @@ typedef struct {
   pn_sequence_t outgoing_window;
   pn_hash_t *local_handles;
   pn_hash_t *remote_handles;
+  pn_alias_set_t handle_aliases;
 
   uint64_t disp_code;
   bool disp_settled;
@@ -147,6 +173,7 @@ struct pn_transport_t {
 
   pn_hash_t *local_channels;
   pn_hash_t *remote_channels;
+  pn_alias_set_t channel_aliases;
 
 
   /* scratch area */
@@ -160,10 +187,7 @@ struct pn_transport_t {
   char *output;
 
   /* statistics */
-  uint64_t bytes_input;
-  uint64_t bytes_output;
-  uint64_t output_frames_ct;
-  uint64_t input_frames_ct;
+  pn_transport_metrics_t metrics;
 
   /* output buffered for send */
   size_t output_size;
@@ -178,6 +202,7 @@ struct pn_transport_t {
   pn_record_t *context;
 
   pn_trace_t trace;
+  pni_trace_ring_t *trace_ring;  // frames recorded under PN_TRACE_BIN
 
   /*
    * The maximum channel number can be constrained in several ways:
@@ -207,6 +232,7 @@ struct pn_transport_t {
   bool auth_required;
   bool authenticated;
   bool encryption_required;
+  bool coalesce_events;
 
   bool referenced;
 };
@@ -217,8 +243,10 @@ struct pn_connection_t {
   pn_endpoint_t *endpoint_tail;
   pn_endpoint_t *transport_head;  // reference counted
   pn_endpoint_t *transport_tail;
-  pn_list_t *sessions;
-  pn_list_t *freed;
+  pn_endpoint_t *child_head;      // sessions
+  pn_endpoint_t *child_tail;
+  pn_endpoint_t *freed_head;
+  pn_endpoint_t *freed_tail;
   pn_transport_t *transport;
   pn_delivery_t *work_head;
   pn_delivery_t *work_tail;
@@ -239,8 +267,11 @@ struct pn_connection_t {
 struct pn_session_t {
   pn_endpoint_t endpoint;
   pn_connection_t *connection;  // reference counted
-  pn_list_t *links;
-  pn_list_t *freed;
+  pn_endpoint_t *child_head;    // links
+  pn_endpoint_t *child_tail;
+  pn_hash_t *link_names;        // links by hash of their name
+  pn_endpoint_t *freed_head;
+  pn_endpoint_t *freed_tail;
   pn_record_t *context;
   size_t incoming_capacity;
   pn_sequence_t incoming_bytes;
@@ -249,6 +280,8 @@ struct pn_session_t {
   pn_sequence_t outgoing_deliveries;
   pn_sequence_t outgoing_window;
   pn_session_state_t state;
+  pn_session_metrics_t metrics;
+  bool window_stalled;  // until the next transfer is written
 };
 
 struct pn_terminus_t {
@@ -274,10 +307,16 @@ struct pn_link_t {
   pn_link_state_t state;
   pn_string_t *name;
   pn_session_t *session;  // reference counted
+  pn_link_t *name_next;   // links in the session whose names hash alike
+  pn_link_t *name_prev;
   pn_delivery_t *unsettled_head;
   pn_delivery_t *unsettled_tail;
+  pn_delivery_t *ranged_head;  // settled in bulk, not yet taken
+  pn_delivery_t *ranged_tail;
   pn_delivery_t *current;
   pn_record_t *context;
+  pn_histogram_t *settle_latency;
+  pn_link_metrics_t metrics;
   size_t unsettled_count;
   pn_sequence_t available;
   pn_sequence_t credit;
@@ -290,6 +329,8 @@ struct pn_link_t {
   bool drain_flag_mode; // receiver only
   bool drain;
   bool detached;
+  bool bulk_settle;
+  bool credit_stalled;  // until the next transfer is written
 };
 
 struct pn_disposition_t {
@@ -315,13 +356,17 @@ struct pn_delivery_t {
   pn_delivery_t *work_prev;
   pn_delivery_t *tpwork_next;
   pn_delivery_t *tpwork_prev;
+  pn_delivery_t *ranged_next;
+  pn_delivery_t *ranged_prev;
   pn_delivery_state_t state;
   pn_buffer_t *bytes;
   pn_record_t *context;
+  uint64_t sent_at;  // when the first frame was written, if recording latency
   bool updated;
   bool settled; // tracks whether we're in the unsettled list or not
   bool work;
   bool tpwork;
+  bool ranged;
   bool done;
   bool referenced;
 };
@@ -343,6 +388,7 @@ void pn_modified(pn_connection_t *connection, pn_endpoint_t *endpoint, bool emit
 void pn_real_settle(pn_delivery_t *delivery);  // will free delivery if link is freed
 void pn_clear_tpwork(pn_delivery_t *delivery);
 void pn_work_update(pn_connection_t *connection, pn_delivery_t *delivery);
+void pni_add_ranged(pn_delivery_t *delivery);
 void pn_clear_modified(pn_connection_t *connection, pn_endpoint_t *endpoint);
 void pn_connection_bound(pn_connection_t *conn);
 void pn_connection_unbound(pn_connection_t *conn);
@@ -352,6 +398,15 @@ void pn_session_unbound(pn_session_t* ssn);
 void pn_link_unbound(pn_link_t* link);
 void pn_ep_incref(pn_endpoint_t *endpoint);
 void pn_ep_decref(pn_endpoint_t *endpoint);
+uintptr_t pni_link_name_hash(const char *name, size_t size);
+void pn_alias_set_clear(pn_alias_set_t *set);
+void pn_alias_set_free(pn_alias_set_t *set);
+void pn_transport_release_channel(pn_transport_t *transport, uint16_t channel);
+void pn_session_release_handle(pn_session_t *ssn, uint32_t handle);
+// while on, coalescable events are collapsed across the whole queue
+void pni_collector_coalesce(pn_collector_t *collector, bool coalesce);
+// copy count metrics counters, each read whole while the owner may write
+void pni_metrics_copy(uint64_t *to, const uint64_t *from, size_t count);
 
 int pn_post_frame(pn_transport_t *transport, uint8_t type, uint16_t ch, const char *fmt, ...);
 
@@ -359,5 +414,7 @@ typedef enum {IN, OUT} pn_dir_t;
 
 void pn_do_trace(pn_transport_t *transport, uint16_t ch, pn_dir_t dir,
                  pn_data_t *args, const char *payload, size_t size);
+void pni_trace_frame(pn_transport_t *transport, pn_dir_t dir, uint8_t frame_type, uint16_t ch,
+                     uint64_t code, pn_data_t *args, size_t size);
 
 #endif /* engine-internal.h */
@@ -152,9 +152,8 @@ void pn_connection_bound(pn_connection_t *connection)
   pn_collector_put(connection->collector, PN_OBJECT, connection, PN_CONNECTION_BOUND);
   pn_ep_incref(&connection->endpoint);
 
-  size_t nsessions = pn_list_size(connection->sessions);
-  for (size_t i = 0; i < nsessions; i++) {
-    pni_session_bound((pn_session_t *) pn_list_get(connection->sessions, i));
+  for (pn_endpoint_t *ssn = connection->child_head; ssn; ssn = ssn->child_next) {
+    pni_session_bound((pn_session_t *) ssn);
   }
 }
 
@@ -215,9 +214,33 @@ void pn_condition_tini(pn_condition_t *condition)
   pn_free(condition->name);
 }
 
+// Sessions and links are kept on intrusive lists under their parent,
+// the live ones on child_head and the freed but not yet finalized ones
+// on freed_head, so that either can be unlinked in constant time.
+static bool pni_remove_child(pn_endpoint_t **head, pn_endpoint_t **tail, pn_endpoint_t *endpoint)
+{
+  if (!endpoint->child_prev && *head != endpoint) return false;
+  if (endpoint->child_prev) endpoint->child_prev->child_next = endpoint->child_next;
+  if (endpoint->child_next) endpoint->child_next->child_prev = endpoint->child_prev;
+  if (*head == endpoint) *head = endpoint->child_next;
+  if (*tail == endpoint) *tail = endpoint->child_prev;
+  endpoint->child_next = endpoint->child_prev = NULL;
+  return true;
+}
+
+static void pni_remove_freed(pn_endpoint_t **head, pn_endpoint_t **tail, pn_endpoint_t *endpoint)
+{
+  if (!endpoint->freed_prev && *head != endpoint) return;
+  if (endpoint->freed_prev) endpoint->freed_prev->freed_next = endpoint->freed_next;
+  if (endpoint->freed_next) endpoint->freed_next->freed_prev = endpoint->freed_prev;
+  if (*head == endpoint) *head = endpoint->freed_next;
+  if (*tail == endpoint) *tail = endpoint->freed_prev;
+  endpoint->freed_next = endpoint->freed_prev = NULL;
+}
+
 static void pni_add_session(pn_connection_t *conn, pn_session_t *ssn)
 {
-  pn_list_add(conn->sessions, ssn);
+  LL_ADD(conn, child, &ssn->endpoint);
   ssn->connection = conn;
   pn_incref(conn);  // keep around until finalized
   pn_ep_incref(&conn->endpoint);
@@ -225,7 +248,7 @@ static void pni_add_session(pn_connection_t *conn, pn_session_t *ssn)
 
 static void pni_remove_session(pn_connection_t *conn, pn_session_t *ssn)
 {
-  if (pn_list_remove(conn->sessions, ssn)) {
+  if (pni_remove_child(&conn->child_head, &conn->child_tail, &ssn->endpoint)) {
     pn_ep_decref(&conn->endpoint);
     LL_REMOVE(conn, endpoint, &ssn->endpoint);
   }
@@ -252,12 +275,11 @@ void pn_session_close(pn_session_t *session)
 void pn_session_free(pn_session_t *session)
 {
   assert(!session->endpoint.freed);
-  while(pn_list_size(session->links)) {
-    pn_link_t *link = (pn_link_t *)pn_list_get(session->links, 0);
-    pn_link_free(link);
+  while(session->child_head) {
+    pn_link_free((pn_link_t *) session->child_head);
   }
   pni_remove_session(session->connection, session);
-  pn_list_add(session->connection->freed, session);
+  LL_ADD(session->connection, freed, &session->endpoint);
   session->endpoint.freed = true;
   pn_ep_decref(&session->endpoint);
 
@@ -285,16 +307,62 @@ void pn_session_set_context(pn_session_t *session, void *context)
 }
 
 
+uintptr_t pni_link_name_hash(const char *name, size_t size)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ (uint8_t) name[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// Links whose names hash alike are chained from the session's link_names
+// in the order they were created.
+static void pni_add_link_name(pn_session_t *ssn, pn_link_t *link)
+{
+  uintptr_t hash = pni_link_name_hash(pn_string_get(link->name), pn_string_size(link->name));
+  pn_link_t *tail = (pn_link_t *) pn_hash_get(ssn->link_names, hash);
+  link->name_next = NULL;
+  link->name_prev = NULL;
+  if (!tail) {
+    pn_hash_put(ssn->link_names, hash, link);
+    return;
+  }
+  while (tail->name_next) tail = tail->name_next;
+  tail->name_next = link;
+  link->name_prev = tail;
+}
+
+static void pni_remove_link_name(pn_session_t *ssn, pn_link_t *link)
+{
+  if (link->name_prev) {
+    link->name_prev->name_next = link->name_next;
+  } else {
+    uintptr_t hash = pni_link_name_hash(pn_string_get(link->name), pn_string_size(link->name));
+    if (link->name_next) {
+      pn_hash_put(ssn->link_names, hash, link->name_next);
+    } else {
+      pn_hash_del(ssn->link_names, hash);
+    }
+  }
+  if (link->name_next) {
+    link->name_next->name_prev = link->name_prev;
+  }
+  link->name_next = link->name_prev = NULL;
+}
+
 static void pni_add_link(pn_session_t *ssn, pn_link_t *link)
 {
-  pn_list_add(ssn->links, link);
+  LL_ADD(ssn, child, &link->endpoint);
+  pni_add_link_name(ssn, link);
   link->session = ssn;
   pn_ep_incref(&ssn->endpoint);
 }
 
 static void pni_remove_link(pn_session_t *ssn, pn_link_t *link)
 {
-  if (pn_list_remove(ssn->links, link)) {
+  if (pni_remove_child(&ssn->child_head, &ssn->child_tail, &link->endpoint)) {
+    pni_remove_link_name(ssn, link);
     pn_ep_decref(&ssn->endpoint);
     LL_REMOVE(ssn->connection, endpoint, &link->endpoint);
   }
@@ -334,7 +402,7 @@ void pn_link_free(pn_link_t *link)
 {
   assert(!link->endpoint.freed);
   pni_remove_link(link->session, link);
-  pn_list_add(link->session->freed, link);
+  LL_ADD(link->session, freed, &link->endpoint);
   pn_delivery_t *delivery = link->unsettled_head;
   while (delivery) {
     pn_delivery_t *next = delivery->unsettled_next;
@@ -380,6 +448,10 @@ void pn_endpoint_init(pn_endpoint_t *endpoint, int type, pn_connection_t *conn)
   endpoint->endpoint_prev = NULL;
   endpoint->transport_next = NULL;
   endpoint->transport_prev = NULL;
+  endpoint->child_next = NULL;
+  endpoint->child_prev = NULL;
+  endpoint->freed_next = NULL;
+  endpoint->freed_prev = NULL;
   endpoint->modified = false;
   endpoint->freed = false;
   endpoint->refcount = 1;
@@ -440,22 +512,20 @@ static void pni_endpoint_tini(pn_endpoint_t *endpoint)
   pn_condition_tini(&endpoint->condition);
 }
 
-static void pni_free_children(pn_list_t *children, pn_list_t *freed)
+// Finalizing a child unlinks it from its parent's lists.
+static void pni_free_children(pn_endpoint_t **children, pn_endpoint_t **freed)
 {
-  while (pn_list_size(children) > 0) {
-    pn_endpoint_t *endpoint = (pn_endpoint_t *) pn_list_get(children, 0);
+  while (*children) {
+    pn_endpoint_t *endpoint = *children;
     assert(!endpoint->referenced);
     pn_free(endpoint);
   }
 
-  while (pn_list_size(freed) > 0) {
-    pn_endpoint_t *endpoint = (pn_endpoint_t *) pn_list_get(freed, 0);
+  while (*freed) {
+    pn_endpoint_t *endpoint = *freed;
     assert(!endpoint->referenced);
     pn_free(endpoint);
   }
-
-  pn_free(children);
-  pn_free(freed);
 }
 
 static void pn_connection_finalize(void *object)
@@ -473,7 +543,7 @@ static void pn_connection_finalize(void *object)
     return;
   }
 
-  pni_free_children(conn->sessions, conn->freed);
+  pni_free_children(&conn->child_head, &conn->freed_head);
   pn_free(conn->context);
   pn_decref(conn->collector);
 
@@ -504,8 +574,10 @@ pn_connection_t *pn_connection(void)
   pn_endpoint_init(&conn->endpoint, CONNECTION, conn);
   conn->transport_head = NULL;
   conn->transport_tail = NULL;
-  conn->sessions = pn_list(PN_WEAKREF, 0);
-  conn->freed = pn_list(PN_WEAKREF, 0);
+  conn->child_head = NULL;
+  conn->child_tail = NULL;
+  conn->freed_head = NULL;
+  conn->freed_tail = NULL;
   conn->transport = NULL;
   conn->work_head = NULL;
   conn->work_tail = NULL;
@@ -724,6 +796,22 @@ void pn_clear_tpwork(pn_delivery_t *delivery)
   }
 }
 
+void pni_add_ranged(pn_delivery_t *delivery)
+{
+  if (!delivery->ranged && !delivery->local.settled) {
+    LL_ADD(delivery->link, ranged, delivery);
+    delivery->ranged = true;
+  }
+}
+
+static void pni_clear_ranged(pn_delivery_t *delivery)
+{
+  if (delivery->ranged) {
+    LL_REMOVE(delivery->link, ranged, delivery);
+    delivery->ranged = false;
+  }
+}
+
 void pn_dump(pn_connection_t *conn)
 {
   pn_endpoint_t *endpoint = conn->transport_head;
@@ -921,17 +1009,22 @@ static void pn_session_finalize(void *object)
   }
 
   pn_free(session->context);
-  pni_free_children(session->links, session->freed);
+  pni_free_children(&session->child_head, &session->freed_head);
+  pn_free(session->link_names);
   pni_endpoint_tini(endpoint);
   pn_delivery_map_free(&session->state.incoming);
   pn_delivery_map_free(&session->state.outgoing);
   pn_free(session->state.local_handles);
   pn_free(session->state.remote_handles);
+  pn_alias_set_free(&session->state.handle_aliases);
   pni_remove_session(session->connection, session);
-  pn_list_remove(session->connection->freed, session);
+  pni_remove_freed(&session->connection->freed_head, &session->connection->freed_tail, endpoint);
 
   if (session->connection->transport) {
     pn_transport_t *transport = session->connection->transport;
+    if (pn_hash_get(transport->local_channels, session->state.local_channel) == session) {
+      pn_transport_release_channel(transport, session->state.local_channel);
+    }
     pn_hash_del(transport->local_channels, session->state.local_channel);
     pn_hash_del(transport->remote_channels, session->state.remote_channel);
   }
@@ -975,8 +1068,11 @@ pn_session_t *pn_session(pn_connection_t *conn)
   if (!ssn) return NULL;
   pn_endpoint_init(&ssn->endpoint, SESSION, conn);
   pni_add_session(conn, ssn);
-  ssn->links = pn_list(PN_WEAKREF, 0);
-  ssn->freed = pn_list(PN_WEAKREF, 0);
+  ssn->child_head = NULL;
+  ssn->child_tail = NULL;
+  ssn->link_names = pn_hash(PN_WEAKREF, 0, 0.75);
+  ssn->freed_head = NULL;
+  ssn->freed_tail = NULL;
   ssn->context = pn_record();
   ssn->incoming_capacity = 1024*1024;
   ssn->incoming_bytes = 0;
@@ -984,6 +1080,8 @@ pn_session_t *pn_session(pn_connection_t *conn)
   ssn->incoming_deliveries = 0;
   ssn->outgoing_deliveries = 0;
   ssn->outgoing_window = 2147483647;
+  memset(&ssn->metrics, 0, sizeof(ssn->metrics));
+  ssn->window_stalled = false;
 
   // begin transport state
   memset(&ssn->state, 0, sizeof(ssn->state));
@@ -1006,9 +1104,8 @@ pn_session_t *pn_session(pn_connection_t *conn)
 static void pni_session_bound(pn_session_t *ssn)
 {
   assert(ssn);
-  size_t nlinks = pn_list_size(ssn->links);
-  for (size_t i = 0; i < nlinks; i++) {
-    pni_link_bound((pn_link_t *) pn_list_get(ssn->links, i));
+  for (pn_endpoint_t *link = ssn->child_head; link; link = link->child_next) {
+    pni_link_bound((pn_link_t *) link);
   }
 }
 
@@ -1048,6 +1145,19 @@ void pn_session_set_outgoing_window(pn_session_t *ssn, size_t window)
   ssn->outgoing_window = window;
 }
 
+const pn_session_metrics_t *pn_session_metrics(pn_session_t *ssn)
+{
+  assert(ssn);
+  return &ssn->metrics;
+}
+
+void pn_session_metrics_copy(pn_session_t *ssn, pn_session_metrics_t *metrics)
+{
+  assert(ssn && metrics);
+  pni_metrics_copy((uint64_t *) metrics, (const uint64_t *) &ssn->metrics,
+                   sizeof(*metrics) / sizeof(uint64_t));
+}
+
 size_t pn_session_outgoing_bytes(pn_session_t *ssn)
 {
   assert(ssn);
@@ -1111,16 +1221,20 @@ static void pn_link_finalize(void *object)
   }
 
   pn_free(link->context);
+  pn_histogram_free(link->settle_latency);
   pni_terminus_free(&link->source);
   pni_terminus_free(&link->target);
   pni_terminus_free(&link->remote_source);
   pni_terminus_free(&link->remote_target);
-  pn_free(link->name);
   pni_endpoint_tini(endpoint);
   pni_remove_link(link->session, link);
+  pn_free(link->name);
+  if (pn_hash_get(link->session->state.local_handles, link->state.local_handle) == link) {
+    pn_session_release_handle(link->session, link->state.local_handle);
+  }
   pn_hash_del(link->session->state.local_handles, link->state.local_handle);
   pn_hash_del(link->session->state.remote_handles, link->state.remote_handle);
-  pn_list_remove(link->session->freed, link);
+  pni_remove_freed(&link->session->freed_head, &link->session->freed_tail, endpoint);
   if (endpoint->referenced) {
     pn_decref(link->session);
   }
@@ -1144,14 +1258,15 @@ pn_link_t *pn_link_new(int type, pn_session_t *session, const char *name)
   pn_link_t *link = (pn_link_t *) pn_class_new(&clazz, sizeof(pn_link_t));
 
   pn_endpoint_init(&link->endpoint, type, session->connection);
+  link->name = pn_string(name);
   pni_add_link(session, link);
   pn_incref(session);  // keep session until link finalized
-  link->name = pn_string(name);
   pni_terminus_init(&link->source, PN_SOURCE);
   pni_terminus_init(&link->target, PN_TARGET);
   pni_terminus_init(&link->remote_source, PN_UNSPECIFIED);
   pni_terminus_init(&link->remote_target, PN_UNSPECIFIED);
   link->unsettled_head = link->unsettled_tail = link->current = NULL;
+  link->ranged_head = link->ranged_tail = NULL;
   link->unsettled_count = 0;
   link->available = 0;
   link->credit = 0;
@@ -1165,6 +1280,10 @@ pn_link_t *pn_link_new(int type, pn_session_t *session, const char *name)
   link->remote_snd_settle_mode = PN_SND_MIXED;
   link->remote_rcv_settle_mode = PN_RCV_FIRST;
   link->detached = false;
+  link->bulk_settle = false;
+  link->credit_stalled = false;
+  link->settle_latency = NULL;
+  memset(&link->metrics, 0, sizeof(link->metrics));
 
   // begin transport state
   link->state.local_handle = -1;
@@ -1427,6 +1546,7 @@ static void pn_delivery_finalize(void *object)
     referenced = delivery->referenced;
 
     pn_clear_tpwork(delivery);
+    pni_clear_ranged(delivery);
     LL_REMOVE(link, unsettled, delivery);
     pn_delivery_map_del(pn_link_is_sender(link)
                         ? &link->session->state.outgoing
@@ -1528,8 +1648,12 @@ pn_delivery_t *pn_delivery(pn_link_t *link, pn_delivery_tag_t tag)
   delivery->tpwork_next = NULL;
   delivery->tpwork_prev = NULL;
   delivery->tpwork = false;
+  delivery->ranged_next = NULL;
+  delivery->ranged_prev = NULL;
+  delivery->ranged = false;
   pn_buffer_clear(delivery->bytes);
   delivery->done = false;
+  delivery->sent_at = 0;
   pn_record_clear(delivery->context);
 
   // begin delivery state
@@ -1786,6 +1910,66 @@ bool pn_link_get_drain(pn_link_t *link)
   return link->drain;
 }
 
+void pn_link_set_bulk_settle(pn_link_t *link, bool bulk)
+{
+  assert(link);
+  link->bulk_settle = bulk;
+}
+
+bool pn_link_get_bulk_settle(pn_link_t *link)
+{
+  assert(link);
+  return link->bulk_settle;
+}
+
+pn_delivery_t *pn_link_take_settled(pn_link_t *link)
+{
+  assert(link);
+  pn_delivery_t *delivery = link->ranged_head;
+  if (delivery) {
+    pni_clear_ranged(delivery);
+  }
+  return delivery;
+}
+
+const pn_link_metrics_t *pn_link_metrics(pn_link_t *link)
+{
+  assert(link);
+  return &link->metrics;
+}
+
+void pn_link_metrics_copy(pn_link_t *link, pn_link_metrics_t *metrics)
+{
+  assert(link && metrics);
+  pni_metrics_copy((uint64_t *) metrics, (const uint64_t *) &link->metrics,
+                   sizeof(*metrics) / sizeof(uint64_t));
+}
+
+void pn_link_record_settle_latency(pn_link_t *link, bool record)
+{
+  assert(link);
+  if (record && !link->settle_latency) {
+    link->settle_latency = pn_histogram();
+  } else if (!record && link->settle_latency) {
+    pn_histogram_free(link->settle_latency);
+    link->settle_latency = NULL;
+  }
+}
+
+const pn_histogram_t *pn_link_settle_latency(pn_link_t *link)
+{
+  assert(link);
+  return link->settle_latency;
+}
+
+bool pn_link_settle_latency_copy(pn_link_t *link, pn_histogram_t *histogram)
+{
+  assert(link && histogram);
+  if (!link->settle_latency) return false;
+  pni_histogram_copy(histogram, link->settle_latency);
+  return true;
+}
+
 pn_snd_settle_mode_t pn_link_snd_settle_mode(pn_link_t *link)
 {
   return link ? (pn_snd_settle_mode_t)link->snd_settle_mode
@@ -1831,6 +2015,7 @@ void pn_delivery_settle(pn_delivery_t *delivery)
 
     link->unsettled_count--;
     delivery->local.settled = true;
+    pni_clear_ranged(delivery);
     pni_add_tpwork(delivery);
     pn_work_update(delivery->link->session->connection, delivery);
     pn_incref(delivery);
@@ -28,6 +28,8 @@ struct pn_collector_t {
   pn_list_t *pool;
   pn_event_t *head;
   pn_event_t *tail;
+  pn_hash_t *coalesced;   // context -> its last coalescable event
+  bool coalescing;
   bool freed;
 };
 
@@ -45,6 +47,8 @@ static void pn_collector_initialize(pn_collector_t *collector)
   collector->pool = pn_list(PN_OBJECT, 0);
   collector->head = NULL;
   collector->tail = NULL;
+  collector->coalesced = NULL;
+  collector->coalescing = false;
   collector->freed = false;
 }
 
@@ -70,6 +74,7 @@ static void pn_collector_finalize(pn_collector_t *collector)
 {
   pn_collector_drain(collector);
   pn_decref(collector->pool);
+  pn_free(collector->coalesced);
 }
 
 static int pn_collector_inspect(pn_collector_t *collector, pn_string_t *dst)
@@ -122,6 +127,35 @@ void pn_collector_release(pn_collector_t *collector)
 
 pn_event_t *pn_event(void);
 
+// Events that report the current state of their context rather than a
+// transition, so a later one adds nothing to an earlier one still queued.
+static bool pni_coalescable(pn_event_type_t type)
+{
+  switch (type) {
+  case PN_DELIVERY:
+  case PN_LINK_FLOW:
+  case PN_TRANSPORT:
+    return true;
+  default:
+    return false;
+  }
+}
+
+void pni_collector_coalesce(pn_collector_t *collector, bool coalesce)
+{
+  assert(collector);
+  if (!coalesce && collector->coalesced) {
+    // the events are held until here so none is recycled while indexed
+    for (pn_handle_t entry = pn_hash_head(collector->coalesced); entry;
+         entry = pn_hash_next(collector->coalesced, entry)) {
+      pn_hash_del(collector->coalesced, pn_hash_key(collector->coalesced, entry));
+    }
+  } else if (coalesce && !collector->coalesced) {
+    collector->coalesced = pn_hash(PN_OBJECT, 0, 0.75);
+  }
+  collector->coalescing = coalesce;
+}
+
 pn_event_t *pn_collector_put(pn_collector_t *collector,
                              const pn_class_t *clazz, void *context,
                              pn_event_type_t type)
@@ -141,6 +175,14 @@ pn_event_t *pn_collector_put(pn_collector_t *collector,
     return NULL;
   }
 
+  bool coalesce = collector->coalescing && pni_coalescable(type);
+  if (coalesce) {
+    pn_event_t *last = (pn_event_t *) pn_hash_get(collector->coalesced, (uintptr_t) context);
+    if (last && last->type == type) {
+      return NULL;
+    }
+  }
+
   clazz = clazz->reify(context);
 
   pn_event_t *event = (pn_event_t *) pn_list_pop(collector->pool);
@@ -165,6 +207,10 @@ pn_event_t *pn_collector_put(pn_collector_t *collector,
   event->type = type;
   pn_class_incref(clazz, event->context);
 
+  if (coalesce) {
+    pn_hash_put(collector->coalesced, (uintptr_t) context, event);
+  }
+
   return event;
 }
 
@@ -356,6 +402,8 @@ const char *pn_event_type_name(pn_event_type_t type)
     return "PN_LINK_FINAL";
   case PN_DELIVERY:
     return "PN_DELIVERY";
+  case PN_DELIVERY_SETTLE_RANGE:
+    return "PN_DELIVERY_SETTLE_RANGE";
   case PN_TRANSPORT:
     return "PN_TRANSPORT";
   case PN_TRANSPORT_AUTHENTICATED:
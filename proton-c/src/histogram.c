@@ -0,0 +1,145 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "histogram.h"
+#include "platform.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// Values below 16 get a bucket each. Above that every power of two is
+// split into eight buckets, so a bucket is never wider than an eighth
+// of the values in it.
+#define PNI_SUB_BUCKETS 8
+#define PNI_BUCKETS (PNI_SUB_BUCKETS + (64 - 3) * PNI_SUB_BUCKETS)
+
+struct pn_histogram_t {
+  uint64_t count;
+  uint64_t min;
+  uint64_t max;
+  uint64_t sum;
+  uint64_t buckets[PNI_BUCKETS];
+};
+
+static int pni_msb(uint64_t value)
+{
+  int msb = 0;
+  while (value >>= 1) msb++;
+  return msb;
+}
+
+static size_t pni_bucket(uint64_t value)
+{
+  if (value < 2 * PNI_SUB_BUCKETS) return (size_t) value;
+  int shift = pni_msb(value) - 3;
+  return PNI_SUB_BUCKETS + shift * PNI_SUB_BUCKETS + (size_t) (value >> shift) - PNI_SUB_BUCKETS;
+}
+
+// The highest value that falls in a bucket.
+static uint64_t pni_bucket_high(size_t bucket)
+{
+  if (bucket < PNI_SUB_BUCKETS) return bucket;
+  size_t shift = (bucket - PNI_SUB_BUCKETS) / PNI_SUB_BUCKETS;
+  uint64_t mantissa = PNI_SUB_BUCKETS + (bucket - PNI_SUB_BUCKETS) % PNI_SUB_BUCKETS;
+  return (mantissa << shift) + (((uint64_t) 1 << shift) - 1);
+}
+
+pn_histogram_t *pn_histogram(void)
+{
+  return (pn_histogram_t *) calloc(1, sizeof(pn_histogram_t));
+}
+
+void pn_histogram_free(pn_histogram_t *histogram)
+{
+  free(histogram);
+}
+
+// Written like the metrics counters, so pni_histogram_copy() can read it
+// from another thread.
+void pni_histogram_record(pn_histogram_t *histogram, uint64_t value)
+{
+  assert(histogram);
+  if (!histogram->count || value < histogram->min) PNI_COUNT_SET(histogram->min, value);
+  if (value > histogram->max) PNI_COUNT_SET(histogram->max, value);
+  PNI_COUNT(histogram->sum, value);
+  PNI_COUNT(histogram->buckets[pni_bucket(value)], 1);
+  PNI_COUNT(histogram->count, 1);
+}
+
+void pni_histogram_copy(pn_histogram_t *to, const pn_histogram_t *from)
+{
+  assert(to && from);
+  to->count = PNI_COUNT_GET(from->count);
+  to->min = PNI_COUNT_GET(from->min);
+  to->max = PNI_COUNT_GET(from->max);
+  to->sum = PNI_COUNT_GET(from->sum);
+  for (size_t i = 0; i < PNI_BUCKETS; i++) {
+    to->buckets[i] = PNI_COUNT_GET(from->buckets[i]);
+  }
+}
+
+uint64_t pn_histogram_count(const pn_histogram_t *histogram)
+{
+  assert(histogram);
+  return histogram->count;
+}
+
+uint64_t pn_histogram_min(const pn_histogram_t *histogram)
+{
+  assert(histogram);
+  return histogram->min;
+}
+
+uint64_t pn_histogram_max(const pn_histogram_t *histogram)
+{
+  assert(histogram);
+  return histogram->max;
+}
+
+double pn_histogram_mean(const pn_histogram_t *histogram)
+{
+  assert(histogram);
+  return histogram->count ? (double) histogram->sum / histogram->count : 0.0;
+}
+
+uint64_t pn_histogram_percentile(const pn_histogram_t *histogram, double percentile)
+{
+  assert(histogram);
+  uint64_t count = histogram->count;
+  if (!count) return 0;
+  if (percentile < 0) percentile = 0;
+  if (percentile > 100) percentile = 100;
+  uint64_t rank = (uint64_t) (percentile / 100.0 * count + 0.5);
+  if (rank < 1) rank = 1;
+  if (rank > count) rank = count;
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < PNI_BUCKETS; i++) {
+    seen += histogram->buckets[i];
+    if (seen >= rank) {
+      uint64_t high = pni_bucket_high(i);
+      if (high > histogram->max) high = histogram->max;
+      if (high < histogram->min) high = histogram->min;
+      return high;
+    }
+  }
+  return histogram->max;
+}
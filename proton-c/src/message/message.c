@@ -372,6 +372,52 @@ void pn_message_clear(pn_message_t *msg)
   pn_data_clear(msg->body);
 }
 
+static int pni_string_copy(pn_string_t *dst, pn_string_t *src)
+{
+  return pn_string_setn(dst, pn_string_get(src), pn_string_size(src));
+}
+
+// The id and correlation id are read as an atom at the current node.
+static int pni_atom_copy(pn_data_t *dst, pn_data_t *src)
+{
+  int err = pn_data_copy(dst, src);
+  if (!err) pn_data_next(dst);
+  return err;
+}
+
+int pn_message_copy(pn_message_t *dst, pn_message_t *src)
+{
+  assert(dst);
+  assert(src);
+  if (dst == src) return 0;
+
+  dst->durable = src->durable;
+  dst->priority = src->priority;
+  dst->ttl = src->ttl;
+  dst->first_acquirer = src->first_acquirer;
+  dst->delivery_count = src->delivery_count;
+  dst->expiry_time = src->expiry_time;
+  dst->creation_time = src->creation_time;
+  dst->group_sequence = src->group_sequence;
+  dst->inferred = src->inferred;
+
+  int err;
+  if ((err = pni_atom_copy(dst->id, src->id))) return err;
+  if ((err = pni_string_copy(dst->user_id, src->user_id))) return err;
+  if ((err = pni_string_copy(dst->address, src->address))) return err;
+  if ((err = pni_string_copy(dst->subject, src->subject))) return err;
+  if ((err = pni_string_copy(dst->reply_to, src->reply_to))) return err;
+  if ((err = pni_atom_copy(dst->correlation_id, src->correlation_id))) return err;
+  if ((err = pni_string_copy(dst->content_type, src->content_type))) return err;
+  if ((err = pni_string_copy(dst->content_encoding, src->content_encoding))) return err;
+  if ((err = pni_string_copy(dst->group_id, src->group_id))) return err;
+  if ((err = pni_string_copy(dst->reply_to_group_id, src->reply_to_group_id))) return err;
+  if ((err = pn_data_copy(dst->instructions, src->instructions))) return err;
+  if ((err = pn_data_copy(dst->annotations, src->annotations))) return err;
+  if ((err = pn_data_copy(dst->properties, src->properties))) return err;
+  return pn_data_copy(dst->body, src->body);
+}
+
 int pn_message_errno(pn_message_t *msg)
 {
   assert(msg);
@@ -0,0 +1,548 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L  // posix_fallocate, fsync
+#endif
+
+#include <proton/object.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "platform.h"
+#include "journal.h"
+
+#ifdef _WIN32
+
+pni_journal_t *pni_journal(const char *path, pn_error_t *error)
+{
+  pn_error_format(error, PN_ERR, "journal not supported on this platform");
+  return NULL;
+}
+
+void pni_journal_free(pni_journal_t *journal) {}
+const char *pni_journal_path(pni_journal_t *journal) { return NULL; }
+pn_error_t *pni_journal_error(pni_journal_t *journal) { return NULL; }
+char *pni_journal_reserve(pni_journal_t *journal, const char *address, size_t *size) { return NULL; }
+int pni_journal_commit(pni_journal_t *journal, size_t size, pni_record_t *record) { return PN_ERR; }
+pn_bytes_t pni_journal_bytes(pni_record_t record) { return pn_bytes(0, NULL); }
+void pni_journal_done(pni_journal_t *journal, pni_record_t record) {}
+int pni_journal_sync(pni_journal_t *journal) { return 0; }
+int pni_journal_replay(pni_journal_t *journal, pni_journal_replay_t replay, void *context) { return 0; }
+
+#else
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/*
+ * A segment file is a 16 byte header followed by records, each a
+ * record header, the null terminated address and the encoded message,
+ * padded to 8 bytes. A record header with state RECORD_EMPTY marks
+ * the end of the segment. The state is written last and the checksum
+ * covers the address and message, so a record torn by a crash ends
+ * the segment too.
+ */
+
+#define PNI_JOURNAL_MAGIC (0x314a4e50) /* "PNJ1" */
+#define PNI_SEGMENT_HEADER (16)
+#define PNI_RECORD_HEADER (sizeof(pni_record_header_t))
+#define PNI_ALIGN(N) (((N) + 7) & ~((size_t) 7))
+
+enum {
+  RECORD_EMPTY = 0,
+  RECORD_LIVE = 1,
+  RECORD_DONE = 2
+};
+
+typedef struct {
+  uint32_t address_size;        /* including the null */
+  uint32_t size;
+  uint32_t checksum;
+  uint32_t state;
+} pni_record_header_t;
+
+struct pni_segment_t {
+  pni_segment_t *next;
+  char *base;
+  size_t size;
+  size_t tail;                  /* end of the last record */
+  size_t dirty_lo;              /* written since the last sync */
+  size_t dirty_hi;
+  size_t live;
+  uint32_t id;
+  int fd;
+};
+
+struct pni_journal_t {
+  pn_string_t *path;
+  pn_string_t *file;
+  pn_error_t *error;
+  pni_segment_t *segments;      /* oldest first */
+  pni_segment_t *active;        /* being appended to */
+  pni_segment_t *replay;        /* found on open, not yet replayed */
+  size_t reserved;              /* address size of the reserved record */
+  size_t pending;               /* records committed since the last sync */
+  uint32_t next_id;
+};
+
+static uint32_t pni_checksum(const char *bytes, size_t size)
+{
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= (uint8_t) bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static size_t pni_page_size(void)
+{
+  long page = sysconf(_SC_PAGESIZE);
+  return page > 0 ? (size_t) page : 4096;
+}
+
+static const char *pni_segment_file(pni_journal_t *journal, uint32_t id)
+{
+  pn_string_format(journal->file, "%s/%08x.pnj", pn_string_get(journal->path), (unsigned) id);
+  return pn_string_get(journal->file);
+}
+
+static void pni_segment_dirty(pni_segment_t *segment, size_t lo, size_t hi)
+{
+  if (lo < segment->dirty_lo) segment->dirty_lo = lo;
+  if (hi > segment->dirty_hi) segment->dirty_hi = hi;
+}
+
+static size_t pni_segment_space(pni_segment_t *segment)
+{
+  size_t left = segment->size - segment->tail;
+  return left > PNI_RECORD_HEADER ? left - PNI_RECORD_HEADER : 0;
+}
+
+static pni_segment_t *pni_segment_map(pni_journal_t *journal, int fd, uint32_t id, size_t size)
+{
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    pn_i_error_from_errno(journal->error, "mmap");
+    close(fd);
+    return NULL;
+  }
+
+  pni_segment_t *segment = (pni_segment_t *) malloc(sizeof(pni_segment_t));
+  if (!segment) {
+    pn_error_format(journal->error, PN_OUT_OF_MEMORY, "journal segment");
+    munmap(base, size);
+    close(fd);
+    return NULL;
+  }
+  segment->next = NULL;
+  segment->base = (char *) base;
+  segment->size = size;
+  segment->tail = PNI_SEGMENT_HEADER;
+  segment->dirty_lo = size;
+  segment->dirty_hi = 0;
+  segment->live = 0;
+  segment->id = id;
+  segment->fd = fd;
+  return segment;
+}
+
+static void pni_segment_close(pni_segment_t *segment)
+{
+  munmap(segment->base, segment->size);
+  close(segment->fd);
+  free(segment);
+}
+
+static int pni_journal_sync_dir(pni_journal_t *journal)
+{
+  int fd = open(pn_string_get(journal->path), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return pn_i_error_from_errno(journal->error, "open journal directory");
+  int err = fsync(fd) ? pn_i_error_from_errno(journal->error, "fsync journal directory") : 0;
+  close(fd);
+  return err;
+}
+
+static pni_segment_t *pni_segment_create(pni_journal_t *journal, size_t size)
+{
+  uint32_t id = journal->next_id++;
+  int fd = open(pni_segment_file(journal, id), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    pn_i_error_from_errno(journal->error, "create journal segment");
+    return NULL;
+  }
+
+  // Allocate the blocks up front, writing through the mapping to a
+  // sparse file that cannot grow would fault instead of failing.
+  int err = 0;
+#ifdef __linux__
+  err = posix_fallocate(fd, 0, size);
+  if (err == EOPNOTSUPP || err == EINVAL) err = ftruncate(fd, size) ? errno : 0;
+#else
+  err = ftruncate(fd, size) ? errno : 0;
+#endif
+  if (err) {
+    errno = err;
+    pn_i_error_from_errno(journal->error, "size journal segment");
+    close(fd);
+    unlink(pni_segment_file(journal, id));
+    return NULL;
+  }
+
+  pni_segment_t *segment = pni_segment_map(journal, fd, id, size);
+  if (!segment) {
+    unlink(pni_segment_file(journal, id));
+    return NULL;
+  }
+  uint32_t *header = (uint32_t *) segment->base;
+  header[0] = PNI_JOURNAL_MAGIC;
+  header[1] = id;
+  if (msync(segment->base, pni_page_size(), MS_SYNC) || fsync(fd)) {
+    err = pn_i_error_from_errno(journal->error, "sync journal segment");
+  } else {
+    err = pni_journal_sync_dir(journal);
+  }
+  if (err) {
+    pni_segment_close(segment);
+    unlink(pni_segment_file(journal, id));
+    return NULL;
+  }
+  return segment;
+}
+
+static pni_segment_t *pni_segment_open(pni_journal_t *journal, uint32_t id)
+{
+  const char *file = pni_segment_file(journal, id);
+  int fd = open(file, O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    pn_i_error_from_errno(journal->error, "open journal segment");
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st)) {
+    pn_i_error_from_errno(journal->error, "stat journal segment");
+    close(fd);
+    return NULL;
+  }
+  if ((size_t) st.st_size < PNI_SEGMENT_HEADER) {
+    pn_error_format(journal->error, PN_ERR, "%s: not a journal segment", file);
+    close(fd);
+    return NULL;
+  }
+
+  pni_segment_t *segment = pni_segment_map(journal, fd, id, st.st_size);
+  if (!segment) return NULL;
+  uint32_t *header = (uint32_t *) segment->base;
+  if (header[0] != PNI_JOURNAL_MAGIC || header[1] != id) {
+    pn_error_format(journal->error, PN_ERR, "%s: not a journal segment", file);
+    pni_segment_close(segment);
+    return NULL;
+  }
+  return segment;
+}
+
+static void pni_segment_remove(pni_journal_t *journal, pni_segment_t *segment)
+{
+  pni_segment_t **prev = &journal->segments;
+  while (*prev != segment) prev = &(*prev)->next;
+  *prev = segment->next;
+  unlink(pni_segment_file(journal, segment->id));
+  pni_segment_close(segment);
+}
+
+static void pni_segment_insert(pni_journal_t *journal, pni_segment_t *segment)
+{
+  pni_segment_t **prev = &journal->segments;
+  while (*prev && (*prev)->id < segment->id) prev = &(*prev)->next;
+  segment->next = *prev;
+  *prev = segment;
+}
+
+static int pni_compare_ids(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *) a;
+  uint32_t y = *(const uint32_t *) b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int pni_journal_open(pni_journal_t *journal)
+{
+  const char *path = pn_string_get(journal->path);
+  if (mkdir(path, 0700) && errno != EEXIST)
+    return pn_i_error_from_errno(journal->error, "create journal directory");
+
+  DIR *dir = opendir(path);
+  if (!dir) return pn_i_error_from_errno(journal->error, "open journal directory");
+
+  uint32_t *ids = NULL;
+  size_t count = 0, capacity = 0;
+  struct dirent *ent;
+  while ((ent = readdir(dir))) {
+    char *end;
+    unsigned long id = strtoul(ent->d_name, &end, 16);
+    if (end != ent->d_name + 8 || strcmp(end, ".pnj")) continue;
+    if (count == capacity) {
+      capacity = capacity ? 2*capacity : 16;
+      uint32_t *grown = (uint32_t *) realloc(ids, capacity*sizeof(uint32_t));
+      if (!grown) {
+        free(ids);
+        closedir(dir);
+        return pn_error_format(journal->error, PN_OUT_OF_MEMORY, "journal directory");
+      }
+      ids = grown;
+    }
+    ids[count++] = (uint32_t) id;
+  }
+  closedir(dir);
+
+  qsort(ids, count, sizeof(uint32_t), pni_compare_ids);
+  int err = 0;
+  pni_segment_t **tail = &journal->replay;
+  for (size_t i = 0; i < count && !err; i++) {
+    pni_segment_t *segment = pni_segment_open(journal, ids[i]);
+    if (segment) {
+      *tail = segment;
+      tail = &segment->next;
+      journal->next_id = ids[i] + 1;
+    } else {
+      err = pn_error_code(journal->error);
+    }
+  }
+  free(ids);
+  return err;
+}
+
+pni_journal_t *pni_journal(const char *path, pn_error_t *error)
+{
+  assert(path);
+  pni_journal_t *journal = (pni_journal_t *) malloc(sizeof(pni_journal_t));
+  if (!journal) {
+    pn_error_format(error, PN_OUT_OF_MEMORY, "journal");
+    return NULL;
+  }
+  journal->path = pn_string(path);
+  journal->file = pn_string(NULL);
+  journal->error = pn_error();
+  journal->segments = NULL;
+  journal->active = NULL;
+  journal->replay = NULL;
+  journal->reserved = 0;
+  journal->pending = 0;
+  journal->next_id = 1;
+
+  if (pni_journal_open(journal)) {
+    pn_error_copy(error, journal->error);
+    pni_journal_free(journal);
+    return NULL;
+  }
+  return journal;
+}
+
+void pni_journal_free(pni_journal_t *journal)
+{
+  if (!journal) return;
+  pni_journal_sync(journal);
+  while (journal->segments) {
+    pni_segment_t *segment = journal->segments;
+    if (!segment->live) {
+      pni_segment_remove(journal, segment);
+    } else {
+      journal->segments = segment->next;
+      pni_segment_close(segment);
+    }
+  }
+  while (journal->replay) {
+    pni_segment_t *segment = journal->replay;
+    journal->replay = segment->next;
+    pni_segment_close(segment);
+  }
+  pn_free(journal->path);
+  pn_free(journal->file);
+  pn_error_free(journal->error);
+  free(journal);
+}
+
+const char *pni_journal_path(pni_journal_t *journal)
+{
+  assert(journal);
+  return pn_string_get(journal->path);
+}
+
+pn_error_t *pni_journal_error(pni_journal_t *journal)
+{
+  assert(journal);
+  return journal->error;
+}
+
+static int pni_journal_rotate(pni_journal_t *journal, size_t size)
+{
+  size_t page = pni_page_size();
+  size_t needed = PNI_SEGMENT_HEADER + PNI_RECORD_HEADER + size;
+  size_t segment_size = PNI_JOURNAL_SEGMENT_SIZE;
+  if (needed > segment_size) segment_size = (needed + page - 1) / page * page;
+
+  pni_segment_t *segment = pni_segment_create(journal, segment_size);
+  if (!segment) return pn_error_code(journal->error);
+
+  pni_segment_t *old = journal->active;
+  pni_segment_insert(journal, segment);
+  journal->active = segment;
+  if (old && !old->live) pni_segment_remove(journal, old);
+  return 0;
+}
+
+char *pni_journal_reserve(pni_journal_t *journal, const char *address, size_t *size)
+{
+  assert(journal);
+  assert(address);
+  size_t address_size = strlen(address) + 1;
+  pni_segment_t *segment = journal->active;
+  if (!segment || pni_segment_space(segment) < address_size + *size) {
+    if (pni_journal_rotate(journal, address_size + *size)) return NULL;
+    segment = journal->active;
+  }
+
+  char *body = segment->base + segment->tail + PNI_RECORD_HEADER;
+  memcpy(body, address, address_size);
+  journal->reserved = address_size;
+  *size = pni_segment_space(segment) - address_size;
+  return body + address_size;
+}
+
+int pni_journal_commit(pni_journal_t *journal, size_t size, pni_record_t *record)
+{
+  assert(journal);
+  pni_segment_t *segment = journal->active;
+  assert(segment && journal->reserved);
+  size_t body = journal->reserved + size;
+  assert(body <= pni_segment_space(segment));
+
+  pni_record_header_t *header = (pni_record_header_t *) (segment->base + segment->tail);
+  header->address_size = (uint32_t) journal->reserved;
+  header->size = (uint32_t) size;
+  header->checksum = pni_checksum(segment->base + segment->tail + PNI_RECORD_HEADER, body);
+  header->state = RECORD_LIVE;
+
+  record->segment = segment;
+  record->offset = segment->tail;
+  pni_segment_dirty(segment, segment->tail, segment->tail + PNI_RECORD_HEADER + body);
+  segment->tail += PNI_RECORD_HEADER + PNI_ALIGN(body);
+  segment->live++;
+  journal->reserved = 0;
+
+  if (++journal->pending >= PNI_JOURNAL_BATCH) {
+    return pni_journal_sync(journal);
+  }
+  return 0;
+}
+
+pn_bytes_t pni_journal_bytes(pni_record_t record)
+{
+  assert(record.segment);
+  const char *start = record.segment->base + record.offset;
+  const pni_record_header_t *header = (const pni_record_header_t *) start;
+  return pn_bytes(header->size, start + PNI_RECORD_HEADER + header->address_size);
+}
+
+void pni_journal_done(pni_journal_t *journal, pni_record_t record)
+{
+  assert(journal);
+  pni_segment_t *segment = record.segment;
+  assert(segment && segment->live);
+  pni_record_header_t *header = (pni_record_header_t *) (segment->base + record.offset);
+  assert(header->state == RECORD_LIVE);
+  header->state = RECORD_DONE;
+  pni_segment_dirty(segment, record.offset, record.offset + PNI_RECORD_HEADER);
+  if (!--segment->live && segment != journal->active) {
+    pni_segment_remove(journal, segment);
+  }
+}
+
+int pni_journal_sync(pni_journal_t *journal)
+{
+  assert(journal);
+  size_t page = pni_page_size();
+  int err = 0;
+  for (pni_segment_t *segment = journal->segments; segment; segment = segment->next) {
+    if (segment->dirty_hi > segment->dirty_lo) {
+      size_t lo = segment->dirty_lo / page * page;
+      if (msync(segment->base + lo, segment->dirty_hi - lo, MS_SYNC) && !err) {
+        err = pn_i_error_from_errno(journal->error, "sync journal");
+      }
+      segment->dirty_lo = segment->size;
+      segment->dirty_hi = 0;
+    }
+  }
+  journal->pending = 0;
+  return err;
+}
+
+static int pni_segment_scan(pni_segment_t *segment, pni_journal_replay_t replay, void *context)
+{
+  size_t offset = PNI_SEGMENT_HEADER;
+  while (segment->size - offset >= PNI_RECORD_HEADER) {
+    const pni_record_header_t *header = (const pni_record_header_t *) (segment->base + offset);
+    if (header->state != RECORD_LIVE && header->state != RECORD_DONE) break;
+    size_t body = (size_t) header->address_size + header->size;
+    if (!header->address_size || body > segment->size - offset - PNI_RECORD_HEADER) break;
+    const char *address = segment->base + offset + PNI_RECORD_HEADER;
+    if (address[header->address_size - 1] || pni_checksum(address, body) != header->checksum) break;
+
+    if (header->state == RECORD_LIVE) {
+      pni_record_t record;
+      record.segment = segment;
+      record.offset = offset;
+      segment->live++;
+      int err = replay(context, address, record);
+      if (err) return err;
+    }
+    offset += PNI_RECORD_HEADER + PNI_ALIGN(body);
+  }
+  segment->tail = offset;
+  return 0;
+}
+
+int pni_journal_replay(pni_journal_t *journal, pni_journal_replay_t replay, void *context)
+{
+  assert(journal);
+  while (journal->replay) {
+    pni_segment_t *segment = journal->replay;
+    journal->replay = segment->next;
+    pni_segment_insert(journal, segment);
+    int err = pni_segment_scan(segment, replay, context);
+    if (err) return err;
+    if (!segment->live) pni_segment_remove(journal, segment);
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef _PROTON_JOURNAL_H
+#define _PROTON_JOURNAL_H 1
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/error.h>
+#include <proton/types.h>
+
+/*
+ * An append only journal of encoded messages, kept in a directory of
+ * memory mapped segment files. Messages are encoded straight into the
+ * mapping and referenced by their offset in it, so a journaled
+ * message has no other copy in memory.
+ *
+ * A record stays live until pni_journal_done() marks it in place.
+ * Live records found when the journal is opened are handed back by
+ * pni_journal_replay(). A segment is deleted once it has no live
+ * records and is no longer being appended to.
+ *
+ * Writes reach the disk in batches: pni_journal_sync() flushes
+ * everything written since the last sync, and pni_journal_commit()
+ * calls it every PNI_JOURNAL_BATCH records.
+ */
+
+#define PNI_JOURNAL_SEGMENT_SIZE (1024*1024)
+#define PNI_JOURNAL_BATCH (64)
+
+typedef struct pni_journal_t pni_journal_t;
+typedef struct pni_segment_t pni_segment_t;
+
+typedef struct {
+  pni_segment_t *segment;
+  size_t offset;
+} pni_record_t;
+
+typedef int (*pni_journal_replay_t)(void *context, const char *address,
+                                    pni_record_t record);
+
+pni_journal_t *pni_journal(const char *path, pn_error_t *error);
+void pni_journal_free(pni_journal_t *journal);
+const char *pni_journal_path(pni_journal_t *journal);
+pn_error_t *pni_journal_error(pni_journal_t *journal);
+
+char *pni_journal_reserve(pni_journal_t *journal, const char *address, size_t *size);
+int pni_journal_commit(pni_journal_t *journal, size_t size, pni_record_t *record);
+pn_bytes_t pni_journal_bytes(pni_record_t record);
+void pni_journal_done(pni_journal_t *journal, pni_record_t record);
+int pni_journal_sync(pni_journal_t *journal);
+int pni_journal_replay(pni_journal_t *journal, pni_journal_replay_t replay, void *context);
+
+#endif /* journal.h */
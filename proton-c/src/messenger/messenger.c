@@ -324,27 +324,32 @@ pn_connection_t *pn_messenger_connection(pn_messenger_t *messenger,
                                          char *port,
                                          pn_listener_ctx_t *lnr);
 
+// The listen socket is non-blocking: accept until the queue is empty.
 static void pni_listener_readable(pn_selectable_t *sel)
 {
   pn_listener_ctx_t *ctx = (pn_listener_ctx_t *) pni_selectable_get_context(sel);
   pn_subscription_t *sub = ctx->subscription;
   const char *scheme = pn_subscription_scheme(sub);
   char name[1024];
-  pn_socket_t sock = pn_accept(ctx->messenger->io, pn_selectable_get_fd(sel), name, 1024);
 
-  pn_transport_t *t = pn_transport();
-  pn_transport_set_server(t);
-  if (ctx->messenger->flags & PN_FLAGS_ALLOW_INSECURE_MECHS) {
-      pn_sasl_t *s = pn_sasl(t);
-      pn_sasl_set_allow_insecure_mechs(s, true);
-  }
-  pn_ssl_t *ssl = pn_ssl(t);
-  pn_ssl_init(ssl, ctx->domain, NULL);
+  while (true) {
+    pn_socket_t sock = pn_accept(ctx->messenger->io, pn_selectable_get_fd(sel), name, 1024);
+    if (sock == PN_INVALID_SOCKET) return;
 
-  pn_connection_t *conn = pn_messenger_connection(ctx->messenger, sock, scheme, NULL, NULL, NULL, NULL, ctx);
-  pn_transport_bind(t, conn);
-  pn_decref(t);
-  pni_conn_modified((pn_connection_ctx_t *) pn_connection_get_context(conn));
+    pn_transport_t *t = pn_transport();
+    pn_transport_set_server(t);
+    if (ctx->messenger->flags & PN_FLAGS_ALLOW_INSECURE_MECHS) {
+        pn_sasl_t *s = pn_sasl(t);
+        pn_sasl_set_allow_insecure_mechs(s, true);
+    }
+    pn_ssl_t *ssl = pn_ssl(t);
+    pn_ssl_init(ssl, ctx->domain, NULL);
+
+    pn_connection_t *conn = pn_messenger_connection(ctx->messenger, sock, scheme, NULL, NULL, NULL, NULL, ctx);
+    pn_transport_bind(t, conn);
+    pn_decref(t);
+    pni_conn_modified((pn_connection_ctx_t *) pn_connection_get_context(conn));
+  }
 }
 
 static void pn_listener_ctx_free(pn_messenger_t *messenger, pn_listener_ctx_t *ctx);
@@ -1357,11 +1362,16 @@ static void pni_messenger_tick(pn_messenger_t *messenger)
   }
 }
 
+static int pni_journal_error_format(pn_messenger_t *messenger, int err);
+
 int pn_messenger_process(pn_messenger_t *messenger)
 {
   bool doMessengerTick = true;
   pn_selectable_t *sel;
   int events;
+  // group commit, anything put since the last pass is flushed before more I/O
+  int err = pni_store_sync(messenger->outgoing);
+  if (err) return pni_journal_error_format(messenger, err);
   while ((sel = pn_selector_next(messenger->selector, &events))) {
     if (events & PN_READABLE) {
       pn_selectable_readable(sel);
@@ -1483,11 +1493,42 @@ pn_connection_t *pn_messenger_resolve(pn_messenger_t *messenger,
                                       const char *address, char **name);
 int pn_messenger_work(pn_messenger_t *messenger, int timeout);
 
+int pni_pump_out(pn_messenger_t *messenger, const char *address, pn_link_t *sender);
+int pni_bump_out(pn_messenger_t *messenger, const char *address);
+pn_link_t *pn_messenger_target(pn_messenger_t *messenger, const char *target,
+                               pn_seconds_t timeout);
+
+// Put the messages left in the journal, in the order they were first put.
+static int pni_messenger_replay(pn_messenger_t *messenger)
+{
+  size_t queued = pni_store_size(messenger->outgoing);
+  int err = pni_store_replay(messenger->outgoing);
+  if (err) return pni_journal_error_format(messenger, err);
+
+  pni_entry_t *entry;
+  while (pni_store_size(messenger->outgoing) > queued &&
+         (entry = pni_store_get(messenger->outgoing, NULL))) {
+    const char *address = pni_entry_address(entry);
+    pn_link_t *sender = pn_messenger_target(messenger, address, 0);
+    if (sender) {
+      err = pni_pump_out(messenger, address, sender);
+    } else if (messenger->connection_error) {
+      err = pni_bump_out(messenger, address);
+    } else {
+      err = pn_error_code(messenger->error);
+      break;
+    }
+    if (err) break;
+  }
+  return err;
+}
+
 int pn_messenger_start(pn_messenger_t *messenger)
 {
   if (!messenger) return PN_ARG_ERR;
 
-  int error = 0;
+  int error = pni_messenger_replay(messenger);
+  if (error) return error;
 
   // When checking of routes is required we attempt to resolve each route
   // with a substitution that has a defined scheme, address and port. If
@@ -1843,6 +1884,28 @@ int pn_messenger_set_outgoing_window(pn_messenger_t *messenger, int window)
   return 0;
 }
 
+int pn_messenger_set_journal(pn_messenger_t *messenger, const char *path)
+{
+  if (!messenger || !path) return PN_ARG_ERR;
+  if (pni_store_journal(messenger->outgoing) || pni_store_size(messenger->outgoing))
+    return pn_error_format(messenger->error, PN_STATE_ERR, "journal must be set before put");
+  pni_journal_t *journal = pni_journal(path, messenger->error);
+  if (!journal) return pn_error_code(messenger->error);
+  return pni_store_set_journal(messenger->outgoing, journal);
+}
+
+const char *pn_messenger_get_journal(pn_messenger_t *messenger)
+{
+  pni_journal_t *journal = pni_store_journal(messenger->outgoing);
+  return journal ? pni_journal_path(journal) : NULL;
+}
+
+static int pni_journal_error_format(pn_messenger_t *messenger, int err)
+{
+  pn_error_t *error = pni_journal_error(pni_store_journal(messenger->outgoing));
+  return pn_error_format(messenger->error, err, "journal error: %s", pn_error_text(error));
+}
+
 int pn_messenger_get_incoming_window(pn_messenger_t *messenger)
 {
   return pni_store_get_window(messenger->incoming);
@@ -1899,8 +1962,7 @@ int pni_pump_out(pn_messenger_t *messenger, const char *address, pn_link_t *send
     return 0;
   }
 
-  pn_buffer_t *buf = pni_entry_bytes(entry);
-  pn_bytes_t bytes = pn_buffer_bytes(buf);
+  pn_bytes_t bytes = pni_entry_encoded(entry);
   const char *encoded = bytes.start;
   size_t size = bytes.size;
 
@@ -1913,6 +1975,7 @@ int pni_pump_out(pn_messenger_t *messenger, const char *address, pn_link_t *send
   pni_entry_set_delivery(entry, d);
   ssize_t n = pn_link_send(sender, encoded, size);
   if (n < 0) {
+    pni_entry_set_status(entry, PN_STATUS_ABORTED);
     pni_entry_free(entry);
     return pn_error_format(messenger->error, n, "send error: %s",
                            pn_error_text(pn_link_error(sender)));
@@ -1965,6 +2028,15 @@ static void pni_restore(pn_messenger_t *messenger, pn_message_t *msg)
   pn_message_set_address(msg, pn_string_get(messenger->original));
 }
 
+static int pni_put_error(pn_messenger_t *messenger, int err)
+{
+  if (pni_store_journal(messenger->outgoing)) {
+    return pni_journal_error_format(messenger, err);
+  } else {
+    return pn_error_format(messenger->error, err, "put: error growing buffer");
+  }
+}
+
 int pn_messenger_put(pn_messenger_t *messenger, pn_message_t *msg)
 {
   if (!messenger) return PN_ARG_ERR;
@@ -1977,27 +2049,36 @@ int pn_messenger_put(pn_messenger_t *messenger, pn_message_t *msg)
     return pn_error_format(messenger->error, PN_ERR, "store error");
 
   messenger->outgoing_tracker = pn_tracker(OUTGOING, pni_entry_track(entry));
-  pn_buffer_t *buf = pni_entry_bytes(entry);
 
   pni_rewrite(messenger, msg);
+  size_t capacity = 0;
   while (true) {
-    char *encoded = pn_buffer_memory(buf).start;
-    size_t size = pn_buffer_capacity(buf);
-    int err = pn_message_encode(msg, encoded, &size);
+    // The entry's buffer, or space in the journal to encode straight into
+    pn_buffer_memory_t memory = pni_entry_reserve(entry, capacity);
+    if (!memory.start) {
+      pni_entry_set_status(entry, PN_STATUS_ABORTED);
+      pni_entry_free(entry);
+      pni_restore(messenger, msg);
+      return pni_put_error(messenger, PN_ERR);
+    }
+    size_t size = memory.size;
+    int err = pn_message_encode(msg, memory.start, &size);
     if (err == PN_OVERFLOW) {
-      err = pn_buffer_ensure(buf, 2*pn_buffer_capacity(buf));
-      if (err) {
-        pni_entry_free(entry);
-        pni_restore(messenger, msg);
-        return pn_error_format(messenger->error, err, "put: error growing buffer");
-      }
+      capacity = pn_max(2*memory.size, (size_t) 64);
     } else if (err) {
+      pni_entry_set_status(entry, PN_STATUS_ABORTED);
+      pni_entry_free(entry);
       pni_restore(messenger, msg);
       return pn_error_format(messenger->error, err, "encode error: %s",
                              pn_message_error(msg));
     } else {
       pni_restore(messenger, msg);
-      pn_buffer_append(buf, encoded, size); // XXX
+      err = pni_entry_commit(entry, size);
+      if (err) {
+        pni_entry_set_status(entry, PN_STATUS_ABORTED);
+        pni_entry_free(entry);
+        return pni_put_error(messenger, err);
+      }
       pn_link_t *sender = pn_messenger_target(messenger, address, 0);
       if (!sender) {
         int err = pn_error_code(messenger->error);
@@ -2236,8 +2317,7 @@ int pn_messenger_get(pn_messenger_t *messenger, pn_message_t *msg)
   if (!entry) return PN_EOS;
 
   messenger->incoming_tracker = pn_tracker(INCOMING, pni_entry_track(entry));
-  pn_buffer_t *buf = pni_entry_bytes(entry);
-  pn_bytes_t bytes = pn_buffer_bytes(buf);
+  pn_bytes_t bytes = pni_entry_encoded(entry);
   const char *encoded = bytes.start;
   size_t size = bytes.size;
 
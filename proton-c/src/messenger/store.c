@@ -30,6 +30,7 @@
 #include <string.h>
 #include "util.h"
 #include "store.h"
+#include "journal.h"
 
 typedef struct pni_stream_t pni_stream_t;
 
@@ -38,10 +39,12 @@ struct pni_store_t {
   pni_entry_t *store_head;
   pni_entry_t *store_tail;
   pn_hash_t *tracked;
+  pni_journal_t *journal;
   size_t size;
   int window;
   pn_sequence_t lwm;
   pn_sequence_t hwm;
+  bool closing;
 };
 
 struct pni_stream_t {
@@ -59,6 +62,7 @@ struct pni_entry_t {
   pni_entry_t *store_next;
   pni_entry_t *store_prev;
   pn_buffer_t *bytes;
+  pni_record_t record;          // in the journal, bytes is NULL
   pn_delivery_t *delivery;
   void *context;
   pn_status_t status;
@@ -66,10 +70,24 @@ struct pni_entry_t {
   bool free;
 };
 
+// The journal record is done with once the message has an outcome,
+// or once it is dropped for any reason other than the messenger going
+// away or failing to send it.
+static void pni_entry_done(pni_entry_t *entry)
+{
+  if (entry->record.segment) {
+    pni_journal_done(entry->stream->store->journal, entry->record);
+    entry->record.segment = NULL;
+  }
+}
+
 void pni_entry_finalize(void *object)
 {
   pni_entry_t *entry = (pni_entry_t *) object;
   assert(entry->free);
+  if (!entry->stream->store->closing && entry->status != PN_STATUS_ABORTED) {
+    pni_entry_done(entry);
+  }
   pn_delivery_t *d = entry->delivery;
   if (d) {
     pn_delivery_settle(d);
@@ -90,6 +108,8 @@ pni_store_t *pni_store()
   store->lwm = 0;
   store->hwm = 0;
   store->tracked = pn_hash(PN_OBJECT, 0, 0.75);
+  store->journal = NULL;
+  store->closing = false;
 
   return store;
 }
@@ -177,6 +197,7 @@ void pni_stream_free(pni_stream_t *stream)
 void pni_store_free(pni_store_t *store)
 {
   if (!store) return;
+  store->closing = true;
   pn_free(store->tracked);
   pni_stream_t *stream = store->streams;
   while (stream) {
@@ -184,6 +205,7 @@ void pni_store_free(pni_store_t *store)
     pni_stream_free(stream);
     stream = next;
   }
+  pni_journal_free(store->journal);
   free(store);
 }
 
@@ -222,7 +244,9 @@ pni_entry_t *pni_store_put(pni_store_t *store, const char *address)
   entry->store_next = NULL;
   entry->store_prev = NULL;
   entry->delivery = NULL;
-  entry->bytes = pn_buffer(64);
+  entry->bytes = store->journal ? NULL : pn_buffer(64);
+  entry->record.segment = NULL;
+  entry->record.offset = 0;
   entry->status = PN_STATUS_UNKNOWN;
   LL_ADD(stream, stream, entry);
   LL_ADD(store, store, entry);
@@ -248,6 +272,50 @@ pn_buffer_t *pni_entry_bytes(pni_entry_t *entry)
   return entry->bytes;
 }
 
+pn_buffer_memory_t pni_entry_reserve(pni_entry_t *entry, size_t size)
+{
+  assert(entry);
+  pn_buffer_memory_t memory = {0, NULL};
+  pni_journal_t *journal = entry->stream->store->journal;
+  if (journal) {
+    memory.start = pni_journal_reserve(journal, pn_string_get(entry->stream->address), &size);
+    if (memory.start) memory.size = size;
+  } else if (!pn_buffer_ensure(entry->bytes, size)) {
+    memory.start = pn_buffer_memory(entry->bytes).start;
+    memory.size = pn_buffer_capacity(entry->bytes);
+  }
+  return memory;
+}
+
+int pni_entry_commit(pni_entry_t *entry, size_t size)
+{
+  assert(entry);
+  pni_journal_t *journal = entry->stream->store->journal;
+  if (journal) {
+    return pni_journal_commit(journal, size, &entry->record);
+  } else {
+    return pn_buffer_append(entry->bytes, pn_buffer_memory(entry->bytes).start, size);
+  }
+}
+
+pn_bytes_t pni_entry_encoded(pni_entry_t *entry)
+{
+  assert(entry);
+  if (entry->record.segment) {
+    return pni_journal_bytes(entry->record);
+  } else if (entry->bytes) {
+    return pn_buffer_bytes(entry->bytes);
+  } else {
+    return pn_bytes(0, NULL);
+  }
+}
+
+const char *pni_entry_address(pni_entry_t *entry)
+{
+  assert(entry);
+  return pn_string_get(entry->stream->address);
+}
+
 pn_status_t pni_entry_get_status(pni_entry_t *entry)
 {
   assert(entry);
@@ -331,6 +399,9 @@ void pni_entry_updated(pni_entry_t *entry)
     } else {
       entry->status = PN_STATUS_PENDING;
     }
+    if (entry->status != PN_STATUS_PENDING) {
+      pni_entry_done(entry);
+    }
   }
 }
 
@@ -440,3 +511,40 @@ void pni_store_set_window(pni_store_t *store, int window)
   assert(store);
   store->window = window;
 }
+
+int pni_store_set_journal(pni_store_t *store, pni_journal_t *journal)
+{
+  assert(store);
+  if (store->journal || store->size) return PN_STATE_ERR;
+  store->journal = journal;
+  return 0;
+}
+
+pni_journal_t *pni_store_journal(pni_store_t *store)
+{
+  assert(store);
+  return store->journal;
+}
+
+static int pni_store_replayed(void *context, const char *address, pni_record_t record)
+{
+  pni_store_t *store = (pni_store_t *) context;
+  pni_entry_t *entry = pni_store_put(store, address);
+  if (!entry) return PN_OUT_OF_MEMORY;
+  entry->record = record;
+  pni_entry_track(entry);
+  return 0;
+}
+
+int pni_store_replay(pni_store_t *store)
+{
+  assert(store);
+  if (!store->journal) return 0;
+  return pni_journal_replay(store->journal, pni_store_replayed, store);
+}
+
+int pni_store_sync(pni_store_t *store)
+{
+  assert(store);
+  return store->journal ? pni_journal_sync(store->journal) : 0;
+}
@@ -23,6 +23,7 @@
  */
 
 #include "buffer.h"
+#include "journal.h"
 
 typedef struct pni_store_t pni_store_t;
 typedef struct pni_entry_t pni_entry_t;
@@ -34,6 +35,10 @@ pni_entry_t *pni_store_put(pni_store_t *store, const char *address);
 pni_entry_t *pni_store_get(pni_store_t *store, const char *address);
 
 pn_buffer_t *pni_entry_bytes(pni_entry_t *entry);
+pn_buffer_memory_t pni_entry_reserve(pni_entry_t *entry, size_t size);
+int pni_entry_commit(pni_entry_t *entry, size_t size);
+pn_bytes_t pni_entry_encoded(pni_entry_t *entry);
+const char *pni_entry_address(pni_entry_t *entry);
 pn_status_t pni_entry_get_status(pni_entry_t *entry);
 void pni_entry_set_status(pni_entry_t *entry, pn_status_t status);
 pn_delivery_t *pni_entry_get_delivery(pni_entry_t *entry);
@@ -50,5 +55,10 @@ int pni_store_update(pni_store_t *store, pn_sequence_t id, pn_status_t status,
 int pni_store_get_window(pni_store_t *store);
 void pni_store_set_window(pni_store_t *store, int window);
 
+int pni_store_set_journal(pni_store_t *store, pni_journal_t *journal);
+pni_journal_t *pni_store_journal(pni_store_t *store);
+int pni_store_replay(pni_store_t *store);
+int pni_store_sync(pni_store_t *store);
+
 
 #endif /* store.h */
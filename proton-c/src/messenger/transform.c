@@ -19,6 +19,7 @@
  *
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <ctype.h>
@@ -41,8 +42,52 @@ typedef struct {
   pn_string_t *substitution;
 } pn_rule_t;
 
+// Rules are indexed by their literal prefix (everything up to the
+// first wildcard) in a character trie. Only rules whose prefix is a
+// prefix of the address being transformed are handed to the matcher,
+// lowest rule index first, so first-match semantics are preserved.
+// Patterns without wildcards are kept apart as exact rules and only
+// considered at the node where the address ends.
+
+typedef struct {
+  size_t *index;
+  size_t size;
+  size_t capacity;
+} pni_rule_set_t;
+
+typedef struct pni_trie_t pni_trie_t;
+
+struct pni_trie_t {
+  pni_trie_t *child;
+  pni_trie_t *sibling;
+  pni_rule_set_t prefix;
+  pni_rule_set_t exact;
+  char c;
+};
+
+typedef struct {
+  pni_rule_set_t *set;
+  size_t next;
+} pni_cursor_t;
+
+// Recently resolved addresses are memoized in a direct mapped cache
+// of this many slots. A colliding address simply replaces the previous
+// occupant, so a miss costs no more than a string copy.
+#define PNI_TRANSFORM_CACHE_SIZE (1024)
+
+typedef struct {
+  pn_string_t *address;
+  pn_string_t *result;
+  bool matched;
+  bool valid;
+} pni_memo_t;
+
 struct pn_transform_t {
   pn_list_t *rules;
+  pni_trie_t *trie;
+  pni_cursor_t *cursors;
+  size_t cursor_capacity;
+  pni_memo_t *cache;
   pn_matcher_t matcher;
   bool matched;
 };
@@ -69,10 +114,86 @@ pn_rule_t *pn_rule(const char *pattern, const char *substitution)
   return rule;
 }
 
+static pni_trie_t *pni_trie(char c)
+{
+  pni_trie_t *node = (pni_trie_t *) calloc(1, sizeof(pni_trie_t));
+  if (node) node->c = c;
+  return node;
+}
+
+static void pni_trie_free(pni_trie_t *node)
+{
+  while (node) {
+    pni_trie_t *sibling = node->sibling;
+    pni_trie_free(node->child);
+    free(node->prefix.index);
+    free(node->exact.index);
+    free(node);
+    node = sibling;
+  }
+}
+
+static pni_trie_t *pni_trie_child(pni_trie_t *node, char c, bool create)
+{
+  pni_trie_t **link = &node->child;
+  while (*link) {
+    if ((*link)->c == c) return *link;
+    link = &(*link)->sibling;
+  }
+  if (create) {
+    *link = pni_trie(c);
+  }
+  return *link;
+}
+
+static bool pni_rule_set_add(pni_rule_set_t *set, size_t index)
+{
+  if (set->size == set->capacity) {
+    size_t capacity = set->capacity ? 2*set->capacity : 4;
+    size_t *grown = (size_t *) realloc(set->index, capacity * sizeof(size_t));
+    if (!grown) return false;
+    set->index = grown;
+    set->capacity = capacity;
+  }
+  // rules are only ever appended so each set stays in ascending order
+  set->index[set->size++] = index;
+  return true;
+}
+
+static void pni_trie_insert(pn_transform_t *transform, const char *pattern, size_t index)
+{
+  pni_trie_t *node = transform->trie;
+  const char *p = pattern ? pattern : "";
+  while (node && *p && *p != '*' && *p != '%') {
+    node = pni_trie_child(node, *p++, true);
+  }
+  if (node) {
+    pni_rule_set_add(*p ? &node->prefix : &node->exact, index);
+  }
+}
+
+static void pni_transform_flush(pn_transform_t *transform)
+{
+  if (transform->cache) {
+    for (size_t i = 0; i < PNI_TRANSFORM_CACHE_SIZE; i++) {
+      transform->cache[i].valid = false;
+    }
+  }
+}
+
 static void pn_transform_finalize(void *object)
 {
   pn_transform_t *transform = (pn_transform_t *) object;
   pn_free(transform->rules);
+  pni_trie_free(transform->trie);
+  free(transform->cursors);
+  if (transform->cache) {
+    for (size_t i = 0; i < PNI_TRANSFORM_CACHE_SIZE; i++) {
+      pn_free(transform->cache[i].address);
+      pn_free(transform->cache[i].result);
+    }
+    free(transform->cache);
+  }
 }
 
 #define CID_pn_transform CID_pn_object
@@ -86,6 +207,10 @@ pn_transform_t *pn_transform()
   static const pn_class_t clazz = PN_CLASS(pn_transform);
   pn_transform_t *transform = (pn_transform_t *) pn_class_new(&clazz, sizeof(pn_transform_t));
   transform->rules = pn_list(PN_OBJECT, 0);
+  transform->trie = pni_trie('\0');
+  transform->cursors = NULL;
+  transform->cursor_capacity = 0;
+  transform->cache = NULL;
   transform->matched = false;
   return transform;
 }
@@ -97,6 +222,8 @@ void pn_transform_rule(pn_transform_t *transform, const char *pattern,
   pn_rule_t *rule = pn_rule(pattern, substitution);
   pn_list_add(transform->rules, rule);
   pn_decref(rule);
+  pni_trie_insert(transform, pattern, pn_list_size(transform->rules) - 1);
+  pni_transform_flush(transform);
 }
 
 static void pni_sub(pn_matcher_t *matcher, size_t group, const char *text, size_t matched)
@@ -206,28 +333,76 @@ static size_t pni_substitute(pn_matcher_t *matcher, const char *pattern, char *d
   return result;
 }
 
-int pn_transform_apply(pn_transform_t *transform, const char *src,
-                       pn_string_t *dst)
+static bool pni_cursor_push(pn_transform_t *transform, size_t *count, pni_rule_set_t *set)
 {
-  for (size_t i = 0; i < pn_list_size(transform->rules); i++)
-  {
-    pn_rule_t *rule = (pn_rule_t *) pn_list_get(transform->rules, i);
-    if (pni_match(&transform->matcher, pn_string_get(rule->pattern), src)) {
-      transform->matched = true;
-      if (!pn_string_get(rule->substitution)) {
-        return pn_string_set(dst, NULL);
+  if (!set->size) return true;
+  if (*count == transform->cursor_capacity) {
+    size_t capacity = transform->cursor_capacity ? 2*transform->cursor_capacity : 16;
+    pni_cursor_t *grown = (pni_cursor_t *) realloc(transform->cursors, capacity * sizeof(pni_cursor_t));
+    if (!grown) return false;
+    transform->cursors = grown;
+    transform->cursor_capacity = capacity;
+  }
+  transform->cursors[*count].set = set;
+  transform->cursors[*count].next = 0;
+  (*count)++;
+  return true;
+}
+
+// Gathers the candidate rule sets along the trie path for src and
+// returns the lowest indexed rule that matches, or NULL.
+static pn_rule_t *pni_transform_find(pn_transform_t *transform, const char *src)
+{
+  const char *text = src ? src : "";
+  size_t count = 0;
+  pni_trie_t *node = transform->trie;
+  const char *t = text;
+  while (node) {
+    if (!pni_cursor_push(transform, &count, &node->prefix)) return NULL;
+    if (!*t) {
+      if (!pni_cursor_push(transform, &count, &node->exact)) return NULL;
+      break;
+    }
+    node = pni_trie_child(node, *t++, false);
+  }
+
+  while (true) {
+    pni_cursor_t *lowest = NULL;
+    for (size_t i = 0; i < count; i++) {
+      pni_cursor_t *cursor = &transform->cursors[i];
+      if (cursor->next < cursor->set->size &&
+          (!lowest || cursor->set->index[cursor->next] < lowest->set->index[lowest->next])) {
+        lowest = cursor;
       }
+    }
+    if (!lowest) return NULL;
 
-      while (true) {
-        size_t capacity = pn_string_capacity(dst);
-        size_t n = pni_substitute(&transform->matcher,
-                                  pn_string_get(rule->substitution),
-                                  pn_string_buffer(dst), capacity);
-        int err = pn_string_resize(dst, n);
-        if (err) return err;
-        if (n <= capacity) {
-          return 0;
-        }
+    pn_rule_t *rule = (pn_rule_t *) pn_list_get(transform->rules, lowest->set->index[lowest->next++]);
+    if (pni_match(&transform->matcher, pn_string_get(rule->pattern), src)) {
+      return rule;
+    }
+  }
+}
+
+static int pni_transform_resolve(pn_transform_t *transform, const char *src,
+                                 pn_string_t *dst)
+{
+  pn_rule_t *rule = pni_transform_find(transform, src);
+  if (rule) {
+    transform->matched = true;
+    if (!pn_string_get(rule->substitution)) {
+      return pn_string_set(dst, NULL);
+    }
+
+    while (true) {
+      size_t capacity = pn_string_capacity(dst);
+      size_t n = pni_substitute(&transform->matcher,
+                                pn_string_get(rule->substitution),
+                                pn_string_buffer(dst), capacity);
+      int err = pn_string_resize(dst, n);
+      if (err) return err;
+      if (n <= capacity) {
+        return 0;
       }
     }
   }
@@ -236,6 +411,53 @@ int pn_transform_apply(pn_transform_t *transform, const char *src,
   return pn_string_set(dst, src);
 }
 
+static pni_memo_t *pni_transform_memo(pn_transform_t *transform, const char *src)
+{
+  if (!transform->cache) {
+    transform->cache = (pni_memo_t *) calloc(PNI_TRANSFORM_CACHE_SIZE, sizeof(pni_memo_t));
+    if (!transform->cache) return NULL;
+  }
+
+  uint32_t hash = 2166136261u;
+  for (const char *c = src; *c; c++) {
+    hash = (hash ^ (uint8_t) *c) * 16777619u;
+  }
+
+  pni_memo_t *memo = &transform->cache[hash % PNI_TRANSFORM_CACHE_SIZE];
+  if (!memo->address) {
+    memo->address = pn_string(NULL);
+    memo->result = pn_string(NULL);
+  }
+  return memo;
+}
+
+int pn_transform_apply(pn_transform_t *transform, const char *src,
+                       pn_string_t *dst)
+{
+  if (!pn_list_size(transform->rules)) {
+    transform->matched = false;
+    return pn_string_set(dst, src);
+  }
+
+  pni_memo_t *memo = src ? pni_transform_memo(transform, src) : NULL;
+  if (!memo) {
+    return pni_transform_resolve(transform, src, dst);
+  }
+
+  if (memo->valid && !strcmp(pn_string_get(memo->address), src)) {
+    transform->matched = memo->matched;
+    return pn_string_set(dst, pn_string_get(memo->result));
+  }
+
+  int err = pni_transform_resolve(transform, src, dst);
+  if (err) return err;
+
+  memo->valid = !pn_string_set(memo->address, src) &&
+    !pn_string_set(memo->result, pn_string_get(dst));
+  memo->matched = transform->matched;
+  return 0;
+}
+
 bool pn_transform_matched(pn_transform_t *transform)
 {
   return transform->matched;
@@ -20,43 +20,152 @@
  */
 
 #include <proton/object.h>
+#include <proton/error.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
-#define PNI_ENTRY_FREE (0)
-#define PNI_ENTRY_LINK (1)
-#define PNI_ENTRY_TAIL (2)
+// Entries live in an open addressed table with a control byte per slot,
+// in the style of SwissTable. A control byte is PNI_CTRL_EMPTY,
+// PNI_CTRL_DELETED, or the low seven bits of the hash of the key in the
+// slot. Lookups load the control bytes of PNI_GROUP slots at a time and
+// only compare keys whose seven bits match, so most misses and hits
+// touch one word of control bytes and one entry. The full hash of each
+// key is kept in its entry so growing the table never calls back into
+// the key's class.
+//
+// Deleted slots are marked rather than refilled, which keeps the handle
+// of every other entry stable while iterating and deleting.
+
+#define PNI_CTRL_EMPTY ((uint8_t) 0x80)
+#define PNI_CTRL_DELETED ((uint8_t) 0xFE)
+#define PNI_GROUP (8)
+
+#define PNI_LSBS ((uint64_t) 0x0101010101010101ULL)
+#define PNI_MSBS ((uint64_t) 0x8080808080808080ULL)
 
 typedef struct {
   void *key;
   void *value;
-  size_t next;
-  uint8_t state;
+  uintptr_t hash;
 } pni_entry_t;
 
 struct pn_map_t {
   const pn_class_t *key;
   const pn_class_t *value;
+  uint8_t *ctrl;          // capacity + PNI_GROUP - 1, the tail mirrors the head
   pni_entry_t *entries;
-  size_t capacity;
-  size_t addressable;
+  size_t capacity;        // a power of two no less than PNI_GROUP
   size_t size;
+  size_t deleted;
+  size_t growth_limit;    // size + deleted may not exceed this
   uintptr_t (*hashcode)(void *key);
   bool (*equals)(void *a, void *b);
   float load_factor;
+  bool identity;          // keys are compared and hashed as integers
 };
 
+static inline bool pni_ctrl_full(uint8_t ctrl)
+{
+  return !(ctrl & 0x80);
+}
+
+// Spread the bits of a hashcode: class hashcodes and integer keys tend
+// to differ only in their low bits.
+static inline uintptr_t pni_mix(uintptr_t h)
+{
+#if UINTPTR_MAX > 0xFFFFFFFFu
+  h ^= h >> 33;
+  h *= (uintptr_t) 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+#else
+  h ^= h >> 16;
+  h *= (uintptr_t) 0x85EBCA6BU;
+  h ^= h >> 13;
+#endif
+  return h;
+}
+
+static inline uint8_t pni_h2(uintptr_t hash)
+{
+  return (uint8_t) (hash & 0x7F);
+}
+
+static inline size_t pni_h1(uintptr_t hash)
+{
+  return (size_t) (hash >> 7);
+}
+
+// The control bytes of the group starting at pos, first slot in the
+// low byte whatever the byte order.
+static inline uint64_t pni_group_load(const uint8_t *ctrl)
+{
+  uint64_t group;
+  memcpy(&group, ctrl, sizeof(group));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  group = ((group & 0x00000000FFFFFFFFULL) << 32) | ((group & 0xFFFFFFFF00000000ULL) >> 32);
+  group = ((group & 0x0000FFFF0000FFFFULL) << 16) | ((group & 0xFFFF0000FFFF0000ULL) >> 16);
+  group = ((group & 0x00FF00FF00FF00FFULL) << 8)  | ((group & 0xFF00FF00FF00FF00ULL) >> 8);
+#endif
+  return group;
+}
+
+// The high bit of each byte matching h2. May report a false match next
+// to a true one, which the key comparison weeds out.
+static inline uint64_t pni_group_match(uint64_t group, uint8_t h2)
+{
+  uint64_t x = group ^ (PNI_LSBS * h2);
+  return (x - PNI_LSBS) & ~x & PNI_MSBS;
+}
+
+static inline uint64_t pni_group_match_empty(uint64_t group)
+{
+  return group & (~group << 6) & PNI_MSBS;
+}
+
+static inline uint64_t pni_group_match_free(uint64_t group)
+{
+  return group & PNI_MSBS;
+}
+
+// Index within the group of the lowest byte flagged in match.
+static inline size_t pni_group_first(uint64_t match)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(match) >> 3;
+#else
+  size_t n = 0;
+  while (!(match & 0x80)) {
+    match >>= 8;
+    n++;
+  }
+  return n;
+#endif
+}
+
+static inline void pni_set_ctrl(pn_map_t *map, size_t index, uint8_t ctrl)
+{
+  map->ctrl[index] = ctrl;
+  map->ctrl[((index - (PNI_GROUP - 1)) & (map->capacity - 1)) + (PNI_GROUP - 1)] = ctrl;
+}
+
+static inline uintptr_t pni_map_hash(pn_map_t *map, void *key)
+{
+  return pni_mix(map->identity ? (uintptr_t) key : map->hashcode(key));
+}
+
 static void pn_map_finalize(void *object)
 {
   pn_map_t *map = (pn_map_t *) object;
 
   for (size_t i = 0; i < map->capacity; i++) {
-    if (map->entries[i].state != PNI_ENTRY_FREE) {
+    if (pni_ctrl_full(map->ctrl[i])) {
       pn_class_decref(map->key, map->entries[i].key);
       pn_class_decref(map->value, map->entries[i].value);
     }
   }
 
+  free(map->ctrl);
   free(map->entries);
 }
 
@@ -67,7 +176,7 @@ static uintptr_t pn_map_hashcode(void *object)
   uintptr_t hashcode = 0;
 
   for (size_t i = 0; i < map->capacity; i++) {
-    if (map->entries[i].state != PNI_ENTRY_FREE) {
+    if (pni_ctrl_full(map->ctrl[i])) {
       void *key = map->entries[i].key;
       void *value = map->entries[i].value;
       hashcode += pn_hashcode(key) ^ pn_hashcode(value);
@@ -77,18 +186,29 @@ static uintptr_t pn_map_hashcode(void *object)
   return hashcode;
 }
 
-static void pni_map_allocate(pn_map_t *map)
+static size_t pni_map_limit(pn_map_t *map, size_t capacity)
 {
-  map->entries = (pni_entry_t *) malloc(map->capacity * sizeof (pni_entry_t));
-  if (map->entries != NULL) {
-    for (size_t i = 0; i < map->capacity; i++) {
-      map->entries[i].key = NULL;
-      map->entries[i].value = NULL;
-      map->entries[i].next = 0;
-      map->entries[i].state = PNI_ENTRY_FREE;
-    }
+  size_t limit = (size_t) (capacity * map->load_factor);
+  return limit < capacity ? limit : capacity - 1;
+}
+
+static bool pni_map_allocate(pn_map_t *map, size_t capacity)
+{
+  uint8_t *ctrl = (uint8_t *) malloc(capacity + PNI_GROUP - 1);
+  pni_entry_t *entries = (pni_entry_t *) malloc(capacity * sizeof(pni_entry_t));
+  if (!ctrl || !entries) {
+    free(ctrl);
+    free(entries);
+    return false;
   }
+  memset(ctrl, PNI_CTRL_EMPTY, capacity + PNI_GROUP - 1);
+  map->ctrl = ctrl;
+  map->entries = entries;
+  map->capacity = capacity;
   map->size = 0;
+  map->deleted = 0;
+  map->growth_limit = pni_map_limit(map, capacity);
+  return true;
 }
 
 static int pn_map_inspect(void *obj, pn_string_t *dst)
@@ -128,13 +248,20 @@ pn_map_t *pn_map(const pn_class_t *key, const pn_class_t *value,
   pn_map_t *map = (pn_map_t *) pn_class_new(&clazz, sizeof(pn_map_t));
   map->key = key;
   map->value = value;
-  map->capacity = capacity ? capacity : 16;
-  map->addressable = (size_t) (map->capacity * 0.86);
-  if (!map->addressable) map->addressable = map->capacity;
-  map->load_factor = load_factor;
+  // past about 7/8 full probe sequences get long
+  map->load_factor = (load_factor > 0 && load_factor <= 0.875) ? load_factor : 0.875;
   map->hashcode = pn_hashcode;
   map->equals = pn_equals;
-  pni_map_allocate(map);
+  map->identity = false;
+  size_t slots = PNI_GROUP;
+  while (slots < capacity) slots *= 2;
+  if (!pni_map_allocate(map, slots)) {
+    map->ctrl = NULL;
+    map->entries = NULL;
+    map->capacity = 0;
+    pn_free(map);
+    return NULL;
+  }
   return map;
 }
 
@@ -144,113 +271,98 @@ size_t pn_map_size(pn_map_t *map)
   return map->size;
 }
 
-static float pni_map_load(pn_map_t *map)
+// The first slot not in use along the probe sequence for hash.
+static size_t pni_map_free_slot(pn_map_t *map, uintptr_t hash)
 {
-  return ((float) map->size) / ((float) map->addressable);
+  size_t mask = map->capacity - 1;
+  size_t pos = pni_h1(hash) & mask;
+  size_t step = 0;
+  while (true) {
+    uint64_t match = pni_group_match_free(pni_group_load(map->ctrl + pos));
+    if (match) {
+      return (pos + pni_group_first(match)) & mask;
+    }
+    step += PNI_GROUP;
+    pos = (pos + step) & mask;
+  }
 }
 
-static bool pni_map_ensure(pn_map_t *map, size_t capacity)
+// Move every entry to a table of the given capacity. Entries keep their
+// references and cached hashes, so no class callbacks are made.
+static bool pni_map_resize(pn_map_t *map, size_t capacity)
 {
-  float load = pni_map_load(map);
-  if (capacity <= map->capacity && load <= map->load_factor) {
-    return false;
-  }
-
-  size_t oldcap = map->capacity;
-
-  while (map->capacity < capacity || pni_map_load(map) > map->load_factor) {
-    map->capacity *= 2;
-    map->addressable = (size_t) (0.86 * map->capacity);
-  }
-
+  uint8_t *ctrl = map->ctrl;
   pni_entry_t *entries = map->entries;
-  pni_map_allocate(map);
+  size_t oldcap = map->capacity;
+  size_t size = map->size;
 
-  for (size_t i = 0; i < oldcap; i++) {
-    if (entries[i].state != PNI_ENTRY_FREE) {
-      void *key = entries[i].key;
-      void *value = entries[i].value;
-      pn_map_put(map, key, value);
-    }
+  if (!pni_map_allocate(map, capacity)) {
+    return false;
   }
 
   for (size_t i = 0; i < oldcap; i++) {
-    if (entries[i].state != PNI_ENTRY_FREE) {
-      void *key = entries[i].key;
-      void *value = entries[i].value;
-      pn_class_decref(map->key, key);
-      pn_class_decref(map->value, value);
+    if (pni_ctrl_full(ctrl[i])) {
+      size_t slot = pni_map_free_slot(map, entries[i].hash);
+      pni_set_ctrl(map, slot, pni_h2(entries[i].hash));
+      map->entries[slot] = entries[i];
     }
   }
+  map->size = size;
 
+  free(ctrl);
   free(entries);
   return true;
 }
 
-static pni_entry_t *pni_map_entry(pn_map_t *map, void *key, pni_entry_t **pprev, bool create)
+static ssize_t pni_map_find(pn_map_t *map, void *key, uintptr_t hash)
 {
-  uintptr_t hashcode = map->hashcode(key);
-
-  pni_entry_t *entry = &map->entries[hashcode % map->addressable];
-  pni_entry_t *prev = NULL;
-
-  if (entry->state == PNI_ENTRY_FREE) {
-    if (create) {
-      entry->state = PNI_ENTRY_TAIL;
-      entry->key = key;
-      pn_class_incref(map->key, key);
-      map->size++;
-      return entry;
-    } else {
-      return NULL;
-    }
-  }
-
+  size_t mask = map->capacity - 1;
+  size_t pos = pni_h1(hash) & mask;
+  size_t step = 0;
+  uint8_t h2 = pni_h2(hash);
   while (true) {
-    if (map->equals(entry->key, key)) {
-      if (pprev) *pprev = prev;
-      return entry;
-    }
-
-    if (entry->state == PNI_ENTRY_TAIL) {
-      break;
-    } else {
-      prev = entry;
-      entry = &map->entries[entry->next];
-    }
-  }
-
-  if (create) {
-    if (pni_map_ensure(map, map->size + 1)) {
-      // if we had to grow the table we need to start over
-      return pni_map_entry(map, key, pprev, create);
-    }
-
-    size_t empty = 0;
-    for (size_t i = 0; i < map->capacity; i++) {
-      size_t idx = map->capacity - i - 1;
-      if (map->entries[idx].state == PNI_ENTRY_FREE) {
-        empty = idx;
-        break;
+    uint64_t group = pni_group_load(map->ctrl + pos);
+    uint64_t match = pni_group_match(group, h2);
+    while (match) {
+      size_t index = (pos + pni_group_first(match)) & mask;
+      pni_entry_t *entry = &map->entries[index];
+      if (entry->hash == hash &&
+          (map->identity ? entry->key == key : map->equals(entry->key, key))) {
+        return index;
       }
+      match &= match - 1;
     }
-    entry->next = empty;
-    entry->state = PNI_ENTRY_LINK;
-    map->entries[empty].state = PNI_ENTRY_TAIL;
-    map->entries[empty].key = key;
-    pn_class_incref(map->key, key);
-    if (pprev) *pprev = entry;
-    map->size++;
-    return &map->entries[empty];
-  } else {
-    return NULL;
+    if (pni_group_match_empty(group)) {
+      return -1;
+    }
+    step += PNI_GROUP;
+    pos = (pos + step) & mask;
   }
 }
 
 int pn_map_put(pn_map_t *map, void *key, void *value)
 {
   assert(map);
-  pni_entry_t *entry = pni_map_entry(map, key, NULL, true);
+  uintptr_t hash = pni_map_hash(map, key);
+  ssize_t index = pni_map_find(map, key, hash);
+  if (index < 0) {
+    if (map->size + map->deleted >= map->growth_limit) {
+      // reclaim deleted slots if that leaves room enough, else grow
+      size_t capacity = map->capacity;
+      if (map->size + 1 > pni_map_limit(map, capacity) / 2) capacity *= 2;
+      if (!pni_map_resize(map, capacity)) return PN_OUT_OF_MEMORY;
+    }
+    index = pni_map_free_slot(map, hash);
+    if (map->ctrl[index] == PNI_CTRL_DELETED) map->deleted--;
+    pni_set_ctrl(map, index, pni_h2(hash));
+    pni_entry_t *entry = &map->entries[index];
+    entry->key = key;
+    entry->value = NULL;
+    entry->hash = hash;
+    pn_class_incref(map->key, key);
+    map->size++;
+  }
+  pni_entry_t *entry = &map->entries[index];
   void *dref_val = entry->value;
   entry->value = value;
   pn_class_incref(map->value, value);
@@ -261,79 +373,24 @@ int pn_map_put(pn_map_t *map, void *key, void *value)
 void *pn_map_get(pn_map_t *map, void *key)
 {
   assert(map);
-  pni_entry_t *entry = pni_map_entry(map, key, NULL, false);
-  return entry ? entry->value : NULL;
-}
-
-static void pni_map_rehash(pn_map_t *map, size_t index)
-{
-  //reinsert entries in chain starting at index
-  assert(map);
-  size_t i = index;
-  bool complete = false;
-  while (!complete) {
-    pni_entry_t *entry = &map->entries[i];
-    assert(entry);
-    assert(entry->state != PNI_ENTRY_FREE);
-    size_t current = i;
-    if (entry->state == PNI_ENTRY_TAIL) {
-      complete = true;
-    } else {
-      assert(entry->state == PNI_ENTRY_LINK);
-      i = entry->next;
-    }
-    uintptr_t hashcode = map->hashcode(entry->key);
-    pni_entry_t *reloc = &map->entries[hashcode % map->addressable];
-    if (reloc->state == PNI_ENTRY_FREE) {
-      //correct addressable slot is available, copy into that...
-      reloc->state = PNI_ENTRY_TAIL;
-      reloc->key = entry->key;
-      reloc->value = entry->value;
-      //...then free the current entry
-      entry->key = NULL;
-      entry->value = NULL;
-      entry->state = PNI_ENTRY_FREE;
-      entry->next = 0;
-    } else {
-      //iterate to end of chain...
-      while (reloc->state == PNI_ENTRY_LINK) {
-        reloc = &map->entries[reloc->next];
-      }
-      assert(reloc->state == PNI_ENTRY_TAIL);
-      //... and append current entry
-      reloc->state = PNI_ENTRY_LINK;
-      reloc->next = current;
-      entry->state = PNI_ENTRY_TAIL;
-      entry->next = 0;
-    }
-  }
+  ssize_t index = pni_map_find(map, key, pni_map_hash(map, key));
+  return index < 0 ? NULL : map->entries[index].value;
 }
 
 void pn_map_del(pn_map_t *map, void *key)
 {
   assert(map);
-  pni_entry_t *prev = NULL;
-  pni_entry_t *entry = pni_map_entry(map, key, &prev, false);
-  if (entry) {
-    uint8_t orig_state = entry->state;
-    size_t orig_next = entry->next;
-
+  ssize_t index = pni_map_find(map, key, pni_map_hash(map, key));
+  if (index >= 0) {
+    pni_entry_t *entry = &map->entries[index];
     void *dref_key = entry->key;
     void *dref_value = entry->value;
-    if (prev) {
-      prev->next = 0;
-      prev->state = PNI_ENTRY_TAIL;
-    }
-    entry->state = PNI_ENTRY_FREE;
-    entry->next = 0;
     entry->key = NULL;
     entry->value = NULL;
+    pni_set_ctrl(map, index, PNI_CTRL_DELETED);
+    map->deleted++;
     map->size--;
 
-    if (orig_state == PNI_ENTRY_LINK) {
-      pni_map_rehash(map, orig_next);
-    }
-
     // do this last as it may trigger further deletions
     pn_class_decref(map->key, dref_key);
     pn_class_decref(map->value, dref_value);
@@ -343,21 +400,17 @@ void pn_map_del(pn_map_t *map, void *key)
 pn_handle_t pn_map_head(pn_map_t *map)
 {
   assert(map);
-  for (size_t i = 0; i < map->capacity; i++)
-  {
-    if (map->entries[i].state != PNI_ENTRY_FREE) {
-      return (pn_handle_t)(i + 1);
-    }
-  }
-
-  return 0;
+  return pn_map_next(map, 0);
 }
 
 pn_handle_t pn_map_next(pn_map_t *map, pn_handle_t entry)
 {
-  for (size_t i = (size_t)entry; i < map->capacity; i++) {
-    if (map->entries[i].state != PNI_ENTRY_FREE) {
-      return (pn_handle_t)(i + 1);
+  for (size_t i = (size_t)entry; i < map->capacity; i += PNI_GROUP) {
+    // the group may run into the mirrored bytes, which are ignored
+    uint64_t full = ~pni_group_load(map->ctrl + i) & PNI_MSBS;
+    if (full) {
+      size_t index = i + pni_group_first(full);
+      return index < map->capacity ? (pn_handle_t)(index + 1) : 0;
     }
   }
 
@@ -382,16 +435,6 @@ struct pn_hash_t {
   pn_map_t map;
 };
 
-static uintptr_t pni_identity_hashcode(void *obj)
-{
-  return (uintptr_t ) obj;
-}
-
-static bool pni_identity_equals(void *a, void *b)
-{
-  return a == b;
-}
-
 #define CID_pni_uintptr CID_pn_void
 static const pn_class_t *pni_uintptr_reify(void *object);
 #define pni_uintptr_new NULL
@@ -415,8 +458,7 @@ static const pn_class_t *pni_uintptr_reify(void *object)
 pn_hash_t *pn_hash(const pn_class_t *clazz, size_t capacity, float load_factor)
 {
   pn_hash_t *hash = (pn_hash_t *) pn_map(PN_UINTPTR, clazz, capacity, load_factor);
-  hash->map.hashcode = pni_identity_hashcode;
-  hash->map.equals = pni_identity_equals;
+  if (hash) hash->map.identity = true;
   return hash;
 }
 
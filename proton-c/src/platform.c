@@ -43,6 +43,13 @@ pn_timestamp_t pn_i_now(void)
   if (clock_gettime(CLOCK_REALTIME, &now)) pni_fatal("clock_gettime() failed\n");
   return ((pn_timestamp_t)now.tv_sec) * 1000 + (now.tv_nsec / 1000000);
 }
+
+uint64_t pn_i_monotonic_us(void)
+{
+  struct timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now)) pni_fatal("clock_gettime() failed\n");
+  return ((uint64_t)now.tv_sec) * 1000000 + (now.tv_nsec / 1000);
+}
 #elif defined(USE_WIN_FILETIME)
 #include <windows.h>
 pn_timestamp_t pn_i_now(void)
@@ -55,6 +62,15 @@ pn_timestamp_t pn_i_now(void)
   // Convert to milliseconds and adjust base epoch
   return t.QuadPart / 10000 - 11644473600000;
 }
+
+uint64_t pn_i_monotonic_us(void)
+{
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (uint64_t) (count.QuadPart / frequency.QuadPart * 1000000 +
+                     count.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+}
 #else
 #include <sys/time.h>
 pn_timestamp_t pn_i_now(void)
@@ -63,6 +79,13 @@ pn_timestamp_t pn_i_now(void)
   if (gettimeofday(&now, NULL)) pni_fatal("gettimeofday failed\n");
   return ((pn_timestamp_t)now.tv_sec) * 1000 + (now.tv_usec / 1000);
 }
+
+uint64_t pn_i_monotonic_us(void)
+{
+  struct timeval now;
+  if (gettimeofday(&now, NULL)) pni_fatal("gettimeofday failed\n");
+  return ((uint64_t)now.tv_sec) * 1000000 + now.tv_usec;
+}
 #endif
 
 #include <string.h>
@@ -47,6 +47,49 @@ int pn_i_getpid(void);
  */
 pn_timestamp_t pn_i_now(void);
 
+/** Get a monotonic time in microseconds.
+ *
+ * The starting point is arbitrary, so the value is only good for
+ * measuring intervals within the process.
+ *
+ * @return current monotonic time
+ * @internal
+ */
+uint64_t pn_i_monotonic_us(void);
+
+/** Update and read the engine's metrics counters.
+ *
+ * Each counter has a single writer, the thread driving its transport,
+ * and may be read by any thread while it is written. The writer uses a
+ * relaxed atomic load and store rather than a locked read-modify-write,
+ * so a count costs no more than a plain increment.
+ *
+ * @internal
+ */
+#if defined(__GNUC__)
+#define PNI_COUNT(c, n) __atomic_store_n(&(c), __atomic_load_n(&(c), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+#define PNI_COUNT_SET(c, v) __atomic_store_n(&(c), (v), __ATOMIC_RELAXED)
+#define PNI_COUNT_GET(c) __atomic_load_n(&(c), __ATOMIC_RELAXED)
+#else
+/* MSVC makes aligned volatile accesses whole on 64 bit targets */
+#define PNI_COUNT(c, n) (*(volatile uint64_t *) &(c) += (n))
+#define PNI_COUNT_SET(c, v) (*(volatile uint64_t *) &(c) = (v))
+#define PNI_COUNT_GET(c) (*(volatile uint64_t *) &(c))
+#endif
+
+/** Add to a counter that several threads may update at once.
+ *
+ * @internal
+ */
+#if defined(__GNUC__)
+#define PNI_COUNT_SHARED(c, n) __atomic_fetch_add(&(c), (n), __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define PNI_COUNT_SHARED(c, n) _InterlockedExchangeAdd64((volatile __int64 *) &(c), (n))
+#else
+#error "No atomic add for PNI_COUNT_SHARED on this compiler"
+#endif
+
 /** Generate system error message.
  *
  * Populate the proton error structure based on the last system error
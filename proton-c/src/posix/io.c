@@ -19,6 +19,10 @@
  *
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // accept4
+#endif
+
 #include <proton/io.h>
 #include <proton/object.h>
 #include <proton/selector.h>
@@ -37,6 +41,11 @@
 
 #include "platform.h"
 
+// accept4 creates the socket non-blocking, saving a fcntl per connection
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+#define PNI_HAVE_ACCEPT4
+#endif
+
 #define MAX_HOST (1024)
 #define MAX_SERV (64)
 
@@ -45,6 +54,8 @@ struct pn_io_t {
   char serv[MAX_SERV];
   pn_error_t *error;
   pn_selector_t *selector;
+  int backlog;
+  bool reuse_port;
   bool wouldblock;
 };
 
@@ -54,6 +65,8 @@ void pn_io_initialize(void *obj)
   io->error = pn_error();
   io->wouldblock = false;
   io->selector = NULL;
+  io->backlog = SOMAXCONN;
+  io->reuse_port = false;
 }
 
 void pn_io_finalize(void *obj)
@@ -94,6 +107,37 @@ int pn_pipe(pn_io_t *io, pn_socket_t *dest)
   return n;
 }
 
+void pn_io_set_listen_backlog(pn_io_t *io, int backlog)
+{
+  assert(io);
+  io->backlog = backlog > 0 ? backlog : SOMAXCONN;
+}
+
+int pn_io_set_reuse_port(pn_io_t *io, bool reuse)
+{
+  assert(io);
+#ifdef SO_REUSEPORT
+  io->reuse_port = reuse;
+  return 0;
+#else
+  if (reuse) return pn_error_format(io->error, PN_ERR, "SO_REUSEPORT is not supported");
+  return 0;
+#endif
+}
+
+static void pn_configure_nodelay(pn_io_t *io, pn_socket_t sock) {
+  //
+  // Disable the Nagle algorithm on TCP connections.
+  //
+  // Note:  It would be more correct for the "level" argument to be SOL_TCP.  However, there
+  //        are portability issues with this macro so we use IPPROTO_TCP instead.
+  //
+  int tcp_nodelay = 1;
+  if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void*) &tcp_nodelay, sizeof(tcp_nodelay)) < 0) {
+    pn_i_error_from_errno(io->error, "setsockopt");
+  }
+}
+
 static void pn_configure_sock(pn_io_t *io, pn_socket_t sock) {
   // this would be nice, but doesn't appear to exist on linux
   /*
@@ -110,16 +154,7 @@ static void pn_configure_sock(pn_io_t *io, pn_socket_t sock) {
     pn_i_error_from_errno(io->error, "fcntl");
   }
 
-  //
-  // Disable the Nagle algorithm on TCP connections.
-  //
-  // Note:  It would be more correct for the "level" argument to be SOL_TCP.  However, there
-  //        are portability issues with this macro so we use IPPROTO_TCP instead.
-  //
-  int tcp_nodelay = 1;
-  if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void*) &tcp_nodelay, sizeof(tcp_nodelay)) < 0) {
-    pn_i_error_from_errno(io->error, "setsockopt");
-  }
+  pn_configure_nodelay(io, sock);
 }
 
 static inline int pn_create_socket(int af, int protocol);
@@ -149,6 +184,18 @@ pn_socket_t pn_listen(pn_io_t *io, const char *host, const char *port)
     return PN_INVALID_SOCKET;
   }
 
+#ifdef SO_REUSEPORT
+  // lets several listeners, each in its own reactor, share the port with
+  // the kernel spreading incoming connections between them
+  if (io->reuse_port &&
+      setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)) == -1) {
+    pn_i_error_from_errno(io->error, "setsockopt");
+    freeaddrinfo(addr);
+    close(sock);
+    return PN_INVALID_SOCKET;
+  }
+#endif
+
   if (bind(sock, addr->ai_addr, addr->ai_addrlen) == -1) {
     pn_i_error_from_errno(io->error, "bind");
     freeaddrinfo(addr);
@@ -158,45 +205,60 @@ pn_socket_t pn_listen(pn_io_t *io, const char *host, const char *port)
 
   freeaddrinfo(addr);
 
-  if (listen(sock, 50) == -1) {
+  if (listen(sock, io->backlog) == -1) {
     pn_i_error_from_errno(io->error, "listen");
     close(sock);
     return PN_INVALID_SOCKET;
   }
 
+  // accepting drains the queue until it would block
+  int flags = fcntl(sock, F_GETFL);
+  if (flags < 0 || fcntl(sock, F_SETFL, flags | O_NONBLOCK) < 0) {
+    pn_i_error_from_errno(io->error, "fcntl");
+    close(sock);
+    return PN_INVALID_SOCKET;
+  }
+
   return sock;
 }
 
-pn_socket_t pn_connect(pn_io_t *io, const char *host, const char *port)
+pn_socket_t pni_connect_address(pn_io_t *io, const struct sockaddr *addr, socklen_t addrlen)
 {
-  struct addrinfo *addr;
-  struct addrinfo hints = {0, AF_UNSPEC, SOCK_STREAM};
-  int code = getaddrinfo(host, port, &hints, &addr);
-  if (code) {
-    pn_error_format(io->error, PN_ERR, "getaddrinfo(%s, %s): %s", host, port, gai_strerror(code));
-    return PN_INVALID_SOCKET;
-  }
-
-  pn_socket_t sock = pn_create_socket(addr->ai_family, addr->ai_protocol);
+  pn_socket_t sock = pn_create_socket(addr->sa_family, IPPROTO_TCP);
   if (sock == PN_INVALID_SOCKET) {
+    int error = errno;
     pn_i_error_from_errno(io->error, "pn_create_socket");
-    freeaddrinfo(addr);
+    errno = error;
     return PN_INVALID_SOCKET;
   }
 
   pn_configure_sock(io, sock);
 
-  if (connect(sock, addr->ai_addr, addr->ai_addrlen) == -1) {
+  if (connect(sock, addr, addrlen) == -1) {
     if (errno != EINPROGRESS) {
+      int error = errno;
       pn_i_error_from_errno(io->error, "connect");
-      freeaddrinfo(addr);
       close(sock);
+      errno = error;
       return PN_INVALID_SOCKET;
     }
   }
 
-  freeaddrinfo(addr);
+  return sock;
+}
 
+pn_socket_t pn_connect(pn_io_t *io, const char *host, const char *port)
+{
+  struct addrinfo *addr;
+  struct addrinfo hints = {0, AF_UNSPEC, SOCK_STREAM};
+  int code = getaddrinfo(host, port, &hints, &addr);
+  if (code) {
+    pn_error_format(io->error, PN_ERR, "getaddrinfo(%s, %s): %s", host, port, gai_strerror(code));
+    return PN_INVALID_SOCKET;
+  }
+
+  pn_socket_t sock = pni_connect_address(io, addr->ai_addr, addr->ai_addrlen);
+  freeaddrinfo(addr);
   return sock;
 }
 
@@ -205,7 +267,12 @@ pn_socket_t pn_accept(pn_io_t *io, pn_socket_t socket, char *name, size_t size)
   struct sockaddr_storage addr;
   socklen_t addrlen = sizeof(addr);
   *name = '\0';
+#ifdef PNI_HAVE_ACCEPT4
+  pn_socket_t sock = accept4(socket, (struct sockaddr *) &addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
   pn_socket_t sock = accept(socket, (struct sockaddr *) &addr, &addrlen);
+#endif
+  io->wouldblock = (sock == PN_INVALID_SOCKET && (errno == EAGAIN || errno == EWOULDBLOCK));
   if (sock == PN_INVALID_SOCKET) {
     pn_i_error_from_errno(io->error, "accept");
     return sock;
@@ -217,7 +284,11 @@ pn_socket_t pn_accept(pn_io_t *io, pn_socket_t socket, char *name, size_t size)
         pn_i_error_from_errno(io->error, "close");
       return PN_INVALID_SOCKET;
     } else {
+#ifdef PNI_HAVE_ACCEPT4
+      pn_configure_nodelay(io, sock);
+#else
       pn_configure_sock(io, sock);
+#endif
       snprintf(name, size, "%s:%s", io->host, io->serv);
       return sock;
     }
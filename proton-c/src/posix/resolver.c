@@ -0,0 +1,794 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Name resolution and connection establishment for outgoing reactor
+ * connections.
+ *
+ * Host names are looked up on a small pool of background threads so
+ * that a slow name server cannot stall the reactor thread. Results are
+ * cached per host and port for a configurable time. The addresses are
+ * then raced "happy eyeballs" style (RFC 8305): address families are
+ * interleaved, a new attempt is started whenever the previous one has
+ * not completed within PNI_CONNECT_DELAY, and the first socket to
+ * connect is handed to the transport.
+ */
+
+#include <proton/connection.h>
+#include <proton/io.h>
+#include <proton/object.h>
+#include <proton/reactor.h>
+#include <proton/transport.h>
+
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "platform.h"
+#include "reactor/reactor.h"
+#include "selectable.h"
+
+pn_selectable_t *pn_reactor_selectable_transport(pn_reactor_t *reactor, pn_socket_t sock, pn_transport_t *transport);
+pn_socket_t pni_connect_address(pn_io_t *io, const struct sockaddr *addr, socklen_t addrlen);
+
+#define PNI_RESOLVER_THREADS (2)
+#define PNI_RESOLVER_BACKLOG (1024)
+#define PNI_RESOLVER_TTL (30000)
+#define PNI_CONNECT_DELAY (250)
+#define PNI_ERROR_SIZE (256)
+
+typedef struct {
+  struct sockaddr_storage addr;
+  socklen_t size;
+} pni_address_t;
+
+// A lookup request. Once queued it is owned by the worker pool until it
+// is handed back on the done queue; only the reactor thread touches
+// the transport.
+typedef struct pni_lookup_t pni_lookup_t;
+
+struct pni_lookup_t {
+  pni_lookup_t *next;
+  pn_transport_t *transport;
+  pn_reactor_lookup_t lookup;
+  void *context;
+  char *host;
+  char *port;
+  pni_address_t *addresses;
+  size_t count;
+  char error[PNI_ERROR_SIZE];
+};
+
+// State shared between the reactor thread and the worker threads. It is
+// reference counted by the resolver and each worker, whoever leaves
+// last frees it, so a reactor can be freed while lookups are blocked.
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t ready;
+  pni_lookup_t *pending;
+  pni_lookup_t *pending_tail;
+  pni_lookup_t *done;
+  pni_lookup_t *done_tail;
+  size_t queued;
+  int threads;
+  int idle;
+  int max_threads;
+  int refcount;
+  bool stopping;
+  pn_socket_t notify;
+} pni_pool_t;
+
+typedef struct {
+  pn_reactor_t *reactor;
+  pni_pool_t *pool;
+  pn_socket_t wakeup[2];
+  pn_selectable_t *selectable;
+  pn_list_t *waiting;
+  pn_map_t *cache;
+  pn_reactor_lookup_t lookup;
+  void *context;
+  pn_millis_t ttl;
+  int threads;
+} pni_resolver_t;
+
+typedef struct {
+  pni_address_t *addresses;
+  size_t count;
+  pn_timestamp_t expiry;
+} pni_cached_t;
+
+typedef struct {
+  pn_reactor_t *reactor;
+  pn_transport_t *transport;
+  pn_string_t *key;
+  pni_address_t *addresses;
+  size_t count;
+  size_t next;
+  pn_list_t *attempts;
+  int error;
+  bool done;
+} pni_race_t;
+
+static pni_address_t *pni_addresses_copy(const pni_address_t *addresses, size_t count)
+{
+  pni_address_t *copy = (pni_address_t *) malloc(count * sizeof(pni_address_t));
+  if (copy) memcpy(copy, addresses, count * sizeof(pni_address_t));
+  return copy;
+}
+
+// Lookups
+
+static void pni_lookup_free(pni_lookup_t *lookup)
+{
+  free(lookup->host);
+  free(lookup->port);
+  free(lookup->addresses);
+  free(lookup);
+}
+
+static char *pni_strdup(const char *s)
+{
+  size_t n = strlen(s) + 1;
+  char *copy = (char *) malloc(n);
+  if (copy) memcpy(copy, s, n);
+  return copy;
+}
+
+static pni_lookup_t *pni_lookup(pni_resolver_t *resolver, pn_transport_t *transport,
+                                const char *host, const char *port)
+{
+  pni_lookup_t *lookup = (pni_lookup_t *) calloc(1, sizeof(pni_lookup_t));
+  if (!lookup) return NULL;
+  lookup->transport = transport;
+  lookup->lookup = resolver->lookup;
+  lookup->context = resolver->context;
+  lookup->host = pni_strdup(host);
+  lookup->port = pni_strdup(port);
+  if (!lookup->host || !lookup->port) {
+    pni_lookup_free(lookup);
+    return NULL;
+  }
+  return lookup;
+}
+
+// Append the addresses from ai to the lookup, alternating address
+// families in the order they are first seen.
+static void pni_lookup_add(pni_lookup_t *lookup, struct addrinfo *ai)
+{
+  size_t total = lookup->count;
+  for (struct addrinfo *a = ai; a; a = a->ai_next) total++;
+  pni_address_t *addresses = (pni_address_t *) realloc(lookup->addresses, total * sizeof(pni_address_t));
+  if (!addresses) return;
+  lookup->addresses = addresses;
+
+  int first = ai ? ai->ai_family : AF_UNSPEC;
+  struct addrinfo *same = ai, *other = ai;
+  bool want_same = true;
+  while (same || other) {
+    while (same && same->ai_family != first) same = same->ai_next;
+    while (other && other->ai_family == first) other = other->ai_next;
+    struct addrinfo **pick = (want_same && same) || !other ? &same : &other;
+    if (*pick) {
+      if ((*pick)->ai_addrlen <= sizeof(struct sockaddr_storage)) {
+        pni_address_t *address = &lookup->addresses[lookup->count++];
+        memcpy(&address->addr, (*pick)->ai_addr, (*pick)->ai_addrlen);
+        address->size = (*pick)->ai_addrlen;
+      }
+      *pick = (*pick)->ai_next;
+    }
+    want_same = !want_same;
+  }
+}
+
+static int pni_lookup_numeric(pni_lookup_t *lookup, const char *host, int flags)
+{
+  struct addrinfo *ai;
+  struct addrinfo hints = {0, AF_UNSPEC, SOCK_STREAM};
+  hints.ai_flags = flags;
+  int code = getaddrinfo(host, lookup->port, &hints, &ai);
+  if (code) {
+    snprintf(lookup->error, PNI_ERROR_SIZE, "getaddrinfo(%s, %s): %s", host, lookup->port, gai_strerror(code));
+    return code;
+  }
+  pni_lookup_add(lookup, ai);
+  freeaddrinfo(ai);
+  return 0;
+}
+
+// Runs on a worker thread, or inline on the reactor thread when the
+// resolver has no threads.
+static void pni_lookup_resolve(pni_lookup_t *lookup)
+{
+  if (!lookup->lookup) {
+    pni_lookup_numeric(lookup, lookup->host, 0);
+    return;
+  }
+
+  pn_string_t *result = pn_string("");
+  if (lookup->lookup(lookup->context, lookup->host, result)) {
+    snprintf(lookup->error, PNI_ERROR_SIZE, "lookup(%s): %s", lookup->host,
+             pn_string_size(result) ? pn_string_get(result) : "failed");
+  } else {
+    char *names = pn_string_buffer(result);
+    char *state = NULL;
+    for (char *name = strtok_r(names, " ", &state); name; name = strtok_r(NULL, " ", &state)) {
+      if (pni_lookup_numeric(lookup, name, AI_NUMERICHOST)) break;
+    }
+    if (!lookup->count && !lookup->error[0]) {
+      snprintf(lookup->error, PNI_ERROR_SIZE, "lookup(%s): no addresses", lookup->host);
+    }
+  }
+  pn_free(result);
+}
+
+// Worker pool
+
+static void pni_pool_free(pni_pool_t *pool)
+{
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->ready);
+  close(pool->notify);
+  free(pool);
+}
+
+static pni_pool_t *pni_pool(pn_socket_t notify, int max_threads)
+{
+  pni_pool_t *pool = (pni_pool_t *) calloc(1, sizeof(pni_pool_t));
+  if (!pool) return NULL;
+  if (pthread_mutex_init(&pool->lock, NULL)) {
+    free(pool);
+    return NULL;
+  }
+  if (pthread_cond_init(&pool->ready, NULL)) {
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+    return NULL;
+  }
+  pool->notify = notify;
+  pool->max_threads = max_threads;
+  pool->refcount = 1;
+  return pool;
+}
+
+static void *pni_pool_worker(void *arg)
+{
+  pni_pool_t *pool = (pni_pool_t *) arg;
+  pthread_mutex_lock(&pool->lock);
+  while (true) {
+    while (!pool->pending && !pool->stopping) {
+      pool->idle++;
+      pthread_cond_wait(&pool->ready, &pool->lock);
+      pool->idle--;
+    }
+    if (pool->stopping) break;
+
+    pni_lookup_t *lookup = pool->pending;
+    pool->pending = lookup->next;
+    if (!pool->pending) pool->pending_tail = NULL;
+    pool->queued--;
+    pthread_mutex_unlock(&pool->lock);
+
+    pni_lookup_resolve(lookup);
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->stopping) {
+      pni_lookup_free(lookup);
+      break;
+    }
+    lookup->next = NULL;
+    if (pool->done_tail) {
+      pool->done_tail->next = lookup;
+    } else {
+      pool->done = lookup;
+    }
+    pool->done_tail = lookup;
+    // written under the lock so the resolver cannot close the read end
+    // of the pipe underneath us
+    if (write(pool->notify, "x", 1) < 0) {}
+  }
+  pool->threads--;
+  bool last = --pool->refcount == 0;
+  pthread_mutex_unlock(&pool->lock);
+  if (last) pni_pool_free(pool);
+  return NULL;
+}
+
+// Queue a lookup, starting another worker if none is idle. Returns
+// false if the lookup could not be queued.
+static bool pni_pool_submit(pni_pool_t *pool, pni_lookup_t *lookup)
+{
+  pthread_mutex_lock(&pool->lock);
+  if (pool->queued >= PNI_RESOLVER_BACKLOG) {
+    pthread_mutex_unlock(&pool->lock);
+    return false;
+  }
+  if (!pool->idle && pool->threads < pool->max_threads) {
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (!pthread_create(&thread, &attr, pni_pool_worker, pool)) {
+      pool->threads++;
+      pool->refcount++;
+    }
+    pthread_attr_destroy(&attr);
+  }
+  if (!pool->threads) {
+    pthread_mutex_unlock(&pool->lock);
+    return false;
+  }
+  lookup->next = NULL;
+  if (pool->pending_tail) {
+    pool->pending_tail->next = lookup;
+  } else {
+    pool->pending = lookup;
+  }
+  pool->pending_tail = lookup;
+  pool->queued++;
+  pthread_cond_signal(&pool->ready);
+  pthread_mutex_unlock(&pool->lock);
+  return true;
+}
+
+static pni_lookup_t *pni_pool_completed(pni_pool_t *pool)
+{
+  pthread_mutex_lock(&pool->lock);
+  pni_lookup_t *done = pool->done;
+  pool->done = pool->done_tail = NULL;
+  pthread_mutex_unlock(&pool->lock);
+  return done;
+}
+
+static void pni_pool_stop(pni_pool_t *pool)
+{
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pni_lookup_t *lookups[] = {pool->pending, pool->done};
+  pool->pending = pool->pending_tail = pool->done = pool->done_tail = NULL;
+  pthread_cond_broadcast(&pool->ready);
+  bool last = --pool->refcount == 0;
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < 2; i++) {
+    while (lookups[i]) {
+      pni_lookup_t *next = lookups[i]->next;
+      pni_lookup_free(lookups[i]);
+      lookups[i] = next;
+    }
+  }
+  if (last) pni_pool_free(pool);
+}
+
+// Cache entries
+
+static void pni_cached_finalize(void *object)
+{
+  pni_cached_t *cached = (pni_cached_t *) object;
+  free(cached->addresses);
+}
+
+#define CID_pni_cached CID_pn_object
+#define pni_cached_initialize NULL
+#define pni_cached_hashcode NULL
+#define pni_cached_compare NULL
+#define pni_cached_inspect NULL
+
+static pni_cached_t *pni_cached(const pni_address_t *addresses, size_t count, pn_timestamp_t expiry)
+{
+  static const pn_class_t clazz = PN_CLASS(pni_cached);
+  pni_cached_t *cached = (pni_cached_t *) pn_class_new(&clazz, sizeof(pni_cached_t));
+  cached->addresses = pni_addresses_copy(addresses, count);
+  cached->count = cached->addresses ? count : 0;
+  cached->expiry = expiry;
+  return cached;
+}
+
+// Resolver
+
+static void pni_resolver_finalize(void *object)
+{
+  pni_resolver_t *resolver = (pni_resolver_t *) object;
+  if (resolver->pool) {
+    pni_pool_stop(resolver->pool);
+  }
+  if (resolver->wakeup[0] != PN_INVALID_SOCKET) {
+    close(resolver->wakeup[0]);
+  }
+  pn_free(resolver->waiting);
+  pn_free(resolver->cache);
+}
+
+#define CID_pni_resolver CID_pn_object
+#define pni_resolver_initialize NULL
+#define pni_resolver_hashcode NULL
+#define pni_resolver_compare NULL
+#define pni_resolver_inspect NULL
+
+PN_HANDLE(PNI_RESOLVER)
+
+static pni_resolver_t *pni_resolver(pn_reactor_t *reactor)
+{
+  pn_record_t *record = pn_reactor_attachments(reactor);
+  pni_resolver_t *resolver = (pni_resolver_t *) pn_record_get(record, PNI_RESOLVER);
+  if (!resolver) {
+    static const pn_class_t clazz = PN_CLASS(pni_resolver);
+    resolver = (pni_resolver_t *) pn_class_new(&clazz, sizeof(pni_resolver_t));
+    resolver->reactor = reactor;
+    resolver->pool = NULL;
+    resolver->wakeup[0] = PN_INVALID_SOCKET;
+    resolver->wakeup[1] = PN_INVALID_SOCKET;
+    resolver->selectable = NULL;
+    resolver->waiting = pn_list(PN_OBJECT, 0);
+    resolver->cache = pn_map(PN_OBJECT, PN_OBJECT, 0, 0.75);
+    resolver->lookup = NULL;
+    resolver->context = NULL;
+    resolver->ttl = PNI_RESOLVER_TTL;
+    resolver->threads = PNI_RESOLVER_THREADS;
+    pn_record_def(record, PNI_RESOLVER, PN_OBJECT);
+    pn_record_set(record, PNI_RESOLVER, resolver);
+    pn_decref(resolver);
+  }
+  return resolver;
+}
+
+void pn_reactor_set_resolver_threads(pn_reactor_t *reactor, int threads)
+{
+  pni_resolver_t *resolver = pni_resolver(reactor);
+  resolver->threads = threads > 0 ? threads : 0;
+  if (resolver->pool) {
+    pthread_mutex_lock(&resolver->pool->lock);
+    resolver->pool->max_threads = resolver->threads;
+    pthread_mutex_unlock(&resolver->pool->lock);
+  }
+}
+
+void pn_reactor_set_resolver_ttl(pn_reactor_t *reactor, pn_millis_t ttl)
+{
+  pni_resolver_t *resolver = pni_resolver(reactor);
+  resolver->ttl = ttl;
+  if (!ttl && pn_map_size(resolver->cache)) {
+    pn_free(resolver->cache);
+    resolver->cache = pn_map(PN_OBJECT, PN_OBJECT, 0, 0.75);
+  }
+}
+
+void pn_reactor_set_resolver_lookup(pn_reactor_t *reactor, pn_reactor_lookup_t lookup, void *context)
+{
+  pni_resolver_t *resolver = pni_resolver(reactor);
+  resolver->lookup = lookup;
+  resolver->context = context;
+  if (pn_map_size(resolver->cache)) {
+    pn_free(resolver->cache);
+    resolver->cache = pn_map(PN_OBJECT, PN_OBJECT, 0, 0.75);
+  }
+}
+
+static void pni_transport_fail(pn_transport_t *transport, const char *description)
+{
+  pn_condition_t *cond = pn_transport_condition(transport);
+  pn_condition_set_name(cond, "proton:io");
+  pn_condition_set_description(cond, description);
+  pn_transport_close_tail(transport);
+  pn_transport_close_head(transport);
+}
+
+// Connection racing
+
+static void pni_race_finalize(void *object)
+{
+  pni_race_t *race = (pni_race_t *) object;
+  pn_decref(race->transport);
+  pn_decref(race->key);
+  pn_free(race->attempts);
+  free(race->addresses);
+}
+
+#define CID_pni_race CID_pn_object
+#define pni_race_initialize NULL
+#define pni_race_hashcode NULL
+#define pni_race_compare NULL
+#define pni_race_inspect NULL
+
+PN_HANDLE(PNI_RACE)
+
+static pni_race_t *pni_attempt_race(pn_selectable_t *sel)
+{
+  return (pni_race_t *) pn_record_get(pn_selectable_attachments(sel), PNI_RACE);
+}
+
+static void pni_attempt_close(pni_race_t *race, pn_selectable_t *sel)
+{
+  pn_list_remove(race->attempts, sel);
+  pn_selectable_terminate(sel);
+  pn_reactor_update(race->reactor, sel);
+}
+
+static void pni_race_next(pni_race_t *race);
+
+static void pni_race_failed(pni_race_t *race)
+{
+  race->done = true;
+  pni_resolver_t *resolver = pni_resolver(race->reactor);
+  pn_map_del(resolver->cache, race->key);
+  pn_io_t *io = pn_reactor_io(race->reactor);
+  errno = race->error;
+  pn_i_error_from_errno(pn_io_error(io), "connect");
+  pni_transport_fail(race->transport, pn_error_text(pn_io_error(io)));
+}
+
+static void pni_attempt_failed(pn_selectable_t *sel, int error)
+{
+  pni_race_t *race = pni_attempt_race(sel);
+  pn_incref(race);
+  race->error = error;
+  pni_attempt_close(race, sel);
+  if (!race->done) {
+    if (race->next < race->count) {
+      pni_race_next(race);
+    } else if (!pn_list_size(race->attempts)) {
+      pni_race_failed(race);
+    }
+  }
+  pn_decref(race);
+}
+
+static int pni_attempt_error(pn_selectable_t *sel)
+{
+  int error = 0;
+  socklen_t size = sizeof(error);
+  if (getsockopt(pn_selectable_get_fd(sel), SOL_SOCKET, SO_ERROR, &error, &size) < 0) {
+    error = errno;
+  }
+  return error;
+}
+
+static void pni_attempt_writable(pn_selectable_t *sel)
+{
+  pni_race_t *race = pni_attempt_race(sel);
+  if (race->done || pn_selectable_is_terminal(sel)) return;
+  int error = pni_attempt_error(sel);
+  if (error) {
+    pni_attempt_failed(sel, error);
+    return;
+  }
+
+  // We have a winner: give its socket to the transport and abandon the rest.
+  pn_incref(race);
+  race->done = true;
+  pn_socket_t sock = pn_selectable_get_fd(sel);
+  pn_selectable_set_fd(sel, PN_INVALID_SOCKET);
+  pni_attempt_close(race, sel);
+  while (pn_list_size(race->attempts)) {
+    pni_attempt_close(race, (pn_selectable_t *) pn_list_get(race->attempts, 0));
+  }
+  if (pn_transport_closed(race->transport)) {
+    pn_close(pn_reactor_io(race->reactor), sock);
+  } else {
+    pn_reactor_selectable_transport(race->reactor, sock, race->transport);
+  }
+  pn_decref(race);
+}
+
+static void pni_attempt_error_event(pn_selectable_t *sel)
+{
+  pni_race_t *race = pni_attempt_race(sel);
+  if (race->done || pn_selectable_is_terminal(sel)) return;
+  int error = pni_attempt_error(sel);
+  pni_attempt_failed(sel, error ? error : ECONNREFUSED);
+}
+
+static void pni_attempt_expired(pn_selectable_t *sel)
+{
+  pni_race_t *race = pni_attempt_race(sel);
+  if (race->done || pn_selectable_is_terminal(sel)) return;
+  // still connecting: keep waiting on it but give the next address a go
+  pn_selectable_set_deadline(sel, 0);
+  pn_reactor_update(race->reactor, sel);
+  if (race->next < race->count) {
+    pni_race_next(race);
+  }
+}
+
+static void pni_attempt_finalize(pn_selectable_t *sel)
+{
+  pn_reactor_t *reactor = (pn_reactor_t *) pni_selectable_get_context(sel);
+  pn_socket_t sock = pn_selectable_get_fd(sel);
+  if (sock != PN_INVALID_SOCKET) {
+    pn_close(pn_reactor_io(reactor), sock);
+  }
+}
+
+// Start connecting to the next address that gets as far as an
+// in-progress connect.
+static void pni_race_next(pni_race_t *race)
+{
+  pn_io_t *io = pn_reactor_io(race->reactor);
+  while (race->next < race->count) {
+    pni_address_t *address = &race->addresses[race->next++];
+    pn_socket_t sock = pni_connect_address(io, (struct sockaddr *) &address->addr, address->size);
+    if (sock == PN_INVALID_SOCKET) {
+      race->error = errno;
+      continue;
+    }
+    pn_selectable_t *sel = pn_reactor_selectable(race->reactor);
+    pn_selectable_set_fd(sel, sock);
+    pn_selectable_on_writable(sel, pni_attempt_writable);
+    pn_selectable_on_error(sel, pni_attempt_error_event);
+    pn_selectable_on_expired(sel, pni_attempt_expired);
+    pn_selectable_on_finalize(sel, pni_attempt_finalize);
+    pn_record_t *record = pn_selectable_attachments(sel);
+    pn_record_def(record, PNI_RACE, PN_OBJECT);
+    pn_record_set(record, PNI_RACE, race);
+    pn_selectable_set_writing(sel, true);
+    if (race->next < race->count) {
+      pn_selectable_set_deadline(sel, pn_reactor_now(race->reactor) + PNI_CONNECT_DELAY);
+    }
+    pn_list_add(race->attempts, sel);
+    pn_reactor_update(race->reactor, sel);
+    return;
+  }
+
+  if (!pn_list_size(race->attempts)) {
+    pni_race_failed(race);
+  }
+}
+
+static void pni_race(pn_reactor_t *reactor, pn_transport_t *transport, pn_string_t *key,
+                     const pni_address_t *addresses, size_t count)
+{
+  static const pn_class_t clazz = PN_CLASS(pni_race);
+  pni_race_t *race = (pni_race_t *) pn_class_new(&clazz, sizeof(pni_race_t));
+  race->reactor = reactor;
+  race->transport = transport;
+  pn_incref(transport);
+  race->key = key;
+  pn_incref(key);
+  race->addresses = pni_addresses_copy(addresses, count);
+  race->count = race->addresses ? count : 0;
+  race->next = 0;
+  race->attempts = pn_list(PN_WEAKREF, 0);
+  race->error = race->count ? 0 : ENOMEM;
+  race->done = false;
+  pni_race_next(race);
+  pn_decref(race);
+}
+
+// Completed lookups
+
+static void pni_resolver_complete(pni_resolver_t *resolver, pni_lookup_t *lookup)
+{
+  pn_reactor_t *reactor = resolver->reactor;
+  pn_transport_t *transport = lookup->transport;
+  if (pn_transport_closed(transport)) {
+    return;
+  }
+  if (!lookup->count) {
+    pni_transport_fail(transport, lookup->error[0] ? lookup->error : "lookup failed");
+    return;
+  }
+
+  pn_string_t *key = pn_string(NULL);
+  pn_string_format(key, "%s:%s", lookup->host, lookup->port);
+  if (resolver->ttl) {
+    pni_cached_t *cached = pni_cached(lookup->addresses, lookup->count,
+                                      pn_reactor_now(reactor) + resolver->ttl);
+    pn_map_put(resolver->cache, key, cached);
+    pn_decref(cached);
+  }
+  pni_race(reactor, transport, key, lookup->addresses, lookup->count);
+  pn_decref(key);
+}
+
+static void pni_resolver_readable(pn_selectable_t *sel)
+{
+  pn_reactor_t *reactor = (pn_reactor_t *) pni_selectable_get_context(sel);
+  pni_resolver_t *resolver = pni_resolver(reactor);
+  char buf[64];
+  pn_read(pn_reactor_io(reactor), pn_selectable_get_fd(sel), buf, sizeof(buf));
+
+  pni_lookup_t *lookup = pni_pool_completed(resolver->pool);
+  while (lookup) {
+    pni_lookup_t *next = lookup->next;
+    pn_transport_t *transport = lookup->transport;
+    pn_incref(transport);
+    if (pn_list_remove(resolver->waiting, transport)) {
+      pni_resolver_complete(resolver, lookup);
+    }
+    pn_decref(transport);
+    pni_lookup_free(lookup);
+    lookup = next;
+  }
+
+  if (!pn_list_size(resolver->waiting)) {
+    // nothing outstanding: stop holding the reactor open
+    pn_selectable_terminate(sel);
+    pn_reactor_update(reactor, sel);
+    resolver->selectable = NULL;
+  }
+}
+
+static bool pni_resolver_submit(pni_resolver_t *resolver, pni_lookup_t *lookup)
+{
+  pn_reactor_t *reactor = resolver->reactor;
+  if (!resolver->pool) {
+    if (pn_pipe(pn_reactor_io(reactor), resolver->wakeup)) return false;
+    resolver->pool = pni_pool(resolver->wakeup[1], resolver->threads);
+    if (!resolver->pool) {
+      close(resolver->wakeup[0]);
+      close(resolver->wakeup[1]);
+      resolver->wakeup[0] = resolver->wakeup[1] = PN_INVALID_SOCKET;
+      return false;
+    }
+  }
+
+  if (!pni_pool_submit(resolver->pool, lookup)) return false;
+
+  pn_list_add(resolver->waiting, lookup->transport);
+  if (!resolver->selectable) {
+    pn_selectable_t *sel = pn_reactor_selectable(reactor);
+    pn_selectable_set_fd(sel, resolver->wakeup[0]);
+    pn_selectable_on_readable(sel, pni_resolver_readable);
+    pn_selectable_set_reading(sel, true);
+    pn_reactor_update(reactor, sel);
+    resolver->selectable = sel;
+  }
+  return true;
+}
+
+void pni_reactor_connect(pn_reactor_t *reactor, pn_transport_t *transport,
+                         const char *host, const char *port)
+{
+  pni_resolver_t *resolver = pni_resolver(reactor);
+
+  pn_string_t *key = pn_string(NULL);
+  pn_string_format(key, "%s:%s", host, port);
+  pni_cached_t *cached = (pni_cached_t *) pn_map_get(resolver->cache, key);
+  if (cached && cached->expiry > pn_reactor_now(reactor)) {
+    pni_race(reactor, transport, key, cached->addresses, cached->count);
+    pn_decref(key);
+    return;
+  } else if (cached) {
+    pn_map_del(resolver->cache, key);
+  }
+  pn_decref(key);
+
+  pni_lookup_t *lookup = pni_lookup(resolver, transport, host, port);
+  if (!lookup) {
+    pni_transport_fail(transport, "lookup failed: out of memory");
+    return;
+  }
+
+  if (resolver->threads && pni_resolver_submit(resolver, lookup)) {
+    return;
+  }
+
+  // no threads to spare: resolve on the reactor thread
+  pni_lookup_resolve(lookup);
+  pni_resolver_complete(resolver, lookup);
+  pni_lookup_free(lookup);
+}
@@ -108,6 +108,16 @@ void pn_selector_update(pn_selector_t *selector, pn_selectable_t *selectable)
   selector->deadlines[idx] = pn_selectable_get_deadline(selectable);
 }
 
+// Move the selectable at index from into the slot at index to.
+static void pni_selector_move(pn_selector_t *selector, size_t from, size_t to)
+{
+  pn_selectable_t *sel = (pn_selectable_t *) pn_list_get(selector->selectables, from);
+  pn_list_set(selector->selectables, to, sel);
+  selector->fds[to] = selector->fds[from];
+  selector->deadlines[to] = selector->deadlines[from];
+  pni_selectable_set_index(sel, to);
+}
+
 void pn_selector_remove(pn_selector_t *selector, pn_selectable_t *selectable)
 {
   assert(selector);
@@ -115,19 +125,26 @@ void pn_selector_remove(pn_selector_t *selector, pn_selectable_t *selectable)
 
   int idx = pni_selectable_get_index(selectable);
   assert(idx >= 0);
-  pn_list_del(selector->selectables, idx, 1);
-  size_t size = pn_list_size(selector->selectables);
-  for (size_t i = idx; i < size; i++) {
-    pn_selectable_t *sel = (pn_selectable_t *) pn_list_get(selector->selectables, i);
-    pni_selectable_set_index(sel, i);
-    selector->fds[i] = selector->fds[i + 1];
+  size_t last = pn_list_size(selector->selectables) - 1;
+  size_t hole = idx;
+
+  // Fill the hole from the end rather than sliding everything down. If
+  // pn_selector_next has already passed the hole, first fill it with
+  // the last selectable it visited, so that the one moved in from the
+  // end is still ahead of it.
+  if (hole < selector->current) {
+    selector->current--;
+    if (hole != selector->current) {
+      pni_selector_move(selector, selector->current, hole);
+      hole = selector->current;
+    }
+  }
+  if (hole != last) {
+    pni_selector_move(selector, last, hole);
   }
+  pn_list_del(selector->selectables, last, 1);
 
   pni_selectable_set_index(selectable, -1);
-
-  if (selector->current >= (size_t) idx) {
-    selector->current--;
-  }
 }
 
 size_t pn_selector_size(pn_selector_t *selector) {
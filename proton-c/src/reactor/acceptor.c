@@ -27,6 +27,7 @@
 #include "reactor.h"
 #include "selectable.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 pn_selectable_t *pn_reactor_selectable_transport(pn_reactor_t *reactor, pn_socket_t sock, pn_transport_t *transport);
@@ -34,11 +35,36 @@ pn_selectable_t *pn_reactor_selectable_transport(pn_reactor_t *reactor, pn_socke
 PN_HANDLE(PNI_ACCEPTOR_HANDLER)
 PN_HANDLE(PNI_ACCEPTOR_SSL_DOMAIN)
 PN_HANDLE(PNI_ACCEPTOR_CONNECTION)
+PN_HANDLE(PNI_ACCEPTOR_STATS)
 
-void pni_acceptor_readable(pn_selectable_t *sel) {
+// Accept at most this many connections per readable event by default, so
+// a flood of connections cannot starve the reactor's other work.
+#define PNI_ACCEPTOR_MAX_ACCEPTS 64
+
+typedef struct {
+  int max_accepts;
+  uint64_t accepted;
+  pn_timestamp_t window_start;  // accept rate is measured over windows of
+  uint64_t window_count;        // at least a second
+  double rate;
+} pni_acceptor_stats_t;
+
+static pni_acceptor_stats_t *pni_acceptor_stats(pn_selectable_t *sel) {
+  return (pni_acceptor_stats_t *) pn_record_get(pn_selectable_attachments(sel), PNI_ACCEPTOR_STATS);
+}
+
+// Close the current rate window if it is at least a second old.
+static void pni_acceptor_roll(pni_acceptor_stats_t *stats, pn_timestamp_t now) {
+  pn_timestamp_t elapsed = now - stats->window_start;
+  if (elapsed >= 1000) {
+    stats->rate = stats->window_count * 1000.0 / elapsed;
+    stats->window_start = now;
+    stats->window_count = 0;
+  }
+}
+
+static void pni_acceptor_connection(pn_selectable_t *sel, pn_socket_t sock, char *name) {
   pn_reactor_t *reactor = (pn_reactor_t *) pni_selectable_get_context(sel);
-  char name[1024];
-  pn_socket_t sock = pn_accept(pn_reactor_io(reactor), pn_selectable_get_fd(sel), name, 1024);
   pn_handler_t *handler = (pn_handler_t *) pn_record_get(pn_selectable_attachments(sel), PNI_ACCEPTOR_HANDLER);
   if (!handler) { handler = pn_reactor_get_handler(reactor); }
   pn_record_t *record = pn_selectable_attachments(sel);
@@ -61,7 +87,24 @@ void pni_acceptor_readable(pn_selectable_t *sel) {
   record = pn_connection_attachments(conn);
   pn_record_def(record, PNI_ACCEPTOR_CONNECTION, PN_OBJECT);
   pn_record_set(record, PNI_ACCEPTOR_CONNECTION, sel);
+}
 
+// Drain the listen queue until it would block, or the per-event limit is
+// reached and the selector reports the socket readable again.
+void pni_acceptor_readable(pn_selectable_t *sel) {
+  pn_reactor_t *reactor = (pn_reactor_t *) pni_selectable_get_context(sel);
+  pni_acceptor_stats_t *stats = pni_acceptor_stats(sel);
+  int count = 0;
+  while (count < stats->max_accepts && pn_selectable_get_fd(sel) != PN_INVALID_SOCKET) {
+    char name[1024];
+    pn_socket_t sock = pn_accept(pn_reactor_io(reactor), pn_selectable_get_fd(sel), name, 1024);
+    if (sock == PN_INVALID_SOCKET) break;
+    pni_acceptor_connection(sel, sock, name);
+    count++;
+  }
+  stats->accepted += count;
+  stats->window_count += count;
+  pni_acceptor_roll(stats, pn_reactor_now(reactor));
 }
 
 void pni_acceptor_finalize(pn_selectable_t *sel) {
@@ -69,6 +112,7 @@ void pni_acceptor_finalize(pn_selectable_t *sel) {
   if (pn_selectable_get_fd(sel) != PN_INVALID_SOCKET) {
     pn_close(pn_reactor_io(reactor), pn_selectable_get_fd(sel));
   }
+  free(pni_acceptor_stats(sel));
 }
 
 pn_acceptor_t *pn_reactor_acceptor(pn_reactor_t *reactor, const char *host, const char *port, pn_handler_t *handler) {
@@ -84,6 +128,11 @@ pn_acceptor_t *pn_reactor_acceptor(pn_reactor_t *reactor, const char *host, cons
   pn_record_t *record = pn_selectable_attachments(sel);
   pn_record_def(record, PNI_ACCEPTOR_HANDLER, PN_OBJECT);
   pn_record_set(record, PNI_ACCEPTOR_HANDLER, handler);
+  pni_acceptor_stats_t *stats = (pni_acceptor_stats_t *) calloc(1, sizeof(pni_acceptor_stats_t));
+  stats->max_accepts = PNI_ACCEPTOR_MAX_ACCEPTS;
+  stats->window_start = pn_reactor_now(reactor);
+  pn_record_def(record, PNI_ACCEPTOR_STATS, PN_VOID);
+  pn_record_set(record, PNI_ACCEPTOR_STATS, stats);
   pn_selectable_set_reading(sel, true);
   pn_reactor_update(reactor, sel);
   return (pn_acceptor_t *) sel;
@@ -109,6 +158,25 @@ void pn_acceptor_set_ssl_domain(pn_acceptor_t *acceptor, pn_ssl_domain_t *domain
   pn_record_set(record, PNI_ACCEPTOR_SSL_DOMAIN, domain);
 }
 
+void pn_acceptor_set_max_accepts(pn_acceptor_t *acceptor, int max)
+{
+  pni_acceptor_stats((pn_selectable_t *) acceptor)->max_accepts = max > 0 ? max : 1;
+}
+
+uint64_t pn_acceptor_get_accepted(pn_acceptor_t *acceptor)
+{
+  return pni_acceptor_stats((pn_selectable_t *) acceptor)->accepted;
+}
+
+double pn_acceptor_get_accept_rate(pn_acceptor_t *acceptor)
+{
+  pn_selectable_t *sel = (pn_selectable_t *) acceptor;
+  pn_reactor_t *reactor = (pn_reactor_t *) pni_selectable_get_context(sel);
+  pni_acceptor_stats_t *stats = pni_acceptor_stats(sel);
+  pni_acceptor_roll(stats, pn_reactor_now(reactor));
+  return stats->rate;
+}
+
 pn_acceptor_t *pn_connection_acceptor(pn_connection_t *conn) {
   // Return the acceptor that created the connection or NULL if an outbound connection
   pn_record_t *record = pn_connection_attachments(conn);
@@ -134,6 +134,10 @@ void pni_handle_bound(pn_reactor_t *reactor, pn_event_t *event) {
   const char *port = "5672";
   pn_string_t *str = NULL;
 
+  // transport events must find the reactor while the connect is still
+  // in progress, or if it fails before the transport gets a socket
+  pni_record_init_reactor(pn_transport_attachments(transport), reactor);
+
   if (pn_connection_acceptor(conn) != NULL) {
       // this connection was created by the acceptor.  There is already a
       // socket assigned to this connection.  Nothing needs to be done.
@@ -184,17 +188,9 @@ void pni_handle_bound(pn_reactor_t *reactor, pn_event_t *event) {
       pn_transport_close_tail(transport);
       pn_transport_close_head(transport);
   } else {
-      pn_socket_t sock = pn_connect(pn_reactor_io(reactor), host, port);
-      // invalid sockets are ignored by poll, so we need to do this manualy
-      if (sock == PN_INVALID_SOCKET) {
-          pn_condition_t *cond = pn_transport_condition(transport);
-          pn_condition_set_name(cond, "proton:io");
-          pn_condition_set_description(cond, pn_error_text(pn_io_error(pn_reactor_io(reactor))));
-          pn_transport_close_tail(transport);
-          pn_transport_close_head(transport);
-      } else {
-          pn_reactor_selectable_transport(reactor, sock, transport);
-      }
+      // resolves and connects in the background, errors are reported
+      // on the transport condition
+      pni_reactor_connect(reactor, transport, host, port);
   }
   pn_free(str);
 }
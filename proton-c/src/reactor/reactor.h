@@ -30,5 +30,7 @@ void pni_event_set_root(pn_event_t *event, pn_handler_t *handler);
 void pni_reactor_set_connection_peer_address(pn_connection_t *connection,
                                              const char *host,
                                              const char *port);
+void pni_reactor_connect(pn_reactor_t *reactor, pn_transport_t *transport,
+                         const char *host, const char *port);
 
 #endif /* src/reactor.h */
@@ -71,9 +71,17 @@ struct pn_ssl_domain_t {
   // settings used for all connections
   char *trusted_CAs;
 
-  // session cache
+  // session cache: hashed by id, and kept on a list in the order the
+  // sessions were saved so the oldest can be evicted when it is full.
   pn_ssl_session_t *ssn_cache_head;
   pn_ssl_session_t *ssn_cache_tail;
+  pn_ssl_session_t **ssn_buckets;
+  size_t ssn_nbuckets;
+  size_t ssn_count;
+  size_t ssn_max;
+  long ssn_ttl;
+  uint64_t ssn_hits;    // counted by the threads of all the domain's connections
+  uint64_t ssn_misses;
 
   int   ref_count;
   pn_ssl_mode_t mode;
@@ -94,8 +102,13 @@ struct pni_ssl_t {
   BIO *bio_ssl;         // i/o from/to SSL socket layer
   BIO *bio_ssl_io;      // SSL "half" of network-facing BIO
   BIO *bio_net_io;      // socket-side "half" of network-facing BIO
-  // buffers for holding I/O from "applications" above SSL
+  // buffers for holding I/O from "applications" above SSL.  Output is a
+  // ring that grows while the app has more to send, up to a few full sized
+  // TLS records, so busy connections encrypt large records and output is
+  // never moved.  Input stays contiguous for the frame parser, consumed
+  // bytes are skipped with in_start rather than moved.
 #define APP_BUF_SIZE    (4*1024)
+#define APP_BUF_MAX     (4*SSL3_RT_MAX_PLAIN_LENGTH)
   char *outbuf;
   char *inbuf;
 
@@ -103,14 +116,17 @@ struct pni_ssl_t {
   ssize_t app_output_closed;  // error code returned by upper layer process output
 
   size_t out_size;
+  size_t out_start;
   size_t out_count;
   size_t in_size;
+  size_t in_start;
   size_t in_count;
 
   bool ssl_shutdown;    // BIO_ssl_shutdown() called on socket.
   bool ssl_closed;      // shutdown complete, or SSL error
   bool read_blocked;    // SSL blocked until more network data is read
   bool write_blocked;   // SSL blocked until data is written to network
+  bool handshake_done;  // first handshake complete and counted
 
   char *subject;
   X509 *peer_certificate;
@@ -131,10 +147,19 @@ static inline pni_ssl_t *get_ssl_internal(pn_ssl_t *ssl)
 struct pn_ssl_session_t {
   const char       *id;
   SSL_SESSION      *session;
+  size_t            hash;
+  pn_ssl_session_t *ssn_hash_next;
   pn_ssl_session_t *ssn_cache_next;
   pn_ssl_session_t *ssn_cache_prev;
 };
 
+#define SSN_CACHE_DEFAULT_MAX 1024
+#define SSN_CACHE_MAX_BUCKETS (64*1024)
+
+// distinguishes our sessions from those of other applications sharing a
+// server's session cache, and lets sessions of verified peers resume.
+static const unsigned char ssn_id_context[] = "org.apache.qpid.proton";
+
 
 // define two sets of allowable ciphers: those that require authentication, and those
 // that do not require authentication (anonymous).  See ciphers(1).
@@ -151,7 +176,10 @@ static ssize_t process_output_done(pn_transport_t *transport, unsigned int layer
 static int init_ssl_socket(pn_transport_t *, pni_ssl_t *);
 static void release_ssl_socket( pni_ssl_t * );
 static pn_ssl_session_t *ssn_cache_find( pn_ssl_domain_t *, const char * );
+static void ssn_cache_add( pn_ssl_domain_t *, pn_ssl_session_t * );
+static void ssn_cache_remove( pn_ssl_domain_t *, pn_ssl_session_t * );
 static void ssl_session_free( pn_ssl_session_t *);
+static void grow_output( pni_ssl_t * );
 static size_t buffered_output( pn_transport_t *transport );
 static X509 *get_peer_certificate(pni_ssl_t *ssl);
 
@@ -369,6 +397,7 @@ static int verify_callback(int preverify_ok, X509_STORE_CTX *ctx)
 }
 
 
+#if (OPENSSL_VERSION_NUMBER < 0x30000000L)
 // this code was generated using the command:
 // "openssl dhparam -C -2 2048"
 static DH *get_dh2048(void)
@@ -403,37 +432,134 @@ static DH *get_dh2048(void)
   DH *dh;
 
   if ((dh=DH_new()) == NULL) return(NULL);
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+  // DH is opaque from 1.1.0
+  BIGNUM *p = BN_bin2bn(dh2048_p,sizeof(dh2048_p),NULL);
+  BIGNUM *g = BN_bin2bn(dh2048_g,sizeof(dh2048_g),NULL);
+  if ((p == NULL) || (g == NULL) || !DH_set0_pqg(dh, p, NULL, g))
+    { BN_free(p); BN_free(g); DH_free(dh); return(NULL); }
+#else
   dh->p=BN_bin2bn(dh2048_p,sizeof(dh2048_p),NULL);
   dh->g=BN_bin2bn(dh2048_g,sizeof(dh2048_g),NULL);
   if ((dh->p == NULL) || (dh->g == NULL))
     { DH_free(dh); return(NULL); }
+#endif
   return(dh);
 }
+#endif
 
-static pn_ssl_session_t *ssn_cache_find( pn_ssl_domain_t *domain, const char *id )
+static size_t ssn_hash( const char *id )
 {
-  pn_timestamp_t now_msec = pn_i_now();
-  long now_sec = (long)(now_msec / 1000);
-  pn_ssl_session_t *ssn = LL_HEAD( domain, ssn_cache );
-  while (ssn) {
-    long expire = SSL_SESSION_get_time( ssn->session )
-      + SSL_SESSION_get_timeout( ssn->session );
-    if (expire < now_sec) {
-      pn_ssl_session_t *next = ssn->ssn_cache_next;
-      LL_REMOVE( domain, ssn_cache, ssn );
-      ssl_session_free( ssn );
-      ssn = next;
-      continue;
-    }
+  // FNV-1a
+  size_t hash = 2166136261u;
+  for (const unsigned char *c = (const unsigned char *) id; *c; c++) {
+    hash = (hash ^ *c) * 16777619u;
+  }
+  return hash;
+}
 
-    if (!strcmp(ssn->id, id)) {
-      break;
-    }
-    ssn = ssn->ssn_cache_next;
+static bool ssn_expired( pn_ssl_domain_t *domain, pn_ssl_session_t *ssn, long now_sec )
+{
+  long saved = SSL_SESSION_get_time( ssn->session );
+  long lifetime = SSL_SESSION_get_timeout( ssn->session );
+  if (domain->ssn_ttl && domain->ssn_ttl < lifetime) lifetime = domain->ssn_ttl;
+  return saved + lifetime < now_sec;
+}
+
+static pn_ssl_session_t *ssn_cache_find( pn_ssl_domain_t *domain, const char *id )
+{
+  if (!domain->ssn_count) return NULL;
+  size_t hash = ssn_hash( id );
+  pn_ssl_session_t *ssn = domain->ssn_buckets[hash & (domain->ssn_nbuckets - 1)];
+  while (ssn && (ssn->hash != hash || strcmp(ssn->id, id))) {
+    ssn = ssn->ssn_hash_next;
+  }
+  if (ssn && ssn_expired( domain, ssn, (long)(pn_i_now() / 1000) )) {
+    ssn_cache_remove( domain, ssn );
+    ssl_session_free( ssn );
+    ssn = NULL;
   }
   return ssn;
 }
 
+static void ssn_cache_remove( pn_ssl_domain_t *domain, pn_ssl_session_t *ssn )
+{
+  pn_ssl_session_t **prev = &domain->ssn_buckets[ssn->hash & (domain->ssn_nbuckets - 1)];
+  while (*prev != ssn) prev = &(*prev)->ssn_hash_next;
+  *prev = ssn->ssn_hash_next;
+  LL_REMOVE( domain, ssn_cache, ssn );
+  domain->ssn_count--;
+}
+
+// Size the hash table for the cache limit and rehash the saved sessions.
+static bool ssn_cache_resize( pn_ssl_domain_t *domain )
+{
+  size_t nbuckets = 16;
+  while (nbuckets < domain->ssn_max && nbuckets < SSN_CACHE_MAX_BUCKETS) nbuckets <<= 1;
+  if (nbuckets == domain->ssn_nbuckets) return true;
+  pn_ssl_session_t **buckets = (pn_ssl_session_t **) calloc(nbuckets, sizeof(pn_ssl_session_t *));
+  if (!buckets) return false;
+  for (pn_ssl_session_t *ssn = LL_HEAD( domain, ssn_cache ); ssn; ssn = ssn->ssn_cache_next) {
+    size_t i = ssn->hash & (nbuckets - 1);
+    ssn->ssn_hash_next = buckets[i];
+    buckets[i] = ssn;
+  }
+  free(domain->ssn_buckets);
+  domain->ssn_buckets = buckets;
+  domain->ssn_nbuckets = nbuckets;
+  return true;
+}
+
+// Drop expired sessions from the old end of the cache, then as many of the
+// oldest as needed to make room for size more.
+static void ssn_cache_trim( pn_ssl_domain_t *domain, size_t size )
+{
+  long now_sec = (long)(pn_i_now() / 1000);
+  pn_ssl_session_t *ssn;
+  while ((ssn = LL_HEAD( domain, ssn_cache )) &&
+         (domain->ssn_count + size > domain->ssn_max || ssn_expired( domain, ssn, now_sec ))) {
+    ssn_cache_remove( domain, ssn );
+    ssl_session_free( ssn );
+  }
+}
+
+// Takes ownership of ssn, replacing any session saved under the same id.
+static void ssn_cache_add( pn_ssl_domain_t *domain, pn_ssl_session_t *ssn )
+{
+  if (!domain->ssn_max || (!domain->ssn_buckets && !ssn_cache_resize( domain ))) {
+    ssl_session_free( ssn );
+    return;
+  }
+  pn_ssl_session_t *old = ssn_cache_find( domain, ssn->id );
+  if (old) {
+    ssn_cache_remove( domain, old );
+    ssl_session_free( old );
+  }
+  ssn_cache_trim( domain, 1 );
+  ssn->hash = ssn_hash( ssn->id );
+  size_t i = ssn->hash & (domain->ssn_nbuckets - 1);
+  ssn->ssn_hash_next = domain->ssn_buckets[i];
+  domain->ssn_buckets[i] = ssn;
+  LL_ADD( domain, ssn_cache, ssn );
+  domain->ssn_count++;
+}
+
+// Count the first handshake of each connection as a hit if it resumed a
+// session.  Clients that never asked to resume are not counted.
+static void info_callback(const SSL *s, int where, int ret)
+{
+  if (!(where & SSL_CB_HANDSHAKE_DONE)) return;
+  pn_transport_t *transport = (pn_transport_t *)SSL_get_ex_data(s, ssl_ex_data_index);
+  pni_ssl_t *ssl = transport ? transport->ssl : NULL;
+  if (!ssl || ssl->handshake_done) return;
+  ssl->handshake_done = true;
+  if (SSL_session_reused( (SSL *) s )) {
+    PNI_COUNT_SHARED(ssl->domain->ssn_hits, 1);
+  } else if (ssl->session_id || ssl->domain->mode == PN_SSL_MODE_SERVER) {
+    PNI_COUNT_SHARED(ssl->domain->ssn_misses, 1);
+  }
+}
+
 static void ssl_session_free( pn_ssl_session_t *ssn)
 {
   if (ssn) {
@@ -502,6 +628,16 @@ pn_ssl_domain_t *pn_ssl_domain( pn_ssl_mode_t mode )
   SSL_CTX_set_options(domain->ctx, SSL_OP_NO_COMPRESSION);
 #endif
 
+  // session resumption: clients cache sessions here by session_id, servers
+  // in the SSL_CTX and, by default, in tickets held by their clients.
+  domain->ssn_max = SSN_CACHE_DEFAULT_MAX;
+  SSL_CTX_set_info_callback(domain->ctx, info_callback);
+  if (mode == PN_SSL_MODE_SERVER) {
+    SSL_CTX_set_session_id_context(domain->ctx, ssn_id_context, sizeof(ssn_id_context) - 1);
+    SSL_CTX_sess_set_cache_size(domain->ctx, SSN_CACHE_DEFAULT_MAX);
+  }
+  pn_ssl_domain_set_session_tickets(domain, true);
+
   // by default, allow anonymous ciphers so certificates are not required 'out of the box'
   if (!SSL_CTX_set_cipher_list( domain->ctx, CIPHERS_ANONYMOUS )) {
     ssl_log_error("Failed to set cipher list to %s", CIPHERS_ANONYMOUS);
@@ -515,12 +651,18 @@ pn_ssl_domain_t *pn_ssl_domain( pn_ssl_mode_t mode )
     return NULL;
   }
 
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+  // the DH API is deprecated from 3.0: let OpenSSL pick built-in
+  // parameters to match the certificate or, if anonymous, the cipher
+  SSL_CTX_set_dh_auto(domain->ctx, 1);
+#else
   DH *dh = get_dh2048();
   if (dh) {
     SSL_CTX_set_tmp_dh(domain->ctx, dh);
     DH_free(dh);
     SSL_CTX_set_options(domain->ctx, SSL_OP_SINGLE_DH_USE);
   }
+#endif
 
   return domain;
 }
@@ -536,6 +678,7 @@ void pn_ssl_domain_free( pn_ssl_domain_t *domain )
       ssl_session_free( ssn );
       ssn = next;
     }
+    free(domain->ssn_buckets);
 
     if (domain->ctx) SSL_CTX_free(domain->ctx);
     if (domain->keyfile_pw) free(domain->keyfile_pw);
@@ -744,6 +887,52 @@ int pn_ssl_domain_allow_unsecured_client(pn_ssl_domain_t *domain)
   return 0;
 }
 
+int pn_ssl_domain_set_session_cache(pn_ssl_domain_t *domain, size_t max_sessions, unsigned int ttl)
+{
+  if (!domain) return PN_ERR;
+  domain->ssn_max = max_sessions;
+  domain->ssn_ttl = ttl;
+  ssn_cache_trim( domain, 0 );
+  if (domain->ssn_buckets && !ssn_cache_resize( domain )) return PN_ERR;
+
+  if (domain->mode == PN_SSL_MODE_SERVER) {
+    // OpenSSL treats a cache size of 0 as unlimited
+    if (max_sessions) {
+      SSL_CTX_set_session_cache_mode(domain->ctx, SSL_SESS_CACHE_SERVER);
+      SSL_CTX_sess_set_cache_size(domain->ctx, max_sessions);
+    } else {
+      SSL_CTX_set_session_cache_mode(domain->ctx, SSL_SESS_CACHE_OFF);
+    }
+    if (ttl) SSL_CTX_set_timeout(domain->ctx, ttl);
+  }
+  return 0;
+}
+
+int pn_ssl_domain_set_session_tickets(pn_ssl_domain_t *domain, bool enable)
+{
+  if (!domain) return PN_ERR;
+#ifdef SSL_OP_NO_TICKET
+  if (enable) {
+    SSL_CTX_clear_options(domain->ctx, SSL_OP_NO_TICKET);
+  } else {
+    SSL_CTX_set_options(domain->ctx, SSL_OP_NO_TICKET);
+  }
+  return 0;
+#else
+  return enable ? PN_ERR : 0;
+#endif
+}
+
+uint64_t pn_ssl_domain_get_session_hits(pn_ssl_domain_t *domain)
+{
+  return domain ? PNI_COUNT_GET(domain->ssn_hits) : 0;
+}
+
+uint64_t pn_ssl_domain_get_session_misses(pn_ssl_domain_t *domain)
+{
+  return domain ? PNI_COUNT_GET(domain->ssn_misses) : 0;
+}
+
 int pn_ssl_get_ssf(pn_ssl_t *ssl0)
 {
   const SSL_CIPHER *c;
@@ -860,9 +1049,16 @@ static int start_ssl_shutdown(pn_transport_t *transport)
       if (ssn) {
         ssn->id = pn_strdup( ssl->session_id );
         ssn->session = SSL_get1_session( ssl->ssl );
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+        // a TLS 1.3 session can only be resumed once its ticket has arrived
+        if (ssn->session && !SSL_SESSION_is_resumable( ssn->session )) {
+          SSL_SESSION_free( ssn->session );
+          ssn->session = NULL;
+        }
+#endif
         if (ssn->session) {
           ssl_log(transport, "Saving SSL session as %s", ssl->session_id );
-          LL_ADD( ssl->domain, ssn_cache, ssn );
+          ssn_cache_add( ssl->domain, ssn );
         } else {
           ssl_session_free( ssn );
         }
@@ -916,11 +1112,17 @@ static ssize_t process_input_ssl( pn_transport_t *transport, unsigned int layer,
 
     // Read all available data from the SSL socket
 
-    if (!ssl->ssl_closed && ssl->in_count < ssl->in_size) {
-      int read = BIO_read( ssl->bio_ssl, &ssl->inbuf[ssl->in_count], ssl->in_size - ssl->in_count );
+    if (!ssl->ssl_closed && ssl->in_start + ssl->in_count == ssl->in_size && ssl->in_start) {
+      // out of room at the end: move the partial frame to the front
+      memmove( ssl->inbuf, ssl->inbuf + ssl->in_start, ssl->in_count );
+      ssl->in_start = 0;
+    }
+    if (!ssl->ssl_closed && ssl->in_start + ssl->in_count < ssl->in_size) {
+      char *tail = &ssl->inbuf[ssl->in_start + ssl->in_count];
+      int read = BIO_read( ssl->bio_ssl, tail, ssl->in_size - ssl->in_start - ssl->in_count );
       if (read > 0) {
         ssl_log( transport, "Read %d bytes from SSL socket for app", read );
-        ssl_log_clear_data(transport, &ssl->inbuf[ssl->in_count], read );
+        ssl_log_clear_data(transport, tail, read );
         ssl->in_count += read;
         work_pending = true;
       } else {
@@ -954,17 +1156,17 @@ static ssize_t process_input_ssl( pn_transport_t *transport, unsigned int layer,
 
     if (!ssl->app_input_closed) {
       if (ssl->in_count > 0 || ssl->ssl_closed) {  /* if ssl_closed, send 0 count */
-        ssize_t consumed = transport->io_layers[layer+1]->process_input(transport, layer+1, ssl->inbuf, ssl->in_count);
+        ssize_t consumed = transport->io_layers[layer+1]->process_input(transport, layer+1, ssl->inbuf + ssl->in_start, ssl->in_count);
         if (consumed > 0) {
           ssl->in_count -= consumed;
-          if (ssl->in_count)
-            memmove( ssl->inbuf, ssl->inbuf + consumed, ssl->in_count );
+          ssl->in_start = ssl->in_count ? ssl->in_start + consumed : 0;
           work_pending = true;
           ssl_log( transport, "Application consumed %d bytes from peer", (int) consumed );
         } else if (consumed < 0) {
           ssl_log(transport, "Application layer closed its input, error=%d (discarding %d bytes)",
                (int) consumed, (int)ssl->in_count);
           ssl->in_count = 0;    // discard any pending input
+          ssl->in_start = 0;
           ssl->app_input_closed = consumed;
           if (ssl->app_output_closed && ssl->out_count == 0) {
             // both sides of app closed, and no more app output pending:
@@ -1031,6 +1233,23 @@ static void handle_error_ssl(pn_transport_t *transport, unsigned int layer)
   transport->io_layers[layer] = &ssl_closed_layer;
 }
 
+// Double the output ring, up to APP_BUF_MAX, keeping the pending output in
+// order at the front.  On failure the ring is left as it was.
+static void grow_output( pni_ssl_t *ssl )
+{
+  if (ssl->out_size >= APP_BUF_MAX) return;
+  size_t newsize = pn_min(APP_BUF_MAX, ssl->out_size * 2);
+  char *newbuf = (char *)malloc(newsize);
+  if (!newbuf) return;
+  size_t run = pn_min(ssl->out_count, ssl->out_size - ssl->out_start);
+  memcpy( newbuf, ssl->outbuf + ssl->out_start, run );
+  memcpy( newbuf + run, ssl->outbuf, ssl->out_count - run );
+  free(ssl->outbuf);
+  ssl->outbuf = newbuf;
+  ssl->out_size = newsize;
+  ssl->out_start = 0;
+}
+
 static ssize_t process_output_ssl( pn_transport_t *transport, unsigned int layer, char *buffer, size_t max_len)
 {
   pni_ssl_t *ssl = transport->ssl;
@@ -1045,11 +1264,23 @@ static ssize_t process_output_ssl( pn_transport_t *transport, unsigned int layer
     // first, get any pending application output, if possible
 
     if (!ssl->app_output_closed && ssl->out_count < ssl->out_size) {
-      ssize_t app_bytes = transport->io_layers[layer+1]->process_output(transport, layer+1, &ssl->outbuf[ssl->out_count], ssl->out_size - ssl->out_count);
+      // fill the free space after the pending output, wrapping around
+      size_t tail = ssl->out_start + ssl->out_count;
+      size_t space = ssl->out_size - ssl->out_count;
+      if (tail >= ssl->out_size) {
+        tail -= ssl->out_size;
+      } else if (tail + space > ssl->out_size) {
+        space = ssl->out_size - tail;
+      }
+      ssize_t app_bytes = transport->io_layers[layer+1]->process_output(transport, layer+1, &ssl->outbuf[tail], space);
       if (app_bytes > 0) {
         ssl->out_count += app_bytes;
         work_pending = true;
         ssl_log(transport, "Gathered %d bytes from app to send to peer", app_bytes );
+        if (ssl->out_count == ssl->out_size) {
+          // the app may have more than fits: make room for it next pass
+          grow_output( ssl );
+        }
       } else {
         if (app_bytes < 0) {
           ssl_log(transport, "Application layer closed its output, error=%d (%d bytes pending send)",
@@ -1062,12 +1293,13 @@ static ssize_t process_output_ssl( pn_transport_t *transport, unsigned int layer
     // now push any pending app data into the socket
 
     if (!ssl->ssl_closed) {
-      char *data = ssl->outbuf;
       if (ssl->out_count > 0) {
-        int wrote = BIO_write( ssl->bio_ssl, data, ssl->out_count );
+        // write the contiguous run at the head of the ring
+        size_t run = pn_min(ssl->out_count, ssl->out_size - ssl->out_start);
+        int wrote = BIO_write( ssl->bio_ssl, &ssl->outbuf[ssl->out_start], run );
         if (wrote > 0) {
-          data += wrote;
           ssl->out_count -= wrote;
+          ssl->out_start = ssl->out_count ? (ssl->out_start + wrote) % ssl->out_size : 0;
           work_pending = true;
           ssl_log( transport, "Wrote %d bytes from app to socket", wrote );
         } else {
@@ -1079,6 +1311,7 @@ static ssize_t process_output_ssl( pn_transport_t *transport, unsigned int layer
               ssl_log(transport, "SSL connection has closed");
               start_ssl_shutdown(transport); // KAG: not sure - this may not be necessary
               ssl->out_count = 0;      // can no longer write to socket, so erase app output data
+              ssl->out_start = 0;
               ssl->ssl_closed = true;
               break;
             default:
@@ -1104,8 +1337,6 @@ static ssize_t process_output_ssl( pn_transport_t *transport, unsigned int layer
           // been written to the SSL socket
           start_ssl_shutdown(transport);
         }
-      } else if (data != ssl->outbuf) {
-        memmove( ssl->outbuf, data, ssl->out_count );
       }
     }
 
@@ -1176,7 +1407,7 @@ static int init_ssl_socket(pn_transport_t* transport, pni_ssl_t *ssl)
       if (rc != 1) {
         ssl_log( transport, "Session restore failed, id=%s", ssn->id );
       }
-      LL_REMOVE( ssl->domain, ssn_cache, ssn );
+      ssn_cache_remove( ssl->domain, ssn );
       ssl_session_free( ssn );
     }
   }
@@ -1189,7 +1420,13 @@ static int init_ssl_socket(pn_transport_t* transport, pni_ssl_t *ssl)
   }
   (void)BIO_set_ssl(ssl->bio_ssl, ssl->ssl, BIO_NOCLOSE);
 
-  // create the "lower" BIO "pipe", and attach it below the SSL layer
+  // let SSL_write return after each record, and accept the rest of a
+  // partially written buffer at a new address
+  SSL_set_mode(ssl->ssl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+  // create the "lower" BIO "pipe", and attach it below the SSL layer.  The
+  // default size holds a whole record, and is allocated up front, so a
+  // larger pipe would cost every connection whether busy or not.
   if (!BIO_new_bio_pair(&ssl->bio_ssl_io, 0, &ssl->bio_net_io, 0)) {
     pn_transport_log(transport, "BIO setup failure." );
     return -1;
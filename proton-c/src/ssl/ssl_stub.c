@@ -118,6 +118,26 @@ int pn_ssl_domain_allow_unsecured_client(pn_ssl_domain_t *domain)
   return -1;
 }
 
+int pn_ssl_domain_set_session_cache(pn_ssl_domain_t *domain, size_t max_sessions, unsigned int ttl)
+{
+  return PN_ERR;
+}
+
+int pn_ssl_domain_set_session_tickets(pn_ssl_domain_t *domain, bool enable)
+{
+  return PN_ERR;
+}
+
+uint64_t pn_ssl_domain_get_session_hits(pn_ssl_domain_t *domain)
+{
+  return 0;
+}
+
+uint64_t pn_ssl_domain_get_session_misses(pn_ssl_domain_t *domain)
+{
+  return 0;
+}
+
 bool pn_ssl_allow_unsecured(pn_ssl_t *ssl)
 {
   return true;
@@ -294,12 +294,762 @@ int test_free_link(int argc, char **argv)
     return 0;
 }
 
+// settle many deliveries out of order while the first stays unsettled, so
+// the sessions' delivery maps must track a window far larger than the
+// deliveries actually in flight
+int test_delivery_window(int argc, char **argv)
+{
+    fprintf(stdout, "test_delivery_window\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+
+    const int total = 20000;
+    const int batch = 500;
+    pn_delivery_t *received[500];
+    pn_delivery_t *first_tx = NULL;
+    pn_delivery_t *first_rx = NULL;
+    int sent = 0;
+    int settled = 0;
+    while (sent < total) {
+        pn_link_flow(rx, batch);
+        pump(t1, t2);
+        while (pn_link_credit(tx) > 0) {
+            pn_delivery_t *d = pn_delivery(tx, pn_dtag((const char *) &sent, sizeof(sent)));
+            if (!first_tx) first_tx = d;
+            pn_link_send(tx, "x", 1);
+            pn_link_advance(tx);
+            sent++;
+        }
+        pump(t1, t2);
+
+        int count = 0;
+        pn_delivery_t *d;
+        while ((d = pn_link_current(rx)) && !pn_delivery_partial(d)) {
+            char byte;
+            assert(pn_link_recv(rx, &byte, 1) == 1);
+            pn_link_advance(rx);
+            received[count++] = d;
+        }
+        assert(count == batch);
+        while (count--) {
+            d = received[count];
+            if (!first_rx) {
+                first_rx = received[0];
+            }
+            if (d != first_rx) {
+                pn_delivery_update(d, PN_ACCEPTED);
+                pn_delivery_settle(d);
+            }
+        }
+        pump(t1, t2);
+
+        d = pn_work_head(c1);
+        while (d) {
+            pn_delivery_t *next = pn_work_next(d);
+            if (pn_delivery_updated(d) && pn_delivery_remote_state(d) == PN_ACCEPTED) {
+                assert(d != first_tx);
+                pn_delivery_settle(d);
+                settled++;
+            }
+            d = next;
+        }
+    }
+    assert(settled == total - 1);
+    assert(pn_delivery_remote_state(first_tx) == 0);
+
+    pn_delivery_update(first_rx, PN_ACCEPTED);
+    pn_delivery_settle(first_rx);
+    pump(t1, t2);
+    assert(pn_delivery_remote_state(first_tx) == PN_ACCEPTED);
+    assert(pn_delivery_settled(first_tx));
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// encode a disposition frame updating [first, last] to accepted
+static ssize_t encode_disposition(char *frame, size_t capacity, uint32_t first, uint32_t last,
+                                  bool settled)
+{
+    pn_data_t *body = pn_data(0);
+    // disposition: role=receiver, first, last, settled, state=accepted
+    pn_data_fill(body, "DL[oIIoDL[]]", (uint64_t) 0x15, true, first, last, settled, (uint64_t) 0x24);
+    ssize_t size = pn_data_encode(body, frame + 8, capacity - 8);
+    assert(size > 0);
+    pn_data_free(body);
+    size += 8;
+    frame[0] = (char) (size >> 24);
+    frame[1] = (char) (size >> 16);
+    frame[2] = (char) (size >> 8);
+    frame[3] = (char) size;
+    frame[4] = 2;   // doff
+    frame[5] = 0;   // AMQP frame
+    frame[6] = 0;   // channel
+    frame[7] = 0;
+    return size;
+}
+
+// feed t a disposition frame updating [first, last] to accepted
+static void inject_disposition(pn_transport_t *t, uint32_t first, uint32_t last, bool settled)
+{
+    char frame[64];
+    ssize_t size = encode_disposition(frame, sizeof(frame), first, last, settled);
+    assert(pn_transport_push(t, frame, size) == size);
+}
+
+static int drain_events(pn_collector_t *collector, pn_event_type_t type)
+{
+    int count = 0;
+    pn_event_t *event;
+    while ((event = pn_collector_peek(collector))) {
+        if (pn_event_type(event) == type) count++;
+        pn_collector_pop(collector);
+    }
+    return count;
+}
+
+// dispositions only visit deliveries that exist, whatever the range
+int test_disposition_range(int argc, char **argv)
+{
+    fprintf(stdout, "test_disposition_range\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    pn_collector_t *collector = pn_collector();
+    pn_connection_collect(c1, collector);
+
+    // ids 0..7 are in flight
+    const int count = 8;
+    pn_delivery_t *sent[8];
+    pn_link_flow(rx, count);
+    pump(t1, t2);
+    for (int i = 0; i < count; i++) {
+        sent[i] = pn_delivery(tx, pn_dtag((const char *) &i, sizeof(i)));
+        pn_link_send(tx, "x", 1);
+        pn_link_advance(tx);
+    }
+    pump(t1, t2);
+    drain_events(collector, PN_DELIVERY);
+
+    // a range wrapping from the top of the id space into ids 0 and 1
+    inject_disposition(t1, 0xFFFFFFF0, 1, true);
+    assert(drain_events(collector, PN_DELIVERY_SETTLE_RANGE) == 0);
+    assert(pn_delivery_settled(sent[0]) && pn_delivery_settled(sent[1]));
+    assert(!pn_delivery_updated(sent[2]));
+
+    // a short range is looked up id by id
+    inject_disposition(t1, 2, 3, true);
+    assert(pn_delivery_settled(sent[2]) && pn_delivery_settled(sent[3]));
+    assert(!pn_delivery_updated(sent[4]));
+    drain_events(collector, PN_DELIVERY);
+
+    // the whole id space in bulk settle mode
+    pn_link_set_bulk_settle(tx, true);
+    assert(pn_link_get_bulk_settle(tx));
+
+    // a range that does not settle still has an event per delivery
+    inject_disposition(t1, 4, 5, false);
+    assert(!pn_delivery_settled(sent[4]) && pn_delivery_updated(sent[5]));
+    assert(drain_events(collector, PN_DELIVERY) == 2);
+
+    inject_disposition(t1, 0, 0xFFFFFFFF, true);
+    int events = 0, ranges = 0;
+    pn_event_t *event;
+    while ((event = pn_collector_peek(collector))) {
+        if (pn_event_type(event) == PN_DELIVERY_SETTLE_RANGE) {
+            assert(pn_event_link(event) == tx);
+            ranges++;
+        }
+        if (pn_event_type(event) == PN_DELIVERY) events++;
+        pn_collector_pop(collector);
+    }
+    assert(ranges == 1 && events == 0);
+    for (int i = 0; i < count; i++) {
+        assert(pn_delivery_remote_state(sent[i]) == PN_ACCEPTED);
+        assert(pn_delivery_settled(sent[i]));
+        assert(pn_delivery_updated(sent[i]));
+    }
+
+    // the deliveries are taken in id order, less those settled meanwhile
+    pn_delivery_settle(sent[6]);
+    for (int i = 0; i < count; i++) {
+        if (i != 6) assert(pn_link_take_settled(tx) == sent[i]);
+    }
+    assert(pn_link_take_settled(tx) == NULL);
+
+    pn_collector_free(collector);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// an incoming attach is matched to an existing link by its exact name
+int test_link_name_match(int argc, char **argv)
+{
+    fprintf(stdout, "test_link_name_match\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_session_t *s1 = pn_session_head(c1, 0);
+    pn_session_t *s2 = pn_session_head(c2, 0);
+
+    // links on c2 that an attach named "link" must not be taken for
+    pn_link_t *longer = pn_receiver(s2, "link-1");
+    pn_link_t *other_role = pn_sender(s2, "link");
+    // the link it should be matched to
+    pn_link_t *expected = pn_receiver(s2, "link");
+
+    pn_link_t *tx = pn_sender(s1, "link");
+    pn_link_open(tx);
+    pump(t1, t2);
+
+    assert(pn_link_state(expected) & PN_REMOTE_ACTIVE);
+    assert(pn_link_state(longer) & PN_REMOTE_UNINIT);
+    assert(pn_link_state(other_role) & PN_REMOTE_UNINIT);
+
+    // many links on the session, attached and detached in turn
+    for (int i = 0; i < 2000; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "churn-%d", i % 500);
+        pn_link_t *link = pn_sender(s1, name);
+        pn_link_open(link);
+        pump(t1, t2);
+        pn_link_t *peer = pn_link_head(c2, PN_LOCAL_UNINIT | PN_REMOTE_ACTIVE);
+        if (peer == expected) peer = pn_link_next(peer, PN_LOCAL_UNINIT | PN_REMOTE_ACTIVE);
+        assert(peer && !strcmp(pn_link_name(peer), name) && pn_link_is_receiver(peer));
+        pn_link_open(peer);
+        pn_link_close(link);
+        pump(t1, t2);
+        pn_link_close(peer);
+        pump(t1, t2);
+        assert(pn_link_state(link) == (PN_LOCAL_CLOSED | PN_REMOTE_CLOSED));
+        pn_link_free(link);
+        pn_link_free(peer);
+    }
+    assert(pn_link_state(expected) == (PN_LOCAL_UNINIT | PN_REMOTE_ACTIVE));
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// free sessions and links from the head, middle and tail of their
+// parents before binding, only the survivors should reach the peer
+int test_free_children(int argc, char **argv)
+{
+    fprintf(stdout, "test_free_children\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_session_t *ssn[4];
+    pn_link_t *links[4][5];
+    for (int i = 0; i < 4; i++) {
+        ssn[i] = pn_session(c1);
+        for (int j = 0; j < 5; j++) {
+            char name[32];
+            snprintf(name, sizeof(name), "link-%d-%d", i, j);
+            links[i][j] = pn_sender(ssn[i], name);
+        }
+    }
+    pn_session_free(ssn[1]);
+    pn_session_free(ssn[3]);
+    int freed[] = {2, 0, 4};
+    for (int i = 0; i < 3; i++) {
+        pn_link_free(links[0][freed[i]]);
+        pn_link_free(links[2][freed[i]]);
+    }
+
+    pn_connection_open(c1);
+    for (int i = 0; i < 4; i += 2) {
+        pn_session_open(ssn[i]);
+        pn_link_open(links[i][1]);
+        pn_link_open(links[i][3]);
+    }
+
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_bind(t2, c2);
+
+    while (pump(t1, t2)) {
+        process_endpoints(c1);
+        process_endpoints(c2);
+    }
+
+    const char *expected[] = {"link-0-1", "link-0-3", "link-2-1", "link-2-3"};
+    int count = 0;
+    for (pn_link_t *link = pn_link_head(c2, 0); link; link = pn_link_next(link, 0)) {
+        assert(count < 4 && !strcmp(pn_link_name(link), expected[count]));
+        assert(pn_link_state(link) == (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+        count++;
+    }
+    assert(count == 4);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// with coalescing on, a delivery updated several times by one chunk of
+// input is reported once, and a receiver with a small window still gets
+// everything
+int test_coalesce_events(int argc, char **argv)
+{
+    fprintf(stdout, "test_coalesce_events\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_set_coalesce_events(t1, true);
+    assert(pn_transport_get_coalesce_events(t1));
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_set_coalesce_events(t2, true);
+    pn_transport_set_max_frame(t2, 512);
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    pn_session_set_incoming_capacity(pn_link_session(rx), 2048);
+    pn_collector_t *collector = pn_collector();
+    pn_connection_collect(c1, collector);
+
+    const int count = 20;
+    pn_delivery_t *sent[20];
+    char payload[1000] = {0};
+    pn_link_flow(rx, count);
+    pump(t1, t2);
+    for (int i = 0; i < count; i++) {
+        sent[i] = pn_delivery(tx, pn_dtag((const char *) &i, sizeof(i)));
+        pn_link_send(tx, payload, sizeof(payload));
+        pn_link_advance(tx);
+    }
+
+    // each message spans several frames and the window holds only a
+    // couple of them, so the receiver must keep refreshing it
+    int received = 0;
+    while (pump(t1, t2)) {
+        pn_delivery_t *d;
+        while ((d = pn_link_current(rx)) && !pn_delivery_partial(d)) {
+            char buffer[1024];
+            assert(pn_link_recv(rx, buffer, sizeof(buffer)) == sizeof(payload));
+            pn_link_advance(rx);
+            pn_delivery_settle(d);
+            received++;
+        }
+    }
+    assert(received == count);
+    drain_events(collector, PN_DELIVERY);
+
+    // two interleaved updates of the same pair of deliveries
+    char frames[128];
+    ssize_t size = encode_disposition(frames, 64, 0, 1, true);
+    size += encode_disposition(frames + size, 64, 0, 1, true);
+    assert(pn_transport_push(t1, frames, size) == size);
+    assert(pn_delivery_settled(sent[0]) && pn_delivery_settled(sent[1]));
+    assert(drain_events(collector, PN_DELIVERY) == 2);
+
+    // the same input with coalescing off reports every update
+    pn_transport_set_coalesce_events(t1, false);
+    size = encode_disposition(frames, 64, 2, 3, true);
+    size += encode_disposition(frames + size, 64, 2, 3, true);
+    assert(pn_transport_push(t1, frames, size) == size);
+    assert(drain_events(collector, PN_DELIVERY) == 4);
+
+    pn_collector_free(collector);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// the counters agree between the two ends and with what was sent
+int test_metrics(int argc, char **argv)
+{
+    fprintf(stdout, "test_metrics\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(!pn_link_settle_latency(tx));
+    pn_link_record_settle_latency(tx, true);
+    assert(pn_histogram_count(pn_link_settle_latency(tx)) == 0);
+
+    // four deliveries against two credits stall the sender once
+    pn_delivery_t *sent[4];
+    pn_link_flow(rx, 2);
+    pump(t1, t2);
+    for (int i = 0; i < 4; i++) {
+        sent[i] = pn_delivery(tx, pn_dtag((const char *) &i, sizeof(i)));
+        pn_link_send(tx, "abc", 3);
+        pn_link_advance(tx);
+        pump(t1, t2);
+    }
+
+    const pn_transport_metrics_t *m1 = pn_transport_metrics(t1);
+    const pn_transport_metrics_t *m2 = pn_transport_metrics(t2);
+    const pn_link_metrics_t *lm = pn_link_metrics(tx);
+    assert(m1->deliveries_sent == 2 && lm->deliveries_sent == 2);
+    assert(m1->credit_stalls == 1 && lm->credit_stalls == 1);
+    assert(lm->bytes_sent == 6 && pn_link_metrics(rx)->bytes_received == 6);
+    assert(pn_session_metrics(pn_link_session(tx))->bytes_sent == 6);
+    assert(m2->deliveries_received == 2);
+    assert(pn_session_metrics(pn_link_session(rx))->deliveries_received == 2);
+
+    // the receiver accepts and settles both, then the sender settles
+    for (pn_delivery_t *d = pn_link_current(rx); d; d = pn_link_current(rx)) {
+        pn_link_advance(rx);
+        pn_delivery_update(d, PN_ACCEPTED);
+        pn_delivery_settle(d);
+    }
+    pump(t1, t2);
+    const pn_histogram_t *latency = pn_link_settle_latency(tx);
+    assert(pn_histogram_count(latency) == 2);
+    assert(pn_histogram_min(latency) <= pn_histogram_percentile(latency, 50));
+    assert(pn_histogram_percentile(latency, 50) <= pn_histogram_max(latency));
+    assert(pn_histogram_percentile(latency, 100) == pn_histogram_max(latency));
+    pn_histogram_t *hcopy = pn_histogram();
+    assert(pn_link_settle_latency_copy(tx, hcopy));
+    assert(pn_histogram_count(hcopy) == 2);
+    assert(pn_histogram_max(hcopy) == pn_histogram_max(latency));
+    assert(pn_histogram_percentile(hcopy, 50) == pn_histogram_percentile(latency, 50));
+    pn_delivery_settle(sent[0]);
+    pn_delivery_settle(sent[1]);
+    pump(t1, t2);
+    assert(m1->deliveries_settled == 2 && lm->deliveries_settled == 2);
+    assert(m2->deliveries_settled == 2);
+
+    // what one end wrote, the other read
+    assert(m1->output[PN_PERFORMATIVE_OPEN].frames == 1);
+    assert(m2->input[PN_PERFORMATIVE_OPEN].frames == 1);
+    assert(m1->output[PN_PERFORMATIVE_TRANSFER].frames == 2);
+    uint64_t frames = 0;
+    for (int i = 0; i < PN_PERFORMATIVE_CT; i++) {
+        assert(m1->output[i].frames == m2->input[i].frames);
+        assert(m1->output[i].bytes == m2->input[i].bytes);
+        frames += m2->input[i].frames;
+    }
+    assert(frames == m2->frames_input && frames == pn_transport_get_frames_input(t2));
+    assert(m1->bytes_output == m2->bytes_input);
+    assert(m1->output_high_water > 0 && m1->bytes_copied > 0);
+
+    // a copy, as another thread would take, matches the live counters
+    pn_transport_metrics_t tcopy;
+    pn_transport_metrics_copy(t1, &tcopy);
+    assert(!memcmp(&tcopy, m1, sizeof(tcopy)));
+    pn_session_metrics_t scopy;
+    pn_session_metrics_copy(pn_link_session(tx), &scopy);
+    assert(!memcmp(&scopy, pn_session_metrics(pn_link_session(tx)), sizeof(scopy)));
+    pn_link_metrics_t lcopy;
+    pn_link_metrics_copy(tx, &lcopy);
+    assert(!memcmp(&lcopy, lm, sizeof(lcopy)));
+
+    pn_link_record_settle_latency(tx, false);
+    assert(!pn_link_settle_latency(tx));
+    assert(!pn_link_settle_latency_copy(tx, hcopy));
+    pn_histogram_free(hcopy);
+
+    // deliveries written before recording starts are not recorded
+    pn_link_flow(rx, 2);
+    pump(t1, t2);
+    pn_link_record_settle_latency(tx, true);
+    for (pn_delivery_t *d = pn_link_current(rx); d; d = pn_link_current(rx)) {
+        pn_link_advance(rx);
+        pn_delivery_settle(d);
+    }
+    pump(t1, t2);
+    assert(pn_histogram_count(pn_link_settle_latency(tx)) == 0);
+    pn_link_record_settle_latency(tx, false);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+static pn_trace_record_t *find_record(char *dump, uint8_t code, bool out, int skip)
+{
+    pn_trace_header_t *header = (pn_trace_header_t *) dump;
+    pn_trace_record_t *records = (pn_trace_record_t *) (dump + sizeof(*header));
+    for (uint64_t i = 0; i < header->count; i++) {
+        if (records[i].code == code && !(records[i].flags & PN_TRACE_OUT) == !out && skip-- == 0)
+            return &records[i];
+    }
+    return NULL;
+}
+
+int test_trace_ring(int argc, char **argv)
+{
+    fprintf(stdout, "test_trace_ring\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_trace(t1, PN_TRACE_BIN);
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_bind(t2, c2);
+
+    // with no ring the dump is just a header
+    assert(pn_transport_trace_dump(t2, NULL, 0) == sizeof(pn_trace_header_t));
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    pn_link_flow(rx, 2);
+    pump(t1, t2);
+    for (int i = 0; i < 2; i++) {
+        pn_delivery(tx, pn_dtag((const char *) &i, sizeof(i)));
+        pn_link_send(tx, "abcde", 5);
+        pn_link_advance(tx);
+    }
+    pump(t1, t2);
+
+    ssize_t size = pn_transport_trace_dump(t1, NULL, 0);
+    assert(size > (ssize_t) sizeof(pn_trace_header_t));
+    char *dump = (char *) malloc(size);
+    assert(pn_transport_trace_dump(t1, dump, size - 1) == PN_OVERFLOW);
+    assert(pn_transport_trace_dump(t1, dump, size) == size);
+
+    pn_trace_header_t *header = (pn_trace_header_t *) dump;
+    assert(!memcmp(header->magic, "PNTRACE1", 8));
+    assert(header->byte_order == 0x01020304);
+    assert(header->record_size == sizeof(pn_trace_record_t));
+    assert(header->dropped == 0);
+    const pn_transport_metrics_t *m = pn_transport_metrics(t1);
+    assert(header->count == m->frames_input + m->frames_output);
+
+    assert(find_record(dump, 0x10, true, 0) && find_record(dump, 0x10, false, 0));
+    pn_trace_record_t *attach = find_record(dump, 0x12, true, 0);
+    assert(attach && !(attach->flags & PN_TRACE_FLAG));
+    pn_trace_record_t *flow = find_record(dump, 0x13, false, 0);
+    assert(flow && flow->fields[0] == 0 && flow->fields[2] == 2);
+    for (int i = 0; i < 2; i++) {
+        pn_trace_record_t *transfer = find_record(dump, 0x14, true, i);
+        assert(transfer && transfer->fields[0] == 0 && transfer->fields[1] == (uint32_t) i);
+        assert(transfer->size == 5 && !(transfer->flags & (PN_TRACE_SETTLED | PN_TRACE_MORE)));
+        assert(transfer->time > 0);
+    }
+    free(dump);
+
+    // a small ring keeps only the latest frames
+    uint64_t frames = m->frames_input + m->frames_output;
+    pn_transport_set_trace_ring(t1, 3);
+    pn_link_flow(rx, 8);
+    pump(t1, t2);
+    for (int i = 0; i < 8; i++) {
+        pn_delivery(tx, pn_dtag((const char *) &i, sizeof(i)));
+        pn_link_send(tx, "abcde", 5);
+        pn_link_advance(tx);
+    }
+    pump(t1, t2);
+    size = pn_transport_trace_dump(t1, NULL, 0);
+    dump = (char *) malloc(size);
+    assert(pn_transport_trace_dump(t1, dump, size) == size);
+    header = (pn_trace_header_t *) dump;
+    assert(header->count == 4 && header->dropped > 0);
+    assert(header->count + header->dropped == m->frames_input + m->frames_output - frames);
+    pn_trace_record_t *last = (pn_trace_record_t *) (dump + sizeof(*header)) + 3;
+    assert(last->code == 0x14 && (last->flags & PN_TRACE_OUT) && last->fields[1] == 9);
+    free(dump);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+int test_transport_pair(int argc, char **argv)
+{
+    fprintf(stdout, "test_transport_pair\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_set_idle_timeout(t1, 100);
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_bind(t2, c2);
+
+    pn_transport_pair_t *pair = pn_transport_pair(t1, t2);
+    const pn_transport_metrics_t *m1 = pn_transport_metrics(t1);
+    const pn_transport_metrics_t *m2 = pn_transport_metrics(t2);
+
+    // 1000 bytes a second with 20ms latency: the header and open take
+    // a millisecond a byte to send, then 20ms to arrive
+    pn_transport_pair_set_latency(pair, 20);
+    pn_transport_pair_set_bandwidth(pair, 1000);
+    pn_transport_pair_set_segment_size(pair, 7);
+    pn_timestamp_t start = pn_transport_pair_now(pair);
+    pn_connection_open(c1);
+    assert(pn_transport_pair_pump(pair) == 0);
+    size_t sent = pn_transport_pair_in_flight(pair);
+    assert(sent == m1->bytes_output && sent > 0);
+    assert(pn_transport_pair_deadline(pair) == start + 7 + 20);
+    while (pn_transport_pair_in_flight(pair)) {
+        pn_timestamp_t deadline = pn_transport_pair_deadline(pair);
+        assert(deadline > pn_transport_pair_now(pair));
+        pn_transport_pair_advance(pair, (pn_millis_t) (deadline - pn_transport_pair_now(pair)));
+    }
+    assert(pn_transport_pair_now(pair) == start + (pn_timestamp_t) sent + 20);
+    assert(m2->bytes_input == sent && m2->input[PN_PERFORMATIVE_OPEN].frames == 1);
+
+    // the reply comes back the same way, behind t2's heartbeats
+    pn_connection_open(c2);
+    pn_transport_pair_pump(pair);
+    assert(pn_transport_pair_in_flight(pair) > 0);
+    while (!(pn_connection_state(c1) & PN_REMOTE_ACTIVE)) {
+        assert(pn_transport_pair_deadline(pair));
+        pn_transport_pair_advance(pair, 1);
+    }
+
+    // with no latency or bandwidth limit bytes go straight across, once
+    // those already on their way have arrived
+    pn_transport_pair_set_latency(pair, 0);
+    pn_transport_pair_set_bandwidth(pair, 0);
+    pn_transport_pair_advance(pair, 50);
+    assert(pn_transport_pair_in_flight(pair) == 0);
+    pn_session_t *ssn = pn_session(c1);
+    pn_session_open(ssn);
+    assert(pn_transport_pair_pump(pair) > 0);
+    assert(pn_transport_pair_in_flight(pair) == 0);
+    assert(m2->input[PN_PERFORMATIVE_BEGIN].frames == 1);
+
+    // t2 keeps the idle connection alive on the pair's clock alone
+    uint64_t empty = m1->input[PN_PERFORMATIVE_OTHER].frames;
+    for (int i = 0; i < 100; i++) {
+        pn_transport_pair_advance(pair, 10);
+    }
+    assert(m1->input[PN_PERFORMATIVE_OTHER].frames > empty);
+    assert(!pn_transport_closed(t1) && !pn_transport_closed(t2));
+    assert(pn_transport_pair_deadline(pair) > pn_transport_pair_now(pair));
+
+    // closing one end closes the other
+    pn_connection_close(c1);
+    pn_transport_pair_pump(pair);
+    pn_connection_close(c2);
+    pn_transport_pair_pump(pair);
+    assert(pn_transport_closed(t1) && pn_transport_closed(t2));
+    assert(m1->frames_output == m2->frames_input && m2->frames_output == m1->frames_input);
+
+    pn_transport_pair_free(pair);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
 
 typedef int (*test_ptr_t)(int argc, char **argv);
 
 test_ptr_t tests[] = {test_free_connection,
                       test_free_session,
                       test_free_link,
+                      test_delivery_window,
+                      test_disposition_range,
+                      test_link_name_match,
+                      test_free_children,
+                      test_coalesce_events,
+                      test_metrics,
+                      test_trace_ring,
+                      test_transport_pair,
                       NULL};
 
 int main(int argc, char **argv)
@@ -40,8 +40,60 @@ static void test_overflow_error(void)
   pn_message_free(message);
 }
 
+static void test_copy(void)
+{
+  pn_message_t *src = pn_message();
+  pn_message_set_address(src, "queue");
+  pn_message_set_subject(src, "subject");
+  pn_message_set_user_id(src, pn_bytes(3, "a\0b"));
+  pn_message_set_durable(src, true);
+  pn_message_set_priority(src, 7);
+  pn_message_set_ttl(src, 1000);
+  pn_message_set_group_sequence(src, -3);
+  pn_message_set_inferred(src, true);
+  pn_data_put_ulong(pn_message_id(src), 42);
+  pn_data_put_map(pn_message_properties(src));
+  pn_data_enter(pn_message_properties(src));
+  pn_data_put_string(pn_message_properties(src), pn_bytes(3, "key"));
+  pn_data_put_int(pn_message_properties(src), 12);
+  pn_data_exit(pn_message_properties(src));
+  pn_data_put_string(pn_message_body(src), pn_bytes(5, "hello"));
+
+  // copy over a message that already has content of its own
+  pn_message_t *dst = pn_message();
+  pn_message_set_reply_to(dst, "old");
+  pn_data_put_int(pn_message_body(dst), 1);
+  assert(pn_message_copy(dst, src) == 0);
+
+  assert(!strcmp(pn_message_get_address(dst), "queue"));
+  assert(!strcmp(pn_message_get_subject(dst), "subject"));
+  assert(pn_message_get_reply_to(dst) == NULL);
+  pn_bytes_t user = pn_message_get_user_id(dst);
+  assert(user.size == 3 && !memcmp(user.start, "a\0b", 3));
+  assert(pn_message_is_durable(dst) && pn_message_is_inferred(dst));
+  assert(pn_message_get_priority(dst) == 7 && pn_message_get_ttl(dst) == 1000);
+  assert(pn_message_get_group_sequence(dst) == -3);
+  assert(pn_message_get_id(dst).type == PN_ULONG && pn_message_get_id(dst).u.as_ulong == 42);
+
+  // the copy encodes exactly as the original does
+  char a[256], b[256];
+  size_t asize = sizeof(a), bsize = sizeof(b);
+  assert(pn_message_encode(src, a, &asize) == 0);
+  assert(pn_message_encode(dst, b, &bsize) == 0);
+  assert(asize == bsize && !memcmp(a, b, asize));
+
+  // and shares nothing with it
+  pn_message_free(src);
+  pn_data_rewind(pn_message_body(dst));
+  assert(pn_data_next(pn_message_body(dst)));
+  assert(pn_data_get_string(pn_message_body(dst)).size == 5);
+  assert(pn_message_copy(dst, dst) == 0);
+  pn_message_free(dst);
+}
+
 int main(int argc, char **argv)
 {
   test_overflow_error();
+  test_copy();
   return 0;
 }
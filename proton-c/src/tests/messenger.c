@@ -0,0 +1,238 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L  // mkdtemp
+#endif
+
+#include <proton/messenger.h>
+#include <proton/message.h>
+#include <proton/codec.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+#define assert(E) ((E) ? 0 : (abort(), 0))
+
+#ifndef _WIN32
+
+static const size_t sizes[] = {10, 700*1024, 700*1024, 10};
+#define COUNT (sizeof(sizes)/sizeof(sizes[0]))
+
+static size_t segments(const char *dir)
+{
+  size_t count = 0;
+  DIR *d = opendir(dir);
+  assert(d);
+  struct dirent *ent;
+  while ((ent = readdir(d))) {
+    if (strstr(ent->d_name, ".pnj")) count++;
+  }
+  closedir(d);
+  return count;
+}
+
+static pn_messenger_t *sender(const char *dir)
+{
+  pn_messenger_t *m = pn_messenger(NULL);
+  pn_messenger_set_blocking(m, false);
+  pn_messenger_set_outgoing_window(m, 10);
+  assert(!pn_messenger_set_journal(m, dir));
+  assert(!strcmp(pn_messenger_get_journal(m), dir));
+  return m;
+}
+
+static void put(pn_messenger_t *m, const char *address, size_t size, char fill)
+{
+  pn_message_t *msg = pn_message();
+  char *body = (char *) malloc(size);
+  memset(body, fill, size);
+  pn_message_set_address(msg, address);
+  pn_data_put_string(pn_message_body(msg), pn_bytes(size, body));
+  assert(!pn_messenger_put(m, msg));
+  free(body);
+  pn_message_free(msg);
+}
+
+static void stop(pn_messenger_t *m, pn_messenger_t *peer)
+{
+  pn_messenger_stop(m);
+  for (int i = 0; i < 2000 && !pn_messenger_stopped(m); i++) {
+    pn_messenger_work(m, 0);
+    pn_messenger_work(peer, 5);
+  }
+  assert(pn_messenger_stopped(m));
+}
+
+/* Messages put by a messenger that stops before sending them are put
+   again when a new messenger on the same journal starts, and the
+   journal is emptied as they are accepted. */
+static void test_journal_replay(void)
+{
+  char dir[] = "/tmp/pn-journal-XXXXXX";
+  assert(mkdtemp(dir));
+  char url[64], address[64];
+  int port = 20000 + getpid() % 10000;
+  sprintf(url, "amqp://~127.0.0.1:%d", port);
+  sprintf(address, "amqp://127.0.0.1:%d/journal", port);
+
+  pn_messenger_t *receiver = pn_messenger(NULL);
+  pn_messenger_set_blocking(receiver, false);
+  pn_messenger_set_incoming_window(receiver, 10);
+  assert(!pn_messenger_start(receiver));
+  assert(pn_messenger_subscribe(receiver, url));
+
+  pn_messenger_t *first = sender(dir);
+  assert(!pn_messenger_start(first));
+  for (size_t i = 0; i < COUNT; i++) {
+    put(first, address, sizes[i], 'a' + i);
+  }
+  assert(pn_messenger_outgoing(first) == (int) COUNT);
+  // The receiver has given no credit, so nothing is sent before the stop.
+  stop(first, receiver);
+  pn_messenger_free(first);
+  assert(segments(dir) == 2);   // rotated for the second large message
+
+  pn_messenger_t *second = sender(dir);
+  assert(!pn_messenger_start(second));
+  assert(pn_messenger_outgoing(second) == (int) COUNT);
+
+  pn_message_t *msg = pn_message();
+  size_t received = 0;
+  pn_messenger_recv(receiver, COUNT);
+  for (int i = 0; i < 2000 && segments(dir); i++) {
+    pn_messenger_work(second, 0);
+    pn_messenger_work(receiver, 5);
+    while (pn_messenger_incoming(receiver)) {
+      assert(!pn_messenger_get(receiver, msg));
+      pn_data_t *body = pn_message_body(msg);
+      pn_data_next(body);
+      pn_bytes_t bytes = pn_data_get_string(body);
+      assert(received < COUNT);
+      assert(bytes.size == sizes[received]);
+      assert(bytes.start[0] == 'a' + (char) received);
+      assert(bytes.start[bytes.size - 1] == 'a' + (char) received);
+      pn_messenger_accept(receiver, pn_messenger_incoming_tracker(receiver), 0);
+      received++;
+    }
+  }
+  assert(received == COUNT);
+  assert(!segments(dir));
+  assert(pn_messenger_outgoing(second) == 0);
+  pn_message_free(msg);
+
+  stop(second, receiver);
+  stop(receiver, second);
+  pn_messenger_free(second);
+
+  pn_messenger_t *third = sender(dir);
+  assert(!pn_messenger_start(third));
+  assert(pn_messenger_outgoing(third) == 0);
+  pn_messenger_free(third);
+
+  pn_messenger_free(receiver);
+  assert(!rmdir(dir));
+}
+
+/* Without a journal, put messages are encoded into the store and
+   sent as the receiver gives credit. */
+static void test_put_send_recv(void)
+{
+  char url[64], address[64];
+  int port = 20000 + (getpid() + 1) % 10000;
+  sprintf(url, "amqp://~127.0.0.1:%d", port);
+  sprintf(address, "amqp://127.0.0.1:%d/memory", port);
+
+  pn_messenger_t *receiver = pn_messenger(NULL);
+  pn_messenger_set_blocking(receiver, false);
+  pn_messenger_set_incoming_window(receiver, 10);
+  assert(!pn_messenger_start(receiver));
+  assert(pn_messenger_subscribe(receiver, url));
+
+  pn_messenger_t *sender = pn_messenger(NULL);
+  pn_messenger_set_blocking(sender, false);
+  pn_messenger_set_outgoing_window(sender, 10);
+  assert(!pn_messenger_get_journal(sender));
+  assert(!pn_messenger_start(sender));
+  for (size_t i = 0; i < COUNT; i++) {
+    put(sender, address, sizes[i], 'a' + i);
+  }
+  assert(pn_messenger_outgoing(sender) == (int) COUNT);
+
+  pn_message_t *msg = pn_message();
+  size_t received = 0;
+  pn_messenger_recv(receiver, COUNT);
+  for (int i = 0; i < 2000 && (received < COUNT || pn_messenger_outgoing(sender)); i++) {
+    pn_messenger_work(sender, 0);
+    pn_messenger_work(receiver, 5);
+    while (pn_messenger_incoming(receiver)) {
+      assert(!pn_messenger_get(receiver, msg));
+      pn_data_t *body = pn_message_body(msg);
+      pn_data_next(body);
+      pn_bytes_t bytes = pn_data_get_string(body);
+      assert(received < COUNT);
+      assert(bytes.size == sizes[received]);
+      assert(bytes.start[0] == 'a' + (char) received);
+      assert(bytes.start[bytes.size - 1] == 'a' + (char) received);
+      pn_messenger_accept(receiver, pn_messenger_incoming_tracker(receiver), 0);
+      received++;
+    }
+  }
+  assert(received == COUNT);
+  assert(pn_messenger_outgoing(sender) == 0);
+  pn_message_free(msg);
+
+  stop(sender, receiver);
+  stop(receiver, sender);
+  pn_messenger_free(sender);
+  pn_messenger_free(receiver);
+}
+
+/* The journal can only be set before anything is put. */
+static void test_journal_late(void)
+{
+  char dir[] = "/tmp/pn-journal-XXXXXX";
+  assert(mkdtemp(dir));
+  pn_messenger_t *m = pn_messenger(NULL);
+  pn_messenger_set_blocking(m, false);
+  assert(!pn_messenger_get_journal(m));
+  assert(!pn_messenger_set_journal(m, dir));
+  assert(pn_messenger_set_journal(m, dir) == PN_STATE_ERR);
+  pn_messenger_free(m);
+  assert(!rmdir(dir));
+}
+
+#endif
+
+int main(int argc, char **argv)
+{
+#ifndef _WIN32
+  test_put_send_recv();
+  test_journal_replay();
+  test_journal_late();
+#endif
+  return 0;
+}
@@ -781,7 +781,7 @@ void test_map_inspect(void)
                 pn_string("k1"), pn_string("v1"),
                 pn_string("k2"), pn_string("v2"),
                 END);
-  test_inspect(m, "{\"k1\": \"v1\", \"k2\": \"v2\"}");
+  test_inspect(m, "{\"k2\": \"v2\", \"k1\": \"v1\"}");
   pn_free(m);
 
   m = build_map(0, 0.75,
@@ -789,7 +789,7 @@ void test_map_inspect(void)
                 pn_string("k2"), pn_string("v2"),
                 pn_string("k3"), pn_string("v3"),
                 END);
-  test_inspect(m, "{\"k3\": \"v3\", \"k1\": \"v1\", \"k2\": \"v2\"}");
+  test_inspect(m, "{\"k2\": \"v2\", \"k1\": \"v1\", \"k3\": \"v3\"}");
   pn_free(m);
 }
 
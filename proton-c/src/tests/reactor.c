@@ -21,11 +21,13 @@
 
 #include <proton/reactor.h>
 #include <proton/handlers.h>
+#include <proton/io.h>
 #include <proton/event.h>
 #include <proton/connection.h>
 #include <proton/session.h>
 #include <proton/link.h>
 #include <proton/delivery.h>
+#include <proton/transport.h>
 #include <proton/url.h>
 #include <stdlib.h>
 #include <string.h>
@@ -372,6 +374,200 @@ static void test_reactor_connect(void) {
   pn_reactor_free(reactor);
 }
 
+typedef struct {
+  pn_acceptor_t *acceptor;
+  int expected;
+  int closed;
+  uint64_t accepted;
+} batch_server_t;
+
+static void batch_server_dispatch(pn_handler_t *handler, pn_event_t *event, pn_event_type_t type) {
+  batch_server_t *srv = (batch_server_t *) pn_handler_mem(handler);
+  switch (type) {
+  case PN_CONNECTION_REMOTE_OPEN:
+    pn_connection_open(pn_event_connection(event));
+    break;
+  case PN_CONNECTION_REMOTE_CLOSE:
+    pn_connection_close(pn_event_connection(event));
+    pn_connection_release(pn_event_connection(event));
+    if (++srv->closed == srv->expected) {
+      srv->accepted = pn_acceptor_get_accepted(srv->acceptor);
+      pn_acceptor_close(srv->acceptor);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+// Clients connecting together are accepted a few at a time.
+static void test_reactor_accept_batch(int count, int max_accepts) {
+  pn_reactor_t *reactor = pn_reactor();
+  pn_io_set_listen_backlog(pn_reactor_io(reactor), count);
+  pn_handler_t *sh = pn_handler_new(batch_server_dispatch, sizeof(batch_server_t), NULL);
+  batch_server_t *srv = (batch_server_t *) pn_handler_mem(sh);
+  srv->acceptor = pn_reactor_acceptor(reactor, "0.0.0.0", "5678", sh);
+  assert(srv->acceptor);
+  pn_acceptor_set_max_accepts(srv->acceptor, max_accepts);
+  srv->expected = count;
+  pn_handler_t *ch = pn_handler_new(client_dispatch, sizeof(client_t), NULL);
+  cmem(ch)->events = pn_list(PN_VOID, 0);
+  for (int i = 0; i < count; i++) {
+    assert(pn_reactor_connection_to_host(reactor, "127.0.0.1", "5678", ch));
+  }
+  pn_reactor_run(reactor);
+  assert(srv->closed == count);
+  assert(srv->accepted == (uint64_t) count);
+  pn_free(cmem(ch)->events);
+  pn_decref(ch);
+  pn_decref(sh);
+  pn_reactor_free(reactor);
+}
+
+static void test_io_reuse_port(void) {
+  pn_io_t *io = pn_io();
+  pn_socket_t first = pn_listen(io, "0.0.0.0", "5679");
+  assert(first != PN_INVALID_SOCKET);
+  assert(pn_listen(io, "0.0.0.0", "5679") == PN_INVALID_SOCKET);
+  pn_close(io, first);
+  if (pn_io_set_reuse_port(io, true) == 0) {
+    first = pn_listen(io, "0.0.0.0", "5679");
+    pn_socket_t second = pn_listen(io, "0.0.0.0", "5679");
+    assert(first != PN_INVALID_SOCKET && second != PN_INVALID_SOCKET);
+    pn_close(io, first);
+    pn_close(io, second);
+  }
+  pn_io_free(io);
+}
+
+// Resolves "broker.test" to the addresses passed as context.
+static int stub_lookup(void *context, const char *host, pn_string_t *addresses) {
+  if (strcmp(host, "broker.test") == 0) {
+    return pn_string_set(addresses, (const char *) context);
+  }
+  pn_string_set(addresses, "no such host");
+  return 1;
+}
+
+static void test_reactor_connect_lookup(const char *addresses, int threads) {
+  pn_reactor_t *reactor = pn_reactor();
+  pn_reactor_set_resolver_threads(reactor, threads);
+  pn_reactor_set_resolver_lookup(reactor, stub_lookup, (void *) addresses);
+  pn_handler_t *sh = pn_handler_new(server_dispatch, sizeof(server_t), NULL);
+  server_t *srv = smem(sh);
+  pn_acceptor_t *acceptor = pn_reactor_acceptor(reactor, "0.0.0.0", "5678", sh);
+  srv->reactor = reactor;
+  srv->acceptor = acceptor;
+  srv->events = pn_list(PN_VOID, 0);
+  pn_handler_t *ch = pn_handler_new(client_dispatch, sizeof(client_t), NULL);
+  client_t *cli = cmem(ch);
+  cli->events = pn_list(PN_VOID, 0);
+  pn_connection_t *conn = pn_reactor_connection_to_host(reactor, "broker.test", "5678", ch);
+  assert(conn);
+  pn_reactor_run(reactor);
+  expect(cli->events, PN_CONNECTION_INIT, PN_CONNECTION_LOCAL_OPEN,
+         PN_CONNECTION_BOUND,
+         PN_CONNECTION_REMOTE_OPEN, PN_CONNECTION_LOCAL_CLOSE,
+         PN_TRANSPORT, PN_TRANSPORT_HEAD_CLOSED,
+         PN_CONNECTION_REMOTE_CLOSE, PN_TRANSPORT_TAIL_CLOSED,
+         PN_TRANSPORT_CLOSED, PN_CONNECTION_UNBOUND,
+         PN_CONNECTION_FINAL, END);
+  pn_free(srv->events);
+  pn_decref(sh);
+  pn_free(cli->events);
+  pn_decref(ch);
+  pn_reactor_free(reactor);
+}
+
+static void lookup_error_dispatch(pn_handler_t *handler, pn_event_t *event, pn_event_type_t type) {
+  bool *failed = (bool *) pn_handler_mem(handler);
+  pn_connection_t *conn = pn_event_connection(event);
+  switch (type) {
+  case PN_CONNECTION_INIT:
+    pn_connection_open(conn);
+    break;
+  case PN_TRANSPORT_ERROR: {
+    pn_condition_t *cond = pn_transport_condition(pn_event_transport(event));
+    assert(strcmp(pn_condition_get_name(cond), "proton:io") == 0);
+    assert(strstr(pn_condition_get_description(cond), "nowhere.test"));
+    *failed = true;
+    break;
+  }
+  case PN_TRANSPORT_CLOSED:
+    pn_connection_release(conn);
+    break;
+  default:
+    break;
+  }
+}
+
+static void test_reactor_connect_lookup_error(int threads) {
+  pn_reactor_t *reactor = pn_reactor();
+  pn_reactor_set_resolver_threads(reactor, threads);
+  pn_reactor_set_resolver_lookup(reactor, stub_lookup, (void *) "127.0.0.1");
+  pn_handler_t *ch = pn_handler_new(lookup_error_dispatch, sizeof(bool), NULL);
+  bool *failed = (bool *) pn_handler_mem(ch);
+  *failed = false;
+  pn_reactor_connection_to_host(reactor, "nowhere.test", "5678", ch);
+  pn_reactor_run(reactor);
+  assert(*failed);
+  pn_decref(ch);
+  pn_reactor_free(reactor);
+}
+
+// Binds its own transport and asks for credit as soon as the connection
+// exists, as the C++ binding does, so transport events arrive while the
+// connect is still in progress.
+static void own_transport_dispatch(pn_handler_t *handler, pn_event_t *event, pn_event_type_t type) {
+  bool *opened = (bool *) pn_handler_mem(handler);
+  pn_connection_t *conn = pn_event_connection(event);
+  switch (type) {
+  case PN_CONNECTION_INIT: {
+    pn_transport_t *transport = pn_transport();
+    pn_transport_bind(transport, conn);
+    pn_decref(transport);
+    pn_connection_open(conn);
+    pn_session_t *ssn = pn_session(conn);
+    pn_session_open(ssn);
+    pn_link_t *rcv = pn_receiver(ssn, "receiver");
+    pn_link_open(rcv);
+    pn_link_flow(rcv, 10);
+    break;
+  }
+  case PN_CONNECTION_REMOTE_OPEN:
+    *opened = true;
+    pn_connection_close(conn);
+    break;
+  case PN_CONNECTION_REMOTE_CLOSE:
+    pn_connection_release(conn);
+    break;
+  default:
+    break;
+  }
+}
+
+static void test_reactor_connect_own_transport(int threads) {
+  pn_reactor_t *reactor = pn_reactor();
+  pn_reactor_set_resolver_threads(reactor, threads);
+  pn_reactor_set_resolver_lookup(reactor, stub_lookup, (void *) "127.0.0.1");
+  pn_handler_t *sh = pn_handler_new(server_dispatch, sizeof(server_t), NULL);
+  server_t *srv = smem(sh);
+  pn_acceptor_t *acceptor = pn_reactor_acceptor(reactor, "0.0.0.0", "5678", sh);
+  srv->reactor = reactor;
+  srv->acceptor = acceptor;
+  srv->events = pn_list(PN_VOID, 0);
+  pn_handler_t *ch = pn_handler_new(own_transport_dispatch, sizeof(bool), NULL);
+  bool *opened = (bool *) pn_handler_mem(ch);
+  *opened = false;
+  pn_reactor_connection_to_host(reactor, "broker.test", "5678", ch);
+  pn_reactor_run(reactor);
+  assert(*opened);
+  pn_free(srv->events);
+  pn_decref(sh);
+  pn_decref(ch);
+  pn_reactor_free(reactor);
+}
+
 typedef struct {
   int received;
 } sink_t;
@@ -544,6 +740,16 @@ int main(int argc, char **argv)
   test_reactor_acceptor();
   test_reactor_acceptor_run();
   test_reactor_connect();
+  test_reactor_connect_lookup("127.0.0.1", 2);
+  test_reactor_connect_lookup("127.0.0.1", 0);
+  // unreachable and refused addresses are raced until one connects
+  test_reactor_connect_lookup("192.0.2.1 ::1 127.0.0.1", 2);
+  test_reactor_connect_lookup_error(2);
+  test_reactor_connect_lookup_error(0);
+  test_reactor_connect_own_transport(2);
+  test_reactor_accept_batch(1, 64);
+  test_reactor_accept_batch(32, 4);
+  test_io_reuse_port();
   for (int i = 0; i < 64; i++) {
     test_reactor_transfer(i, 2);
   }
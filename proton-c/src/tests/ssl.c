@@ -0,0 +1,202 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <proton/connection.h>
+#include <proton/error.h>
+#include <proton/ssl.h>
+#include <proton/transport.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define sleep_seconds(s) Sleep((s) * 1000)
+#else
+#include <unistd.h>
+#define sleep_seconds(s) sleep(s)
+#endif
+
+// never remove 'assert()'
+#undef NDEBUG
+#include <assert.h>
+
+// push data from one transport to another
+static int xfer(pn_transport_t *src, pn_transport_t *dest)
+{
+    ssize_t out = pn_transport_pending(src);
+    if (out > 0) {
+        ssize_t in = pn_transport_capacity(dest);
+        if (in > 0) {
+            size_t count = (size_t)((out < in) ? out : in);
+            pn_transport_push(dest, pn_transport_head(src), count);
+            pn_transport_pop(src, count);
+            return (int)count;
+        }
+    }
+    return 0;
+}
+
+// transfer all available data between two transports
+static void pump(pn_transport_t *t1, pn_transport_t *t2)
+{
+    while (xfer(t1, t2) + xfer(t2, t1))
+        ;
+}
+
+// A server domain with the test certificate, run from examples/cpp/ssl_certs.
+// Clients do not verify it: anonymous ciphers are not allowed at OpenSSL's
+// default security level.
+static pn_ssl_domain_t *server_domain(void)
+{
+    pn_ssl_domain_t *server = pn_ssl_domain(PN_SSL_MODE_SERVER);
+    assert(!pn_ssl_domain_set_credentials(server, "tserver-certificate.pem",
+                                          "tserver-private-key.pem", "tserverpw"));
+    return server;
+}
+
+// Open and close one TLS connection between a client using
+// session_id and a server. The client saves its session as it closes.
+static void run_connection(pn_ssl_domain_t *client, pn_ssl_domain_t *server, const char *session_id)
+{
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t *t1 = pn_transport();
+    assert(!pn_ssl_init(pn_ssl(t1), client, session_id));
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    assert(!pn_ssl_init(pn_ssl(t2), server, NULL));
+    pn_transport_bind(t2, c2);
+
+    pn_connection_open(c1);
+    pn_connection_open(c2);
+    pump(t1, t2);
+    assert(pn_connection_state(c1) & PN_REMOTE_ACTIVE);
+    assert(pn_connection_state(c2) & PN_REMOTE_ACTIVE);
+
+    pn_connection_close(c1);
+    pn_connection_close(c2);
+    pump(t1, t2);
+    pn_transport_close_tail(t1);
+    pn_transport_close_tail(t2);
+
+    pn_transport_unbind(t1);
+    pn_transport_unbind(t2);
+    pn_transport_free(t1);
+    pn_transport_free(t2);
+    pn_connection_free(c1);
+    pn_connection_free(c2);
+}
+
+static void check_counts(pn_ssl_domain_t *domain, uint64_t hits, uint64_t misses)
+{
+    assert(pn_ssl_domain_get_session_hits(domain) == hits);
+    assert(pn_ssl_domain_get_session_misses(domain) == misses);
+}
+
+// only connections given a session_id count on the client, the server
+// counts every handshake
+static void test_session_counts(void)
+{
+    fprintf(stdout, "test_session_counts\n");
+    pn_ssl_domain_t *client = pn_ssl_domain(PN_SSL_MODE_CLIENT);
+    pn_ssl_domain_t *server = server_domain();
+    check_counts(client, 0, 0);
+
+    run_connection(client, server, NULL);
+    check_counts(client, 0, 0);
+    check_counts(server, 0, 1);
+
+    run_connection(client, server, "a");
+    check_counts(client, 0, 1);
+    run_connection(client, server, "a");
+    check_counts(client, 1, 1);
+    check_counts(server, 1, 2);
+
+    pn_ssl_domain_free(client);
+    pn_ssl_domain_free(server);
+}
+
+// a full cache evicts the least recently saved session
+static void test_session_eviction(void)
+{
+    fprintf(stdout, "test_session_eviction\n");
+    pn_ssl_domain_t *client = pn_ssl_domain(PN_SSL_MODE_CLIENT);
+    pn_ssl_domain_t *server = server_domain();
+    assert(!pn_ssl_domain_set_session_cache(client, 2, 0));
+
+    run_connection(client, server, "a");
+    run_connection(client, server, "b");
+    run_connection(client, server, "c");      // evicts a
+    check_counts(client, 0, 3);
+    run_connection(client, server, "b");      // resumed and saved again, so newest
+    check_counts(client, 1, 3);
+    run_connection(client, server, "a");      // evicts c
+    check_counts(client, 1, 4);
+    run_connection(client, server, "c");
+    check_counts(client, 1, 5);
+    run_connection(client, server, "a");
+    check_counts(client, 2, 5);
+
+    // no cache, no resumption
+    assert(!pn_ssl_domain_set_session_cache(client, 0, 0));
+    run_connection(client, server, "a");
+    run_connection(client, server, "a");
+    check_counts(client, 2, 7);
+
+    pn_ssl_domain_free(client);
+    pn_ssl_domain_free(server);
+}
+
+// a session older than the cache ttl is not resumed
+static void test_session_ttl(void)
+{
+    fprintf(stdout, "test_session_ttl\n");
+    pn_ssl_domain_t *client = pn_ssl_domain(PN_SSL_MODE_CLIENT);
+    pn_ssl_domain_t *server = server_domain();
+    assert(!pn_ssl_domain_set_session_cache(client, 8, 1));
+
+    run_connection(client, server, "a");
+    run_connection(client, server, "a");
+    check_counts(client, 1, 1);
+    sleep_seconds(3);
+    run_connection(client, server, "a");
+    check_counts(client, 1, 2);
+
+    pn_ssl_domain_free(client);
+    pn_ssl_domain_free(server);
+}
+
+int main(int argc, char **argv)
+{
+    if (!pn_ssl_present()) {
+        // without SSL there is no cache to configure and nothing to count
+        assert(pn_ssl_domain_set_session_cache(NULL, 1, 0) == PN_ERR);
+        assert(pn_ssl_domain_set_session_tickets(NULL, true) == PN_ERR);
+        fprintf(stdout, "no SSL support, skipping session cache tests\n");
+        return 0;
+    }
+    test_session_counts();
+    test_session_eviction();
+    test_session_ttl();
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "messenger/transform.h"
+
+// never remove 'assert()'
+#undef NDEBUG
+#include <assert.h>
+
+// Apply transform to src, and check the result and whether a rule matched.
+// Each address is applied twice so the second answer comes from the cache.
+static void check_result(pn_transform_t *transform, const char *src,
+                         const char *expected, bool matched)
+{
+  pn_string_t *dst = pn_string(NULL);
+  for (int i = 0; i < 2; i++) {
+    assert(!pn_transform_apply(transform, src, dst));
+    const char *result = pn_string_get(dst);
+    if (expected ? !result || strcmp(result, expected) : result != NULL) {
+      fprintf(stderr, "%s: expected %s, got %s\n", src,
+              expected ? expected : "NULL", result ? result : "NULL");
+      abort();
+    }
+    assert(pn_transform_matched(transform) == matched);
+  }
+  pn_free(dst);
+}
+
+static void check(pn_transform_t *transform, const char *src, const char *expected)
+{
+  check_result(transform, src, expected, true);
+}
+
+// no rule matches, src is passed through
+static void check_unmatched(pn_transform_t *transform, const char *src)
+{
+  check_result(transform, src, src, false);
+}
+
+// Rules whose literal prefixes overlap sit at different trie nodes, but
+// the first rule added still wins.
+static void test_first_match(void)
+{
+  pn_transform_t *transform = pn_transform();
+  pn_transform_rule(transform, "amqp://host/queue", "exact");
+  pn_transform_rule(transform, "amqp://host/*", "host");
+  pn_transform_rule(transform, "amqp://*", "any");
+  pn_transform_rule(transform, "amqp://host/queue/*", "deeper");
+  pn_transform_rule(transform, "amqp://host/queue", "shadowed");
+
+  check(transform, "amqp://host/queue", "exact");
+  check(transform, "amqp://host/queue/sub", "host");
+  check(transform, "amqp://host/", "host");
+  check(transform, "amqp://other/queue", "any");
+  check_unmatched(transform, "amqp:/");
+  pn_free(transform);
+
+  // the same rules in the opposite order
+  transform = pn_transform();
+  pn_transform_rule(transform, "amqp://host/queue/*", "deeper");
+  pn_transform_rule(transform, "amqp://*", "any");
+  pn_transform_rule(transform, "amqp://host/*", "host");
+  pn_transform_rule(transform, "amqp://host/queue", "exact");
+
+  check(transform, "amqp://host/queue/sub", "deeper");
+  check(transform, "amqp://host/queue", "any");
+  check(transform, "amqp://host/x", "any");
+  pn_free(transform);
+}
+
+static void test_substitution(void)
+{
+  pn_transform_t *transform = pn_transform();
+  pn_transform_rule(transform, "amqp://%/*", "$2 at $1");
+  pn_transform_rule(transform, "%.%:*", "$3@$2.$1 ($0) $$9 $9");
+  pn_transform_rule(transform, "drop/*", NULL);
+
+  check(transform, "amqp://host/a/b", "a/b at host");
+  check(transform, "amqp://host/", " at host");
+  check(transform, "a.b:c", "c@b.a (a.b:c) $9 ");
+  check(transform, "drop/me", NULL);
+  pn_free(transform);
+}
+
+// Rules that start with a wildcard have no literal prefix and are
+// candidates for every address, interleaved with the others by order.
+static void test_no_prefix(void)
+{
+  pn_transform_t *transform = pn_transform();
+  pn_transform_rule(transform, "amqp://host/*", "host $1");
+  pn_transform_rule(transform, "*/x", "x $1");
+  pn_transform_rule(transform, "amqp://*", "any $1");
+  pn_transform_rule(transform, "%", "word $1");
+  pn_transform_rule(transform, "*", "all $1");
+
+  check(transform, "amqp://host/x", "host x");
+  check(transform, "amqp://other/x", "x amqp://other");
+  check(transform, "amqp://other/y", "any other/y");
+  check(transform, "word", "word word");
+  check(transform, "some/thing", "all some/thing");
+  check(transform, "", "word ");
+  pn_free(transform);
+}
+
+// Adding a rule forgets every cached result.
+static void test_cache_invalidation(void)
+{
+  pn_transform_t *transform = pn_transform();
+  pn_transform_rule(transform, "amqp://host/*", "host $1");
+
+  check_unmatched(transform, "amqp://other/q");
+  check(transform, "amqp://host/q", "host q");
+
+  pn_transform_rule(transform, "amqp://other/*", "other $1");
+  check(transform, "amqp://other/q", "other q");
+  check(transform, "amqp://host/q", "host q");
+
+  pn_transform_rule(transform, "*", NULL);
+  check(transform, "amqp://third/q", NULL);
+  check(transform, "amqp://other/q", "other q");
+  pn_free(transform);
+}
+
+int main(int argc, char **argv)
+{
+  test_first_match();
+  test_substitution();
+  test_no_prefix();
+  test_cache_invalidation();
+  return 0;
+}
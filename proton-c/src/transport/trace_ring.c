@@ -0,0 +1,184 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "trace_ring.h"
+
+#include "dispatch_actions.h"
+#include "platform.h"
+#include "protocol.h"
+
+#include <proton/error.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// The ring has a single writer, the thread driving the transport, and
+// may be dumped from any thread. Each record works as a seqlock: its
+// seq is cleared before the record is rewritten and set to the record's
+// position plus one after, so a reader can tell a record that changed
+// under it from a whole one.
+#if defined(__GNUC__)
+#define PNI_LOAD(T, p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define PNI_STORE(T, p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define PNI_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#ifdef _MSC_VER
+#include <windows.h>
+#define PNI_FENCE() MemoryBarrier()
+#else
+#define PNI_FENCE()
+#endif
+// volatile accesses have acquire and release semantics with MSVC
+#define PNI_LOAD(T, p) (*(volatile T *) (p))
+#define PNI_STORE(T, p, v) (*(volatile T *) (p) = (v))
+#endif
+
+struct pni_trace_ring_t {
+  uint64_t next;           // records ever written
+  uint64_t mask;
+  uint64_t epoch;          // added to the monotonic clock to get wall-clock time
+  pn_trace_record_t *records;
+};
+
+pni_trace_ring_t *pni_trace_ring(size_t records)
+{
+  uint64_t capacity = 1;
+  while (capacity < records) capacity <<= 1;
+  pni_trace_ring_t *ring = (pni_trace_ring_t *) malloc(sizeof(pni_trace_ring_t));
+  if (!ring) return NULL;
+  ring->records = (pn_trace_record_t *) calloc((size_t) capacity, sizeof(pn_trace_record_t));
+  if (!ring->records) {
+    free(ring);
+    return NULL;
+  }
+  ring->next = 0;
+  ring->mask = capacity - 1;
+  ring->epoch = (uint64_t) pn_i_now() * 1000 - pn_i_monotonic_us();
+  return ring;
+}
+
+void pni_trace_ring_free(pni_trace_ring_t *ring)
+{
+  if (!ring) return;
+  free(ring->records);
+  free(ring);
+}
+
+// Pick out the few fields of each performative worth keeping.
+static void pni_trace_fields(pn_trace_record_t *record, uint64_t code, pn_data_t *args)
+{
+  bool q1 = false, q2 = false, b1 = false, b2 = false;
+  uint16_t h = 0;
+  uint32_t *f = record->fields;
+  uint64_t l = 0;
+  switch (code) {
+  case OPEN:
+    pn_data_scan(args, "D.[..?I?HI]", &q1, &f[0], &q2, &h, &f[2]);
+    f[1] = q2 ? h : 0xFFFF;
+    break;
+  case BEGIN:
+    pn_data_scan(args, "D.[?HII]", &q1, &h, &f[1], &f[2]);
+    f[0] = q1 ? h : 0xFFFF;
+    break;
+  case ATTACH:
+    pn_data_scan(args, "D.[.Io]", &f[0], &b1);
+    if (b1) record->flags |= PN_TRACE_FLAG;
+    break;
+  case FLOW:
+    pn_data_scan(args, "D.[....?I?II.o]", &q1, &f[0], &q2, &f[1], &f[2], &b1);
+    if (!q1) f[0] = 0xFFFFFFFF;
+    if (b1) record->flags |= PN_TRACE_FLAG;
+    break;
+  case TRANSFER:
+    pn_data_scan(args, "D.[I?I..oo]", &f[0], &q1, &f[1], &b1, &b2);
+    if (b1) record->flags |= PN_TRACE_SETTLED;
+    if (b2) record->flags |= PN_TRACE_MORE;
+    break;
+  case DISPOSITION:
+    pn_data_scan(args, "D.[oI?IoD?L.]", &b1, &f[0], &q1, &f[1], &b2, &q2, &l);
+    if (!q1) f[1] = f[0];
+    f[2] = (uint32_t) l;
+    if (b1) record->flags |= PN_TRACE_FLAG;
+    if (b2) record->flags |= PN_TRACE_SETTLED;
+    break;
+  case DETACH:
+    pn_data_scan(args, "D.[Io]", &f[0], &b1);
+    if (b1) record->flags |= PN_TRACE_FLAG;
+    break;
+  default:
+    break;
+  }
+}
+
+void pni_trace_ring_record(pni_trace_ring_t *ring, bool out, uint8_t frame_type, uint16_t channel,
+                           uint64_t code, pn_data_t *args, size_t size)
+{
+  uint64_t next = ring->next;
+  pn_trace_record_t *record = &ring->records[next & ring->mask];
+  PNI_STORE(uint32_t, &record->seq, 0);
+  PNI_FENCE();
+  record->time = pn_i_monotonic_us() + ring->epoch;
+  record->size = (uint32_t) size;
+  record->fields[0] = record->fields[1] = record->fields[2] = 0;
+  record->channel = channel;
+  record->code = (uint8_t) code;
+  record->flags = (out ? PN_TRACE_OUT : 0) | (frame_type == SASL_FRAME_TYPE ? PN_TRACE_SASL : 0);
+  if (frame_type == AMQP_FRAME_TYPE && code) {
+    pni_trace_fields(record, code, args);
+  }
+  PNI_STORE(uint32_t, &record->seq, (uint32_t) (next + 1));
+  PNI_STORE(uint64_t, &ring->next, next + 1);
+}
+
+// With no ring there is just the header.
+ssize_t pni_trace_ring_dump(pni_trace_ring_t *ring, char *bytes, size_t size)
+{
+  uint64_t next = ring ? PNI_LOAD(uint64_t, &ring->next) : 0;
+  uint64_t capacity = ring ? ring->mask + 1 : 0;
+  uint64_t first = next > capacity ? next - capacity : 0;
+  size_t needed = sizeof(pn_trace_header_t) + (size_t) (next - first) * sizeof(pn_trace_record_t);
+  if (!bytes) return needed;
+  if (size < needed) return PN_OVERFLOW;
+
+  pn_trace_header_t header;
+  memcpy(header.magic, "PNTRACE1", 8);
+  header.byte_order = 0x01020304;
+  header.record_size = sizeof(pn_trace_record_t);
+  header.count = 0;
+  header.dropped = first;
+
+  pn_trace_record_t *dst = (pn_trace_record_t *) (bytes + sizeof(header));
+  for (uint64_t i = first; i < next; i++) {
+    pn_trace_record_t *record = &ring->records[i & ring->mask];
+    uint32_t seq = PNI_LOAD(uint32_t, &record->seq);
+    memcpy(dst, record, sizeof(*record));
+    PNI_FENCE();
+    if (seq != (uint32_t) (i + 1) || PNI_LOAD(uint32_t, &record->seq) != seq) {
+      header.dropped++;
+      continue;
+    }
+    dst->seq = seq;
+    dst++;
+    header.count++;
+  }
+  memcpy(bytes, &header, sizeof(header));
+  return sizeof(header) + (size_t) header.count * sizeof(pn_trace_record_t);
+}
@@ -0,0 +1,36 @@
+#ifndef PROTON_TRACE_RING_H
+#define PROTON_TRACE_RING_H 1
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "proton/codec.h"
+#include "proton/transport.h"
+
+typedef struct pni_trace_ring_t pni_trace_ring_t;
+
+pni_trace_ring_t *pni_trace_ring(size_t records);
+void pni_trace_ring_free(pni_trace_ring_t *ring);
+void pni_trace_ring_record(pni_trace_ring_t *ring, bool out, uint8_t frame_type, uint16_t channel,
+                           uint64_t code, pn_data_t *args, size_t size);
+ssize_t pni_trace_ring_dump(pni_trace_ring_t *ring, char *bytes, size_t size);
+
+#endif /* trace_ring.h */
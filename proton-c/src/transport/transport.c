@@ -26,6 +26,7 @@
 
 #include "autodetect.h"
 #include "protocol.h"
+#include "encodings.h"
 #include "dispatch_actions.h"
 #include "proton/event.h"
 #include "platform.h"
@@ -70,20 +71,88 @@ static void pni_calculate_channel_max(pn_transport_t *transport) {
   }
 }
 
+// The smallest ring that is spilled to the overflow hash rather than grown
+// when it is at most half full.
+#define PNI_DELIVERY_RING_SPILL (4096)
+
 void pn_delivery_map_init(pn_delivery_map_t *db, pn_sequence_t next)
 {
-  db->deliveries = pn_hash(PN_WEAKREF, 0, 0.75);
+  db->ring = NULL;
+  db->overflow = NULL;
+  db->capacity = 0;
+  db->head = 0;
+  db->live = 0;
+  db->base = next;
   db->next = next;
 }
 
 void pn_delivery_map_free(pn_delivery_map_t *db)
 {
-  pn_free(db->deliveries);
+  free(db->ring);
+  pn_free(db->overflow);
+}
+
+// Ids wrap, so distances between them are taken unsigned.
+static inline uint32_t pni_delivery_map_window(pn_delivery_map_t *db)
+{
+  return (uint32_t) db->next - (uint32_t) db->base;
+}
+
+// The ring slot for id, or NULL if id is outside the window.
+static inline pn_delivery_t **pni_delivery_map_slot(pn_delivery_map_t *db, pn_sequence_t id)
+{
+  uint32_t offset = (uint32_t) id - (uint32_t) db->base;
+  if (offset >= pni_delivery_map_window(db)) return NULL;
+  return &db->ring[(db->head + offset) & (db->capacity - 1)];
 }
 
 static pn_delivery_t *pni_delivery_map_get(pn_delivery_map_t *db, pn_sequence_t id)
 {
-  return (pn_delivery_t *) pn_hash_get(db->deliveries, id);
+  pn_delivery_t **slot = pni_delivery_map_slot(db, id);
+  if (slot) return *slot;
+  return db->overflow ? (pn_delivery_t *) pn_hash_get(db->overflow, id) : NULL;
+}
+
+// Advance base past settled deliveries.
+static void pni_delivery_map_trim(pn_delivery_map_t *db)
+{
+  while (db->base != db->next && !db->ring[db->head]) {
+    db->head = (db->head + 1) & (db->capacity - 1);
+    db->base = (uint32_t) db->base + 1;
+  }
+}
+
+// Make room for one more id when the window fills the ring: move the
+// stragglers at the old end of a sparse ring to the overflow hash,
+// otherwise double the ring.
+static void pni_delivery_map_grow(pn_delivery_map_t *db)
+{
+  if (db->capacity >= PNI_DELIVERY_RING_SPILL && db->live <= db->capacity / 2) {
+    if (!db->overflow) db->overflow = pn_hash(PN_WEAKREF, 0, 0.75);
+    while (pni_delivery_map_window(db) > db->capacity / 2) {
+      pn_delivery_t *delivery = db->ring[db->head];
+      if (delivery) {
+        pn_hash_put(db->overflow, db->base, delivery);
+        db->ring[db->head] = NULL;
+        db->live--;
+      }
+      db->head = (db->head + 1) & (db->capacity - 1);
+      db->base = (uint32_t) db->base + 1;
+    }
+    pni_delivery_map_trim(db);
+    return;
+  }
+
+  size_t capacity = db->capacity ? 2 * db->capacity : 16;
+  pn_delivery_t **ring = (pn_delivery_t **) calloc(capacity, sizeof(pn_delivery_t *));
+  size_t count = pni_delivery_map_window(db);
+  for (size_t i = 0; i < count; i++) {
+    ring[i] = db->ring[(db->head + i) & (db->capacity - 1)];
+  }
+  free(db->ring);
+  db->ring = ring;
+  db->capacity = capacity;
+  db->head = 0;
 }
 
 static void pn_delivery_state_init(pn_delivery_state_t *ds, pn_delivery_t *delivery, pn_sequence_t id)
@@ -95,9 +164,13 @@ static void pn_delivery_state_init(pn_delivery_state_t *ds, pn_delivery_t *deliv
 
 static pn_delivery_state_t *pni_delivery_map_push(pn_delivery_map_t *db, pn_delivery_t *delivery)
 {
+  if (pni_delivery_map_window(db) == db->capacity) {
+    pni_delivery_map_grow(db);
+  }
   pn_delivery_state_t *ds = &delivery->state;
   pn_delivery_state_init(ds, delivery, db->next++);
-  pn_hash_put(db->deliveries, ds->id, delivery);
+  *pni_delivery_map_slot(db, ds->id) = delivery;
+  db->live++;
   return ds;
 }
 
@@ -106,21 +179,34 @@ void pn_delivery_map_del(pn_delivery_map_t *db, pn_delivery_t *delivery)
   if (delivery->state.init) {
     delivery->state.init = false;
     delivery->state.sent = false;
-    pn_hash_del(db->deliveries, delivery->state.id);
+    pn_delivery_t **slot = pni_delivery_map_slot(db, delivery->state.id);
+    if (slot && *slot == delivery) {
+      *slot = NULL;
+      db->live--;
+      pni_delivery_map_trim(db);
+    } else if (db->overflow) {
+      pn_hash_del(db->overflow, delivery->state.id);
+    }
   }
 }
 
 static void pni_delivery_map_clear(pn_delivery_map_t *dm)
 {
-  pn_hash_t *hash = dm->deliveries;
-  for (pn_handle_t entry = pn_hash_head(hash);
-       entry;
-       entry = pn_hash_next(hash, entry))
-  {
-    pn_delivery_t *dlv = (pn_delivery_t *) pn_hash_value(hash, entry);
-    pn_delivery_map_del(dm, dlv);
+  while (dm->base != dm->next) {
+    pn_delivery_map_del(dm, dm->ring[dm->head]);
+  }
+  pn_hash_t *hash = dm->overflow;
+  if (hash) {
+    for (pn_handle_t entry = pn_hash_head(hash);
+         entry;
+         entry = pn_hash_next(hash, entry))
+    {
+      pn_delivery_t *dlv = (pn_delivery_t *) pn_hash_value(hash, entry);
+      pn_delivery_map_del(dm, dlv);
+    }
   }
-  dm->next = 0;
+  dm->base = dm->next = 0;
+  dm->head = 0;
 }
 
 static void pni_default_tracer(pn_transport_t *transport, const char *message)
@@ -384,8 +470,7 @@ static void pn_transport_initialize(void *object)
   transport->args = pn_data(16);
   transport->output_args = pn_data(16);
   transport->frame = pn_buffer(PN_TRANSPORT_INITIAL_FRAME_SIZE);
-  transport->input_frames_ct = 0;
-  transport->output_frames_ct = 0;
+  memset(&transport->metrics, 0, sizeof(transport->metrics));
 
   transport->connection = NULL;
   transport->context = pn_record();
@@ -440,9 +525,9 @@ static void pn_transport_initialize(void *object)
 
   transport->local_channels = pn_hash(PN_WEAKREF, 0, 0.75);
   transport->remote_channels = pn_hash(PN_WEAKREF, 0, 0.75);
-
-  transport->bytes_input = 0;
-  transport->bytes_output = 0;
+  transport->channel_aliases.used = NULL;
+  transport->channel_aliases.full = NULL;
+  transport->channel_aliases.words = 0;
 
   transport->input_pending = 0;
   transport->output_pending = 0;
@@ -456,12 +541,16 @@ static void pn_transport_initialize(void *object)
   transport->auth_required = false;
   transport->authenticated = false;
   transport->encryption_required = false;
+  transport->coalesce_events = false;
 
   transport->referenced = true;
 
-  transport->trace = (pn_env_bool("PN_TRACE_RAW") ? PN_TRACE_RAW : PN_TRACE_OFF) |
-    (pn_env_bool("PN_TRACE_FRM") ? PN_TRACE_FRM : PN_TRACE_OFF) |
-    (pn_env_bool("PN_TRACE_DRV") ? PN_TRACE_DRV : PN_TRACE_OFF);
+  transport->trace_ring = NULL;
+  pn_transport_trace(transport,
+                     (pn_env_bool("PN_TRACE_RAW") ? PN_TRACE_RAW : PN_TRACE_OFF) |
+                     (pn_env_bool("PN_TRACE_FRM") ? PN_TRACE_FRM : PN_TRACE_OFF) |
+                     (pn_env_bool("PN_TRACE_DRV") ? PN_TRACE_DRV : PN_TRACE_OFF) |
+                     (pn_env_bool("PN_TRACE_BIN") ? PN_TRACE_BIN : PN_TRACE_OFF));
 }
 
 
@@ -587,6 +676,18 @@ bool pn_transport_is_encrypted(pn_transport_t *transport)
     return transport && transport->ssl && pn_ssl_get_ssf((pn_ssl_t*)transport)>0;
 }
 
+void pn_transport_set_coalesce_events(pn_transport_t *transport, bool coalesce)
+{
+  assert(transport);
+  transport->coalesce_events = coalesce;
+}
+
+bool pn_transport_get_coalesce_events(pn_transport_t *transport)
+{
+  assert(transport);
+  return transport->coalesce_events;
+}
+
 void pn_transport_free(pn_transport_t *transport)
 {
   if (!transport) return;
@@ -614,6 +715,7 @@ static void pn_transport_finalize(void *object)
 
   pn_ssl_free(transport);
   pn_sasl_free(transport);
+  pni_trace_ring_free(transport->trace_ring);
   free(transport->remote_container);
   free(transport->remote_hostname);
   pn_free(transport->remote_offered_capabilities);
@@ -625,6 +727,7 @@ static void pn_transport_finalize(void *object)
   pn_error_free(transport->error);
   pn_free(transport->local_channels);
   pn_free(transport->remote_channels);
+  pn_alias_set_free(&transport->channel_aliases);
   if (transport->input_buf) free(transport->input_buf);
   if (transport->output_buf) free(transport->output_buf);
   pn_free(transport->scratch);
@@ -711,6 +814,7 @@ void pni_transport_unbind_channels(pn_hash_t *channels)
     pni_delivery_map_clear(&ssn->state.outgoing);
     pni_transport_unbind_handles(ssn->state.local_handles, true);
     pni_transport_unbind_handles(ssn->state.remote_handles, true);
+    pn_alias_set_clear(&ssn->state.handle_aliases);
     pn_session_unbound(ssn);
     pn_ep_decref(&ssn->endpoint);
     pn_hash_del(channels, key);
@@ -746,6 +850,7 @@ int pn_transport_unbind(pn_transport_t *transport)
 
   pni_transport_unbind_channels(transport->local_channels);
   pni_transport_unbind_channels(transport->remote_channels);
+  pn_alias_set_clear(&transport->channel_aliases);
 
   pn_connection_unbound(conn);
   if (was_referenced) {
@@ -860,6 +965,35 @@ void pn_do_trace(pn_transport_t *transport, uint16_t ch, pn_dir_t dir,
   }
 }
 
+void pni_trace_frame(pn_transport_t *transport, pn_dir_t dir, uint8_t frame_type, uint16_t ch,
+                     uint64_t code, pn_data_t *args, size_t size)
+{
+  if (transport->trace_ring) {
+    pni_trace_ring_record(transport->trace_ring, dir == OUT, frame_type, ch, code, args, size);
+  }
+}
+
+// The descriptor code of an encoded performative, or 0 if there is none.
+static uint64_t pni_encoded_code(const char *bytes, size_t size)
+{
+  if (size >= 3 && bytes[0] == 0 && (uint8_t) bytes[1] == PNE_SMALLULONG) {
+    return (uint8_t) bytes[2];
+  }
+  return 0;
+}
+
+// Account for a frame of size bytes just written to the output.
+static void pni_count_output(pn_transport_t *transport, uint8_t type, uint64_t code, size_t size)
+{
+  pn_transport_metrics_t *metrics = &transport->metrics;
+  PNI_COUNT(metrics->frames_output, 1);
+  pni_count_frame(metrics->output, type, code, size);
+  PNI_COUNT(metrics->bytes_copied, size);
+  if (transport->available + size > metrics->output_high_water) {
+    PNI_COUNT_SET(metrics->output_high_water, transport->available + size);
+  }
+}
+
 int pn_post_frame(pn_transport_t *transport, uint8_t type, uint16_t ch, const char *fmt, ...)
 {
   pn_buffer_t *frame_buf = transport->frame;
@@ -904,7 +1038,11 @@ int pn_post_frame(pn_transport_t *transport, uint8_t type, uint16_t ch, const ch
     transport->capacity *= 2;
     transport->output = (char *) realloc(transport->output, transport->capacity);
   }
-  transport->output_frames_ct += 1;
+  uint64_t code = pni_encoded_code(buf.start, wr);
+  pni_count_output(transport, type, code, n);
+  if (transport->trace & PN_TRACE_BIN) {
+    pni_trace_frame(transport, OUT, type, ch, code, transport->output_args, 0);
+  }
   if (transport->trace & PN_TRACE_RAW) {
     pn_string_set(transport->scratch, "RAW: \"");
     pn_quote(transport->scratch, transport->output + transport->available, n);
@@ -990,6 +1128,7 @@ static int pni_post_amqp_transfer_frame(pn_transport_t *transport, uint16_t ch,
     pn_do_trace(transport, ch, OUT, transport->output_args, payload->start, available);
 
     memmove( buf.start + buf.size, payload->start, available);
+    PNI_COUNT(transport->metrics.bytes_copied, available);
     payload->start += available;
     payload->size -= available;
     buf.size += available;
@@ -1005,7 +1144,10 @@ static int pni_post_amqp_transfer_frame(pn_transport_t *transport, uint16_t ch,
       transport->capacity *= 2;
       transport->output = (char *) realloc(transport->output, transport->capacity);
     }
-    transport->output_frames_ct += 1;
+    pni_count_output(transport, AMQP_FRAME_TYPE, TRANSFER, n);
+    if (transport->trace & PN_TRACE_BIN) {
+      pni_trace_frame(transport, OUT, AMQP_FRAME_TYPE, ch, TRANSFER, transport->output_args, available);
+    }
     framecount++;
     if (transport->trace & PN_TRACE_RAW) {
       pn_string_set(transport->scratch, "RAW: \"");
@@ -1220,16 +1362,17 @@ pn_link_t *pn_find_link(pn_session_t *ssn, pn_bytes_t name, bool is_sender)
 {
   pn_endpoint_type_t type = is_sender ? SENDER : RECEIVER;
 
-  for (size_t i = 0; i < pn_list_size(ssn->links); i++)
+  uintptr_t hash = pni_link_name_hash(name.start, name.size);
+  for (pn_link_t *link = (pn_link_t *) pn_hash_get(ssn->link_names, hash); link; link = link->name_next)
   {
-    pn_link_t *link = (pn_link_t *) pn_list_get(ssn->links, i);
     if (link->endpoint.type == type &&
         // This function is used to locate the link object for an
         // incoming attach. If a link object of the same name is found
         // which is closed both locally and remotely, assume that is
         // no longer in use.
         !((link->endpoint.state & PN_LOCAL_CLOSED) && (link->endpoint.state & PN_REMOTE_CLOSED)) &&
-        !strncmp(name.start, pn_string_get(link->name), name.size))
+        pn_string_size(link->name) == name.size &&
+        !memcmp(name.start, pn_string_get(link->name), name.size))
     {
       return link;
     }
@@ -1453,7 +1596,7 @@ int pn_do_transfer(pn_transport_t *transport, uint8_t frame_type, uint16_t chann
     pn_delivery_map_t *incoming = &ssn->state.incoming;
 
     if (!ssn->state.incoming_init) {
-      incoming->next = id;
+      incoming->base = incoming->next = id;
       ssn->state.incoming_init = true;
       ssn->incoming_deliveries++;
     }
@@ -1473,6 +1616,9 @@ int pn_do_transfer(pn_transport_t *transport, uint8_t frame_type, uint16_t chann
     link->state.delivery_count++;
     link->state.link_credit--;
     link->queued++;
+    PNI_COUNT(link->metrics.deliveries_received, 1);
+    PNI_COUNT(ssn->metrics.deliveries_received, 1);
+    PNI_COUNT(transport->metrics.deliveries_received, 1);
 
     // XXX: need to fill in remote state: delivery->remote.state = ...;
     delivery->remote.settled = settled;
@@ -1484,14 +1630,26 @@ int pn_do_transfer(pn_transport_t *transport, uint8_t frame_type, uint16_t chann
 
   pn_buffer_append(delivery->bytes, payload->start, payload->size);
   ssn->incoming_bytes += payload->size;
+  PNI_COUNT(link->metrics.bytes_received, payload->size);
+  PNI_COUNT(ssn->metrics.bytes_received, payload->size);
+  PNI_COUNT(transport->metrics.bytes_copied, payload->size);
   delivery->done = !more;
 
   ssn->state.incoming_transfer_count++;
   ssn->state.incoming_window--;
+  if (!ssn->state.incoming_window) {
+    PNI_COUNT(ssn->metrics.incoming_window_stalls, 1);
+    PNI_COUNT(transport->metrics.window_stalls, 1);
+  }
 
   // XXX: need better policy for when to refresh window
   if (!ssn->state.incoming_window && (int32_t) link->state.local_handle >= 0) {
-    pni_post_flow(transport, ssn, link);
+    if (transport->coalesce_events && (link->endpoint.state & PN_LOCAL_ACTIVE)) {
+      // pni_process_flow_receiver refreshes it once the input is done
+      pn_modified(transport->connection, &link->endpoint, true);
+    } else {
+      pni_post_flow(transport, ssn, link);
+    }
   }
 
   pn_collector_put(transport->connection->collector, PN_OBJECT, delivery, PN_DELIVERY);
@@ -1572,6 +1730,126 @@ static int pn_scan_error(pn_data_t *data, pn_condition_t *condition, const char
   return 0;
 }
 
+// Parse the outcome carried by a disposition into remote.
+static int pni_disposition_parse(pn_transport_t *transport, pn_disposition_t *remote, uint64_t type)
+{
+  int err;
+  switch (type) {
+  case PN_RECEIVED:
+    pn_data_rewind(transport->disp_data);
+    pn_data_next(transport->disp_data);
+    pn_data_enter(transport->disp_data);
+    if (pn_data_next(transport->disp_data))
+      remote->section_number = pn_data_get_uint(transport->disp_data);
+    if (pn_data_next(transport->disp_data))
+      remote->section_offset = pn_data_get_ulong(transport->disp_data);
+    break;
+  case PN_ACCEPTED:
+    break;
+  case PN_REJECTED:
+    err = pn_scan_error(transport->disp_data, &remote->condition, SCAN_ERROR_DISP);
+    if (err) return err;
+    break;
+  case PN_RELEASED:
+    break;
+  case PN_MODIFIED:
+    pn_data_rewind(transport->disp_data);
+    pn_data_next(transport->disp_data);
+    pn_data_enter(transport->disp_data);
+    if (pn_data_next(transport->disp_data))
+      remote->failed = pn_data_get_bool(transport->disp_data);
+    if (pn_data_next(transport->disp_data))
+      remote->undeliverable = pn_data_get_bool(transport->disp_data);
+    pn_data_narrow(transport->disp_data);
+    pn_data_clear(remote->data);
+    pn_data_appendn(remote->annotations, transport->disp_data, 1);
+    pn_data_widen(transport->disp_data);
+    break;
+  default:
+    pn_data_copy(remote->data, transport->disp_data);
+    break;
+  }
+  return 0;
+}
+
+// Copy an outcome already parsed for another delivery of the same
+// disposition rather than parsing it again.
+static int pni_disposition_copy(pn_disposition_t *remote, pn_disposition_t *src)
+{
+  int err;
+  switch (src->type) {
+  case PN_RECEIVED:
+    remote->section_number = src->section_number;
+    remote->section_offset = src->section_offset;
+    break;
+  case PN_REJECTED:
+    pn_condition_clear(&remote->condition);
+    pn_string_copy(remote->condition.name, src->condition.name);
+    pn_string_copy(remote->condition.description, src->condition.description);
+    err = pn_data_copy(remote->condition.info, src->condition.info);
+    if (err) return err;
+    break;
+  case PN_MODIFIED:
+    remote->failed = src->failed;
+    remote->undeliverable = src->undeliverable;
+    pn_data_clear(remote->data);
+    err = pn_data_copy(remote->annotations, src->annotations);
+    if (err) return err;
+    break;
+  case PN_ACCEPTED:
+  case PN_RELEASED:
+    break;
+  default:
+    err = pn_data_copy(remote->data, src->data);
+    if (err) return err;
+    break;
+  }
+  return 0;
+}
+
+typedef struct {
+  pn_transport_t *transport;
+  pn_delivery_t *parsed;
+  uint64_t type;
+  bool type_init;
+  bool remote_data;
+  bool settled;
+  bool range;
+} pni_disposition_t;
+
+static int pni_disposition_apply(pni_disposition_t *disp, pn_delivery_t *delivery)
+{
+  pn_disposition_t *remote = &delivery->remote;
+  if (disp->type_init) remote->type = disp->type;
+  if (disp->remote_data) {
+    int err = disp->parsed
+      ? pni_disposition_copy(remote, &disp->parsed->remote)
+      : pni_disposition_parse(disp->transport, remote, disp->type);
+    if (err) return err;
+    disp->parsed = delivery;
+  }
+  // sent_at is 0 if recording started after the delivery was written
+  if (disp->settled && !remote->settled && delivery->link->settle_latency &&
+      delivery->state.sent && delivery->sent_at) {
+    pni_histogram_record(delivery->link->settle_latency,
+                         pn_i_monotonic_us() - delivery->sent_at);
+  }
+  remote->settled = disp->settled;
+  delivery->updated = true;
+  pn_connection_t *connection = disp->transport->connection;
+  pn_work_update(connection, delivery);
+
+  // consecutive events for the same link collapse into one, the
+  // deliveries wait on the link until they are taken
+  if (disp->range && disp->settled && delivery->link->bulk_settle) {
+    pni_add_ranged(delivery);
+    pn_collector_put(connection->collector, PN_OBJECT, delivery->link, PN_DELIVERY_SETTLE_RANGE);
+  } else {
+    pn_collector_put(connection->collector, PN_OBJECT, delivery, PN_DELIVERY);
+  }
+  return 0;
+}
+
 int pn_do_disposition(pn_transport_t *transport, uint8_t frame_type, uint16_t channel, pn_data_t *args, const pn_bytes_t *payload)
 {
   bool role;
@@ -1597,57 +1875,51 @@ int pn_do_disposition(pn_transport_t *transport, uint8_t frame_type, uint16_t ch
     deliveries = &ssn->state.incoming;
   }
 
+  pni_disposition_t disp;
+  disp.transport = transport;
+  disp.parsed = NULL;
+  disp.type = type;
+  disp.type_init = type_init;
   pn_data_rewind(transport->disp_data);
-  bool remote_data = (pn_data_next(transport->disp_data) &&
+  disp.remote_data = (pn_data_next(transport->disp_data) &&
                       pn_data_get_list(transport->disp_data) > 0);
-
-  for (pn_sequence_t id = first; id <= last; id++) {
-    pn_delivery_t *delivery = pni_delivery_map_get(deliveries, id);
-    pn_disposition_t *remote = &delivery->remote;
-    if (delivery) {
-      if (type_init) remote->type = type;
-      if (remote_data) {
-        switch (type) {
-        case PN_RECEIVED:
-          pn_data_rewind(transport->disp_data);
-          pn_data_next(transport->disp_data);
-          pn_data_enter(transport->disp_data);
-          if (pn_data_next(transport->disp_data))
-            remote->section_number = pn_data_get_uint(transport->disp_data);
-          if (pn_data_next(transport->disp_data))
-            remote->section_offset = pn_data_get_ulong(transport->disp_data);
-          break;
-        case PN_ACCEPTED:
-          break;
-        case PN_REJECTED:
-          err = pn_scan_error(transport->disp_data, &remote->condition, SCAN_ERROR_DISP);
+  disp.settled = settled;
+  disp.range = first != last;
+
+  // The range is inclusive and may wrap, so span is one less than the
+  // number of ids it names. Look the ids up one by one only when there
+  // are fewer of them than deliveries in the map, otherwise walk the
+  // map and pick out the deliveries that fall in the range.
+  uint32_t span = (uint32_t) last - (uint32_t) first;
+  uint32_t window = pni_delivery_map_window(deliveries);
+  size_t overflow = deliveries->overflow ? pn_hash_size(deliveries->overflow) : 0;
+  if ((size_t) span < window + overflow) {
+    for (uint32_t i = 0; i <= span; i++) {
+      pn_delivery_t *delivery = pni_delivery_map_get(deliveries, (uint32_t) first + i);
+      if (delivery) {
+        err = pni_disposition_apply(&disp, delivery);
+        if (err) return err;
+      }
+    }
+  } else {
+    // overflow ids all precede the ring window
+    if (overflow) {
+      pn_hash_t *hash = deliveries->overflow;
+      for (pn_handle_t entry = pn_hash_head(hash); entry; entry = pn_hash_next(hash, entry)) {
+        uint32_t id = (uint32_t) pn_hash_key(hash, entry);
+        if (id - (uint32_t) first <= span) {
+          err = pni_disposition_apply(&disp, (pn_delivery_t *) pn_hash_value(hash, entry));
           if (err) return err;
-          break;
-        case PN_RELEASED:
-          break;
-        case PN_MODIFIED:
-          pn_data_rewind(transport->disp_data);
-          pn_data_next(transport->disp_data);
-          pn_data_enter(transport->disp_data);
-          if (pn_data_next(transport->disp_data))
-            remote->failed = pn_data_get_bool(transport->disp_data);
-          if (pn_data_next(transport->disp_data))
-            remote->undeliverable = pn_data_get_bool(transport->disp_data);
-          pn_data_narrow(transport->disp_data);
-          pn_data_clear(remote->data);
-          pn_data_appendn(remote->annotations, transport->disp_data, 1);
-          pn_data_widen(transport->disp_data);
-          break;
-        default:
-          pn_data_copy(remote->data, transport->disp_data);
-          break;
         }
       }
-      remote->settled = settled;
-      delivery->updated = true;
-      pn_work_update(transport->connection, delivery);
-
-      pn_collector_put(transport->connection->collector, PN_OBJECT, delivery, PN_DELIVERY);
+    }
+    for (uint32_t offset = 0; offset < window; offset++) {
+      pn_sequence_t id = (uint32_t) deliveries->base + offset;
+      pn_delivery_t *delivery = *pni_delivery_map_slot(deliveries, id);
+      if (delivery && (uint32_t) id - (uint32_t) first <= span) {
+        err = pni_disposition_apply(&disp, delivery);
+        if (err) return err;
+      }
     }
   }
 
@@ -1745,7 +2017,7 @@ static ssize_t transport_consume(pn_transport_t *transport)
   // flow to the app the same way, but provides cleaner error messages
   // since we don't try to look for a protocol header when, e.g. the
   // connection was refused.
-  if (!transport->bytes_input && transport->tail_closed &&
+  if (!transport->metrics.bytes_input && transport->tail_closed &&
       pn_condition_is_set(&transport->condition)) {
     pn_do_error(transport, NULL, NULL);
     return PN_EOS;
@@ -1775,6 +2047,7 @@ static ssize_t transport_consume(pn_transport_t *transport)
 
   if (transport->input_pending && consumed) {
     memmove( transport->input_buf,  &transport->input_buf[consumed], transport->input_pending );
+    PNI_COUNT(transport->metrics.bytes_copied, transport->input_pending);
   }
 
   return consumed;
@@ -1812,17 +2085,103 @@ static int pni_process_conn_setup(pn_transport_t *transport, pn_endpoint_t *endp
   return 0;
 }
 
-static uint16_t allocate_alias(pn_hash_t *aliases, uint32_t max_index, int * valid)
+static inline unsigned pni_lowest_bit(uint64_t bits)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(bits);
+#else
+  unsigned n = 0;
+  while (!(bits & 1)) {
+    bits >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+void pn_alias_set_clear(pn_alias_set_t *set)
+{
+  if (set->words) {
+    memset(set->used, 0, set->words * sizeof(uint64_t));
+    memset(set->full, 0, (set->words + 63) / 64 * sizeof(uint64_t));
+  }
+}
+
+void pn_alias_set_free(pn_alias_set_t *set)
+{
+  free(set->used);
+  free(set->full);
+  set->used = NULL;
+  set->full = NULL;
+  set->words = 0;
+}
+
+static bool pni_alias_set_grow(pn_alias_set_t *set, size_t words)
 {
-  for (uint32_t i = 0; i <= max_index; i++) {
-    if (!pn_hash_get(aliases, i)) {
-      * valid = 1;
-      return i;
+  size_t full_words = (words + 63) / 64;
+  size_t old_full_words = (set->words + 63) / 64;
+  uint64_t *used = (uint64_t *) realloc(set->used, words * sizeof(uint64_t));
+  if (!used) return false;
+  set->used = used;
+  uint64_t *full = (uint64_t *) realloc(set->full, full_words * sizeof(uint64_t));
+  if (!full) return false;
+  set->full = full;
+  memset(used + set->words, 0, (words - set->words) * sizeof(uint64_t));
+  memset(full + old_full_words, 0, (full_words - old_full_words) * sizeof(uint64_t));
+  set->words = words;
+  return true;
+}
+
+// Claim the lowest number not in use, if it is no greater than max_index.
+static bool allocate_alias(pn_alias_set_t *set, uint32_t max_index, uint32_t *alias)
+{
+  size_t word = set->words;
+  for (size_t i = 0; i < (set->words + 63) / 64; i++) {
+    uint64_t open = ~set->full[i];
+    if (open) {
+      word = i * 64 + pni_lowest_bit(open);
+      break;
     }
   }
+  // bits of full past the last word of used are never set
+  if (word >= set->words) {
+    word = set->words;
+  }
+  uint64_t bit = word < set->words ? pni_lowest_bit(~set->used[word]) : 0;
+  uint64_t index = (uint64_t) word * 64 + bit;
+  if (index > max_index) return false;
 
-  * valid = 0;
-  return 0;
+  if (word >= set->words) {
+    size_t words = set->words ? 2 * set->words : 1;
+    size_t limit = (size_t) max_index / 64 + 1;
+    if (words > limit) words = limit;
+    if (!pni_alias_set_grow(set, words)) return false;
+  }
+  set->used[word] |= (uint64_t) 1 << bit;
+  if (set->used[word] == ~(uint64_t) 0) {
+    set->full[word / 64] |= (uint64_t) 1 << (word % 64);
+  }
+  *alias = (uint32_t) index;
+  return true;
+}
+
+static void release_alias(pn_alias_set_t *set, uint32_t alias)
+{
+  size_t word = alias / 64;
+  if (word < set->words) {
+    set->used[word] &= ~((uint64_t) 1 << (alias % 64));
+    set->full[word / 64] &= ~((uint64_t) 1 << (word % 64));
+  }
+}
+
+void pn_transport_release_channel(pn_transport_t *transport, uint16_t channel)
+{
+  release_alias(&transport->channel_aliases, channel);
+}
+
+void pn_session_release_handle(pn_session_t *ssn, uint32_t handle)
+{
+  release_alias(&ssn->state.handle_aliases, handle);
 }
 
 static size_t pni_session_outgoing_window(pn_session_t *ssn)
@@ -1844,9 +2203,8 @@ static int pni_map_local_channel(pn_session_t *ssn)
 {
   pn_transport_t *transport = ssn->connection->transport;
   pn_session_state_t *state = &ssn->state;
-  int valid;
-  uint16_t channel = allocate_alias(transport->local_channels, transport->channel_max, & valid);
-  if (!valid) {
+  uint32_t channel;
+  if (!allocate_alias(&transport->channel_aliases, transport->channel_max, &channel)) {
     return 0;
   }
   state->local_channel = channel;
@@ -1899,10 +2257,8 @@ static const char *expiry_symbol(pn_expiry_policy_t policy)
 static int pni_map_local_handle(pn_link_t *link) {
   pn_link_state_t *state = &link->state;
   pn_session_state_t *ssn_state = &link->session->state;
-  int valid;
   // XXX TODO MICK: once changes are made to handle_max, change this hardcoded value to something reasonable.
-  state->local_handle = allocate_alias(ssn_state->local_handles, 65536, & valid);
-  if ( ! valid )
+  if (!allocate_alias(&ssn_state->handle_aliases, 65536, &state->local_handle))
     return 0;
   pn_hash_put(ssn_state->local_handles, state->local_handle, link);
   pn_ep_incref(&link->endpoint);
@@ -2085,6 +2441,26 @@ static int pni_post_disp(pn_transport_t *transport, pn_delivery_t *delivery)
   return 0;
 }
 
+// A stall is counted once, when it starts, however often the blocked
+// delivery is looked at before it can go.
+static void pni_credit_stall(pn_transport_t *transport, pn_link_t *link)
+{
+  if (!link->credit_stalled) {
+    link->credit_stalled = true;
+    PNI_COUNT(link->metrics.credit_stalls, 1);
+    PNI_COUNT(transport->metrics.credit_stalls, 1);
+  }
+}
+
+static void pni_window_stall(pn_transport_t *transport, pn_session_t *ssn)
+{
+  if (!ssn->window_stalled) {
+    ssn->window_stalled = true;
+    PNI_COUNT(ssn->metrics.outgoing_window_stalls, 1);
+    PNI_COUNT(transport->metrics.window_stalls, 1);
+  }
+}
+
 static int pni_process_tpwork_sender(pn_transport_t *transport, pn_delivery_t *delivery, bool *settle)
 {
   *settle = false;
@@ -2094,10 +2470,16 @@ static int pni_process_tpwork_sender(pn_transport_t *transport, pn_delivery_t *d
   bool xfr_posted = false;
   if ((int16_t) ssn_state->local_channel >= 0 && (int32_t) link_state->local_handle >= 0) {
     pn_delivery_state_t *state = &delivery->state;
-    if (!state->sent && (delivery->done || pn_buffer_size(delivery->bytes) > 0) &&
-        ssn_state->remote_incoming_window > 0 && link_state->link_credit > 0) {
+    bool ready = !state->sent && (delivery->done || pn_buffer_size(delivery->bytes) > 0);
+    if (ready && link_state->link_credit <= 0) {
+      pni_credit_stall(transport, link);
+    } else if (ready && ssn_state->remote_incoming_window <= 0) {
+      pni_window_stall(transport, link->session);
+    }
+    if (ready && ssn_state->remote_incoming_window > 0 && link_state->link_credit > 0) {
       if (!state->init) {
         state = pni_delivery_map_push(&ssn_state->outgoing, delivery);
+        if (link->settle_latency) delivery->sent_at = pn_i_monotonic_us();
       }
 
       pn_bytes_t bytes = pn_buffer_bytes(delivery->bytes);
@@ -2122,12 +2504,21 @@ static int pni_process_tpwork_sender(pn_transport_t *transport, pn_delivery_t *d
       int sent = full_size - bytes.size;
       pn_buffer_trim(delivery->bytes, sent, 0);
       link->session->outgoing_bytes -= sent;
+      link->credit_stalled = false;
+      link->session->window_stalled = false;
+      PNI_COUNT(link->metrics.bytes_sent, sent);
+      PNI_COUNT(link->session->metrics.bytes_sent, sent);
       if (!pn_buffer_size(delivery->bytes) && delivery->done) {
         state->sent = true;
         link_state->delivery_count++;
         link_state->link_credit--;
         link->queued--;
         link->session->outgoing_deliveries--;
+        PNI_COUNT(link->metrics.deliveries_sent, 1);
+        PNI_COUNT(link->session->metrics.deliveries_sent, 1);
+        PNI_COUNT(transport->metrics.deliveries_sent, 1);
+      } else if (!ssn_state->remote_incoming_window) {
+        pni_window_stall(transport, link->session);
       }
 
       pn_collector_put(transport->connection->collector, PN_OBJECT, link, PN_LINK_FLOW);
@@ -2190,6 +2581,9 @@ static int pni_process_tpwork(pn_transport_t *transport, pn_endpoint_t *endpoint
       }
 
       if (settle) {
+        PNI_COUNT(link->metrics.deliveries_settled, 1);
+        PNI_COUNT(link->session->metrics.deliveries_settled, 1);
+        PNI_COUNT(transport->metrics.deliveries_settled, 1);
         pn_full_settle(dm, delivery);
       } else if (!pn_delivery_buffered(delivery)) {
         pn_clear_tpwork(delivery);
@@ -2245,6 +2639,7 @@ static void pni_unmap_local_handle(pn_link_t *link) {
   uintptr_t handle = state->local_handle;
   state->local_handle = -2;
   if (pn_hash_get(link->session->state.local_handles, handle)) {
+    release_alias(&link->session->state.handle_aliases, handle);
     pn_ep_decref(&link->endpoint);
   }
   // may delete link
@@ -2317,11 +2712,13 @@ static void pni_unmap_local_channel(pn_session_t *ssn) {
   // XXX: should really update link state also
   pni_delivery_map_clear(&ssn->state.outgoing);
   pni_transport_unbind_handles(ssn->state.local_handles, false);
+  pn_alias_set_clear(&ssn->state.handle_aliases);
   pn_transport_t *transport = ssn->connection->transport;
   pn_session_state_t *state = &ssn->state;
   uintptr_t channel = state->local_channel;
   state->local_channel = -2;
   if (pn_hash_get(transport->local_channels, channel)) {
+    release_alias(&transport->channel_aliases, channel);
     pn_ep_decref(&ssn->endpoint);
   }
   // may delete session
@@ -2497,9 +2894,9 @@ static pn_timestamp_t pn_tick_amqp(pn_transport_t* transport, unsigned int layer
 
   if (transport->local_idle_timeout) {
     if (transport->dead_remote_deadline == 0 ||
-        transport->last_bytes_input != transport->bytes_input) {
+        transport->last_bytes_input != transport->metrics.bytes_input) {
       transport->dead_remote_deadline = now + transport->local_idle_timeout;
-      transport->last_bytes_input = transport->bytes_input;
+      transport->last_bytes_input = transport->metrics.bytes_input;
     } else if (transport->dead_remote_deadline <= now) {
       transport->dead_remote_deadline = now + transport->local_idle_timeout;
       if (!transport->posted_idle_timeout) {
@@ -2514,9 +2911,9 @@ static pn_timestamp_t pn_tick_amqp(pn_transport_t* transport, unsigned int layer
   // Prevent remote idle timeout as describe by AMQP 1.0:
   if (transport->remote_idle_timeout && !transport->close_sent) {
     if (transport->keepalive_deadline == 0 ||
-        transport->last_bytes_output != transport->bytes_output) {
+        transport->last_bytes_output != transport->metrics.bytes_output) {
       transport->keepalive_deadline = now + (pn_timestamp_t)(transport->remote_idle_timeout/2.0);
-      transport->last_bytes_output = transport->bytes_output;
+      transport->last_bytes_output = transport->metrics.bytes_output;
     } else if (transport->keepalive_deadline <= now) {
       transport->keepalive_deadline = now + (pn_timestamp_t)(transport->remote_idle_timeout/2.0);
       if (transport->available == 0) {    // no outbound data pending
@@ -2647,6 +3044,27 @@ ssize_t pn_transport_output(pn_transport_t *transport, char *bytes, size_t size)
 void pn_transport_trace(pn_transport_t *transport, pn_trace_t trace)
 {
   transport->trace = trace;
+  if ((trace & PN_TRACE_BIN) && !transport->trace_ring) {
+    pn_transport_set_trace_ring(transport, 4096);
+  }
+}
+
+int pn_transport_set_trace_ring(pn_transport_t *transport, size_t records)
+{
+  assert(transport);
+  pni_trace_ring_free(transport->trace_ring);
+  transport->trace_ring = NULL;
+  if (records) {
+    transport->trace_ring = pni_trace_ring(records);
+    if (!transport->trace_ring) return PN_OUT_OF_MEMORY;
+  }
+  return 0;
+}
+
+ssize_t pn_transport_trace_dump(pn_transport_t *transport, char *bytes, size_t size)
+{
+  assert(transport);
+  return pni_trace_ring_dump(transport->trace_ring, bytes, size);
 }
 
 void pn_transport_set_tracer(pn_transport_t *transport, pn_tracer_t tracer)
@@ -2787,17 +3205,37 @@ pn_timestamp_t pn_transport_tick(pn_transport_t *transport, pn_timestamp_t now)
 uint64_t pn_transport_get_frames_output(const pn_transport_t *transport)
 {
   if (transport)
-    return transport->output_frames_ct;
+    return transport->metrics.frames_output;
   return 0;
 }
 
 uint64_t pn_transport_get_frames_input(const pn_transport_t *transport)
 {
   if (transport)
-    return transport->input_frames_ct;
+    return transport->metrics.frames_input;
   return 0;
 }
 
+const pn_transport_metrics_t *pn_transport_metrics(pn_transport_t *transport)
+{
+  assert(transport);
+  return &transport->metrics;
+}
+
+void pni_metrics_copy(uint64_t *to, const uint64_t *from, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    to[i] = PNI_COUNT_GET(from[i]);
+  }
+}
+
+void pn_transport_metrics_copy(pn_transport_t *transport, pn_transport_metrics_t *metrics)
+{
+  assert(transport && metrics);
+  pni_metrics_copy((uint64_t *) metrics, (const uint64_t *) &transport->metrics,
+                   sizeof(*metrics) / sizeof(uint64_t));
+}
+
 // input
 ssize_t pn_transport_capacity(pn_transport_t *transport)  /* <0 == done */
 {
@@ -2862,9 +3300,13 @@ int pn_transport_process(pn_transport_t *transport, size_t size)
   assert(transport);
   size = pn_min( size, (transport->input_size - transport->input_pending) );
   transport->input_pending += size;
-  transport->bytes_input += size;
+  PNI_COUNT(transport->metrics.bytes_input, size);
 
+  pn_collector_t *collector = transport->connection ? transport->connection->collector : NULL;
+  bool coalesce = transport->coalesce_events && collector;
+  if (coalesce) pni_collector_coalesce(collector, true);
   ssize_t n = transport_consume( transport );
+  if (coalesce) pni_collector_coalesce(collector, false);
   if (n == PN_EOS) {
     pni_close_tail(transport);
   }
@@ -2922,10 +3364,11 @@ void pn_transport_pop(pn_transport_t *transport, size_t size)
   if (transport) {
     assert( transport->output_pending >= size );
     transport->output_pending -= size;
-    transport->bytes_output += size;
+    PNI_COUNT(transport->metrics.bytes_output, size);
     if (transport->output_pending) {
       memmove( transport->output_buf,  &transport->output_buf[size],
                transport->output_pending );
+      PNI_COUNT(transport->metrics.bytes_copied, transport->output_pending);
     }
 
     if (transport->output_pending==0 && pn_transport_pending(transport) < 0) {
@@ -0,0 +1,270 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/transport.h>
+#include <proton/transport_pair.h>
+
+#include "buffer.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Bytes written by one transport in one go, due at the other end at a
+// given time. Times within the pair are kept in microseconds so that
+// a low bandwidth does not round every segment up to a millisecond.
+typedef struct {
+  uint64_t due;
+  size_t size;
+} pni_segment_t;
+
+// One direction of the link.
+typedef struct {
+  pn_transport_t *src;
+  pn_transport_t *dst;
+  pn_buffer_t *bytes;           // in flight, oldest first
+  pni_segment_t *segments;
+  size_t head;                  // first segment still in flight
+  size_t count;                 // segments in use, from 0
+  size_t capacity;
+  uint64_t idle_at;             // when the link has finished sending
+  pn_timestamp_t tick;          // src's next timer deadline
+  bool closed;                  // dst has been told the stream ended
+} pni_pipe_t;
+
+struct pn_transport_pair_t {
+  pni_pipe_t pipes[2];
+  uint64_t now;
+  uint64_t latency;
+  size_t bandwidth;
+  size_t segment_size;
+};
+
+static void pni_pipe_init(pni_pipe_t *pipe, pn_transport_t *src, pn_transport_t *dst)
+{
+  pipe->src = src;
+  pipe->dst = dst;
+  pipe->bytes = NULL;
+  pipe->segments = NULL;
+  pipe->head = 0;
+  pipe->count = 0;
+  pipe->capacity = 0;
+  pipe->idle_at = 0;
+  pipe->tick = 0;
+  pipe->closed = false;
+}
+
+static void pni_pipe_free(pni_pipe_t *pipe)
+{
+  if (pipe->bytes) pn_buffer_free(pipe->bytes);
+  free(pipe->segments);
+}
+
+static bool pni_pipe_empty(pni_pipe_t *pipe)
+{
+  return pipe->head == pipe->count;
+}
+
+pn_transport_pair_t *pn_transport_pair(pn_transport_t *a, pn_transport_t *b)
+{
+  assert(a && b && a != b);
+  pn_transport_pair_t *pair = (pn_transport_pair_t *) malloc(sizeof(pn_transport_pair_t));
+  if (!pair) return NULL;
+  pni_pipe_init(&pair->pipes[0], a, b);
+  pni_pipe_init(&pair->pipes[1], b, a);
+  pair->now = 1000;
+  pair->latency = 0;
+  pair->bandwidth = 0;
+  pair->segment_size = 0;
+  return pair;
+}
+
+void pn_transport_pair_free(pn_transport_pair_t *pair)
+{
+  if (!pair) return;
+  pni_pipe_free(&pair->pipes[0]);
+  pni_pipe_free(&pair->pipes[1]);
+  free(pair);
+}
+
+void pn_transport_pair_set_latency(pn_transport_pair_t *pair, pn_millis_t latency)
+{
+  assert(pair);
+  pair->latency = (uint64_t) latency * 1000;
+}
+
+void pn_transport_pair_set_bandwidth(pn_transport_pair_t *pair, size_t bytes_per_second)
+{
+  assert(pair);
+  pair->bandwidth = bytes_per_second;
+}
+
+void pn_transport_pair_set_segment_size(pn_transport_pair_t *pair, size_t size)
+{
+  assert(pair);
+  pair->segment_size = size;
+}
+
+pn_timestamp_t pn_transport_pair_now(pn_transport_pair_t *pair)
+{
+  assert(pair);
+  return (pn_timestamp_t) (pair->now / 1000);
+}
+
+size_t pn_transport_pair_in_flight(pn_transport_pair_t *pair)
+{
+  assert(pair);
+  size_t size = 0;
+  for (int i = 0; i < 2; i++) {
+    if (pair->pipes[i].bytes) size += pn_buffer_size(pair->pipes[i].bytes);
+  }
+  return size;
+}
+
+// Put size bytes from the head of src on the link.
+static int pni_pipe_send(pn_transport_pair_t *pair, pni_pipe_t *pipe, size_t size)
+{
+  if (!pipe->bytes) {
+    pipe->bytes = pn_buffer(size);
+    if (!pipe->bytes) return PN_OUT_OF_MEMORY;
+  }
+  if (pipe->count == pipe->capacity) {
+    if (pipe->head > pipe->count / 2) {
+      memmove(pipe->segments, pipe->segments + pipe->head, (pipe->count - pipe->head) * sizeof(pni_segment_t));
+      pipe->count -= pipe->head;
+      pipe->head = 0;
+    } else {
+      size_t capacity = pipe->capacity ? 2 * pipe->capacity : 16;
+      pni_segment_t *segments = (pni_segment_t *) realloc(pipe->segments, capacity * sizeof(pni_segment_t));
+      if (!segments) return PN_OUT_OF_MEMORY;
+      pipe->segments = segments;
+      pipe->capacity = capacity;
+    }
+  }
+  int err = pn_buffer_append(pipe->bytes, pn_transport_head(pipe->src), size);
+  if (err) return err;
+
+  uint64_t start = pipe->idle_at > pair->now ? pipe->idle_at : pair->now;
+  pipe->idle_at = start + (pair->bandwidth ? (uint64_t) size * 1000000 / pair->bandwidth : 0);
+  pni_segment_t *segment = &pipe->segments[pipe->count++];
+  segment->due = pipe->idle_at + pair->latency;
+  segment->size = size;
+  pn_transport_pop(pipe->src, size);
+  return 0;
+}
+
+// Hand the segments that have arrived to dst, as far as it will take them.
+static size_t pni_pipe_receive(pn_transport_pair_t *pair, pni_pipe_t *pipe)
+{
+  size_t moved = 0;
+  while (!pni_pipe_empty(pipe) && pipe->segments[pipe->head].due <= pair->now) {
+    pni_segment_t *segment = &pipe->segments[pipe->head];
+    ssize_t capacity = pn_transport_capacity(pipe->dst);
+    size_t n = segment->size;
+    if (capacity < 0) {
+      // nobody is reading, the bytes are lost
+    } else if (capacity == 0) {
+      break;
+    } else {
+      if ((size_t) capacity < n) n = capacity;
+      pn_buffer_get(pipe->bytes, 0, n, pn_transport_tail(pipe->dst));
+      pn_transport_process(pipe->dst, n);
+      moved += n;
+    }
+    pn_buffer_trim(pipe->bytes, n, 0);
+    segment->size -= n;
+    if (!segment->size) pipe->head++;
+  }
+  if (pni_pipe_empty(pipe)) {
+    pipe->head = pipe->count = 0;
+  }
+  return moved;
+}
+
+static size_t pni_pipe_pump(pn_transport_pair_t *pair, pni_pipe_t *pipe)
+{
+  bool direct = !pair->latency && !pair->bandwidth;
+  size_t moved = 0;
+  ssize_t pending;
+  while ((pending = pn_transport_pending(pipe->src)) > 0) {
+    size_t n = pending;
+    if (pair->segment_size && pair->segment_size < n) n = pair->segment_size;
+    if (direct && pni_pipe_empty(pipe)) {
+      // nothing to wait for, so skip the link and copy straight across
+      ssize_t capacity = pn_transport_capacity(pipe->dst);
+      if (capacity == 0) break;
+      if (capacity > 0) {
+        if ((size_t) capacity < n) n = capacity;
+        memcpy(pn_transport_tail(pipe->dst), pn_transport_head(pipe->src), n);
+        pn_transport_process(pipe->dst, n);
+        moved += n;
+      }
+      pn_transport_pop(pipe->src, n);
+    } else if (pni_pipe_send(pair, pipe, n)) {
+      break;
+    }
+  }
+  moved += pni_pipe_receive(pair, pipe);
+  if (pending < 0 && pni_pipe_empty(pipe) && !pipe->closed) {
+    pn_transport_close_tail(pipe->dst);
+    pipe->closed = true;
+  }
+  return moved;
+}
+
+size_t pn_transport_pair_pump(pn_transport_pair_t *pair)
+{
+  assert(pair);
+  size_t total = 0;
+  size_t moved;
+  do {
+    moved = pni_pipe_pump(pair, &pair->pipes[0]);
+    moved += pni_pipe_pump(pair, &pair->pipes[1]);
+    total += moved;
+  } while (moved);
+  return total;
+}
+
+size_t pn_transport_pair_advance(pn_transport_pair_t *pair, pn_millis_t time)
+{
+  assert(pair);
+  pair->now += (uint64_t) time * 1000;
+  for (int i = 0; i < 2; i++) {
+    pair->pipes[i].tick = pn_transport_tick(pair->pipes[i].src, pn_transport_pair_now(pair));
+  }
+  return pn_transport_pair_pump(pair);
+}
+
+pn_timestamp_t pn_transport_pair_deadline(pn_transport_pair_t *pair)
+{
+  assert(pair);
+  pn_timestamp_t deadline = 0;
+  for (int i = 0; i < 2; i++) {
+    pni_pipe_t *pipe = &pair->pipes[i];
+    if (!pni_pipe_empty(pipe)) {
+      // round up, the segment has not arrived until the whole millisecond has passed
+      pn_timestamp_t due = (pn_timestamp_t) ((pipe->segments[pipe->head].due + 999) / 1000);
+      if (!deadline || due < deadline) deadline = due;
+    }
+    if (pipe->tick && (!deadline || pipe->tick < deadline)) deadline = pipe->tick;
+  }
+  return deadline;
+}
@@ -64,6 +64,7 @@ struct pn_io_t {
   char host[NI_MAXHOST];
   char serv[NI_MAXSERV];
   pn_error_t *error;
+  int backlog;
   bool trace;
   bool wouldblock;
   iocp_t *iocp;
@@ -74,6 +75,7 @@ void pn_io_initialize(void *obj)
   pn_io_t *io = (pn_io_t *) obj;
   io->error = pn_error();
   io->wouldblock = false;
+  io->backlog = SOMAXCONN;
   io->trace = pn_env_bool("PN_TRACE_DRV");
 
   /* Request WinSock 2.2 */
@@ -117,6 +119,21 @@ pn_error_t *pn_io_error(pn_io_t *io)
   return io->error;
 }
 
+void pn_io_set_listen_backlog(pn_io_t *io, int backlog)
+{
+  assert(io);
+  io->backlog = backlog > 0 ? backlog : SOMAXCONN;
+}
+
+int pn_io_set_reuse_port(pn_io_t *io, bool reuse)
+{
+  assert(io);
+  // Windows has no equivalent: SO_REUSEADDR lets another socket take
+  // over the port rather than share its connections.
+  if (reuse) return pn_error_format(io->error, PN_ERR, "SO_REUSEPORT is not supported");
+  return 0;
+}
+
 static void ensure_unique(pn_io_t *io, pn_socket_t new_socket)
 {
   // A brand new socket can have the same HANDLE value as a previous
@@ -212,7 +229,7 @@ pn_socket_t pn_listen(pn_io_t *io, const char *host, const char *port)
   }
   freeaddrinfo(addr);
 
-  if (listen(sock, 50) == -1) {
+  if (listen(sock, io->backlog) == -1) {
     pni_win32_error(io->error, "listen", WSAGetLastError());
     closesocket(sock);
     return INVALID_SOCKET;
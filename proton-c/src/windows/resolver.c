@@ -0,0 +1,131 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Outgoing reactor connections on Windows. Connecting is already
+ * overlapped by the IOCP layer, name lookups are still done inline on
+ * the reactor thread so the resolver thread and cache settings are
+ * accepted but have no effect. A lookup function is honoured.
+ */
+
+#include <proton/connection.h>
+#include <proton/io.h>
+#include <proton/object.h>
+#include <proton/reactor.h>
+#include <proton/transport.h>
+
+#include <string.h>
+
+#include "reactor/reactor.h"
+
+pn_selectable_t *pn_reactor_selectable_transport(pn_reactor_t *reactor, pn_socket_t sock, pn_transport_t *transport);
+
+typedef struct {
+  pn_reactor_lookup_t lookup;
+  void *context;
+} pni_resolver_t;
+
+#define CID_pni_resolver CID_pn_object
+#define pni_resolver_initialize NULL
+#define pni_resolver_finalize NULL
+#define pni_resolver_hashcode NULL
+#define pni_resolver_compare NULL
+#define pni_resolver_inspect NULL
+
+PN_HANDLE(PNI_RESOLVER)
+
+static pni_resolver_t *pni_resolver(pn_reactor_t *reactor)
+{
+  pn_record_t *record = pn_reactor_attachments(reactor);
+  pni_resolver_t *resolver = (pni_resolver_t *) pn_record_get(record, PNI_RESOLVER);
+  if (!resolver) {
+    static const pn_class_t clazz = PN_CLASS(pni_resolver);
+    resolver = (pni_resolver_t *) pn_class_new(&clazz, sizeof(pni_resolver_t));
+    resolver->lookup = NULL;
+    resolver->context = NULL;
+    pn_record_def(record, PNI_RESOLVER, PN_OBJECT);
+    pn_record_set(record, PNI_RESOLVER, resolver);
+    pn_decref(resolver);
+  }
+  return resolver;
+}
+
+void pn_reactor_set_resolver_threads(pn_reactor_t *reactor, int threads)
+{
+  (void) reactor;
+  (void) threads;
+}
+
+void pn_reactor_set_resolver_ttl(pn_reactor_t *reactor, pn_millis_t ttl)
+{
+  (void) reactor;
+  (void) ttl;
+}
+
+void pn_reactor_set_resolver_lookup(pn_reactor_t *reactor, pn_reactor_lookup_t lookup, void *context)
+{
+  pni_resolver_t *resolver = pni_resolver(reactor);
+  resolver->lookup = lookup;
+  resolver->context = context;
+}
+
+static void pni_transport_fail(pn_transport_t *transport, const char *description)
+{
+  pn_condition_t *cond = pn_transport_condition(transport);
+  pn_condition_set_name(cond, "proton:io");
+  pn_condition_set_description(cond, description);
+  pn_transport_close_tail(transport);
+  pn_transport_close_head(transport);
+}
+
+void pni_reactor_connect(pn_reactor_t *reactor, pn_transport_t *transport,
+                         const char *host, const char *port)
+{
+  pni_resolver_t *resolver = pni_resolver(reactor);
+  pn_io_t *io = pn_reactor_io(reactor);
+  pn_string_t *addresses = NULL;
+
+  if (resolver->lookup) {
+    addresses = pn_string("");
+    if (resolver->lookup(resolver->context, host, addresses)) {
+      pn_string_t *error = pn_string(NULL);
+      pn_string_format(error, "lookup(%s): %s", host,
+                       pn_string_size(addresses) ? pn_string_get(addresses) : "failed");
+      pni_transport_fail(transport, pn_string_get(error));
+      pn_free(error);
+      pn_free(addresses);
+      return;
+    }
+    // only the first address is used
+    char *first = pn_string_buffer(addresses);
+    char *space = strchr(first, ' ');
+    if (space) *space = '\0';
+    host = first;
+  }
+
+  pn_socket_t sock = pn_connect(io, host, port);
+  if (sock == PN_INVALID_SOCKET) {
+    pni_transport_fail(transport, pn_error_text(pn_io_error(io)));
+  } else {
+    pn_reactor_selectable_transport(reactor, sock, transport);
+  }
+  pn_free(addresses);
+}
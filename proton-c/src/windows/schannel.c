@@ -649,6 +649,28 @@ int pn_ssl_domain_allow_unsecured_client(pn_ssl_domain_t *domain)
   return 0;
 }
 
+// SChannel keeps its own session cache, which cannot be sized or counted
+// per domain: see pn_ssl_domain_set_session_cache() in ssl.h.
+int pn_ssl_domain_set_session_cache(pn_ssl_domain_t *domain, size_t max_sessions, unsigned int ttl)
+{
+  return PN_ERR;
+}
+
+int pn_ssl_domain_set_session_tickets(pn_ssl_domain_t *domain, bool enable)
+{
+  return PN_ERR;
+}
+
+uint64_t pn_ssl_domain_get_session_hits(pn_ssl_domain_t *domain)
+{
+  return 0;
+}
+
+uint64_t pn_ssl_domain_get_session_misses(pn_ssl_domain_t *domain)
+{
+  return 0;
+}
+
 
 // TODO: This is just an untested guess
 int pn_ssl_get_ssf(pn_ssl_t *ssl0)
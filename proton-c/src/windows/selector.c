@@ -195,19 +195,19 @@ void pn_selector_remove(pn_selector_t *selector, pn_selectable_t *selectable)
     iocpd->selector = NULL;
     iocpd->selectable = NULL;
   }
-  pn_list_del(selector->selectables, idx, 1);
-  pn_list_del(selector->iocp_descriptors, idx, 1);
-  size_t size = pn_list_size(selector->selectables);
-  for (size_t i = idx; i < size; i++) {
-    pn_selectable_t *sel = (pn_selectable_t *) pn_list_get(selector->selectables, i);
-    pni_selectable_set_index(sel, i);
+  // fill the hole from the end rather than sliding everything down,
+  // iteration follows the triggered list so order does not matter
+  size_t last = pn_list_size(selector->selectables) - 1;
+  if ((size_t) idx != last) {
+    pn_selectable_t *sel = (pn_selectable_t *) pn_list_get(selector->selectables, last);
+    pn_list_set(selector->selectables, idx, sel);
+    pn_list_set(selector->iocp_descriptors, idx, pn_list_get(selector->iocp_descriptors, last));
+    pni_selectable_set_index(sel, idx);
   }
+  pn_list_del(selector->selectables, last, 1);
+  pn_list_del(selector->iocp_descriptors, last, 1);
 
   pni_selectable_set_index(selectable, -1);
-
-  if (selector->current >= (size_t) idx) {
-    selector->current--;
-  }
 }
 
 size_t pn_selector_size(pn_selector_t *selector) {
@@ -0,0 +1,207 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Measures the cost of attaching and detaching links on a single
+ * session between a client and a server transport connected in
+ * memory. The client first attaches a working set of links, then
+ * repeatedly detaches its oldest link and attaches a new one until
+ * the total number of attaches is reached, then detaches the rest.
+ * Last it frees an unbound connection holding a working set of links
+ * on each of a few sessions, which shows the cost of tearing down a
+ * big client.
+ *
+ * usage: link-churn [total-links [working-set]]
+ */
+
+#include "pncompat/misc_funcs.inc"
+
+#include <proton/connection.h>
+#include <proton/event.h>
+#include <proton/link.h>
+#include <proton/session.h>
+#include <proton/transport.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BATCH 1000
+#define TEARDOWN_SESSIONS 4
+
+typedef struct {
+  pn_connection_t *connection;
+  pn_transport_t *transport;
+  pn_collector_t *collector;
+} peer_t;
+
+static void die(const char *message)
+{
+  fprintf(stderr, "link-churn: %s\n", message);
+  exit(1);
+}
+
+static void peer_init(peer_t *peer, bool server)
+{
+  peer->connection = pn_connection();
+  peer->transport = pn_transport();
+  peer->collector = pn_collector();
+  if (server) pn_transport_set_server(peer->transport);
+  pn_connection_collect(peer->connection, peer->collector);
+  pn_transport_bind(peer->transport, peer->connection);
+  pn_connection_open(peer->connection);
+}
+
+static void peer_free(peer_t *peer)
+{
+  pn_transport_unbind(peer->transport);
+  pn_transport_free(peer->transport);
+  pn_connection_free(peer->connection);
+  pn_collector_free(peer->collector);
+}
+
+// Move as much output from one transport to the input of the other as
+// it can take.
+static size_t pump_one(pn_transport_t *from, pn_transport_t *to)
+{
+  ssize_t pending = pn_transport_pending(from);
+  ssize_t capacity = pn_transport_capacity(to);
+  if (pending <= 0 || capacity <= 0) return 0;
+  size_t n = pending < capacity ? pending : capacity;
+  memcpy(pn_transport_tail(to), pn_transport_head(from), n);
+  if (pn_transport_process(to, n) < 0) die("transport error");
+  pn_transport_pop(from, n);
+  return n;
+}
+
+// Open whatever the peer opens and close whatever it closes.  Links
+// are freed once closed at both ends.
+static void handle(peer_t *peer)
+{
+  pn_event_t *event;
+  while ((event = pn_collector_peek(peer->collector))) {
+    switch (pn_event_type(event)) {
+    case PN_SESSION_REMOTE_OPEN: {
+      pn_session_t *ssn = pn_event_session(event);
+      if (pn_session_state(ssn) & PN_LOCAL_UNINIT) pn_session_open(ssn);
+      break;
+    }
+    case PN_LINK_REMOTE_OPEN: {
+      pn_link_t *link = pn_event_link(event);
+      if (pn_link_state(link) & PN_LOCAL_UNINIT) pn_link_open(link);
+      break;
+    }
+    case PN_LINK_REMOTE_CLOSE: {
+      pn_link_t *link = pn_event_link(event);
+      if (pn_link_state(link) & PN_LOCAL_ACTIVE) pn_link_close(link);
+      pn_link_free(link);
+      break;
+    }
+    default:
+      break;
+    }
+    pn_collector_pop(peer->collector);
+  }
+}
+
+static void pump(peer_t *a, peer_t *b)
+{
+  do {
+    handle(a);
+    handle(b);
+  } while (pump_one(a->transport, b->transport) + pump_one(b->transport, a->transport));
+}
+
+static pn_link_t *attach(pn_session_t *ssn, long id)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "link-%ld", id);
+  pn_link_t *link = pn_sender(ssn, name);
+  pn_link_open(link);
+  return link;
+}
+
+static void report(const char *phase, long count, pn_timestamp_t elapsed)
+{
+  if (!elapsed) elapsed = 1;
+  printf("%-8s %8ld links %8lu ms %10.0f links/sec\n", phase, count,
+         (unsigned long) elapsed, count * 1000.0 / elapsed);
+  fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  long total = argc > 1 ? atol(argv[1]) : 100000;
+  long working = argc > 2 ? atol(argv[2]) : 20000;
+  if (working > total) working = total;
+  if (working < 1 || working > 65536) die("working set must be between 1 and 65536");
+
+  peer_t client, server;
+  peer_init(&client, false);
+  peer_init(&server, true);
+  pn_session_t *ssn = pn_session(client.connection);
+  pn_session_open(ssn);
+  pump(&client, &server);
+
+  // a ring of the links the client has open, oldest first
+  pn_link_t **links = (pn_link_t **) calloc(working, sizeof(pn_link_t *));
+  long attached = 0, oldest = 0;
+
+  pn_timestamp_t start = time_now();
+  while (attached < working) {
+    links[attached % working] = attach(ssn, attached);
+    if (++attached % BATCH == 0) pump(&client, &server);
+  }
+  pump(&client, &server);
+  report("attach", working, time_now() - start);
+
+  start = time_now();
+  while (attached < total) {
+    pn_link_close(links[oldest % working]);
+    oldest++;
+    links[attached % working] = attach(ssn, attached);
+    if (++attached % BATCH == 0) pump(&client, &server);
+  }
+  pump(&client, &server);
+  report("churn", total - working, time_now() - start);
+
+  start = time_now();
+  long remaining = attached - oldest;
+  while (oldest < attached) {
+    pn_link_close(links[oldest % working]);
+    if (++oldest % BATCH == 0) pump(&client, &server);
+  }
+  pump(&client, &server);
+  report("detach", remaining, time_now() - start);
+
+  free(links);
+  peer_free(&client);
+  peer_free(&server);
+
+  pn_connection_t *conn = pn_connection();
+  for (int i = 0; i < TEARDOWN_SESSIONS; i++) {
+    pn_session_t *s = pn_session(conn);
+    for (long j = 0; j < working; j++) attach(s, j);
+  }
+  start = time_now();
+  pn_connection_free(conn);
+  report("teardown", working * TEARDOWN_SESSIONS, time_now() - start);
+  return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Measures pn_hash and pn_map under the access patterns the engine
+ * uses them for:
+ *
+ *   window   a sliding window of sequential delivery ids: put the
+ *            newest, look up a recent one, delete the oldest
+ *   handles  small integer handles and channels attached and detached
+ *            at random, looked up on every frame
+ *   names    string keyed lookups, hits and misses, as for link names
+ *            and connection properties
+ *   drain    fill then iterate, deleting each entry as it is visited,
+ *            as unbinding a transport does
+ *
+ * usage: map-bench [operations]
+ */
+
+#include "pncompat/misc_funcs.inc"
+
+#include <proton/object.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void report(const char *name, long ops, pn_timestamp_t elapsed, uintptr_t check)
+{
+  if (!elapsed) elapsed = 1;
+  printf("%-8s %10ld ops %8lu ms %12.0f ops/sec (%lu)\n", name, ops,
+         (unsigned long) elapsed, ops * 1000.0 / elapsed, (unsigned long) check);
+  fflush(stdout);
+}
+
+static uint32_t next_random(uint32_t *state)
+{
+  *state = *state * 1103515245 + 12345;
+  return *state >> 8;
+}
+
+static void window(long ops, int width)
+{
+  pn_hash_t *hash = pn_hash(PN_VOID, 0, 0.75);
+  uintptr_t check = 0;
+  pn_timestamp_t start = time_now();
+  for (long id = 0; id < ops; id++) {
+    pn_hash_put(hash, id, (void *) (uintptr_t) (id + 1));
+    check += (uintptr_t) pn_hash_get(hash, id - width/2);
+    if (id >= width) pn_hash_del(hash, id - width);
+  }
+  report("window", ops, time_now() - start, check);
+  pn_free(hash);
+}
+
+static void handles(long ops, int max)
+{
+  pn_hash_t *hash = pn_hash(PN_VOID, 0, 0.75);
+  uint32_t seed = 1;
+  uintptr_t check = 0;
+  pn_timestamp_t start = time_now();
+  for (long i = 0; i < ops; i++) {
+    uintptr_t handle = next_random(&seed) % max;
+    if (i % 8 == 0) {
+      if (pn_hash_get(hash, handle)) {
+        pn_hash_del(hash, handle);
+      } else {
+        pn_hash_put(hash, handle, (void *) (handle + 1));
+      }
+    } else {
+      check += (uintptr_t) pn_hash_get(hash, handle);
+    }
+  }
+  report("handles", ops, time_now() - start, check);
+  pn_free(hash);
+}
+
+static void names(long ops, int count)
+{
+  pn_map_t *map = pn_map(PN_OBJECT, PN_VOID, 0, 0.75);
+  pn_string_t **keys = (pn_string_t **) malloc(2 * count * sizeof(pn_string_t *));
+  for (int i = 0; i < 2 * count; i++) {
+    keys[i] = pn_string(NULL);
+    pn_string_format(keys[i], "receiver-%d-%s", i, "amqp://host/queue");
+  }
+  for (int i = 0; i < count; i++) {
+    pn_map_put(map, keys[i], (void *) (uintptr_t) (i + 1));
+  }
+  uint32_t seed = 1;
+  uintptr_t check = 0;
+  pn_timestamp_t start = time_now();
+  for (long i = 0; i < ops; i++) {
+    check += (uintptr_t) pn_map_get(map, keys[next_random(&seed) % (2 * count)]);
+  }
+  report("names", ops, time_now() - start, check);
+  pn_free(map);
+  for (int i = 0; i < 2 * count; i++) pn_free(keys[i]);
+  free(keys);
+}
+
+static void drain(long ops, int count)
+{
+  pn_hash_t *hash = pn_hash(PN_VOID, 0, 0.75);
+  uintptr_t check = 0;
+  long done = 0;
+  pn_timestamp_t start = time_now();
+  while (done < ops) {
+    for (int i = 0; i < count; i++) {
+      pn_hash_put(hash, done + i, (void *) (uintptr_t) 1);
+    }
+    for (pn_handle_t entry = pn_hash_head(hash); entry; entry = pn_hash_next(hash, entry)) {
+      check += (uintptr_t) pn_hash_value(hash, entry);
+      pn_hash_del(hash, pn_hash_key(hash, entry));
+    }
+    done += count;
+  }
+  report("drain", done, time_now() - start, check);
+  pn_free(hash);
+}
+
+int main(int argc, char **argv)
+{
+  long ops = argc > 1 ? atol(argv[1]) : 10000000;
+  window(ops, 2048);
+  handles(ops, 1024);
+  names(ops, 1000);
+  drain(ops, 1000);
+  return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Measures transfer throughput between a client and a server transport
+ * connected in memory, with and without TLS, for a range of message
+ * sizes, then the rate of full and resumed TLS handshakes. No sockets
+ * are involved so the figures show the cost of the protocol and TLS
+ * layers alone.
+ *
+ * usage: tls-bench [certificate-directory]
+ */
+
+#include "pncompat/misc_funcs.inc"
+
+#include <proton/connection.h>
+#include <proton/delivery.h>
+#include <proton/link.h>
+#include <proton/session.h>
+#include <proton/ssl.h>
+#include <proton/transport.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SSL_DB
+#define SSL_DB "."
+#endif
+
+#define VOLUME (64*1024*1024)
+#define HANDSHAKES 2000
+
+typedef struct {
+  pn_connection_t *connection;
+  pn_transport_t *transport;
+} peer_t;
+
+static void die(const char *message)
+{
+  fprintf(stderr, "tls-bench: %s\n", message);
+  exit(1);
+}
+
+static void peer_init(peer_t *peer, bool server, pn_ssl_domain_t *domain, const char *session_id)
+{
+  peer->connection = pn_connection();
+  peer->transport = pn_transport();
+  if (server) pn_transport_set_server(peer->transport);
+  if (domain && pn_ssl_init(pn_ssl(peer->transport), domain, session_id)) {
+    die("pn_ssl_init failed");
+  }
+  pn_transport_bind(peer->transport, peer->connection);
+  pn_connection_open(peer->connection);
+}
+
+static void peer_free(peer_t *peer)
+{
+  pn_transport_unbind(peer->transport);
+  pn_transport_free(peer->transport);
+  pn_connection_free(peer->connection);
+}
+
+// Move as much output from one transport to the input of the other as
+// it can take.
+static size_t pump_one(pn_transport_t *from, pn_transport_t *to)
+{
+  ssize_t pending = pn_transport_pending(from);
+  ssize_t capacity = pn_transport_capacity(to);
+  if (pending <= 0 || capacity <= 0) return 0;
+  size_t n = pending < capacity ? pending : capacity;
+  memcpy(pn_transport_tail(to), pn_transport_head(from), n);
+  if (pn_transport_process(to, n) < 0) die("transport error");
+  pn_transport_pop(from, n);
+  return n;
+}
+
+static void pump(peer_t *a, peer_t *b)
+{
+  while (pump_one(a->transport, b->transport) + pump_one(b->transport, a->transport));
+}
+
+// Open whatever the peer opened.
+static void accept_remote(pn_connection_t *connection)
+{
+  for (pn_session_t *ssn = pn_session_head(connection, PN_LOCAL_UNINIT); ssn;
+       ssn = pn_session_next(ssn, PN_LOCAL_UNINIT)) {
+    pn_session_open(ssn);
+  }
+  for (pn_link_t *link = pn_link_head(connection, PN_LOCAL_UNINIT); link;
+       link = pn_link_next(link, PN_LOCAL_UNINIT)) {
+    pn_link_open(link);
+  }
+}
+
+static pn_link_t *first_receiver(pn_connection_t *connection)
+{
+  for (pn_link_t *link = pn_link_head(connection, 0); link; link = pn_link_next(link, 0)) {
+    if (pn_link_is_receiver(link)) return link;
+  }
+  return NULL;
+}
+
+// Send count messages of size bytes from client to server, returns the
+// elapsed time in milliseconds.
+static pn_timestamp_t run(pn_ssl_domain_t *client_domain, pn_ssl_domain_t *server_domain,
+                          size_t size, long count)
+{
+  peer_t client, server;
+  peer_init(&client, false, client_domain, NULL);
+  peer_init(&server, true, server_domain, NULL);
+
+  pn_session_t *ssn = pn_session(client.connection);
+  pn_session_open(ssn);
+  pn_link_t *snd = pn_sender(ssn, "bench");
+  pn_link_set_snd_settle_mode(snd, PN_SND_SETTLED);
+  pn_link_open(snd);
+  pump(&client, &server);
+  accept_remote(server.connection);
+  pn_link_t *rcv = first_receiver(server.connection);
+  if (!rcv) die("no receiver");
+  // keep about a megabyte in flight
+  int window = size < 1024 ? 1024 : (int) (1024*1024 / size) + 1;
+  pn_link_flow(rcv, window);
+  pump(&client, &server);
+
+  char *payload = (char *) calloc(1, size);
+  char *buffer = (char *) malloc(size);
+  long sent = 0, received = 0;
+  pn_timestamp_t start = time_now();
+  while (received < count) {
+    while (sent < count && pn_link_credit(snd) > 0) {
+      pn_delivery_t *d = pn_delivery(snd, pn_dtag((const char *) &sent, sizeof(sent)));
+      pn_link_send(snd, payload, size);
+      pn_link_advance(snd);
+      pn_delivery_settle(d);
+      sent++;
+    }
+    pump(&client, &server);
+    for (pn_delivery_t *d = pn_link_current(rcv);
+         d && pn_delivery_readable(d) && !pn_delivery_partial(d);
+         d = pn_link_current(rcv)) {
+      size_t total = 0;
+      ssize_t n;
+      while ((n = pn_link_recv(rcv, buffer, size)) > 0) total += n;
+      if (total != size) die("short message");
+      pn_link_advance(rcv);
+      pn_delivery_settle(d);
+      received++;
+    }
+    pn_link_flow(rcv, window - pn_link_credit(rcv));
+    pump(&client, &server);
+  }
+  pn_timestamp_t elapsed = time_now() - start;
+
+  free(payload);
+  free(buffer);
+  peer_free(&client);
+  peer_free(&server);
+  return elapsed ? elapsed : 1;
+}
+
+// Open and cleanly close count connections, returns the elapsed time in
+// milliseconds.  With resume each client asks to resume the session of
+// the previous one.
+static pn_timestamp_t handshakes(pn_ssl_domain_t *client_domain, pn_ssl_domain_t *server_domain,
+                                 long count, bool resume)
+{
+  pn_timestamp_t start = time_now();
+  for (long i = 0; i < count; i++) {
+    peer_t client, server;
+    peer_init(&client, false, client_domain, resume ? "tls-bench" : NULL);
+    peer_init(&server, true, server_domain, NULL);
+    pump(&client, &server);
+    pn_connection_close(client.connection);
+    pn_connection_close(server.connection);
+    pump(&client, &server);
+    peer_free(&client);
+    peer_free(&server);
+  }
+  pn_timestamp_t elapsed = time_now() - start;
+  return elapsed ? elapsed : 1;
+}
+
+int main(int argc, char **argv)
+{
+  const char *db = argc > 1 ? argv[1] : SSL_DB;
+  char cert[1024], key[1024];
+  snprintf(cert, sizeof(cert), "%s/server-certificate.pem", db);
+  snprintf(key, sizeof(key), "%s/server-private-key.pem", db);
+
+  pn_ssl_domain_t *server_domain = NULL, *client_domain = NULL;
+  if (pn_ssl_present()) {
+    server_domain = pn_ssl_domain(PN_SSL_MODE_SERVER);
+    if (pn_ssl_domain_set_credentials(server_domain, cert, key, "server-password")) {
+      fprintf(stderr, "tls-bench: cannot load server credentials from %s\n", db);
+      return 1;
+    }
+    client_domain = pn_ssl_domain(PN_SSL_MODE_CLIENT);
+    pn_ssl_domain_set_peer_authentication(client_domain, PN_SSL_ANONYMOUS_PEER, NULL);
+  } else {
+    printf("SSL is not available, measuring plain transfers only\n");
+  }
+
+  size_t sizes[] = {128, 1024, 16*1024, 64*1024, 1024*1024};
+  for (size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+    size_t size = sizes[i];
+    long count = VOLUME / size;
+    pn_timestamp_t plain = run(NULL, NULL, size, count);
+    printf("%8zu bytes plain: %8.1f MB/s %10.0f msgs/sec", size,
+           (double) count * size / 1000.0 / plain, count * 1000.0 / plain);
+    if (server_domain) {
+      pn_timestamp_t tls = run(client_domain, server_domain, size, count);
+      printf("   tls: %8.1f MB/s %10.0f msgs/sec",
+             (double) count * size / 1000.0 / tls, count * 1000.0 / tls);
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+
+  if (server_domain) {
+    pn_timestamp_t full = handshakes(client_domain, server_domain, HANDSHAKES, false);
+    printf("full handshakes:    %8.0f /sec\n", HANDSHAKES * 1000.0 / full);
+    pn_timestamp_t resumed = handshakes(client_domain, server_domain, HANDSHAKES, true);
+    printf("resumed handshakes: %8.0f /sec (client hits %llu misses %llu)\n",
+           HANDSHAKES * 1000.0 / resumed,
+           (unsigned long long) pn_ssl_domain_get_session_hits(client_domain),
+           (unsigned long long) pn_ssl_domain_get_session_misses(client_domain));
+  }
+
+  if (server_domain) pn_ssl_domain_free(server_domain);
+  if (client_domain) pn_ssl_domain_free(client_domain);
+  return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Measures messenger route/rewrite throughput as the number of rules
+ * grows. Each table holds one wildcard route per host plus a catch-all
+ * at the end, the shape of a large pn_messenger_route configuration.
+ */
+
+#include "pncompat/misc_funcs.inc"
+#include "messenger/transform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ADDRESSES (4096)
+
+static void check(pn_transform_t *transform, const char *src, const char *expected)
+{
+  pn_string_t *dst = pn_string(NULL);
+  pn_transform_apply(transform, src, dst);
+  if (strcmp(pn_string_get(dst), expected)) {
+    fprintf(stderr, "%s: expected %s, got %s\n", src, expected, pn_string_get(dst));
+    exit(1);
+  }
+  pn_free(dst);
+}
+
+static pn_transform_t *routes(int rules)
+{
+  pn_transform_t *transform = pn_transform();
+  char pattern[64], substitution[64];
+  for (int i = 0; i < rules; i++) {
+    sprintf(pattern, "amqp://host-%d/%%", i);
+    sprintf(substitution, "amqp://relay-%d/$1", i % 16);
+    pn_transform_rule(transform, pattern, substitution);
+  }
+  pn_transform_rule(transform, "*", "amqp://default/$1");
+  return transform;
+}
+
+static void run(int rules, int distinct, long iterations)
+{
+  pn_transform_t *transform = routes(rules);
+  pn_string_t *dst = pn_string(NULL);
+  char **addresses = (char **) malloc(distinct * sizeof(char *));
+  for (int i = 0; i < distinct; i++) {
+    addresses[i] = (char *) malloc(64);
+    // one in eight addresses falls through to the catch-all
+    sprintf(addresses[i], "amqp://host-%d/queue-%d", (i % 8) ? (i * 7919) % rules : rules + i, i);
+  }
+
+  check(transform, "amqp://host-0/q", "amqp://relay-0/q");
+  check(transform, "amqp://host-0/q/r", "amqp://default/amqp://host-0/q/r");
+
+  pn_timestamp_t start = time_now();
+  for (long i = 0; i < iterations; i++) {
+    pn_transform_apply(transform, addresses[i % distinct], dst);
+  }
+  pn_timestamp_t elapsed = time_now() - start;
+  if (!elapsed) elapsed = 1;
+  printf("%8d rules %6d addresses: %10.0f routes/sec\n", rules, distinct,
+         (double) iterations * 1000 / elapsed);
+
+  for (int i = 0; i < distinct; i++) free(addresses[i]);
+  free(addresses);
+  pn_free(dst);
+  pn_free(transform);
+}
+
+int main(int argc, char **argv)
+{
+  long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+  static const int rules[] = {1, 10, 100, 1000, 10000};
+  for (size_t i = 0; i < sizeof(rules)/sizeof(rules[0]); i++) {
+    // a working set that fits the memo cache, and one that defeats it
+    run(rules[i], 256, iterations);
+    run(rules[i], ADDRESSES, iterations);
+  }
+  return 0;
+}
@@ -0,0 +1,672 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * In-process micro-benchmarks of the codec, framing, engine and C++
+ * binding. Nothing here touches a socket, and every benchmark works on
+ * the same fixed data each run, so results can be compared from one
+ * build to the next. Transports and engines are connected with
+ * pn_transport_pair and connection_engine_pair.
+ *
+ * Each benchmark is calibrated to run for about --time milliseconds,
+ * then run --repeat times. The fastest and median runs are reported,
+ * as text or, with --json, as a JSON document for regression tracking.
+ *
+ * usage: proton-bench [--time ms] [--repeat n] [--json file] [--list] [name-prefix...]
+ */
+
+#include "framing/framing.h"
+
+#include <proton/codec.h>
+#include <proton/engine.h>
+#include <proton/message.h>
+
+#include <proton/connection.hpp>
+#include <proton/delivery.hpp>
+#include <proton/handler.hpp>
+#include <proton/id_generator.hpp>
+#include <proton/io/connection_engine.hpp>
+#include <proton/io/connection_engine_pair.hpp>
+#include <proton/message.hpp>
+#include <proton/message_id.hpp>
+#include <proton/receiver.hpp>
+#include <proton/sender.hpp>
+#include <proton/uuid.hpp>
+#include <proton/value.hpp>
+#include <proton/map.hpp>
+#include <proton/vector.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+#if __cplusplus < 201103L
+#define override
+#endif
+
+namespace {
+
+uint64_t now_ns() {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return uint64_t(now.QuadPart / freq.QuadPart) * 1000000000 +
+        uint64_t(now.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return uint64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+#else
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return uint64_t(now.tv_sec) * 1000000000 + uint64_t(now.tv_usec) * 1000;
+#endif
+}
+
+// Results are folded in here so the compiler cannot discard the work.
+volatile size_t sink;
+
+/// A benchmark does the same operation n times in run(). Anything it
+/// needs is built once in the constructor, outside the timed region.
+struct benchmark {
+    const char* name;
+    size_t bytes;               // bytes processed per operation, 0 if not meaningful
+
+    benchmark(const char* n, size_t b=0) : name(n), bytes(b) {}
+    virtual ~benchmark() {}
+    virtual void run(long n) = 0;
+};
+
+// The application-properties and body of a typical small message.
+void fill_properties(pn_data_t* data) {
+    pn_data_put_map(data);
+    pn_data_enter(data);
+    static const char* keys[] = { "colour", "size", "region", "priority", "trace" };
+    for (int i = 0; i < 5; ++i) {
+        pn_data_put_string(data, pn_bytes(strlen(keys[i]), keys[i]));
+        if (i % 2) pn_data_put_long(data, i * 1000);
+        else pn_data_put_string(data, pn_bytes(5, "value"));
+    }
+    pn_data_exit(data);
+}
+
+void fill_body(pn_data_t* data) {
+    pn_data_put_list(data);
+    pn_data_enter(data);
+    for (int i = 0; i < 16; ++i) pn_data_put_int(data, i);
+    pn_data_put_string(data, pn_bytes(11, "hello world"));
+    pn_data_put_double(data, 3.25);
+    pn_data_put_bool(data, true);
+    pn_data_exit(data);
+}
+
+pn_message_t* c_message() {
+    pn_message_t* m = pn_message();
+    pn_message_set_address(m, "amqp://example.com/queue");
+    pn_message_set_subject(m, "benchmark");
+    pn_data_put_ulong(pn_message_id(m), 42);
+    pn_message_set_durable(m, true);
+    fill_properties(pn_message_properties(m));
+    fill_body(pn_message_body(m));
+    return m;
+}
+
+proton::message cpp_message() {
+    proton::message m;
+    m.address("amqp://example.com/queue");
+    m.subject("benchmark");
+    m.id(uint64_t(42));
+    m.durable(true);
+    m.properties()["colour"] = std::string("value");
+    m.properties()["size"] = int64_t(1000);
+    m.properties()["region"] = std::string("value");
+    m.properties()["priority"] = int64_t(3000);
+    m.properties()["trace"] = std::string("value");
+    m.body(std::string(128, 'x'));
+    return m;
+}
+
+struct data_encode : public benchmark {
+    pn_data_t* data;
+    char buf[1024];
+
+    data_encode() : benchmark("data_encode"), data(pn_data(0)) {
+        fill_properties(data);
+        fill_body(data);
+        bytes = pn_data_encode(data, buf, sizeof(buf));
+    }
+    ~data_encode() { pn_data_free(data); }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) sink += pn_data_encode(data, buf, sizeof(buf));
+    }
+};
+
+struct data_decode : public benchmark {
+    pn_data_t* data;
+    char buf[1024];
+
+    data_decode() : benchmark("data_decode"), data(pn_data(0)) {
+        fill_properties(data);
+        fill_body(data);
+        bytes = pn_data_encode(data, buf, sizeof(buf));
+    }
+    ~data_decode() { pn_data_free(data); }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) {
+            pn_data_clear(data);
+            sink += pn_data_decode(data, buf, bytes);
+        }
+    }
+};
+
+struct message_encode : public benchmark {
+    pn_message_t* msg;
+    char buf[2048];
+
+    message_encode() : benchmark("message_encode"), msg(c_message()) {
+        size_t size = sizeof(buf);
+        pn_message_encode(msg, buf, &size);
+        bytes = size;
+    }
+    ~message_encode() { pn_message_free(msg); }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) {
+            size_t size = sizeof(buf);
+            pn_message_encode(msg, buf, &size);
+            sink += size;
+        }
+    }
+};
+
+struct message_decode : public benchmark {
+    pn_message_t* msg;
+    char buf[2048];
+
+    message_decode() : benchmark("message_decode"), msg(c_message()) {
+        size_t size = sizeof(buf);
+        pn_message_encode(msg, buf, &size);
+        bytes = size;
+    }
+    ~message_decode() { pn_message_free(msg); }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) sink += pn_message_decode(msg, buf, bytes);
+    }
+};
+
+// A transfer frame header followed by a payload of the given size.
+struct frame_write : public benchmark {
+    std::vector<char> payload, out;
+    pn_frame_t frame;
+
+    frame_write(const char* name, size_t size) : benchmark(name), payload(size, 'x'), out(size + 64) {
+        frame.type = 0;
+        frame.channel = 1;
+        frame.ex_size = 0;
+        frame.extended = NULL;
+        frame.size = payload.size();
+        frame.payload = &payload[0];
+        bytes = pn_write_frame(&out[0], out.size(), frame);
+    }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) sink += pn_write_frame(&out[0], out.size(), frame);
+    }
+};
+
+// Split a buffer of back to back frames, as the transport's input does.
+struct frame_read : public benchmark {
+    std::vector<char> in;
+    size_t frames;
+
+    frame_read(const char* name, size_t size) : benchmark(name), in(64 * (size + 8)), frames(64) {
+        std::vector<char> payload(size, 'x');
+        pn_frame_t frame = { 0, 1, 0, NULL, size, &payload[0] };
+        size_t at = 0;
+        for (size_t i = 0; i < frames; ++i) at += pn_write_frame(&in[at], in.size() - at, frame);
+    }
+
+    void run(long n) override {
+        pn_frame_t frame;
+        size_t at = 0;
+        for (long i = 0; i < n; ++i) {
+            ssize_t size = pn_read_frame(&frame, &in[at], in.size() - at, 0);
+            sink += frame.size;
+            at = (at + size) % in.size();
+        }
+    }
+};
+
+// Send and settle deliveries over a pair of C transports.
+struct transport_transfer : public benchmark {
+    pn_connection_t *c1, *c2;
+    pn_transport_t *t1, *t2;
+    pn_transport_pair_t* pair;
+    pn_link_t *tx, *rx;
+    std::vector<char> payload;
+
+    transport_transfer() : benchmark("transport_transfer", 256), payload(256, 'x') {
+        c1 = pn_connection(); t1 = pn_transport(); pn_transport_bind(t1, c1);
+        c2 = pn_connection(); t2 = pn_transport(); pn_transport_set_server(t2); pn_transport_bind(t2, c2);
+        pair = pn_transport_pair(t1, t2);
+        pn_connection_open(c1);
+        pn_session_t* ssn = pn_session(c1);
+        pn_session_open(ssn);
+        tx = pn_sender(ssn, "bench");
+        pn_link_open(tx);
+        pump();
+        pn_connection_open(c2);
+        pn_session_open(pn_session_head(c2, 0));
+        rx = pn_link_head(c2, 0);
+        pn_link_open(rx);
+        pump();
+    }
+
+    ~transport_transfer() {
+        pn_transport_pair_free(pair);
+        pn_transport_unbind(t1); pn_transport_free(t1); pn_connection_free(c1);
+        pn_transport_unbind(t2); pn_transport_free(t2); pn_connection_free(c2);
+    }
+
+    void pump() { pn_transport_pair_pump(pair); }
+
+    void run(long n) override {
+        unsigned tag = 0;
+        for (long done = 0; done < n;) {
+            long batch = std::min(n - done, 64L);
+            pn_link_flow(rx, int(batch));
+            pump();
+            for (long i = 0; i < batch; ++i, ++tag) {
+                pn_delivery(tx, pn_dtag(reinterpret_cast<char*>(&tag), sizeof(tag)));
+                pn_link_send(tx, &payload[0], payload.size());
+                pn_link_advance(tx);
+            }
+            pump();
+            for (pn_delivery_t* d = pn_link_current(rx); d; d = pn_link_current(rx)) {
+                sink += pn_delivery_pending(d);
+                pn_link_advance(rx);
+                pn_delivery_update(d, PN_ACCEPTED);
+                pn_delivery_settle(d);
+                ++done;
+            }
+            pump();
+            for (pn_delivery_t* d = pn_unsettled_head(tx); d; d = pn_unsettled_head(tx)) {
+                pn_delivery_settle(d);
+            }
+            pump();
+        }
+    }
+};
+
+using proton::io::connection_engine;
+
+struct send_handler : public proton::handler {
+    proton::message msg;
+    proton::sender sender;
+    long remaining;
+
+    send_handler() : msg(cpp_message()), remaining(0) {}
+
+    void on_sender_open(proton::sender& s) override { sender = s; }
+
+    void on_sendable(proton::sender& s) override { send(s); }
+
+    void send(proton::sender& s) {
+        for (; remaining > 0 && s.credit() > 0; --remaining) s.send(msg);
+    }
+};
+
+struct receive_handler : public proton::handler {
+    long received;
+
+    receive_handler() : received(0) {}
+
+    void on_message(proton::delivery&, proton::message& m) override {
+        sink += m.body().empty() ? 0 : 1;
+        ++received;
+    }
+};
+
+// Send, receive, accept and settle messages between a pair of
+// connection_engines, as an application would see them.
+struct engine_transfer : public benchmark {
+    send_handler hs;
+    receive_handler hr;
+    connection_engine a, b;
+    proton::io::connection_engine_pair link;
+
+    engine_transfer() : benchmark("engine_transfer"), a(hs), b(hr), link(a, b) {
+        bytes = hs.msg.encode().size();
+        a.connection().open();
+        a.connection().open_sender("bench");
+        while (!hs.sender || !hs.sender.active()) pump();
+    }
+
+    void pump() { link.process(); }
+
+    void run(long n) override {
+        long target = hr.received + n;
+        hs.remaining += n;
+        hs.send(hs.sender);
+        while (hr.received < target) {
+            pump();
+            hs.send(hs.sender);
+        }
+        pump();
+    }
+};
+
+struct cpp_message_copy : public benchmark {
+    proton::message msg;
+
+    cpp_message_copy() : benchmark("cpp_message_copy"), msg(cpp_message()) {}
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) {
+            proton::message copy(msg);
+            sink += copy.properties().size();
+        }
+    }
+};
+
+struct cpp_message_codec : public benchmark {
+    proton::message msg, decoded;
+    std::vector<char> buf;
+
+    cpp_message_codec() : benchmark("cpp_message_codec"), msg(cpp_message()) {
+        msg.encode(buf);
+        bytes = buf.size();
+    }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) {
+            msg.encode(buf);
+            decoded.decode(buf);
+            sink += decoded.properties().size();
+        }
+    }
+};
+
+// Decode a message carrying tracing annotations and read them back.
+struct cpp_message_annotations : public benchmark {
+    std::vector<char> buf;
+
+    cpp_message_annotations() : benchmark("cpp_message_annotations") {
+        proton::message m(cpp_message());
+        for (int i = 0; i < 16; ++i) {
+            std::ostringstream key;
+            key << "x-trace-" << i;
+            m.message_annotations()[proton::symbol(key.str())] = int64_t(i);
+        }
+        m.encode(buf);
+        bytes = buf.size();
+    }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) {
+            proton::message m;
+            m.decode(buf);
+            const proton::message::annotation_map& a = m.message_annotations();
+            for (proton::message::annotation_map::const_iterator j = a.begin(); j != a.end(); ++j)
+                sink += size_t(proton::get<int64_t>(j->second));
+        }
+    }
+};
+
+// Decode a message and match a selector on one of its properties, as a
+// broker filtering a subscription would.
+struct cpp_message_selector : public benchmark {
+    std::vector<char> buf;
+
+    cpp_message_selector() : benchmark("cpp_message_selector") {
+        proton::message m(cpp_message());
+        for (int i = 0; i < 16; ++i) {
+            std::ostringstream key;
+            key << "prop-" << i;
+            m.properties()[key.str()] = int64_t(i);
+        }
+        m.properties()["region"] = "eu-west";
+        m.encode(buf);
+        bytes = buf.size();
+    }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) {
+            proton::message m;
+            m.decode(buf);
+            proton::scalar region = m.property("region");
+            sink += proton::get<proton::string_view>(region) == "eu-west";
+        }
+    }
+};
+
+// Name links and connections as the library does.
+struct cpp_id_generator : public benchmark {
+    proton::id_generator gen;
+
+    cpp_id_generator() : benchmark("cpp_id_generator"), gen(proton::uuid::random().str() + "/") {}
+
+    void run(long n) override {
+        char name[128];
+        for (long i = 0; i < n; ++i) {
+            sink += gen.next(name, sizeof(name));
+            sink += gen.next().size();
+            sink += size_t(proton::uuid::random()[0]);
+        }
+    }
+};
+
+struct cpp_value_scalar : public benchmark {
+    cpp_value_scalar() : benchmark("cpp_value_scalar") {}
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) {
+            proton::value v = int64_t(i);
+            sink += size_t(proton::get<int64_t>(v));
+            v = std::string("short string");
+            sink += proton::get<std::string>(v).size();
+        }
+    }
+};
+
+struct cpp_value_map : public benchmark {
+    std::map<std::string, int32_t> map;
+
+    cpp_value_map() : benchmark("cpp_value_map") {
+        static const char* keys[] = { "colour", "size", "region", "priority", "trace" };
+        for (int i = 0; i < 5; ++i) map[keys[i]] = i;
+    }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) {
+            proton::value v(map);
+            std::map<std::string, int32_t> out;
+            proton::get(v, out);
+            sink += out.size();
+        }
+    }
+};
+
+struct cpp_value_vector : public benchmark {
+    std::vector<int32_t> vec;
+
+    cpp_value_vector() : benchmark("cpp_value_vector"), vec(64) {
+        for (size_t i = 0; i < vec.size(); ++i) vec[i] = int32_t(i);
+    }
+
+    void run(long n) override {
+        for (long i = 0; i < n; ++i) {
+            proton::value v(vec);
+            std::vector<int32_t> out;
+            proton::get(v, out);
+            sink += out.size();
+        }
+    }
+};
+
+struct result {
+    std::string name;
+    long iterations;
+    double best_ns, median_ns;
+    size_t bytes;
+};
+
+uint64_t time_run(benchmark& b, long n) {
+    uint64_t start = now_ns();
+    b.run(n);
+    return now_ns() - start;
+}
+
+result measure(benchmark& b, uint64_t target_ns, int repeat) {
+    // Grow the batch until it takes a tenth of the target, then scale.
+    long n = 1;
+    uint64_t t = time_run(b, n);
+    while (t < target_ns / 10 && n < (1L << 30)) {
+        n *= 2;
+        t = time_run(b, n);
+    }
+    if (t) n = std::max(1L, long(double(n) * target_ns / t));
+    std::vector<double> per_op;
+    for (int i = 0; i < repeat; ++i) per_op.push_back(double(time_run(b, n)) / n);
+    std::sort(per_op.begin(), per_op.end());
+    result r;
+    r.name = b.name;
+    r.iterations = n;
+    r.best_ns = per_op.front();
+    r.median_ns = per_op[per_op.size() / 2];
+    r.bytes = b.bytes;
+    return r;
+}
+
+void print(const result& r) {
+    printf("%-20s %10ld ops %10.1f ns/op %12.0f ops/sec", r.name.c_str(), r.iterations,
+           r.best_ns, 1e9 / r.best_ns);
+    if (r.bytes) printf(" %9.1f MB/s", r.bytes * 1e3 / r.best_ns);
+    printf("  (median %.1f ns/op)\n", r.median_ns);
+    fflush(stdout);
+}
+
+void write_json(FILE* out, const std::vector<result>& results, long time_ms, int repeat) {
+    fprintf(out, "{\n  \"suite\": \"proton-bench\",\n  \"time_ms\": %ld,\n  \"repeat\": %d,\n  \"benchmarks\": [", time_ms, repeat);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const result& r = results[i];
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"iterations\": %ld, \"ns_per_op\": %.2f, "
+                "\"median_ns_per_op\": %.2f, \"ops_per_sec\": %.0f, \"bytes_per_op\": %lu}",
+                i ? "," : "", r.name.c_str(), r.iterations, r.best_ns, r.median_ns,
+                1e9 / r.best_ns, (unsigned long) r.bytes);
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+benchmark* make(int i) {
+    switch (i) {
+      case 0: return new data_encode;
+      case 1: return new data_decode;
+      case 2: return new message_encode;
+      case 3: return new message_decode;
+      case 4: return new frame_write("frame_write_64", 64);
+      case 5: return new frame_write("frame_write_16k", 16384);
+      case 6: return new frame_read("frame_read_64", 64);
+      case 7: return new frame_read("frame_read_16k", 16384);
+      case 8: return new transport_transfer;
+      case 9: return new engine_transfer;
+      case 10: return new cpp_message_copy;
+      case 11: return new cpp_message_codec;
+      case 12: return new cpp_value_scalar;
+      case 13: return new cpp_value_map;
+      case 14: return new cpp_value_vector;
+      case 15: return new cpp_message_annotations;
+      case 16: return new cpp_message_selector;
+      case 17: return new cpp_id_generator;
+      default: return 0;
+    }
+}
+
+bool selected(const char* name, const std::vector<std::string>& prefixes) {
+    if (prefixes.empty()) return true;
+    for (size_t i = 0; i < prefixes.size(); ++i) {
+        if (strncmp(name, prefixes[i].c_str(), prefixes[i].size()) == 0) return true;
+    }
+    return false;
+}
+
+int usage(const char* prog) {
+    fprintf(stderr, "usage: %s [--time ms] [--repeat n] [--json file] [--list] [name-prefix...]\n", prog);
+    return 1;
+}
+
+}
+
+int main(int argc, char** argv) {
+    long time_ms = 200;
+    int repeat = 5;
+    const char* json = 0;
+    bool list = false;
+    std::vector<std::string> prefixes;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--time" && i + 1 < argc) time_ms = atol(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc) repeat = atoi(argv[++i]);
+        else if (arg == "--json" && i + 1 < argc) json = argv[++i];
+        else if (arg == "--list") list = true;
+        else if (arg.size() && arg[0] == '-') return usage(argv[0]);
+        else prefixes.push_back(arg);
+    }
+    if (time_ms <= 0 || repeat <= 0) return usage(argv[0]);
+
+    std::vector<result> results;
+    for (int i = 0; benchmark* b = make(i); ++i) {
+        if (selected(b->name, prefixes)) {
+            if (list) printf("%s\n", b->name);
+            else {
+                results.push_back(measure(*b, uint64_t(time_ms) * 1000000, repeat));
+                print(results.back());
+            }
+        }
+        delete b;
+    }
+
+    if (json) {
+        FILE* out = strcmp(json, "-") ? fopen(json, "w") : stdout;
+        if (!out) {
+            perror(json);
+            return 1;
+        }
+        write_json(out, results, time_ms, repeat);
+        if (out != stdout) fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Prints a binary frame trace saved from pn_transport_trace_dump(), one
+ * frame per line, for example:
+ *
+ *   2016-10-19 12:00:00.123456 [1] -> @transfer handle=0 delivery-id=5 settled (1024)
+ *
+ * usage: trace-print [trace-file]
+ */
+
+#include <proton/transport.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint16_t swap16(uint16_t v) { return (uint16_t) ((v >> 8) | (v << 8)); }
+static uint32_t swap32(uint32_t v) { return ((uint32_t) swap16((uint16_t) v) << 16) | swap16((uint16_t) (v >> 16)); }
+static uint64_t swap64(uint64_t v) { return ((uint64_t) swap32((uint32_t) v) << 32) | swap32((uint32_t) (v >> 32)); }
+
+static const char *performative(uint8_t code, uint8_t flags)
+{
+  if (flags & PN_TRACE_SASL) {
+    switch (code) {
+    case 0x40: return "sasl-mechanisms";
+    case 0x41: return "sasl-init";
+    case 0x42: return "sasl-challenge";
+    case 0x43: return "sasl-response";
+    case 0x44: return "sasl-outcome";
+    default: return "sasl-unknown";
+    }
+  }
+  switch (code) {
+  case 0x00: return NULL;
+  case 0x10: return "open";
+  case 0x11: return "begin";
+  case 0x12: return "attach";
+  case 0x13: return "flow";
+  case 0x14: return "transfer";
+  case 0x15: return "disposition";
+  case 0x16: return "detach";
+  case 0x17: return "end";
+  case 0x18: return "close";
+  default: return "unknown";
+  }
+}
+
+static const char *outcome(uint32_t code)
+{
+  switch (code) {
+  case 0x23: return "received";
+  case 0x24: return "accepted";
+  case 0x25: return "rejected";
+  case 0x26: return "released";
+  case 0x27: return "modified";
+  default: return NULL;
+  }
+}
+
+static void print_record(const pn_trace_record_t *r)
+{
+  time_t secs = (time_t) (r->time / 1000000);
+  struct tm *tm = gmtime(&secs);
+  char when[32] = "?";
+  if (tm) strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", tm);
+  printf("%s.%06u [%u] %s ", when, (unsigned) (r->time % 1000000), r->channel,
+         (r->flags & PN_TRACE_OUT) ? "->" : "<-");
+
+  const char *name = performative(r->code, r->flags);
+  if (!name) {
+    printf("(EMPTY FRAME)\n");
+    return;
+  }
+  printf("@%s", name);
+  const uint32_t *f = r->fields;
+  bool flag = r->flags & PN_TRACE_FLAG;
+  if (!(r->flags & PN_TRACE_SASL)) {
+    switch (r->code) {
+    case 0x10:
+      printf(" max-frame-size=%u channel-max=%u idle-time-out=%u", f[0], f[1], f[2]);
+      break;
+    case 0x11:
+      if (f[0] != 0xFFFF) printf(" remote-channel=%u", f[0]);
+      printf(" next-outgoing-id=%u incoming-window=%u", f[1], f[2]);
+      break;
+    case 0x12:
+      printf(" handle=%u role=%s", f[0], flag ? "receiver" : "sender");
+      break;
+    case 0x13:
+      if (f[0] != 0xFFFFFFFF) printf(" handle=%u delivery-count=%u link-credit=%u", f[0], f[1], f[2]);
+      if (flag) printf(" drain");
+      break;
+    case 0x14:
+      printf(" handle=%u delivery-id=%u", f[0], f[1]);
+      break;
+    case 0x15:
+      printf(" role=%s first=%u last=%u", flag ? "receiver" : "sender", f[0], f[1]);
+      if (outcome(f[2])) printf(" %s", outcome(f[2]));
+      break;
+    case 0x16:
+      printf(" handle=%u%s", f[0], flag ? " closed" : "");
+      break;
+    default:
+      break;
+    }
+  }
+  if (r->flags & PN_TRACE_SETTLED) printf(" settled");
+  if (r->flags & PN_TRACE_MORE) printf(" more");
+  if (r->size) printf(" (%u)", r->size);
+  printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+  FILE *in = argc > 1 ? fopen(argv[1], "rb") : stdin;
+  if (!in) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  pn_trace_header_t header;
+  if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, "PNTRACE1", 8)) {
+    fprintf(stderr, "trace-print: not a proton frame trace\n");
+    return 1;
+  }
+  bool swap = header.byte_order != 0x01020304;
+  if (swap) {
+    header.record_size = swap32(header.record_size);
+    header.count = swap64(header.count);
+    header.dropped = swap64(header.dropped);
+  }
+  if (header.record_size != sizeof(pn_trace_record_t)) {
+    fprintf(stderr, "trace-print: unexpected record size %u\n", header.record_size);
+    return 1;
+  }
+
+  if (header.dropped) printf("(%llu earlier frames not recorded)\n", (unsigned long long) header.dropped);
+  pn_trace_record_t r;
+  uint64_t n = 0;
+  while (n < header.count && fread(&r, sizeof(r), 1, in) == 1) {
+    if (swap) {
+      r.time = swap64(r.time);
+      r.size = swap32(r.size);
+      for (int i = 0; i < 3; i++) r.fields[i] = swap32(r.fields[i]);
+      r.channel = swap16(r.channel);
+    }
+    print_record(&r);
+    n++;
+  }
+  if (n < header.count) {
+    fprintf(stderr, "trace-print: trace truncated after %llu of %llu frames\n",
+            (unsigned long long) n, (unsigned long long) header.count);
+    return 1;
+  }
+  return 0;
+}